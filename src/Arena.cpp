@@ -0,0 +1,112 @@
+#include <algorithm>
+#include "Arena.h"
+
+Arena::Arena(std::size_t firstBlockSize)
+        :firstBlockSize{std::max<std::size_t>(firstBlockSize, 1)}
+{
+}
+
+void Arena::reset()
+{
+    // Complexity O(blocks), the containers using the arena were destroyed without freeing anything
+    if(blocks.size() > 1)
+    {
+        const auto size{capacity()};
+        blocks.clear();
+        addBlock(size);
+    } else if(not blocks.empty())
+    {
+        next = blocks.front().memory.get();
+        remaining = blocks.front().size;
+    }
+    usedBytes = 0;
+}
+
+std::size_t Arena::capacity() const
+{
+    std::size_t size{0};
+    for(const auto& block : blocks)
+    {
+        size += block.size;
+    }
+    return size;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    // Complexity O(1), a new block is allocated when the current one is full, doubling the arena
+    void* pointer{next};
+    if(not std::align(alignment, bytes, pointer, remaining))
+    {
+        addBlock(std::max(blocks.empty() ? firstBlockSize : capacity(), bytes + alignment));
+        pointer = next;
+        std::align(alignment, bytes, pointer, remaining);
+    }
+    const auto* previous{next};
+    next = static_cast<std::byte*>(pointer) + bytes;
+    remaining -= bytes;
+    usedBytes += static_cast<std::size_t>(next - previous);
+    return pointer;
+}
+
+void Arena::do_deallocate(void*, std::size_t, std::size_t)
+{
+    // released all at once by reset
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void Arena::addBlock(std::size_t size)
+{
+    // not value initialized, the containers write their memory before reading it
+    blocks.push_back({std::unique_ptr<std::byte[]>{new std::byte[size]}, size});
+    next = blocks.back().memory.get();
+    remaining = size;
+}
+
+void ArenaPool::Release::operator()(Arena* arena) const
+{
+    pool->release(arena);
+}
+
+ArenaPool::Lease ArenaPool::acquire()
+{
+    std::unique_ptr<Arena> arena;
+    {
+        std::lock_guard lock{mutex};
+        if(not arenas.empty())
+        {
+            arena = std::move(arenas.back());
+            arenas.pop_back();
+        }
+    }
+    if(not arena)
+    {
+        arena = std::make_unique<Arena>();
+    }
+    return Lease{arena.release(), Release{shared_from_this()}};
+}
+
+std::size_t ArenaPool::pooledArenas() const
+{
+    std::lock_guard lock{mutex};
+    return arenas.size();
+}
+
+void ArenaPool::release(Arena* released)
+{
+    std::unique_ptr<Arena> arena{released};
+    if(arena->capacity() > maxArenaCapacity)
+    {
+        return;
+    }
+    arena->reset();
+    std::lock_guard lock{mutex};
+    if(arenas.size() < maxPooledArenas)
+    {
+        arenas.push_back(std::move(arena));
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+/**
+ * Responsibility: hand out the memory of short lived containers (the changes of a transaction)
+ * bumping a pointer through a few big blocks, a monotonic arena.
+ *
+ * Deallocating does nothing, the memory is released all at once by reset(), which keeps it for the next use:
+ * the blocks are merged into a single one of their total size, so filling the arena again with the same
+ * amount of memory does not allocate at all.
+ */
+class Arena: public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t defaultBlockSize{16 * 1024};
+
+    explicit Arena(std::size_t firstBlockSize = defaultBlockSize);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Everything allocated from the arena is released, the containers using it must be destroyed before.
+     */
+    void reset();
+
+    /**
+     * Bytes of the blocks owned by the arena.
+     */
+    std::size_t capacity() const;
+
+    /**
+     * Bytes handed out since the arena was reset, alignment padding included.
+     */
+    std::size_t used() const { return usedBytes; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void addBlock(std::size_t size);
+
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> memory;
+        std::size_t size;
+    };
+
+    std::size_t firstBlockSize;
+    std::vector<Block> blocks;
+    std::byte* next{nullptr};
+    std::size_t remaining{0};
+    std::size_t usedBytes{0};
+};
+
+/**
+ * Responsibility: recycle arenas between transactions, so the memory of a transaction is taken from
+ * the ones that finished before instead of from the heap.
+ *
+ * Thread safe. Arenas grown over maxArenaCapacity are freed instead of kept, like the ones released
+ * when the pool already has maxPooledArenas.
+ */
+class ArenaPool: public std::enable_shared_from_this<ArenaPool>
+{
+public:
+    static constexpr std::size_t maxPooledArenas{64};
+    static constexpr std::size_t maxArenaCapacity{16 * 1024 * 1024};
+
+    /**
+     * Gives the arena back to the pool once the lease is destroyed, the pool is kept alive meanwhile.
+     */
+    struct Release
+    {
+        std::shared_ptr<ArenaPool> pool;
+        void operator()(Arena* arena) const;
+    };
+    using Lease = std::unique_ptr<Arena, Release>;
+
+    /**
+     * An arena released before, or a new one if there is none. The pool must be owned by a std::shared_ptr.
+     */
+    Lease acquire();
+
+    std::size_t pooledArenas() const;
+
+private:
+    void release(Arena* arena);
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Arena>> arenas;
+};
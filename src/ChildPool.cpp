@@ -0,0 +1,55 @@
+#include "ChildPool.h"
+#include "ChildStore.h"
+#include "ParentStore.h"
+
+ChildPool::ChildPool() = default;
+ChildPool::~ChildPool() = default;
+
+void ChildPool::Release::operator()(ChildStore* child) const
+{
+    if(const auto owner{pool.lock()})
+    {
+        owner->release(child);
+        return;
+    }
+    delete child;
+}
+
+std::shared_ptr<ChildStore> ChildPool::acquire(std::shared_ptr<ParentStore> parent)
+{
+    std::unique_ptr<ChildStore> child;
+    {
+        std::lock_guard lock{mutex};
+        if(not children.empty())
+        {
+            child = std::move(children.back());
+            children.pop_back();
+        }
+    }
+    auto snapshot{parent->snapshot()};
+    if(child)
+    {
+        child->reuse(std::move(parent), std::move(snapshot));
+    } else
+    {
+        child = std::make_unique<ChildStore>(std::move(parent), std::move(snapshot));
+    }
+    return {child.release(), Release{weak_from_this()}};
+}
+
+std::size_t ChildPool::pooledChildren() const
+{
+    std::lock_guard lock{mutex};
+    return children.size();
+}
+
+void ChildPool::release(ChildStore* released)
+{
+    std::unique_ptr<ChildStore> child{released};
+    child->reset();
+    std::lock_guard lock{mutex};
+    if(children.size() < maxPooledChildren)
+    {
+        children.push_back(std::move(child));
+    }
+}
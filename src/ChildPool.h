@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ChildStore;
+class ParentStore;
+
+/**
+ * Responsibility: keep the children of a parent store once they are not used anymore, so the next short
+ * transaction takes one whose containers and arena are already allocated instead of building new ones.
+ *
+ * Thread safe. A released child is reset (rolled back and detached from the parent, so an idle child
+ * neither pins old versions of the parent nor keeps it alive), and freed if the pool already has
+ * maxPooledChildren. Children still in use when the pool is destroyed are freed when released.
+ */
+class ChildPool: public std::enable_shared_from_this<ChildPool>
+{
+public:
+    static constexpr std::size_t maxPooledChildren{64};
+
+    ChildPool();
+    ChildPool(const ChildPool&) = delete;
+    ChildPool& operator=(const ChildPool&) = delete;
+    ~ChildPool();
+
+    /**
+     * A child released before, or a new one, over the latest version of the parent. It goes back to the pool
+     * once the last reference to it is dropped. The pool must be owned by a std::shared_ptr.
+     */
+    std::shared_ptr<ChildStore> acquire(std::shared_ptr<ParentStore> parent);
+
+    std::size_t pooledChildren() const;
+
+private:
+    /**
+     * Deleter of the children handed out. A released child keeps the control block of its last std::shared_ptr
+     * (through enable_shared_from_this), so the deleter must not own the pool: the pool would own itself.
+     * A child released once the pool is gone is deleted.
+     */
+    struct Release
+    {
+        std::weak_ptr<ChildPool> pool;
+        void operator()(ChildStore* child) const;
+    };
+
+    void release(ChildStore* child);
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<ChildStore>> children;
+};
@@ -1,179 +1,1044 @@
+#include <algorithm>
+#include <stdexcept>
 #include <vector>
 #include "ChildStore.h"
+#include "ParentStore.h"
+#include "StoreSnapshot.h"
 
-ChildStore::ChildStore(std::shared_ptr<Store> parent)
-        :parent{std::move(parent)}
+namespace
 {
+    template<typename IsHidden>
+    std::size_t countHidden(IdRange parentIds, const IsHidden& isHidden)
+    {
+        std::size_t count{0};
+        for(const auto id : parentIds)
+        {
+            count += isHidden(id) ? 1 : 0;
+        }
+        return count;
+    }
 }
 
-void ChildStore::insert(std::int64_t id, const TodoProperties& properties)
+ChildStore::ChildStore(std::shared_ptr<ParentStore> parent, std::shared_ptr<StoreSnapshot> parentSnapshot)
+        :parent{std::move(parent)}, parentSnapshot{std::move(parentSnapshot)}, overlay{newOverlay()}
 {
-    todosToBeInserted[id]=properties;
+}
 
-    // insert the id into the titleIds
-    const auto& title{std::get<std::string>(properties.at(titleKey))};
-    titleIds.insert(title, id);
+ChildStore::ChildStore(std::shared_ptr<ChildStore> parentChild)
+        :parent{parentChild->parent}, parentSnapshot{parentChild->parentSnapshot}, parentChild{std::move(parentChild)},
+         forkedOverlay{this->parentChild->overlay}, overlay{this->parentChild->overlay}
+{
+}
+
+ChildStore::Overlay& ChildStore::writableOverlay(std::int64_t changedId)
+{
+    auto& state{ownOverlay()};
+    if(not savepoints.empty() and loggedIds.insert(changedId))
+    {
+        logChange(changedId);
+    }
+    if(parentChild)
+    {
+        changedIds.insert(changedId);
+    }
+    return state;
+}
 
-    // insert the id into the timestampIds
-    const auto timestamp{std::get<double>(properties.at(timestampKey))};
-    timestampIds.insert(timestamp, id);
+ChildStore::Overlay& ChildStore::ownOverlay()
+{
+    if(overlay.use_count() > 1)
+    {
+        overlay = std::make_shared<Overlay>(*overlay, parent->arenas->acquire());
+    }
+    return *overlay;
 }
 
-void ChildStore::update(std::int64_t id, const TodoProperties& properties)
+void ChildStore::insert(std::int64_t id, TodoPatch patch)
 {
-    const auto alreadyExists{propertiesToBeUpdated.find(id) not_eq propertiesToBeUpdated.end()};
-    if(alreadyExists)
+    if(not patch.complete())
+    {
+        throw std::invalid_argument("Missing properties when inserting a todo in the store. "
+                                    "Please review that all properties are specified");
+    }
+    auto& state{writableOverlay(id)};
+    state.todosToBeRemoved.erase(id);
+
+    const auto insertedIt{state.todosToBeInserted.find(id)};
+    if(insertedIt not_eq state.todosToBeInserted.end())
     {
-        for(const auto& property : properties)
+        state.removeChildIds(insertedIt->second, id);
+    } else
+    {
+        // the todo overwrites a parent one, pending updates would overwrite it again when committing
+        const auto updatedIt{state.propertiesToBeUpdated.find(id)};
+        if(updatedIt not_eq state.propertiesToBeUpdated.end())
         {
-            propertiesToBeUpdated.at(id)[property.first] = property.second;
+            state.removeChildIds(updatedIt->second, id);
+            state.propertiesToBeUpdated.erase(updatedIt);
         }
-    } else
+        // nothing is hidden if the todo is not in the parent, which is found out when looking the values up
+        state.hideParentValues(id, indexedProperties);
+    }
+
+    auto& insertedPatch{state.todosToBeInserted[id]};
+    insertedPatch = std::move(patch);
+    state.insertChildIds(insertedPatch, id);
+}
+
+void ChildStore::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void ChildStore::insertBatch(const std::vector<Todo>& todos)
+{
+    // the child keeps every pending todo as a patch until committing
+    for(const auto& todo : todos)
+    {
+        insert(todo.id, TodoPatch::fromTodo(todo));
+    }
+}
+
+void ChildStore::update(std::int64_t id, const TodoPatch& patch)
+{
+    auto& state{writableOverlay(id)};
+    const auto insertedIt{state.todosToBeInserted.find(id)};
+    if(insertedIt not_eq state.todosToBeInserted.end())
+    {
+        // the todo only exists in the child, so it is updated in place
+        auto& insertedPatch{insertedIt->second};
+        state.removeChildIds(insertedPatch, id);
+        insertedPatch.merge(patch);
+        state.insertChildIds(insertedPatch, id);
+        return;
+    }
+
+    auto& updatedPatch{state.propertiesToBeUpdated[id]};
+    // the child values of a previous update are replaced, so they are not found when querying anymore
+    state.removeChildIds(updatedPatch, id);
+
+    // a blind update does not read the parent todo, only its indexed values are looked up later
+    state.hideParentValues(id, patch.present & indexedProperties);
+    updatedPatch.merge(patch);
+    state.insertChildIds(updatedPatch, id);
+}
+
+void ChildStore::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void ChildStore::get(std::int64_t id, Todo& todo) const
+{
+    const auto idWillBeRemoved{overlay->todosToBeRemoved.find(id) not_eq overlay->todosToBeRemoved.end()};
+    if(idWillBeRemoved)
     {
-        propertiesToBeUpdated[id]=properties;
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
     }
 
-    const auto hasTitleProperty{properties.find(titleKey) not_eq properties.end()};
-    if(hasTitleProperty)
+    const auto insertedIt{overlay->todosToBeInserted.find(id)};
+    if(insertedIt not_eq overlay->todosToBeInserted.end())
     {
-        const auto oldTitle{std::get<std::string>(parent->get(id).at(titleKey))};
-        oldTitleIdsToBeUpdated[oldTitle].insert(id);
-        const auto& newTitle{std::get<std::string>(properties.at(titleKey))};
-        titleIds.insert(newTitle, id);
+        // if the id is going to be inserted in the child, just return the properties
+        todo.id = id;
+        insertedIt->second.applyTo(todo);
+        return;
     }
 
-    const auto hasTimestampProperty{properties.find(timestampKey) not_eq properties.end()};
-    if(hasTimestampProperty)
+    // if the id is about to be updated return the new properties instead of the ones from the parent
+    readSet.ids.insert(id);
+    parentSnapshot->get(id, todo);
+    const auto updatedIt{overlay->propertiesToBeUpdated.find(id)};
+    if(updatedIt not_eq overlay->propertiesToBeUpdated.end())
     {
-        const auto oldTimestamp{std::get<double>(parent->get(id).at(timestampKey))};
-        oldTimestampIdsToBeUpdated.insert({oldTimestamp, id});
-        const auto timestamp{std::get<double>(properties.at(timestampKey))};
-        timestampIds.insert(timestamp, id);
+        updatedIt->second.applyTo(todo);
     }
 }
 
 TodoProperties ChildStore::get(std::int64_t id) const
 {
-    TodoProperties properties;
-    const auto idWillBeInserted{todosToBeInserted.find(id) not_eq todosToBeInserted.end()};
-    if(idWillBeInserted)
+    // todos removed in the child have no properties, the missing ones throw like the typed get
+    if(overlay->todosToBeRemoved.find(id) not_eq overlay->todosToBeRemoved.end())
     {
-        // if the id is going to be inserted in the child, just return the properties
-        properties = todosToBeInserted.at(id);
-    }else{
-        const auto idWillBeRemoved{todosToBeRemoved.find(id) not_eq todosToBeRemoved.end()};
-        if (not idWillBeRemoved)
-        {
-            // return to-do properties from the parent if the id is not included in the ones to remove in the child
-            properties = parent->get(id);
+        return {};
+    }
+    Todo todo;
+    get(id, todo);
+    return toProperties(todo);
+}
 
-            // if the id is about to be updated return the new properties instead of the ones from the parent
-            const auto idWillBeUpdated{propertiesToBeUpdated.find(id) not_eq propertiesToBeUpdated.end()};
-            if (idWillBeUpdated)
+void ChildStore::getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& result) const
+{
+    result.resize(ids.size());
+    parentIds.clear();
+    parentPositions.clear();
+    for(std::size_t i{0}; i < ids.size(); ++i)
+    {
+        const auto id{ids[i]};
+        auto& todo{result[i]};
+        if(overlay->todosToBeRemoved.find(id) not_eq overlay->todosToBeRemoved.end())
+        {
+            todo.reset();
+            continue;
+        }
+        const auto insertedIt{overlay->todosToBeInserted.find(id)};
+        if(insertedIt not_eq overlay->todosToBeInserted.end())
+        {
+            if(not todo)
             {
-                for (auto& property : propertiesToBeUpdated.at(id))
-                {
-                    properties[property.first] = property.second;
-                }
+                todo.emplace();
             }
+            todo->id = id;
+            insertedIt->second.applyTo(*todo);
+            continue;
+        }
+        parentIds.push_back(id);
+        parentPositions.push_back(i);
+    }
+    if(parentIds.empty())
+    {
+        return;
+    }
+
+    for(const auto id : parentIds)
+    {
+        readSet.ids.insert(id);
+    }
+    parentSnapshot->getMany(parentIds, parentTodos);
+    for(std::size_t i{0}; i < parentIds.size(); ++i)
+    {
+        // swapping hands the old strings of the result to the parent buffer, to be reused in the next call
+        auto& todo{result[parentPositions[i]]};
+        std::swap(todo, parentTodos[i]);
+        if(not todo)
+        {
+            continue;
+        }
+        const auto updatedIt{overlay->propertiesToBeUpdated.find(parentIds[i])};
+        if(updatedIt not_eq overlay->propertiesToBeUpdated.end())
+        {
+            updatedIt->second.applyTo(*todo);
         }
     }
-    return properties;
 }
 
 void ChildStore::remove(std::int64_t id)
 {
-    // keep track of the id to be removed into the parent when commit the child
-    todosToBeRemoved.insert(id);
+    auto& state{writableOverlay(id)};
+    const auto insertedIt{state.todosToBeInserted.find(id)};
+    const auto wasInserted{insertedIt not_eq state.todosToBeInserted.end()};
+    if(wasInserted)
+    {
+        state.removeChildIds(insertedIt->second, id);
+        state.todosToBeInserted.erase(insertedIt);
+    } else
+    {
+        const auto updatedIt{state.propertiesToBeUpdated.find(id)};
+        if(updatedIt not_eq state.propertiesToBeUpdated.end())
+        {
+            state.removeChildIds(updatedIt->second, id);
+            state.propertiesToBeUpdated.erase(updatedIt);
+        }
+    }
+
+    const auto existInParent{parentSnapshot->checkId(id)};
+    if(existInParent)
+    {
+        state.hideParentValues(id, indexedProperties);
+    }
+    // a todo that never reached the parent has nothing to remove when committing
+    if(existInParent or not wasInserted)
+    {
+        // keep track of the id to be removed into the parent when commit the child
+        state.todosToBeRemoved.insert(id);
+    }
 }
 
 bool ChildStore::checkId(std::int64_t id) const
 {
-    const auto existInParent{parent->checkId(id)};
-    const auto existInToBeInserted{todosToBeInserted.find(id) not_eq todosToBeInserted.end()};
-    const auto existInToBeRemoved{todosToBeRemoved.find(id) not_eq todosToBeRemoved.end()};
-    return (existInParent or existInToBeInserted) and not existInToBeRemoved;
+    const auto existInToBeRemoved{overlay->todosToBeRemoved.find(id) not_eq overlay->todosToBeRemoved.end()};
+    if(existInToBeRemoved)
+    {
+        return false;
+    }
+    const auto existInToBeInserted{overlay->todosToBeInserted.find(id) not_eq overlay->todosToBeInserted.end()};
+    if(existInToBeInserted)
+    {
+        return true;
+    }
+    readSet.ids.insert(id);
+    return parentSnapshot->checkId(id);
+}
+
+IdRange ChildStore::query(const TodoProperty& property) const
+{
+    auto parentIds{parentSnapshot->query(property)};
+    if(property.first not_eq titleKey)
+    {
+        const auto isRemoved{[this](std::int64_t id) { return overlay->todosToBeRemoved.count(id) == 1; }};
+        return makeOverlayRange(std::move(parentIds), isRemoved, {});
+    }
+
+    // the parent ids whose title is updated or removed in the child are hidden, the child ids have
+    // the current title. Only the ids of the title are checked, O(1) per id, whatever the size of the child
+    const auto& title{std::get<std::string>(property.second)};
+    readSet.titles.insert(title);
+    const auto& oldTitleIds{overlay->oldTitleIdsToBeUpdated.getIds(title)};
+    const auto& childIds{overlay->titleIds.getIds(title)};
+    return makeOverlayRange(std::move(parentIds),
+                            [this, &oldTitleIds](std::int64_t id)
+                            {
+                                return oldTitleIds.contains(id) or
+                                       overlay->hidesParentValue(id, TodoPropertyId::title);
+                            },
+                            makeIdRange(childIds.begin(), childIds.end(), [](std::int64_t id) { return id; }));
+}
+
+IdRange ChildStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    readSet.timestampRanges.emplace(minTimeStamp, maxTimeStamp);
+    return makeOverlayRange(parentSnapshot->rangeQuery(minTimeStamp, maxTimeStamp),
+                            hiddenInRange(minTimeStamp, maxTimeStamp),
+                            overlay->timestampIds.getRange(minTimeStamp, maxTimeStamp));
+}
+
+RangePage ChildStore::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                        std::size_t limit, const RangeCursor& cursor) const
+{
+    // the whole range is read, the next pages may be asked later
+    readSet.timestampRanges.emplace(minTimeStamp, maxTimeStamp);
+    // parent todos updated or removed in the child are hidden, the child todos have the current timestamp
+    return mergeOverlayPage(limit, cursor,
+                            [&](std::size_t pageSize, const RangeCursor& parentCursor)
+                            {
+                                return parentSnapshot->rangeQueryOrdered(minTimeStamp, maxTimeStamp,
+                                                                         pageSize, parentCursor);
+                            },
+                            [this](const TimestampTree::Entry& todo)
+                            {
+                                return overlay->oldTimestampIdsToBeUpdated.contains(todo.timestamp, todo.id) or
+                                       overlay->hidesParentValue(todo.id, TodoPropertyId::timestamp);
+                            },
+                            [&](std::size_t pageSize)
+                            {
+                                return overlay->timestampIds.getOrderedRange(minTimeStamp, maxTimeStamp,
+                                                                             pageSize, cursor);
+                            });
+}
+
+std::size_t ChildStore::queryCount(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return parentSnapshot->queryCount(property);
+    }
+    // every hidden parent id had that title in the parent, every child id has it in the child
+    const auto& title{std::get<std::string>(property.second)};
+    readSet.titles.insert(title);
+    const auto parentCount{parentSnapshot->queryCount(property)};
+    if(lookUpHiddenValues(parentCount))
+    {
+        return parentCount - resolvedOverlay().oldTitleIdsToBeUpdated.count(title) + overlay->titleIds.count(title);
+    }
+    const auto& oldTitleIds{overlay->oldTitleIdsToBeUpdated.getIds(title)};
+    return parentCount - countHidden(parentSnapshot->query(property),
+                                     [this, &oldTitleIds](std::int64_t id)
+                                     {
+                                         return oldTitleIds.contains(id) or
+                                                overlay->hidesParentValue(id, TodoPropertyId::title);
+                                     }) + overlay->titleIds.count(title);
+}
+
+std::size_t ChildStore::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    readSet.timestampRanges.emplace(minTimeStamp, maxTimeStamp);
+    const auto parentCount{parentSnapshot->rangeCount(minTimeStamp, maxTimeStamp)};
+    if(lookUpHiddenValues(parentCount))
+    {
+        return parentCount - resolvedOverlay().oldTimestampIdsToBeUpdated.countRange(minTimeStamp, maxTimeStamp) +
+               overlay->timestampIds.countRange(minTimeStamp, maxTimeStamp);
+    }
+    return parentCount - countHidden(parentSnapshot->rangeQuery(minTimeStamp, maxTimeStamp),
+                                     hiddenInRange(minTimeStamp, maxTimeStamp)) +
+           overlay->timestampIds.countRange(minTimeStamp, maxTimeStamp);
+}
+
+bool ChildStore::lookUpHiddenValues(std::size_t parentCount) const
+{
+    // once looked up, the hidden values are counted from the child indexes in O(log n), but looking them up
+    // costs O(hidden values not looked up yet), so a count with less parent ids than that checks them instead
+    return overlay->parentValuesToHide.size() <= parentCount;
+}
+
+std::function<bool(std::int64_t)> ChildStore::hiddenInRange(double minTimeStamp, double maxTimeStamp) const
+{
+    // only the parent timestamps the child updated or removed inside the range are collected, O(log n + k)
+    return [this, oldRangeIds{overlay->oldTimestampIdsToBeUpdated.getRangeIds(minTimeStamp, maxTimeStamp)}]
+            (std::int64_t id)
+            {
+                return oldRangeIds.contains(id) or overlay->hidesParentValue(id, TodoPropertyId::timestamp);
+            };
+}
+
+std::unique_ptr<Store> ChildStore::createChild()
+{
+    // Complexity O(1), the overlay is only copied when one of the children writes
+    return std::make_unique<ChildStore>(std::static_pointer_cast<ChildStore>(shared_from_this()));
+}
+
+void ChildStore::commit()
+{
+    if(parentChild)
+    {
+        commitIntoParentChild();
+        return;
+    }
+
+    validateCommit();
+
+    // every pending change is applied at once, as a single version of the parent,
+    // with the index entries the child already keeps for its own queries
+    const std::vector<CommitDelta> deltas{delta()};
+    // the snapshot is not read while committing. Releasing it first, the parent does not keep
+    // the old versions of the committed todos unless another child still reads them
+    parentSnapshot.reset();
+    try
+    {
+        parent->commitDeltas(deltas);
+    } catch(...)
+    {
+        // nothing was committed, and nothing the child read changed since its snapshot (it was validated)
+        parentSnapshot = parent->snapshot();
+        throw;
+    }
+    restart();
+}
+
+CommitDelta ChildStore::delta() const
+{
+    // the hidden parent values not looked up yet are removed by the parent from its own columns
+    CommitDelta delta{{}, &overlay->oldTitleIdsToBeUpdated, &overlay->oldTimestampIdsToBeUpdated,
+                      &overlay->parentValuesToHide, &overlay->titleIds, &overlay->timestampIds};
+    auto& changes{delta.changes};
+    changes.reserve(overlay->todosToBeInserted.size() + overlay->propertiesToBeUpdated.size() +
+                    overlay->todosToBeRemoved.size());
+    for(const auto& todo : overlay->todosToBeInserted)
+    {
+        changes.push_back({TodoChange::Kind::insert, todo.first, &todo.second});
+    }
+    for(const auto& todo : overlay->propertiesToBeUpdated)
+    {
+        changes.push_back({TodoChange::Kind::update, todo.first, &todo.second});
+    }
+    for(const auto id : overlay->todosToBeRemoved)
+    {
+        changes.push_back({TodoChange::Kind::remove, id, nullptr});
+    }
+    // every todo changes once, so the order does not matter. In id order the parent reads its todos
+    // in the order they were stored instead of jumping around them in hash order
+    std::sort(changes.begin(), changes.end(),
+              [](const TodoChange& change, const TodoChange& other) { return change.id < other.id; });
+    return delta;
+}
+
+const ChildStore::Overlay& ChildStore::resolvedOverlay() const
+{
+    // looking the values up does not change what the overlay means, so a shared overlay is resolved in place
+    // for every child sharing it (they all read the same parent snapshot)
+    if(not overlay->parentValuesToHide.empty())
+    {
+        overlay->resolveHiddenParentValues(*parentSnapshot);
+    }
+    return *overlay;
+}
+
+std::shared_ptr<ChildStore::Overlay> ChildStore::newOverlay() const
+{
+    return std::make_shared<Overlay>(parent->arenas->acquire());
+}
+
+void ChildStore::restart()
+{
+    releaseSavepoints();
+    clearOverlay();
+    readSet.clear();
+    parentSnapshot = parent->snapshot();
+}
+
+void ChildStore::rollback()
+{
+    if(parentChild)
+    {
+        overlay = parentChild->overlay;
+        forkedOverlay = overlay;
+        parentSnapshot = parentChild->parentSnapshot;
+        changedIds = {};
+        readSet.clear();
+        releaseSavepoints();
+        return;
+    }
+    // the snapshot is released first, so the parent does not keep old versions only this child was reading
+    parentSnapshot.reset();
+    restart();
+}
+
+ChildStore::Savepoint ChildStore::savepoint()
+{
+    savepoints.emplace_back(nextSavepointId, undoLog.size());
+    loggedIds = {};
+    return {nextSavepointId++};
+}
+
+void ChildStore::rollbackTo(const Savepoint& savepoint)
+{
+    const auto taken{std::find_if(savepoints.begin(), savepoints.end(),
+                                  [&savepoint](const auto& alive) { return alive.first == savepoint.id; })};
+    if(taken == savepoints.end())
+    {
+        throw std::invalid_argument("The savepoint was released, it cannot be rolled back to");
+    }
+    const auto logSize{taken->second};
+    savepoints.erase(taken + 1, savepoints.end());
+    if(undoLog.size() > logSize)
+    {
+        ownOverlay();
+        // Complexity O(todos changed since the savepoint), the latest changes are undone first
+        while(undoLog.size() > logSize)
+        {
+            undo(undoLog.back());
+            undoLog.pop_back();
+        }
+    }
+    loggedIds = {};
+}
+
+void ChildStore::logChange(std::int64_t id)
+{
+    const auto& state{*overlay};
+    UndoEntry entry{id, {}, {}, state.todosToBeRemoved.count(id) == 1, changedIds.contains(id)};
+    const auto insertedIt{state.todosToBeInserted.find(id)};
+    if(insertedIt not_eq state.todosToBeInserted.end())
+    {
+        entry.inserted = insertedIt->second;
+    }
+    const auto updatedIt{state.propertiesToBeUpdated.find(id)};
+    if(updatedIt not_eq state.propertiesToBeUpdated.end())
+    {
+        entry.updated = updatedIt->second;
+    }
+    undoLog.push_back(std::move(entry));
 }
 
-std::unordered_set<std::int64_t> ChildStore::query(const TodoProperty& property) const
+void ChildStore::undo(const UndoEntry& entry)
 {
-    auto ids{parent->query(property)};
+    auto& state{*overlay};
+    const auto id{entry.id};
+    const auto hiddenValues{state.hiddenParentValues(id)};
+    const auto insertedIt{state.todosToBeInserted.find(id)};
+    if(insertedIt not_eq state.todosToBeInserted.end())
+    {
+        state.removeChildIds(insertedIt->second, id);
+        state.todosToBeInserted.erase(insertedIt);
+    }
+    const auto updatedIt{state.propertiesToBeUpdated.find(id)};
+    if(updatedIt not_eq state.propertiesToBeUpdated.end())
+    {
+        state.removeChildIds(updatedIt->second, id);
+        state.propertiesToBeUpdated.erase(updatedIt);
+    }
+    state.todosToBeRemoved.erase(id);
+
+    // the parent values hidden now are found again. A value looked up and hidden again by a later update
+    // is both pending and in the old indexes, so the old indexes are checked for every hidden value
+    state.parentValuesToHide.erase(id);
+    std::string title;
+    double timestamp;
+    if(hiddenValues not_eq 0 and parentSnapshot->getIndexedValues(id, title, timestamp))
+    {
+        if(state.oldTitleIdsToBeUpdated.getIds(title).contains(id))
+        {
+            state.oldTitleIdsToBeUpdated.remove(title, id);
+        }
+        if(state.oldTimestampIdsToBeUpdated.contains(timestamp, id))
+        {
+            state.oldTimestampIdsToBeUpdated.remove(timestamp, id);
+        }
+    }
+
+    if(entry.inserted)
+    {
+        auto& insertedPatch{state.todosToBeInserted[id]};
+        insertedPatch = *entry.inserted;
+        state.insertChildIds(insertedPatch, id);
+    }
+    if(entry.updated)
+    {
+        auto& updatedPatch{state.propertiesToBeUpdated[id]};
+        updatedPatch = *entry.updated;
+        state.insertChildIds(updatedPatch, id);
+    }
+    if(entry.removed)
+    {
+        state.todosToBeRemoved.insert(id);
+    }
+    // hidden again as they were, to be looked up when a query needs them
+    state.hideParentValues(id, state.hiddenParentValues(id));
+    if(not entry.changed)
+    {
+        changedIds.erase(id);
+    }
+}
+
+void ChildStore::releaseSavepoints()
+{
+    savepoints.clear();
+    undoLog.clear();
+    loggedIds = {};
+}
+
+void ChildStore::clearOverlay()
+{
+    // a nested child still reads a shared overlay, and an arena grown too much is given back to the pool
+    if(overlay.use_count() > 1 or overlay->arena->capacity() > ArenaPool::maxArenaCapacity)
+    {
+        overlay = newOverlay();
+        return;
+    }
+    const auto insertedCount{overlay->todosToBeInserted.size()};
+    const auto updatedCount{overlay->propertiesToBeUpdated.size()};
+    const auto removedCount{overlay->todosToBeRemoved.size()};
+    const auto hiddenCount{overlay->parentValuesToHide.size()};
+    // destroying the containers gives nothing back to the arena, it is released at once afterwards
+    auto arena{std::move(overlay->arena)};
+    overlay.reset();
+    arena->reset();
+    overlay = std::make_shared<Overlay>(std::move(arena));
+    overlay->todosToBeInserted.reserve(insertedCount);
+    overlay->propertiesToBeUpdated.reserve(updatedCount);
+    overlay->todosToBeRemoved.reserve(removedCount);
+    overlay->parentValuesToHide.reserve(hiddenCount);
+}
+
+void ChildStore::reset()
+{
+    parentSnapshot.reset();
+    releaseSavepoints();
+    clearOverlay();
+    readSet.clear();
+    parent.reset();
+}
+
+void ChildStore::reuse(std::shared_ptr<ParentStore> parent, std::shared_ptr<StoreSnapshot> parentSnapshot)
+{
+    this->parent = std::move(parent);
+    this->parentSnapshot = std::move(parentSnapshot);
+}
+
+void ChildStore::validateCommit() const
+{
+    if(parentChild)
+    {
+        // the same overlay means the parent child did not change since this child was created
+        if(parentChild->overlay not_eq forkedOverlay)
+        {
+            validateParentChildCommit();
+        }
+        return;
+    }
+    // nothing was committed into the parent since the snapshot was taken
+    if(parent->version() == parentSnapshot->version())
+    {
+        return;
+    }
 
-    // remove the ids that are going to be removed from the parent set
-    for(const auto& idToBeRemoved : todosToBeRemoved)
+    const auto validateId{[this](std::int64_t id)
+                          {
+                              if(parentSnapshot->changed(id))
+                              {
+                                  throw CommitConflict("Todo with id "+std::to_string(id)+
+                                                       " was changed by another commit");
+                              }
+                          }};
+    // the todos written by the child were read from the snapshot too (to hide their parent values)
+    for(const auto& todo : overlay->todosToBeInserted)
+    {
+        validateId(todo.first);
+    }
+    for(const auto& todo : overlay->propertiesToBeUpdated)
+    {
+        validateId(todo.first);
+    }
+    for(const auto id : overlay->todosToBeRemoved)
+    {
+        validateId(id);
+    }
+    for(const auto id : readSet.ids)
     {
-        ids.erase(idToBeRemoved);
+        validateId(id);
     }
 
-    if(property.first == titleKey)
+    for(const auto& title : readSet.titles)
     {
-        // add the titles that are going to be inserted or updated in the child
-        const auto& title{std::get<std::string>(property.second)};
-        auto childIds{titleIds.getIds(title)};
-        if(not childIds.empty())
+        if(parentSnapshot->changedTitle(title))
         {
-            ids.merge(std::move(childIds));
+            throw CommitConflict("Todos with title "+title+" were changed by another commit");
         }
+    }
+    for(const auto& range : readSet.timestampRanges)
+    {
+        if(parentSnapshot->changedRange(range.first, range.second))
+        {
+            throw CommitConflict("Todos with timestamp between "+std::to_string(range.first)+" and "+
+                                 std::to_string(range.second)+" were changed by another commit");
+        }
+    }
+}
 
-        // remove the ids from old title that are going to be updated in the child
-        const auto titleWillBeUpdated{oldTitleIdsToBeUpdated.find(title) not_eq oldTitleIdsToBeUpdated.end()};
-        if(titleWillBeUpdated)
+void ChildStore::checkChanges() const
+{
+    if(parentChild)
+    {
+        return;
+    }
+    // the same check the parent does before committing the delta
+    for(const auto& change : delta().changes)
+    {
+        ParentStore::checkChange(change, parent->checkId(change.id));
+    }
+}
+
+void ChildStore::validateGroupCommit(const GroupWrites& earlierWrites) const
+{
+    const auto validateId{[&earlierWrites](std::int64_t id)
+                          {
+                              if(earlierWrites.ids.contains(id))
+                              {
+                                  throw CommitConflict("Todo with id "+std::to_string(id)+
+                                                       " was changed by another commit of the group");
+                              }
+                          }};
+    for(const auto& todo : overlay->todosToBeInserted)
+    {
+        validateId(todo.first);
+    }
+    for(const auto& todo : overlay->propertiesToBeUpdated)
+    {
+        validateId(todo.first);
+    }
+    for(const auto id : overlay->todosToBeRemoved)
+    {
+        validateId(id);
+    }
+    for(const auto id : readSet.ids)
+    {
+        validateId(id);
+    }
+    for(const auto& title : readSet.titles)
+    {
+        if(earlierWrites.titles.count(title) == 1)
+        {
+            throw CommitConflict("Todos with title "+title+" were changed by another commit of the group");
+        }
+    }
+    for(const auto& range : readSet.timestampRanges)
+    {
+        const auto timestamp{earlierWrites.timestamps.lower_bound(range.first)};
+        if(timestamp not_eq earlierWrites.timestamps.end() and *timestamp <= range.second)
         {
-            for(const auto& id : oldTitleIdsToBeUpdated.at(title))
+            throw CommitConflict("Todos with timestamp between "+std::to_string(range.first)+" and "+
+                                 std::to_string(range.second)+" were changed by another commit of the group");
+        }
+    }
+}
+
+void ChildStore::addGroupWrites(GroupWrites& writes) const
+{
+    // the parent values of a written todo stop being found, the child ones start being found
+    std::string title;
+    double timestamp;
+    const auto addParentValues{[this, &writes, &title, &timestamp](std::int64_t id)
+                               {
+                                   if(parentSnapshot->getIndexedValues(id, title, timestamp))
+                                   {
+                                       writes.titles.insert(title);
+                                       writes.timestamps.insert(timestamp);
+                                   }
+                               }};
+    const auto addChildValues{[&writes](const TodoPatch& patch)
+                              {
+                                  if(patch.has(TodoPropertyId::title))
+                                  {
+                                      writes.titles.insert(patch.title);
+                                  }
+                                  if(patch.has(TodoPropertyId::timestamp))
+                                  {
+                                      writes.timestamps.insert(patch.timestamp);
+                                  }
+                              }};
+    for(const auto& todo : overlay->todosToBeInserted)
+    {
+        writes.ids.insert(todo.first);
+        addParentValues(todo.first);
+        addChildValues(todo.second);
+    }
+    for(const auto& todo : overlay->propertiesToBeUpdated)
+    {
+        writes.ids.insert(todo.first);
+        addParentValues(todo.first);
+        addChildValues(todo.second);
+    }
+    for(const auto id : overlay->todosToBeRemoved)
+    {
+        writes.ids.insert(id);
+        addParentValues(id);
+    }
+}
+
+void ChildStore::commitIntoParentChild()
+{
+    // a shared overlay is never changed in place, so the same overlay means the parent child did not change
+    if(parentChild->overlay == forkedOverlay)
+    {
+        // the parent child did not change since this child was created, and the overlay of this child
+        // already has every change of the parent child, so it is folded just by sharing it. Complexity O(1)
+        parentChild->overlay = overlay;
+    } else
+    {
+        validateParentChildCommit();
+        // the parent child changed meanwhile, only the todos changed by this child are replayed into it
+        for(const auto id : changedIds)
+        {
+            const auto insertedIt{overlay->todosToBeInserted.find(id)};
+            if(insertedIt not_eq overlay->todosToBeInserted.end())
+            {
+                parentChild->insert(id, insertedIt->second);
+                continue;
+            }
+            const auto updatedIt{overlay->propertiesToBeUpdated.find(id)};
+            if(updatedIt not_eq overlay->propertiesToBeUpdated.end())
+            {
+                parentChild->update(id, updatedIt->second);
+                continue;
+            }
+            if(overlay->todosToBeRemoved.count(id) == 1)
             {
-                ids.erase(id);
+                parentChild->remove(id);
             }
         }
     }
-    return ids;
+    // the reads of this child are validated when the parent child commits
+    parentChild->readSet.merge(readSet);
+    readSet.clear();
+    // further changes of this child are relative to the committed state, read as the parent child reads it
+    overlay = parentChild->overlay;
+    forkedOverlay = overlay;
+    parentSnapshot = parentChild->parentSnapshot;
+    changedIds = {};
+    releaseSavepoints();
 }
 
-std::unordered_set<std::int64_t> ChildStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+void ChildStore::validateParentChildCommit() const
 {
-    auto ids{parent->rangeQuery(minTimeStamp, maxTimeStamp)};
+    const auto& current{*parentChild->overlay};
+    const auto& currentSnapshot{*parentChild->parentSnapshot};
+    // only the todos changed in one of the overlays, or committed into the store by the parent child
+    // or by others since the snapshot of this child, can differ. Complexity O(changes of both overlays)
+    IdSet candidateIds;
+    for(const auto* state : {forkedOverlay.get(), &current})
+    {
+        for(const auto& todo : state->todosToBeInserted)
+        {
+            candidateIds.insert(todo.first);
+        }
+        for(const auto& todo : state->propertiesToBeUpdated)
+        {
+            candidateIds.insert(todo.first);
+        }
+        for(const auto id : state->todosToBeRemoved)
+        {
+            candidateIds.insert(id);
+        }
+    }
+    if(parentSnapshot not_eq parentChild->parentSnapshot)
+    {
+        for(const auto id : parentSnapshot->changedIds())
+        {
+            candidateIds.insert(id);
+        }
+    }
 
-    // remove the ids from the parent that is going to be removed in the child
-    for(const auto& idToBeRemoved : todosToBeRemoved)
+    const auto sameTodo{[](const std::optional<Todo>& todo, const std::optional<Todo>& other)
+                        {
+                            return todo.has_value() == other.has_value() and
+                                   (not todo or (todo->title == other->title and
+                                                 todo->description == other->description and
+                                                 todo->timestamp == other->timestamp));
+                        }};
+    for(const auto id : candidateIds)
     {
-        ids.erase(idToBeRemoved);
+        const auto forkedTodo{readTodo(*forkedOverlay, *parentSnapshot, id)};
+        const auto currentTodo{readTodo(current, currentSnapshot, id)};
+        if(sameTodo(forkedTodo, currentTodo))
+        {
+            continue;
+        }
+        if(changedIds.contains(id) or readSet.ids.contains(id))
+        {
+            throw CommitConflict("Todo with id "+std::to_string(id)+" was changed by the parent child");
+        }
+        for(const auto& title : readSet.titles)
+        {
+            if((forkedTodo and forkedTodo->title == title) not_eq (currentTodo and currentTodo->title == title))
+            {
+                throw CommitConflict("Todos with title "+title+" were changed by the parent child");
+            }
+        }
+        for(const auto& range : readSet.timestampRanges)
+        {
+            const auto inRange{[&range](const std::optional<Todo>& todo)
+                               {
+                                   return todo and range.first <= todo->timestamp and
+                                          todo->timestamp <= range.second;
+                               }};
+            if(inRange(forkedTodo) not_eq inRange(currentTodo))
+            {
+                throw CommitConflict("Todos with timestamp between "+std::to_string(range.first)+" and "+
+                                     std::to_string(range.second)+" were changed by the parent child");
+            }
+        }
     }
+}
 
-    // remove the ids from the parent that are going to be updated in the child
-    auto startIterator{oldTimestampIdsToBeUpdated.lower_bound(minTimeStamp)};
-    auto endIterator{oldTimestampIdsToBeUpdated.upper_bound(maxTimeStamp)};
-    for(auto it=startIterator; it != endIterator; std::advance(it, 1))
+std::optional<Todo> ChildStore::readTodo(const Overlay& overlay, const StoreSnapshot& snapshot, std::int64_t id)
+{
+    if(overlay.todosToBeRemoved.count(id) == 1)
     {
-        ids.erase(it->second);
+        return std::nullopt;
     }
+    Todo todo{id};
+    const auto insertedIt{overlay.todosToBeInserted.find(id)};
+    if(insertedIt not_eq overlay.todosToBeInserted.end())
+    {
+        insertedIt->second.applyTo(todo);
+        return todo;
+    }
+    if(not snapshot.checkId(id))
+    {
+        return std::nullopt;
+    }
+    snapshot.get(id, todo);
+    const auto updatedIt{overlay.propertiesToBeUpdated.find(id)};
+    if(updatedIt not_eq overlay.propertiesToBeUpdated.end())
+    {
+        updatedIt->second.applyTo(todo);
+    }
+    return todo;
+}
 
-    // add the new ids inserted and the ones updated in the child
-    const auto& childIds{timestampIds.getRangeIds(minTimeStamp, maxTimeStamp)};
-    ids.insert(childIds.cbegin(), childIds.cend());
-    return ids;
+void ChildStore::Overlay::insertChildIds(const TodoPatch& patch, std::int64_t id)
+{
+    if(patch.has(TodoPropertyId::title))
+    {
+        titleIds.insert(patch.title, id);
+    }
+    if(patch.has(TodoPropertyId::timestamp))
+    {
+        timestampIds.insert(patch.timestamp, id);
+    }
 }
 
-std::unique_ptr<Store> ChildStore::createChild()
+void ChildStore::Overlay::removeChildIds(const TodoPatch& patch, std::int64_t id)
+{
+    if(patch.has(TodoPropertyId::title))
+    {
+        titleIds.remove(patch.title, id);
+    }
+    if(patch.has(TodoPropertyId::timestamp))
+    {
+        timestampIds.remove(patch.timestamp, id);
+    }
+}
+
+ChildStore::Overlay::Overlay(ArenaPool::Lease arena)
+        :arena{std::move(arena)}
 {
-    throw std::runtime_error("Child store cannot create children");
 }
 
-void ChildStore::commit()
+ChildStore::Overlay::Overlay(const Overlay& other, ArenaPool::Lease arena)
+        :arena{std::move(arena)},
+         todosToBeInserted{other.todosToBeInserted, this->arena.get()},
+         propertiesToBeUpdated{other.propertiesToBeUpdated, this->arena.get()},
+         todosToBeRemoved{other.todosToBeRemoved, this->arena.get()},
+         titleIds{other.titleIds, this->arena.get()},
+         timestampIds{other.timestampIds, this->arena.get()},
+         oldTitleIdsToBeUpdated{other.oldTitleIdsToBeUpdated, this->arena.get()},
+         oldTimestampIdsToBeUpdated{other.oldTimestampIdsToBeUpdated, this->arena.get()},
+         parentValuesToHide{other.parentValuesToHide, this->arena.get()}
 {
-    /**
-     * Perform all the saved actions on the parent when committing
-     */
-    for(const auto& todo : todosToBeInserted)
+}
+
+std::uint8_t ChildStore::Overlay::hiddenParentValues(std::int64_t id) const
+{
+    if(todosToBeInserted.contains(id) or todosToBeRemoved.count(id) == 1)
     {
-        parent->insert(todo.first, todo.second);
+        return indexedProperties;
     }
+    const auto updatedIt{propertiesToBeUpdated.find(id)};
+    return updatedIt == propertiesToBeUpdated.end() ? 0 : updatedIt->second.present & indexedProperties;
+}
 
-    for(const auto& todo : propertiesToBeUpdated)
+bool ChildStore::Overlay::hidesParentValue(std::int64_t id, TodoPropertyId property) const
+{
+    // Complexity O(1), nothing to look up once the values were resolved
+    if(parentValuesToHide.empty())
     {
-        parent->update(todo.first, todo.second);
+        return false;
     }
+    const auto hidden{parentValuesToHide.find(id)};
+    return hidden not_eq parentValuesToHide.end() and (hidden->second & propertyBit(property)) not_eq 0;
+}
 
-    for(const auto& id : todosToBeRemoved)
+void ChildStore::Overlay::hideParentValues(std::int64_t id, std::uint8_t properties)
+{
+    if(properties not_eq 0)
     {
-        parent->remove(id);
+        // hiding a value already hidden does nothing
+        parentValuesToHide[id] |= properties;
+    }
+}
+
+void ChildStore::Overlay::resolveHiddenParentValues(const StoreSnapshot& parent)
+{
+    // the ids are looked up in order, so the parent todos are read in the order they were stored
+    // instead of jumping around them in hash order
+    std::vector<std::pair<std::int64_t, std::uint8_t>> hiddenIds;
+    hiddenIds.reserve(parentValuesToHide.size());
+    for(const auto& hidden : parentValuesToHide)
+    {
+        hiddenIds.emplace_back(hidden.first, hidden.second);
+    }
+    std::sort(hiddenIds.begin(), hiddenIds.end());
+
+    // only the indexed values are copied, not the whole parent todos, and the timestamps are inserted in bulk
+    std::string title;
+    double timestamp;
+    std::vector<TimestampTree::Entry> oldTimestamps;
+    for(const auto& hidden : hiddenIds)
+    {
+        const auto id{hidden.first};
+        if(not parent.getIndexedValues(id, title, timestamp))
+        {
+            continue;
+        }
+        if((hidden.second & propertyBit(TodoPropertyId::title)) not_eq 0)
+        {
+            oldTitleIdsToBeUpdated.insert(title, id);
+        }
+        if((hidden.second & propertyBit(TodoPropertyId::timestamp)) not_eq 0)
+        {
+            oldTimestamps.push_back({timestamp, id});
+        }
     }
+    oldTimestampIdsToBeUpdated.insert(std::move(oldTimestamps));
+    parentValuesToHide.clear();
 }
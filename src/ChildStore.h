@@ -5,40 +5,296 @@
 #include <list>
 #include <memory>
 #include <set>
+#include <unordered_set>
+#include <functional>
+#include <optional>
+#include "Arena.h"
 #include "Store.h"
 #include "StringPropertyIds.h"
 #include "DoublePropertyIds.h"
+#include "FlatIdMap.h"
+#include "IdSet.h"
+#include "ReadSet.h"
+
+class ParentStore;
+class StoreSnapshot;
+struct CommitDelta;
 
 class ChildStore: public Store
 {
 public:
-    explicit ChildStore(std::shared_ptr<Store> parent);
+    /**
+     * The child reads the parent through a snapshot of it, so it keeps a consistent view
+     * while other children commit, and commits into the parent itself.
+     */
+    ChildStore(std::shared_ptr<ParentStore> parent, std::shared_ptr<StoreSnapshot> parentSnapshot);
+    /**
+     * Nested child: it starts sharing the overlay of its parent child, so creating it is O(1),
+     * and reads the parent store snapshot directly, so reads cost the same at any depth.
+     */
+    explicit ChildStore(std::shared_ptr<ChildStore> parentChild);
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
     void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
     void update(std::int64_t id, const TodoProperties& properties) override;
     TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
     void remove(std::int64_t id) override;
     bool checkId(std::int64_t id) const override;
-    std::unordered_set<std::int64_t> query(const TodoProperty& property) const override;
-    std::unordered_set<std::int64_t> rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    /**
+     * The child must be owned by a std::shared_ptr, the nested child keeps it alive to commit into it.
+     */
     std::unique_ptr<Store> createChild() override;
+    /**
+     * Throws CommitConflict, committing nothing, if a todo the child read or wrote, a title it queried
+     * or a timestamp range it queried was changed in the parent after the child was created
+     * (optimistic concurrency control). After committing, the child reads the new version of the parent.
+     * A nested child is validated the same way against its parent child, for the changes the parent child
+     * got since the nested child was created or last committed, and then reads its parent child again.
+     */
     void commit() override;
+    /**
+     * The containers of the discarded changes keep their capacity for the next transaction. A nested child
+     * discards the changes done since it was created or committed, and reads its parent child again.
+     */
+    void rollback() override;
+
+    /**
+     * Point of the changes of the child that rollbackTo goes back to.
+     */
+    struct Savepoint
+    {
+        std::uint64_t id;
+    };
+
+    /**
+     * From a savepoint on, the first change of every todo keeps the values the child had for it before
+     * (an undo log), so going back costs the todos changed since the savepoint, not the size of the child.
+     */
+    Savepoint savepoint();
+    /**
+     * Undoes the changes done since the savepoint, which can be rolled back to again. The savepoints taken
+     * after it are released, and so are all of them when the child commits or rolls back: rolling back to
+     * a released savepoint throws std::invalid_argument. The todos read meanwhile are still validated
+     * when committing.
+     */
+    void rollbackTo(const Savepoint& savepoint);
+
+    /**
+     * Throws CommitConflict if committing would conflict, without committing anything. Stores spanning
+     * several parents validate all their children before committing any of them.
+     */
+    void validateCommit() const;
+    /**
+     * Throws std::invalid_argument if a change of the child cannot be applied to the parent store (updating
+     * or removing a missing todo, inserting an incomplete one), without committing anything.
+     * The changes of a nested child are checked when the outermost child commits them.
+     */
+    void checkChanges() const;
 private:
+    friend class GroupCommit;
+    friend class ChildPool;
+
+    /**
+     * Every change of the child over the parent store, including the changes of the children
+     * it was created from. Nested children share it with their parent child until one of them
+     * writes (copy on write).
+     * Its containers are allocated from an arena of the parent store pool, released all at once
+     * with the overlay when the child commits or is discarded, and reused by the next child.
+     */
+    struct Overlay
+    {
+        explicit Overlay(ArenaPool::Lease arena);
+        /**
+         * Copy of the overlay of another child in a new arena.
+         */
+        Overlay(const Overlay& other, ArenaPool::Lease arena);
+
+        /**
+         * Keep the child title and timestamp indexes in sync with the child version of a todo
+         */
+        void insertChildIds(const TodoPatch& patch, std::int64_t id);
+        void removeChildIds(const TodoPatch& patch, std::int64_t id);
+
+        /**
+         * The parent title and timestamp (the ones in the properties mask) of a todo the child overwrites
+         * or removes must not be found when querying the child. Hiding them does not read the parent,
+         * they are looked up in a single pass once a query needs them (or removed by the parent when committing).
+         */
+        void hideParentValues(std::int64_t id, std::uint8_t properties);
+        void resolveHiddenParentValues(const StoreSnapshot& parent);
+        /**
+         * Whether the parent value of the property is hidden and was not looked up yet. Queries check it
+         * for the parent ids of their title or range only, instead of looking every hidden value up.
+         */
+        bool hidesParentValue(std::int64_t id, TodoPropertyId property) const;
+        /**
+         * Mask of the parent values the child hides for the todo, looked up or not: every indexed value
+         * of the todos it inserts or removes, the updated ones otherwise.
+         */
+        std::uint8_t hiddenParentValues(std::int64_t id) const;
+
+        /**
+         * Declared first, so it is released after the containers using it are destroyed.
+         */
+        ArenaPool::Lease arena;
+
+        /**
+         * Keep the todos in maps so the actual operations will be performance
+         * in the todos of the parent when committing the child.
+         * Inserted todos are complete patches, updated ones only have the properties changed in the child.
+         * */
+        FlatIdMap<TodoPatch> todosToBeInserted{arena.get()};
+        FlatIdMap<TodoPatch> propertiesToBeUpdated{arena.get()};
+        std::pmr::unordered_set<std::int64_t> todosToBeRemoved{arena.get()};
+        /**
+         * Keep a list of ids for improving queries performance.
+         * titleIds and timestampIds hold the current child values of the inserted and updated todos,
+         * the old ones hold the parent values hidden by the child, so both can be applied
+         * while iterating the parent query results.
+         */
+        StringPropertyIds titleIds{arena.get()};
+        DoublePropertyIds timestampIds{arena.get()};
+        StringPropertyIds oldTitleIdsToBeUpdated{arena.get()};
+        DoublePropertyIds oldTimestampIdsToBeUpdated{arena.get()};
+        /**
+         * Ids whose parent values are hidden but not looked up yet, with the mask of the properties to hide.
+         */
+        FlatIdMap<std::uint8_t> parentValuesToHide{arena.get()};
+    };
+
+    static constexpr std::uint8_t indexedProperties{propertyBit(TodoPropertyId::title) |
+                                                    propertyBit(TodoPropertyId::timestamp)};
+
     /**
-     * Keep the todos in maps so the actual operations will be performance
-     * in the todos of the parent when committing the child
-     * */
-    std::unordered_map<std::int64_t, TodoProperties> todosToBeInserted;
-    std::unordered_map<std::int64_t, TodoProperties> propertiesToBeUpdated;
-    std::unordered_set<std::int64_t> todosToBeRemoved;
-    std::shared_ptr<Store> parent;
+     * Overlay with the hidden parent values already looked up, for the counts that need them.
+     */
+    const Overlay& resolvedOverlay() const;
     /**
-     * Keep a list of ids for improving queries performance
+     * Whether a count of parentCount parent ids looks every hidden value up (then it is counted from the
+     * child indexes) or checks the parent ids one by one, whichever touches less ids.
      */
-    StringPropertyIds titleIds;
-    DoublePropertyIds timestampIds;
-    std::unordered_map<std::string, std::unordered_set<std::int64_t>> oldTitleIdsToBeUpdated;
-    std::multimap<double, std::int64_t> oldTimestampIdsToBeUpdated;
-};
+    bool lookUpHiddenValues(std::size_t parentCount) const;
+    /**
+     * Whether a parent id of the range is hidden by the child (its parent timestamp is in the range).
+     */
+    std::function<bool(std::int64_t)> hiddenInRange(double minTimeStamp, double maxTimeStamp) const;
+
+    /**
+     * Overlay to be modified, copied first if it is still shared with another child.
+     * The id is recorded as changed by this child, to be replayed if the parent child changed meanwhile,
+     * and its values logged to be undone if it is its first change since the last savepoint.
+     */
+    Overlay& writableOverlay(std::int64_t changedId);
+    Overlay& ownOverlay();
 
+    /**
+     * Values the child had for a todo before its first change since a savepoint.
+     */
+    struct UndoEntry
+    {
+        std::int64_t id;
+        std::optional<TodoPatch> inserted;
+        std::optional<TodoPatch> updated;
+        bool removed;
+        bool changed;
+    };
+
+    void logChange(std::int64_t id);
+    /**
+     * Puts the todo back as it was in the entry, finding again the parent values hidden since then.
+     */
+    void undo(const UndoEntry& entry);
+    void releaseSavepoints();
+
+    /**
+     * Folds the overlay of a nested child into its parent child
+     */
+    void commitIntoParentChild();
+    /**
+     * Throws CommitConflict if a todo the nested child read or wrote, a title or a timestamp range it queried
+     * is not the same in its parent child than in the overlay it forked, read over its own snapshot.
+     */
+    void validateParentChildCommit() const;
+    /**
+     * The todo as a child with the overlay over the snapshot reads it, none if it does not exist there.
+     */
+    static std::optional<Todo> readTodo(const Overlay& overlay, const StoreSnapshot& snapshot, std::int64_t id);
+
+    /**
+     * Every pending change and the parent index entries it removes and adds, read from the overlay.
+     * The delta points into the overlay, so it is valid until the child changes.
+     */
+    CommitDelta delta() const;
+
+    /**
+     * Group commit steps: the validation against the commits accepted before in the group
+     * and the writes the next ones are validated against.
+     */
+    void validateGroupCommit(const GroupWrites& earlierWrites) const;
+    void addGroupWrites(GroupWrites& writes) const;
+
+    /**
+     * Once committed, the child goes on as a new transaction over the new version of the parent.
+     */
+    void restart();
+
+    /**
+     * Empty overlay in an arena taken from the parent store pool.
+     */
+    std::shared_ptr<Overlay> newOverlay() const;
+
+    /**
+     * Discards the overlay. If no nested child shares it, its containers are built again in its arena,
+     * once reset, with the capacity they had, so the next changes are written in memory already allocated.
+     */
+    void clearOverlay();
 
+    /**
+     * A child kept idle in a ChildPool is rolled back and detached from its parent store, so it neither
+     * pins old versions of the parent nor keeps it alive, until it is reused over the latest version.
+     */
+    void reset();
+    void reuse(std::shared_ptr<ParentStore> parent, std::shared_ptr<StoreSnapshot> parentSnapshot);
 
+    /**
+     * Store the child commits into, and the snapshot of it the child reads from. Nested children read
+     * the same snapshot than their parent child, their overlay already has the changes of every child between them.
+     */
+    std::shared_ptr<ParentStore> parent;
+    std::shared_ptr<StoreSnapshot> parentSnapshot;
+    /**
+     * What the child read from the parent snapshot, the todos it wrote are in the overlay.
+     */
+    mutable ReadSet readSet;
+    /**
+     * Parent child of a nested child, the overlay it had when the child was created
+     * and the ids this child changed since then.
+     */
+    std::shared_ptr<ChildStore> parentChild;
+    std::shared_ptr<const Overlay> forkedOverlay;
+    IdSet changedIds;
+    std::shared_ptr<Overlay> overlay;
+    /**
+     * Savepoints alive (id and undo log size when taken), the undo log since the first one,
+     * and the ids logged since the last one.
+     */
+    std::vector<std::pair<std::uint64_t, std::size_t>> savepoints;
+    std::uint64_t nextSavepointId{0};
+    std::vector<UndoEntry> undoLog;
+    IdSet loggedIds;
+    /**
+     * Reused by getMany to ask the parent for all the ids the child does not resolve in a single call
+     */
+    mutable std::vector<std::int64_t> parentIds;
+    mutable std::vector<std::size_t> parentPositions;
+    mutable std::vector<std::optional<Todo>> parentTodos;
+};
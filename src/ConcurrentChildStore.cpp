@@ -0,0 +1,459 @@
+#include <array>
+#include <mutex>
+#include <stdexcept>
+#include "ConcurrentChildStore.h"
+
+namespace
+{
+    bool sameTodo(const std::optional<Todo>& todo, const std::optional<Todo>& other)
+    {
+        if(not todo or not other)
+        {
+            return todo.has_value() == other.has_value();
+        }
+        return todo->title == other->title and todo->description == other->description and
+               todo->timestamp == other->timestamp;
+    }
+
+    template<typename PostingList>
+    bool sameIds(const PostingList& ids, const PostingList& otherIds)
+    {
+        // a posting list changed since is a new version, whatever its ids
+        if(ids.sameVersion(otherIds))
+        {
+            return true;
+        }
+        if(ids.size() not_eq otherIds.size())
+        {
+            return false;
+        }
+        for(const auto& entry : ids)
+        {
+            if(not otherIds.contains(entry.first))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool sameRange(const PersistentTimestampTree& entries, const PersistentTimestampTree& otherEntries,
+                   double minTimeStamp, double maxTimeStamp)
+    {
+        if(entries.sameVersion(otherEntries))
+        {
+            return true;
+        }
+        if(entries.count(minTimeStamp, maxTimeStamp) not_eq otherEntries.count(minTimeStamp, maxTimeStamp))
+        {
+            return false;
+        }
+        auto entry{entries.lowerBound(minTimeStamp)};
+        const auto last{entries.upperBound(maxTimeStamp)};
+        auto otherEntry{otherEntries.lowerBound(minTimeStamp)};
+        for(; entry not_eq last; ++entry, ++otherEntry)
+        {
+            if(*entry not_eq *otherEntry)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    CommitConflict todoConflict(std::int64_t id, const std::string& by)
+    {
+        return CommitConflict("Todo with id "+std::to_string(id)+" was changed by "+by);
+    }
+
+    CommitConflict titleConflict(const std::string& title, const std::string& by)
+    {
+        return CommitConflict("Todos with title "+title+" were changed by "+by);
+    }
+
+    CommitConflict rangeConflict(const std::pair<double, double>& range, const std::string& by)
+    {
+        return CommitConflict("Todos with timestamp between "+std::to_string(range.first)+" and "+
+                              std::to_string(range.second)+" were changed by "+by);
+    }
+}
+
+ConcurrentChildStore::ConcurrentChildStore(std::shared_ptr<ConcurrentParentStore> parent)
+        : parent{std::move(parent)}
+{
+}
+
+ConcurrentChildStore::ConcurrentChildStore(std::shared_ptr<ConcurrentChildStore> parentChild)
+        : parent{parentChild->parent}, parentChild{std::move(parentChild)}
+{
+    restart();
+}
+
+void ConcurrentChildStore::insert(std::int64_t id, TodoPatch patch)
+{
+    if(not patch.complete())
+    {
+        throw std::invalid_argument("Missing properties when inserting a todo in the store. "
+                                    "Please review that all properties are specified");
+    }
+    // the todo it replaces is read too, so its old index entries are known and validated
+    read(id);
+    writtenTodos.insert_or_assign(id, Todo{id, std::move(patch.title), std::move(patch.description),
+                                           patch.timestamp});
+    ++writeCount;
+}
+
+void ConcurrentChildStore::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void ConcurrentChildStore::insertBatch(const std::vector<Todo>& batch)
+{
+    for(const auto& todo : batch)
+    {
+        insert(todo.id, TodoPatch::fromTodo(todo));
+    }
+}
+
+void ConcurrentChildStore::update(std::int64_t id, const TodoPatch& patch)
+{
+    const auto& todo{read(id)};
+    if(not todo)
+    {
+        throw std::invalid_argument("Error updating properties. "
+                                    "Todo with id "+std::to_string(id)+" not found");
+    }
+    // copied before writing, the todo may be in the written ones
+    auto updatedTodo{*todo};
+    patch.applyTo(updatedTodo);
+    writtenTodos.insert_or_assign(id, std::move(updatedTodo));
+    ++writeCount;
+}
+
+void ConcurrentChildStore::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void ConcurrentChildStore::get(std::int64_t id, Todo& todo) const
+{
+    const auto& found{read(id)};
+    if(not found)
+    {
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
+    }
+    todo = *found;
+}
+
+TodoProperties ConcurrentChildStore::get(std::int64_t id) const
+{
+    Todo todo;
+    get(id, todo);
+    return toProperties(todo);
+}
+
+void ConcurrentChildStore::getMany(const std::vector<std::int64_t>& ids,
+                                   std::vector<std::optional<Todo>>& result) const
+{
+    result.resize(ids.size());
+    for(std::size_t i{0}; i < ids.size(); ++i)
+    {
+        result[i] = read(ids[i]);
+    }
+}
+
+void ConcurrentChildStore::remove(std::int64_t id)
+{
+    if(not read(id))
+    {
+        throw std::invalid_argument("Error removing todo. "
+                                    "Todo with id "+std::to_string(id)+" not found");
+    }
+    writtenTodos.insert_or_assign(id, std::nullopt);
+    ++writeCount;
+}
+
+bool ConcurrentChildStore::checkId(std::int64_t id) const
+{
+    return read(id).has_value();
+}
+
+IdRange ConcurrentChildStore::query(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return {};
+    }
+    const auto titleIds{childTitleIds(std::get<std::string>(property.second))};
+    std::vector<std::int64_t> ids;
+    ids.reserve(titleIds.size());
+    for(const auto& entry : titleIds)
+    {
+        ids.push_back(entry.first);
+    }
+    return makeOwningIdRange(std::move(ids));
+}
+
+IdRange ConcurrentChildStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    if(maxTimeStamp < minTimeStamp)
+    {
+        return {};
+    }
+    readRanges.emplace(minTimeStamp, maxTimeStamp);
+    const auto entries{childTimestamps()};
+    std::vector<std::int64_t> ids;
+    const auto last{entries.upperBound(maxTimeStamp)};
+    for(auto entry{entries.lowerBound(minTimeStamp)}; entry not_eq last; ++entry)
+    {
+        ids.push_back(entry->id);
+    }
+    return makeOwningIdRange(std::move(ids));
+}
+
+RangePage ConcurrentChildStore::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                                  std::size_t limit, const RangeCursor& cursor) const
+{
+    readRanges.emplace(minTimeStamp, maxTimeStamp);
+    const auto entries{childTimestamps()};
+    return readOrderedPage(entries, minTimeStamp, maxTimeStamp, limit, cursor);
+}
+
+std::size_t ConcurrentChildStore::queryCount(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return 0;
+    }
+    return childTitleIds(std::get<std::string>(property.second)).size();
+}
+
+std::size_t ConcurrentChildStore::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    readRanges.emplace(minTimeStamp, maxTimeStamp);
+    return childTimestamps().count(minTimeStamp, maxTimeStamp);
+}
+
+std::unique_ptr<Store> ConcurrentChildStore::createChild()
+{
+    return std::make_unique<ConcurrentChildStore>(
+            std::static_pointer_cast<ConcurrentChildStore>(shared_from_this()));
+}
+
+void ConcurrentChildStore::commit()
+{
+    if(parentChild)
+    {
+        commitIntoParentChild();
+        restart();
+        return;
+    }
+
+    {
+        // the written todos were read too. Partitions are always locked in the same order,
+        // so children committing at the same time do not deadlock
+        std::array<bool, ConcurrentParentStore::partitionCount> readPartitions{};
+        for(const auto& todo : readTodos)
+        {
+            readPartitions[ConcurrentParentStore::partitionIndex(todo.first)] = true;
+        }
+        const auto indexesRead{not readTitleIds.empty() or readTimestamps};
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for(std::size_t index{0}; index < readPartitions.size(); ++index)
+        {
+            if(indexesRead or readPartitions[index])
+            {
+                locks.emplace_back(parent->partitions[index].writerMutex);
+            }
+        }
+
+        validate();
+        for(const auto& todo : writtenTodos)
+        {
+            auto& todoPartition{parent->partition(todo.first)};
+            if(todo.second)
+            {
+                parent->put(todoPartition, std::make_unique<const Todo>(*todo.second));
+            } else
+            {
+                parent->erase(todoPartition, todo.first);
+            }
+        }
+    }
+    restart();
+}
+
+void ConcurrentChildStore::rollback()
+{
+    restart();
+}
+
+const std::optional<Todo>& ConcurrentChildStore::read(std::int64_t id) const
+{
+    const auto written{writtenTodos.find(id)};
+    if(written not_eq writtenTodos.end())
+    {
+        return written->second;
+    }
+    const auto found{readTodos.try_emplace(id)};
+    auto& todo{found.first->second};
+    if(found.second)
+    {
+        Todo parentTodo;
+        if(parent->find(id, parentTodo))
+        {
+            todo = std::move(parentTodo);
+        }
+    }
+    return todo;
+}
+
+ConcurrentChildStore::PostingList ConcurrentChildStore::childTitleIds(const std::string& title) const
+{
+    auto readIds{readTitleIds.find(title)};
+    if(readIds == readTitleIds.end())
+    {
+        readIds = readTitleIds.emplace(title, parent->copyTitleIds(title)).first;
+    }
+    // Complexity O(1) for the copy, the written todos path-copy the nodes they change
+    auto ids{readIds->second};
+    for(const auto& todo : writtenTodos)
+    {
+        ids.erase(todo.first);
+        if(todo.second and todo.second->title == title)
+        {
+            ids[todo.first];
+        }
+    }
+    return ids;
+}
+
+PersistentTimestampTree ConcurrentChildStore::childTimestamps() const
+{
+    if(not readTimestamps)
+    {
+        readTimestamps = parent->copyTimestamps();
+    }
+    auto entries{*readTimestamps};
+    for(const auto& todo : writtenTodos)
+    {
+        // every written todo was read first
+        const auto& readTodo{readTodos.at(todo.first)};
+        if(readTodo)
+        {
+            entries.erase({readTodo->timestamp, todo.first});
+        }
+        if(todo.second)
+        {
+            entries.insert({todo.second->timestamp, todo.first});
+        }
+    }
+    return entries;
+}
+
+void ConcurrentChildStore::restart()
+{
+    if(parentChild)
+    {
+        writtenTodos = parentChild->writtenTodos;
+        readTodos = parentChild->readTodos;
+        readTitleIds = parentChild->readTitleIds;
+        readTimestamps = parentChild->readTimestamps;
+        readRanges = parentChild->readRanges;
+        forkedWriteCount = parentChild->writeCount;
+        return;
+    }
+    writtenTodos = {};
+    readTodos = {};
+    readTitleIds.clear();
+    readTimestamps.reset();
+    readRanges.clear();
+}
+
+void ConcurrentChildStore::validate() const
+{
+    const std::string by{"another commit"};
+    for(const auto& todo : readTodos)
+    {
+        std::optional<Todo> current{std::in_place};
+        if(not parent->find(todo.first, *current))
+        {
+            current.reset();
+        }
+        if(not sameTodo(todo.second, current))
+        {
+            throw todoConflict(todo.first, by);
+        }
+    }
+    for(const auto& ids : readTitleIds)
+    {
+        if(not sameIds(ids.second, parent->copyTitleIds(ids.first)))
+        {
+            throw titleConflict(ids.first, by);
+        }
+    }
+    if(readTimestamps)
+    {
+        const auto entries{parent->copyTimestamps()};
+        for(const auto& range : readRanges)
+        {
+            if(not sameRange(*readTimestamps, entries, range.first, range.second))
+            {
+                throw rangeConflict(range, by);
+            }
+        }
+    }
+}
+
+void ConcurrentChildStore::commitIntoParentChild()
+{
+    auto& target{*parentChild};
+    if(target.writeCount not_eq forkedWriteCount)
+    {
+        throw CommitConflict("The parent child was written after the nested child was created");
+    }
+
+    // what both read after the nested child was created must be the same, it is all validated by the parent child
+    const std::string by{"the parent child"};
+    for(const auto& todo : readTodos)
+    {
+        const auto targetTodo{target.readTodos.find(todo.first)};
+        if(targetTodo not_eq target.readTodos.end() and not sameTodo(targetTodo->second, todo.second))
+        {
+            throw todoConflict(todo.first, by);
+        }
+    }
+    for(const auto& ids : readTitleIds)
+    {
+        const auto targetIds{target.readTitleIds.find(ids.first)};
+        if(targetIds not_eq target.readTitleIds.end() and not sameIds(targetIds->second, ids.second))
+        {
+            throw titleConflict(ids.first, by);
+        }
+    }
+    if(readTimestamps and target.readTimestamps)
+    {
+        for(const auto& range : readRanges)
+        {
+            if(not sameRange(*readTimestamps, *target.readTimestamps, range.first, range.second))
+            {
+                throw rangeConflict(range, by);
+            }
+        }
+    }
+
+    for(const auto& todo : readTodos)
+    {
+        target.readTodos.try_emplace(todo.first, todo.second);
+    }
+    target.readTitleIds.insert(readTitleIds.begin(), readTitleIds.end());
+    if(not target.readTimestamps)
+    {
+        target.readTimestamps = readTimestamps;
+    }
+    target.readRanges.insert(readRanges.begin(), readRanges.end());
+    // the written todos of the nested child are the ones of the parent child plus its own
+    target.writtenTodos = std::move(writtenTodos);
+    ++target.writeCount;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "Store.h"
+#include "FlatIdMap.h"
+#include "ConcurrentParentStore.h"
+
+/**
+ * Responsibility: a transaction over a ConcurrentParentStore (or over another concurrent child).
+ *
+ * The child keeps the todos it writes and reads the rest from the store as it is when first read:
+ * a todo, the ids of a title or the timestamp index are remembered the first time they are read
+ * (the indexes as O(1) copies of their published versions), so the child reads them the same way until
+ * it commits, with its own writes applied on top. Updating or removing a todo that does not exist throws
+ * std::invalid_argument right away.
+ * Committing locks the partitions of the todos read (every partition if a title or a range was queried,
+ * so no writer changes the indexes meanwhile), validates that everything read is still the same in
+ * the store (optimistic concurrency control, CommitConflict committing nothing) and writes the todos.
+ * Like the other children, a child is used by one thread at a time.
+ */
+class ConcurrentChildStore: public Store
+{
+public:
+    explicit ConcurrentChildStore(std::shared_ptr<ConcurrentParentStore> parent);
+    /**
+     * Nested child, it starts as a copy of its parent child and commits into it.
+     */
+    explicit ConcurrentChildStore(std::shared_ptr<ConcurrentChildStore> parentChild);
+
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
+    void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
+    void update(std::int64_t id, const TodoProperties& properties) override;
+    TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
+    void remove(std::int64_t id) override;
+    bool checkId(std::int64_t id) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    /**
+     * The child must be owned by a std::shared_ptr, the nested child keeps it alive to commit into it.
+     */
+    std::unique_ptr<Store> createChild() override;
+    /**
+     * A nested child replaces the todos written by its parent child with its own, which include them, and
+     * adds what it read to what the parent child read. It throws CommitConflict if the parent child wrote
+     * after the nested child was created, or read something else than it. After committing, the child goes on
+     * without changes nor reads.
+     */
+    void commit() override;
+    void rollback() override;
+
+private:
+    using PostingList = ConcurrentParentStore::PostingList;
+
+    /**
+     * The todo as the child reads it, empty if it does not exist. Complexity O(1)
+     */
+    const std::optional<Todo>& read(std::int64_t id) const;
+
+    /**
+     * The ids of the title and the timestamp index as the child reads them, with its writes applied.
+     * Complexity O(k log n) for k todos written by the child.
+     */
+    PostingList childTitleIds(const std::string& title) const;
+    PersistentTimestampTree childTimestamps() const;
+
+    /**
+     * Goes on without changes nor reads, or as a copy of the parent child for a nested one.
+     */
+    void restart();
+
+    /**
+     * Throws CommitConflict if a todo, a title or a timestamp range read by the child is not the same
+     * in the store anymore. The partitions must be locked.
+     */
+    void validate() const;
+    void commitIntoParentChild();
+
+    std::shared_ptr<ConcurrentParentStore> parent;
+    std::shared_ptr<ConcurrentChildStore> parentChild;
+    /**
+     * Every todo written by the child as it is now, empty if it was removed.
+     */
+    FlatIdMap<std::optional<Todo>> writtenTodos;
+    /**
+     * Every todo read from the store as it was then, the written ones included.
+     */
+    mutable FlatIdMap<std::optional<Todo>> readTodos;
+    mutable std::unordered_map<std::string, PostingList> readTitleIds;
+    mutable std::optional<PersistentTimestampTree> readTimestamps;
+    mutable std::set<std::pair<double, double>> readRanges;
+    /**
+     * Number of writes of the child, nested commits included, and the one of the parent child
+     * when this nested child was created.
+     */
+    std::uint64_t writeCount{0};
+    std::uint64_t forkedWriteCount{0};
+};
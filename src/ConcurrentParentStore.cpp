@@ -0,0 +1,521 @@
+#include <functional>
+#include <stdexcept>
+#include "ConcurrentParentStore.h"
+#include "ConcurrentChildStore.h"
+
+namespace
+{
+    // tombstone left by removed records, only its address is used
+    const Todo removedRecord{};
+
+    void copyRecord(const Todo& record, Todo& todo)
+    {
+        todo.id = record.id;
+        todo.title = record.title;
+        todo.description = record.description;
+        todo.timestamp = record.timestamp;
+    }
+}
+
+ConcurrentParentStore::RecordTable::RecordTable(std::size_t capacity)
+        : mask{capacity - 1}, records{std::make_unique<std::atomic<const Todo*>[]>(capacity)}
+{
+    for(std::size_t index{0}; index < capacity; ++index)
+    {
+        records[index].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentParentStore::ConcurrentParentStore()
+{
+    for(auto& todoPartition : partitions)
+    {
+        todoPartition.table.store(new RecordTable{minTableCapacity});
+    }
+    for(auto& stripe : titleStripes)
+    {
+        stripe.titles.store(new TitleMap{});
+    }
+    timestamps.entries.store(new PersistentTimestampTree{});
+}
+
+ConcurrentParentStore::~ConcurrentParentStore()
+{
+    // nobody can be reading anymore, the retired objects are freed by the retire lists
+    for(auto& todoPartition : partitions)
+    {
+        const auto* table{todoPartition.table.load()};
+        for(std::size_t index{0}; index <= table->mask; ++index)
+        {
+            const auto* record{table->records[index].load()};
+            if(record not_eq &removedRecord)
+            {
+                delete record;
+            }
+        }
+        delete table;
+    }
+    for(auto& stripe : titleStripes)
+    {
+        delete stripe.titles.load();
+    }
+    delete timestamps.entries.load();
+}
+
+void ConcurrentParentStore::insert(std::int64_t id, TodoPatch patch)
+{
+    if(not patch.complete())
+    {
+        throw std::invalid_argument("Missing properties when inserting a todo in the store. "
+                                    "Please review that all properties are specified");
+    }
+
+    auto& todoPartition{partition(id)};
+    std::unique_lock lock{todoPartition.writerMutex};
+    put(todoPartition, std::make_unique<const Todo>(Todo{id, std::move(patch.title), std::move(patch.description),
+                                                         patch.timestamp}));
+}
+
+void ConcurrentParentStore::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void ConcurrentParentStore::insertBatch(const std::vector<Todo>& batch)
+{
+    // every todo locks its own partition, so other threads keep reading and writing the rest while loading
+    for(const auto& todo : batch)
+    {
+        insert(todo.id, TodoPatch::fromTodo(todo));
+    }
+}
+
+void ConcurrentParentStore::update(std::int64_t id, const TodoPatch& patch)
+{
+    auto& todoPartition{partition(id)};
+    std::unique_lock lock{todoPartition.writerMutex};
+    const auto* oldRecord{findRecord(*todoPartition.table.load(std::memory_order_relaxed), id)};
+    if(not oldRecord)
+    {
+        throw std::invalid_argument("Error updating properties. "
+                                    "Todo with id "+std::to_string(id)+" not found");
+    }
+
+    // records are never changed in place, readers may be copying the old one
+    auto record{std::make_unique<Todo>(*oldRecord)};
+    // the indexes are only touched when the value changes
+    if(patch.has(TodoPropertyId::title) and patch.title not_eq oldRecord->title)
+    {
+        unindexTitle(oldRecord->title, id);
+        record->title = patch.title;
+        indexTitle(record->title, id);
+    }
+    if(patch.has(TodoPropertyId::description))
+    {
+        record->description = patch.description;
+    }
+    if(patch.has(TodoPropertyId::timestamp) and patch.timestamp not_eq oldRecord->timestamp)
+    {
+        updateTimestamp(oldRecord->timestamp, patch.timestamp, id);
+        record->timestamp = patch.timestamp;
+    }
+    publishRecord(todoPartition, std::move(record));
+    todoPartition.retired.retire(oldRecord);
+}
+
+void ConcurrentParentStore::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void ConcurrentParentStore::get(std::int64_t id, Todo& todo) const
+{
+    if(not find(id, todo))
+    {
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
+    }
+}
+
+TodoProperties ConcurrentParentStore::get(std::int64_t id) const
+{
+    Todo todo;
+    get(id, todo);
+    return toProperties(todo);
+}
+
+void ConcurrentParentStore::getMany(const std::vector<std::int64_t>& ids,
+                                    std::vector<std::optional<Todo>>& result) const
+{
+    result.resize(ids.size());
+    const ReadEpoch epoch;
+    for(std::size_t i{0}; i < ids.size(); ++i)
+    {
+        const auto id{ids[i]};
+        const auto* record{findRecord(*partition(id).table.load(std::memory_order_acquire), id)};
+        auto& todo{result[i]};
+        if(not record)
+        {
+            todo.reset();
+            continue;
+        }
+        if(not todo)
+        {
+            todo.emplace();
+        }
+        copyRecord(*record, *todo);
+    }
+}
+
+void ConcurrentParentStore::remove(std::int64_t id)
+{
+    auto& todoPartition{partition(id)};
+    std::unique_lock lock{todoPartition.writerMutex};
+    if(not erase(todoPartition, id))
+    {
+        throw std::invalid_argument("Error removing todo. "
+                                    "Todo with id "+std::to_string(id)+" not found");
+    }
+}
+
+bool ConcurrentParentStore::checkId(std::int64_t id) const
+{
+    const ReadEpoch epoch;
+    return findRecord(*partition(id).table.load(std::memory_order_acquire), id);
+}
+
+IdRange ConcurrentParentStore::query(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return {};
+    }
+    const ReadEpoch epoch;
+    const auto* ids{findTitleIds(std::get<std::string>(property.second))};
+    if(not ids)
+    {
+        return {};
+    }
+    // the ids are copied, the epoch is released before they are read
+    std::vector<std::int64_t> titleIds;
+    titleIds.reserve(ids->size());
+    for(const auto& entry : *ids)
+    {
+        titleIds.push_back(entry.first);
+    }
+    return makeOwningIdRange(std::move(titleIds));
+}
+
+IdRange ConcurrentParentStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    if(maxTimeStamp < minTimeStamp)
+    {
+        return {};
+    }
+    std::vector<std::int64_t> ids;
+    const ReadEpoch epoch;
+    const auto& entries{*timestamps.entries.load(std::memory_order_acquire)};
+    const auto last{entries.upperBound(maxTimeStamp)};
+    for(auto entry{entries.lowerBound(minTimeStamp)}; entry not_eq last; ++entry)
+    {
+        ids.push_back(entry->id);
+    }
+    return makeOwningIdRange(std::move(ids));
+}
+
+RangePage ConcurrentParentStore::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                                   std::size_t limit, const RangeCursor& cursor) const
+{
+    const ReadEpoch epoch;
+    return readOrderedPage(*timestamps.entries.load(std::memory_order_acquire), minTimeStamp, maxTimeStamp,
+                           limit, cursor);
+}
+
+std::size_t ConcurrentParentStore::queryCount(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return 0;
+    }
+    const ReadEpoch epoch;
+    const auto* ids{findTitleIds(std::get<std::string>(property.second))};
+    return ids ? ids->size() : 0;
+}
+
+std::size_t ConcurrentParentStore::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    const ReadEpoch epoch;
+    return timestamps.entries.load(std::memory_order_acquire)->count(minTimeStamp, maxTimeStamp);
+}
+
+std::unique_ptr<Store> ConcurrentParentStore::createChild()
+{
+    return std::make_unique<ConcurrentChildStore>(
+            std::static_pointer_cast<ConcurrentParentStore>(shared_from_this()));
+}
+
+void ConcurrentParentStore::commit()
+{
+    throw std::runtime_error("Parent store cannot commit, only child stores can");
+}
+
+void ConcurrentParentStore::rollback()
+{
+    throw std::runtime_error("Parent store cannot roll back, only child stores can");
+}
+
+ConcurrentParentStore::Partition& ConcurrentParentStore::partition(std::int64_t id)
+{
+    return partitions[partitionIndex(id)];
+}
+
+const ConcurrentParentStore::Partition& ConcurrentParentStore::partition(std::int64_t id) const
+{
+    return partitions[partitionIndex(id)];
+}
+
+std::size_t ConcurrentParentStore::partitionIndex(std::int64_t id)
+{
+    // multiplicative hashing spreads consecutive ids over all the partitions, taking the high bits
+    return (std::uint64_t(id) * 0xC2B2AE3D27D4EB4FULL) >> (64 - partitionBits);
+}
+
+std::size_t ConcurrentParentStore::tableIndex(std::int64_t id)
+{
+    // another multiplier and the low bits, so the ids of a partition are still spread over its table
+    auto hash{std::uint64_t(id) * 0x9E3779B97F4A7C15ULL};
+    hash ^= hash >> 29;
+    return hash;
+}
+
+const Todo* ConcurrentParentStore::findRecord(const RecordTable& table, std::int64_t id)
+{
+    // Complexity O(1) on average, the table is at most half full
+    for(auto index{tableIndex(id) & table.mask};; index = (index + 1) & table.mask)
+    {
+        const auto* record{table.records[index].load(std::memory_order_acquire)};
+        if(not record)
+        {
+            return nullptr;
+        }
+        if(record not_eq &removedRecord and record->id == id)
+        {
+            return record;
+        }
+    }
+}
+
+const Todo* ConcurrentParentStore::publishRecord(Partition& partition, std::unique_ptr<const Todo> record)
+{
+    if((partition.usedEntries + 1) * 2 > partition.table.load(std::memory_order_relaxed)->mask + 1)
+    {
+        growTable(partition);
+    }
+    const auto& table{*partition.table.load(std::memory_order_relaxed)};
+    const auto id{record->id};
+    std::atomic<const Todo*>* firstRemoved{nullptr};
+    for(auto index{tableIndex(id) & table.mask};; index = (index + 1) & table.mask)
+    {
+        auto& entry{table.records[index]};
+        const auto* current{entry.load(std::memory_order_relaxed)};
+        if(not current)
+        {
+            // the id is not in the table, the first tombstone of the probing is reused if any
+            if(firstRemoved)
+            {
+                firstRemoved->store(record.release(), std::memory_order_release);
+            } else
+            {
+                entry.store(record.release(), std::memory_order_release);
+                ++partition.usedEntries;
+            }
+            ++partition.liveRecords;
+            return nullptr;
+        }
+        if(current == &removedRecord)
+        {
+            firstRemoved = firstRemoved ? firstRemoved : &entry;
+        } else if(current->id == id)
+        {
+            entry.store(record.release(), std::memory_order_release);
+            return current;
+        }
+    }
+}
+
+const Todo* ConcurrentParentStore::unpublishRecord(Partition& partition, std::int64_t id)
+{
+    const auto& table{*partition.table.load(std::memory_order_relaxed)};
+    for(auto index{tableIndex(id) & table.mask};; index = (index + 1) & table.mask)
+    {
+        auto& entry{table.records[index]};
+        const auto* current{entry.load(std::memory_order_relaxed)};
+        if(not current)
+        {
+            return nullptr;
+        }
+        if(current not_eq &removedRecord and current->id == id)
+        {
+            entry.store(&removedRecord, std::memory_order_release);
+            --partition.liveRecords;
+            return current;
+        }
+    }
+}
+
+void ConcurrentParentStore::growTable(Partition& partition)
+{
+    const auto* oldTable{partition.table.load(std::memory_order_relaxed)};
+    // the new table is a quarter full, so it takes many insertions before growing again
+    auto capacity{minTableCapacity};
+    while(capacity < (partition.liveRecords + 1) * 4)
+    {
+        capacity *= 2;
+    }
+    auto table{std::make_unique<RecordTable>(capacity)};
+    for(std::size_t oldIndex{0}; oldIndex <= oldTable->mask; ++oldIndex)
+    {
+        const auto* record{oldTable->records[oldIndex].load(std::memory_order_relaxed)};
+        if(not record or record == &removedRecord)
+        {
+            continue;
+        }
+        auto index{tableIndex(record->id) & table->mask};
+        while(table->records[index].load(std::memory_order_relaxed))
+        {
+            index = (index + 1) & table->mask;
+        }
+        table->records[index].store(record, std::memory_order_relaxed);
+    }
+    partition.usedEntries = partition.liveRecords;
+    // the records move to the new table as they are, only the old array of pointers is retired
+    partition.table.store(table.release(), std::memory_order_release);
+    partition.retired.retire(oldTable);
+}
+
+void ConcurrentParentStore::put(Partition& todoPartition, std::unique_ptr<const Todo> record)
+{
+    const auto id{record->id};
+    const auto& title{record->title};
+    const auto timestamp{record->timestamp};
+    const auto* oldRecord{publishRecord(todoPartition, std::move(record))};
+    if(oldRecord)
+    {
+        // the todo is overwritten, so the old values must not be found when querying anymore
+        unindexTitle(oldRecord->title, id);
+        unindexTimestamp(oldRecord->timestamp, id);
+        todoPartition.retired.retire(oldRecord);
+    }
+    indexTitle(title, id);
+    indexTimestamp(timestamp, id);
+}
+
+bool ConcurrentParentStore::erase(Partition& todoPartition, std::int64_t id)
+{
+    const auto* oldRecord{unpublishRecord(todoPartition, id)};
+    if(not oldRecord)
+    {
+        return false;
+    }
+    unindexTitle(oldRecord->title, id);
+    unindexTimestamp(oldRecord->timestamp, id);
+    todoPartition.retired.retire(oldRecord);
+    return true;
+}
+
+bool ConcurrentParentStore::find(std::int64_t id, Todo& todo) const
+{
+    const ReadEpoch epoch;
+    const auto* record{findRecord(*partition(id).table.load(std::memory_order_acquire), id)};
+    if(not record)
+    {
+        return false;
+    }
+    copyRecord(*record, todo);
+    return true;
+}
+
+ConcurrentParentStore::PostingList ConcurrentParentStore::copyTitleIds(const std::string& title) const
+{
+    const ReadEpoch epoch;
+    const auto* ids{findTitleIds(title)};
+    return ids ? *ids : PostingList{};
+}
+
+PersistentTimestampTree ConcurrentParentStore::copyTimestamps() const
+{
+    const ReadEpoch epoch;
+    return *timestamps.entries.load(std::memory_order_acquire);
+}
+
+ConcurrentParentStore::TitleStripe& ConcurrentParentStore::titleStripe(const std::string& title)
+{
+    return titleStripes[std::hash<std::string>{}(title) % titleStripeCount];
+}
+
+const ConcurrentParentStore::TitleStripe& ConcurrentParentStore::titleStripe(const std::string& title) const
+{
+    return titleStripes[std::hash<std::string>{}(title) % titleStripeCount];
+}
+
+const ConcurrentParentStore::PostingList* ConcurrentParentStore::findTitleIds(const std::string& title) const
+{
+    return titleStripe(title).titles.load(std::memory_order_acquire)->find(title);
+}
+
+void ConcurrentParentStore::indexTitle(const std::string& title, std::int64_t id)
+{
+    auto& stripe{titleStripe(title)};
+    std::unique_lock lock{stripe.writerMutex};
+    stripe.writerTitles[title][id];
+    publishTitles(stripe);
+}
+
+void ConcurrentParentStore::unindexTitle(const std::string& title, std::int64_t id)
+{
+    auto& stripe{titleStripe(title)};
+    std::unique_lock lock{stripe.writerMutex};
+    auto& ids{stripe.writerTitles[title]};
+    ids.erase(id);
+    if(ids.empty())
+    {
+        stripe.writerTitles.erase(title);
+    }
+    publishTitles(stripe);
+}
+
+void ConcurrentParentStore::publishTitles(TitleStripe& stripe)
+{
+    // the published version is a copy in O(1), the next write path-copies the nodes it shares with it
+    const auto* titles{stripe.titles.load(std::memory_order_relaxed)};
+    stripe.titles.store(new TitleMap{stripe.writerTitles}, std::memory_order_release);
+    stripe.retired.retire(titles);
+}
+
+void ConcurrentParentStore::indexTimestamp(double timestamp, std::int64_t id)
+{
+    std::unique_lock lock{timestamps.writerMutex};
+    timestamps.writerEntries.insert({timestamp, id});
+    publishTimestamps();
+}
+
+void ConcurrentParentStore::unindexTimestamp(double timestamp, std::int64_t id)
+{
+    std::unique_lock lock{timestamps.writerMutex};
+    timestamps.writerEntries.erase({timestamp, id});
+    publishTimestamps();
+}
+
+void ConcurrentParentStore::updateTimestamp(double oldTimestamp, double newTimestamp, std::int64_t id)
+{
+    std::unique_lock lock{timestamps.writerMutex};
+    timestamps.writerEntries.erase({oldTimestamp, id});
+    timestamps.writerEntries.insert({newTimestamp, id});
+    publishTimestamps();
+}
+
+void ConcurrentParentStore::publishTimestamps()
+{
+    const auto* entries{timestamps.entries.load(std::memory_order_relaxed)};
+    timestamps.entries.store(new PersistentTimestampTree{timestamps.writerEntries}, std::memory_order_release);
+    timestamps.retired.retire(entries);
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include "Store.h"
+#include "Epochs.h"
+#include "PersistentHashMap.h"
+#include "PersistentTimestampTree.h"
+
+/**
+ * Responsibility: a parent store shared by many threads.
+ *
+ * Reading takes no lock: every todo is an immutable record, and the primary index of every partition,
+ * the persistent title map of every stripe and the timestamp tree are published through atomic pointers.
+ * Writers build a new record (or index version, or a bigger table) and publish it, and the replaced
+ * one is freed through epoch-based reclamation once no reader can still be reading it, so readers only
+ * write their own epoch slot. Writers are serialized by the lock of the partition of their todo (and the
+ * lock of the title stripe they change), and keep the partition locked while they update the indexes, so
+ * the changes of a todo reach the indexes in the same order than the todo. The timestamp index is published
+ * the same way, as a persistent tree, so range queries and counts take no lock either.
+ * Query results are copied, so nothing is pinned once a query returns. A query may run between the
+ * change of a todo and the change of its indexes, changes are not atomic across partitions and indexes.
+ * Children (ConcurrentChildStore) keep their changes until they commit, see there how they are validated.
+ */
+class ConcurrentParentStore: public Store
+{
+public:
+    ConcurrentParentStore();
+    ~ConcurrentParentStore() override;
+    ConcurrentParentStore(const ConcurrentParentStore&) = delete;
+    ConcurrentParentStore& operator=(const ConcurrentParentStore&) = delete;
+
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
+    void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
+    void update(std::int64_t id, const TodoProperties& properties) override;
+    TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
+    void remove(std::int64_t id) override;
+    bool checkId(std::int64_t id) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    /**
+     * The store must be owned by a std::shared_ptr, the child keeps it alive to commit into it.
+     */
+    std::unique_ptr<Store> createChild() override;
+    void commit() override;
+    void rollback() override;
+
+private:
+    friend class ConcurrentChildStore;
+
+    static constexpr std::size_t partitionBits{6};
+    static constexpr std::size_t partitionCount{std::size_t{1} << partitionBits};
+    static constexpr std::size_t titleStripeCount{16};
+    static constexpr std::size_t minTableCapacity{16};
+
+    /**
+     * Open addressing table of records with linear probing. An empty entry ends the probing and removed
+     * records leave a tombstone, the table is replaced by a bigger one without tombstones when half full.
+     */
+    struct RecordTable
+    {
+        explicit RecordTable(std::size_t capacity);
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<const Todo*>[]> records;
+    };
+
+    /**
+     * Every partition lives in its own cache lines, so writers of neighbour partitions do not share them.
+     */
+    struct alignas(64) Partition
+    {
+        std::atomic<const RecordTable*> table;
+        std::mutex writerMutex;
+        // only read and written by the writer holding the lock
+        std::size_t liveRecords{0};
+        std::size_t usedEntries{0};
+        RetireList retired;
+    };
+
+    /**
+     * Value of the posting lists, only the ids are used.
+     */
+    struct Indexed
+    {
+    };
+    using PostingList = PersistentHashMap<std::int64_t, Indexed>;
+    using TitleMap = PersistentHashMap<std::string, PostingList>;
+
+    /**
+     * The writer changes its own version of the titles, which shares its nodes with the published ones,
+     * and publishes a copy of it: a write path-copies O(log n) nodes of the title map and of the posting
+     * list, instead of copying the whole posting list, or the whole map for a new title.
+     */
+    struct alignas(64) TitleStripe
+    {
+        std::atomic<const TitleMap*> titles;
+        std::mutex writerMutex;
+        // only read and written by the writer holding the lock
+        TitleMap writerTitles;
+        RetireList retired;
+    };
+
+    /**
+     * Published like the titles of a stripe: readers read the published tree in place under their epoch,
+     * a write path-copies O(log n) nodes of the writer version.
+     */
+    struct alignas(64) TimestampIndex
+    {
+        std::atomic<const PersistentTimestampTree*> entries;
+        std::mutex writerMutex;
+        // only read and written by the writer holding the lock
+        PersistentTimestampTree writerEntries;
+        RetireList retired;
+    };
+
+    static std::size_t partitionIndex(std::int64_t id);
+    static std::size_t tableIndex(std::int64_t id);
+    Partition& partition(std::int64_t id);
+    const Partition& partition(std::int64_t id) const;
+    TitleStripe& titleStripe(const std::string& title);
+    const TitleStripe& titleStripe(const std::string& title) const;
+
+    /**
+     * Returns nullptr if the id is not in the table. Readers must have pinned an epoch.
+     */
+    static const Todo* findRecord(const RecordTable& table, std::int64_t id);
+
+    /**
+     * Record and table replacements, the partition must be locked. They return the replaced record
+     * (or nullptr), which must be retired once it is not needed anymore.
+     */
+    static const Todo* publishRecord(Partition& partition, std::unique_ptr<const Todo> record);
+    static const Todo* unpublishRecord(Partition& partition, std::int64_t id);
+    static void growTable(Partition& partition);
+
+    /**
+     * Todo changes with their index updates, the partition must be locked. Removing returns false
+     * if the todo does not exist.
+     */
+    void put(Partition& partition, std::unique_ptr<const Todo> record);
+    bool erase(Partition& partition, std::int64_t id);
+
+    /**
+     * Copies the todo, false if it does not exist.
+     */
+    bool find(std::int64_t id, Todo& todo) const;
+
+    /**
+     * O(1) copies of the published ids of a title (empty if no todo has it) and timestamp index,
+     * which stay the same whatever is changed afterwards.
+     */
+    PostingList copyTitleIds(const std::string& title) const;
+    PersistentTimestampTree copyTimestamps() const;
+
+    /**
+     * Returns nullptr if no todo has the title. Readers must have pinned an epoch.
+     */
+    const PostingList* findTitleIds(const std::string& title) const;
+
+    /**
+     * Index updates, the partition of the todo must be locked.
+     */
+    void indexTitle(const std::string& title, std::int64_t id);
+    void unindexTitle(const std::string& title, std::int64_t id);
+    /**
+     * Publishes the version of the titles changed by the writer, the stripe must be locked.
+     */
+    static void publishTitles(TitleStripe& stripe);
+    void indexTimestamp(double timestamp, std::int64_t id);
+    void unindexTimestamp(double timestamp, std::int64_t id);
+    void updateTimestamp(double oldTimestamp, double newTimestamp, std::int64_t id);
+    /**
+     * Publishes the version of the timestamps changed by the writer, the timestamp index must be locked.
+     */
+    void publishTimestamps();
+
+    std::array<Partition, partitionCount> partitions;
+    std::array<TitleStripe, titleStripeCount> titleStripes;
+    TimestampIndex timestamps;
+};
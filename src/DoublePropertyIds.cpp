@@ -1,49 +1,139 @@
-
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
 #include "DoublePropertyIds.h"
 
+DoublePropertyIds::DoublePropertyIds(std::pmr::memory_resource* resource)
+        :propertyIds{resource}
+{
+}
+
+DoublePropertyIds::DoublePropertyIds(const DoublePropertyIds& other, std::pmr::memory_resource* resource)
+        :propertyIds{other.propertyIds, resource}
+{
+}
+
 void DoublePropertyIds::insert(double property, std::int64_t id)
 {
-    // logarithmic complexity Nlog(size+N) (implementations may optimize if the range is already sorted)
-    propertyIds[property].insert(id);
+    // logarithmic complexity O(log n)
+    propertyIds.insert({property, id});
 }
 
-std::unordered_set<std::int64_t> DoublePropertyIds::getRangeIds(double minValue, double maxValue) const
+void DoublePropertyIds::insert(std::vector<TimestampTree::Entry> entries)
 {
-    const auto& startIterator{propertyIds.lower_bound(minValue)};
-    const auto& endIterator{propertyIds.upper_bound(maxValue)};
+    std::sort(entries.begin(), entries.end()); // Complexity O(k log k)
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    insertSorted(entries.begin(), entries.end());
+}
+
+void DoublePropertyIds::insert(const DoublePropertyIds& other)
+{
+    insertSorted(other.propertyIds.begin(), other.propertyIds.end());
+}
 
-    std::unordered_set<std::int64_t> ids;
-    for(auto it=startIterator; it != endIterator; std::advance(it, 1))
+template<typename Iterator>
+void DoublePropertyIds::insertSorted(Iterator first, Iterator last)
+{
+    if(not mergeSorted(std::distance(first, last)))
     {
-        auto timeStampIds{it->second};
-        ids.merge(timeStampIds);
+        for(; first not_eq last; ++first)
+        {
+            propertyIds.insert(*first); // Complexity O(log n)
+        }
+        return;
     }
-    return ids;
+
+    // merge with the pairs already in the index and fill the leaves again, Complexity O(n + k)
+    std::vector<TimestampTree::Entry> mergedEntries;
+    mergedEntries.reserve(propertyIds.size() + std::distance(first, last));
+    std::set_union(propertyIds.begin(), propertyIds.end(), first, last, std::back_inserter(mergedEntries));
+    propertyIds.assignSorted(mergedEntries);
 }
 
-void DoublePropertyIds::updateProperty(double oldPropertyValue,
-                                       double newPropertyValue,
-                                       std::int64_t id)
+void DoublePropertyIds::remove(std::vector<TimestampTree::Entry> entries)
 {
-    remove(oldPropertyValue, id); // Best case O(1), worst case O(log n)
-    insert(newPropertyValue, id); // Complexity O(log n)
+    std::sort(entries.begin(), entries.end()); // Complexity O(k log k)
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    removeSorted(entries.begin(), entries.end());
 }
 
-void DoublePropertyIds::remove(double property, std::int64_t id)
+void DoublePropertyIds::remove(const DoublePropertyIds& other)
 {
-    // find has logarithmic complexity O(log n)
-    auto it{propertyIds.find(property)};
-    const auto propertyExists{it not_eq propertyIds.end()};
-    if(propertyExists)
+    removeSorted(other.propertyIds.begin(), other.propertyIds.end());
+}
+
+template<typename Iterator>
+void DoublePropertyIds::removeSorted(Iterator first, Iterator last)
+{
+    if(not mergeSorted(std::distance(first, last)))
     {
-        if (it->second.size() > 1)
-        {
-            it->second.erase(id); // Complexity O(1), worst case O(N)
-        } else
+        // in order, so the leaves are visited sequentially
+        for(; first not_eq last; ++first)
         {
-            propertyIds.erase(it); // Complexity O(1)
+            propertyIds.erase(*first); // Complexity O(log n)
         }
+        return;
     }
+
+    // Complexity O(n + k)
+    std::vector<TimestampTree::Entry> remainingEntries;
+    remainingEntries.reserve(propertyIds.size());
+    std::set_difference(propertyIds.begin(), propertyIds.end(), first, last, std::back_inserter(remainingEntries));
+    propertyIds.assignSorted(remainingEntries);
 }
 
+IdSet DoublePropertyIds::getRangeIds(double minValue, double maxValue) const
+{
+    // lower bound is O(log n), then the pairs in the range are read sequentially from the leaves
+    std::vector<std::int64_t> ids;
+    for(auto it{propertyIds.lowerBound(minValue)}; it not_eq propertyIds.end() and it->timestamp <= maxValue; ++it)
+    {
+        ids.push_back(it->id);
+    }
+    return IdSet::fromIds(std::move(ids));
+}
+
+IdRange DoublePropertyIds::getRange(double minValue, double maxValue) const
+{
+    if(maxValue < minValue)
+    {
+        return {};
+    }
+    // two bound searches O(log n), nothing is read until the range is iterated
+    return makeIdRange(propertyIds.lowerBound(minValue), propertyIds.upperBound(maxValue),
+                       [](const TimestampTree::Entry& entry) { return entry.id; });
+}
+
+RangePage DoublePropertyIds::getOrderedRange(double minValue, double maxValue, std::size_t limit,
+                                             const RangeCursor& cursor) const
+{
+    return readOrderedPage(propertyIds, minValue, maxValue, limit, cursor);
+}
+
+bool DoublePropertyIds::contains(double property, std::int64_t id) const
+{
+    // logarithmic complexity O(log n)
+    const TimestampTree::Entry entry{property, id};
+    const auto it{propertyIds.lowerBound(entry)};
+    return it not_eq propertyIds.end() and *it == entry;
+}
 
+std::size_t DoublePropertyIds::countRange(double minValue, double maxValue) const
+{
+    return propertyIds.count(minValue, maxValue);
+}
+
+void DoublePropertyIds::updateProperty(double oldPropertyValue,
+                                       double newPropertyValue,
+                                       std::int64_t id)
+{
+    remove(oldPropertyValue, id); // Complexity O(log n)
+    insert(newPropertyValue, id); // Complexity O(log n)
+}
+
+void DoublePropertyIds::remove(double property, std::int64_t id)
+{
+    // logarithmic complexity O(log n)
+    propertyIds.erase({property, id});
+}
@@ -1,7 +1,9 @@
 #pragma once
-#include <unordered_set>
-#include <unordered_map>
-#include <map>
+#include <cstdint>
+#include "IdRange.h"
+#include "IdSet.h"
+#include "RangePage.h"
+#include "TimestampTree.h"
 
 /**
  * Responsibility: keep a set of ids related to a double property so
@@ -10,13 +12,58 @@
 class DoublePropertyIds
 {
 public:
+    DoublePropertyIds() = default;
+    /**
+     * The index nodes are allocated from the memory resource (copies use the default one unless given).
+     */
+    explicit DoublePropertyIds(std::pmr::memory_resource* resource);
+    DoublePropertyIds(const DoublePropertyIds& other, std::pmr::memory_resource* resource);
+
     void insert(double property, std::int64_t id);
 
+    /**
+     * Bulk version of insert. The pairs are sorted once and, unless they are only a few
+     * compared with the ones already in the index, the leaves are rebuilt sequentially.
+     */
+    void insert(std::vector<TimestampTree::Entry> entries);
+
+    /**
+     * Bulk version of remove, sorting the pairs first like the bulk insert.
+     */
+    void remove(std::vector<TimestampTree::Entry> entries);
+
+    /**
+     * Bulk versions of insert and remove with every pair of another index, which are already sorted.
+     * Like inserting a vector of pairs, the leaves are rebuilt sequentially unless the pairs are only a few.
+     */
+    void insert(const DoublePropertyIds& other);
+    void remove(const DoublePropertyIds& other);
+
     /**
      * Here we couldn't return a const& because the set has to be created depending of the range.
      * An alternative would be to create a view using C++20 range features (or rangeV3, boost).
      */
-    std::unordered_set<std::int64_t> getRangeIds(double minValue, double maxValue) const;
+    IdSet getRangeIds(double minValue, double maxValue) const;
+
+    /**
+     * Lazy version of getRangeIds, the ids are read from the index leaves while iterating
+     * and come sorted by property value instead of by id.
+     * The range is valid until the index is modified.
+     */
+    IdRange getRange(double minValue, double maxValue) const;
+
+    /**
+     * Up to limit (property, id) pairs of the range in the cursor order, starting after the last pair of the cursor.
+     * Complexity O(log n + limit)
+     */
+    RangePage getOrderedRange(double minValue, double maxValue, std::size_t limit, const RangeCursor& cursor) const;
+
+    bool contains(double property, std::int64_t id) const;
+
+    /**
+     * Number of ids in the range, counted from the index inner nodes. Complexity O(log n)
+     */
+    std::size_t countRange(double minValue, double maxValue) const;
 
     void updateProperty(double oldPropertyValue,
                         double newPropertyValue,
@@ -24,12 +71,20 @@ public:
 
     void remove(double property, std::int64_t id);
 private:
+    /**
+     * Whether k sorted pairs are merged with the index rebuilding its leaves, O(n + k),
+     * instead of changing them one by one, O(k log n).
+     */
+    bool mergeSorted(std::size_t entryCount) const { return entryCount >= propertyIds.size() / 8; }
+    template<typename Iterator>
+    void insertSorted(Iterator first, Iterator last);
+    template<typename Iterator>
+    void removeSorted(Iterator first, Iterator last);
+
     /**
      * A sorted container is more convenient than an unordered one to improve
      * the performance while searching ranges (from min value to mas value).
+     * Keeping (property, id) pairs in a B+-tree makes a range a sequential read of its leaves.
      */
-    std::map<double, std::unordered_set<std::int64_t>> propertyIds;
+    TimestampTree propertyIds;
 };
-
-
-
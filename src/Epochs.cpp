@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include "Epochs.h"
+
+namespace
+{
+    // 0 is never a global epoch, so it marks the slots of the threads that are not reading
+    constexpr std::uint64_t notReading{0};
+
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<std::uint64_t> epoch{notReading};
+        std::atomic<bool> taken{false};
+    };
+
+    std::atomic<std::uint64_t> globalEpoch{1};
+    std::array<ReaderSlot, ReadEpoch::maxThreads> readerSlots;
+    // slots are taken from the beginning, so writers only scan up to the last one ever taken
+    std::atomic<std::size_t> usedReaderSlots{0};
+
+    /**
+     * Slot of the calling thread, taken the first time the thread reads and freed when it exits.
+     */
+    struct ThreadReader
+    {
+        ThreadReader()
+        {
+            for(std::size_t index{0}; index < readerSlots.size(); ++index)
+            {
+                auto free{false};
+                if(readerSlots[index].taken.compare_exchange_strong(free, true))
+                {
+                    slot = &readerSlots[index];
+                    auto used{usedReaderSlots.load()};
+                    while(used <= index and not usedReaderSlots.compare_exchange_weak(used, index + 1))
+                    {
+                    }
+                    return;
+                }
+            }
+            throw std::runtime_error("Too many threads reading concurrent stores at the same time");
+        }
+
+        ~ThreadReader()
+        {
+            slot->taken.store(false);
+        }
+
+        ReaderSlot* slot{nullptr};
+        std::size_t depth{0};
+    };
+
+    ThreadReader& threadReader()
+    {
+        thread_local ThreadReader reader;
+        return reader;
+    }
+}
+
+ReadEpoch::ReadEpoch()
+{
+    auto& reader{threadReader()};
+    if(reader.depth++ == 0)
+    {
+        reader.slot->epoch.store(globalEpoch.load(), std::memory_order_relaxed);
+        // the pin must be visible to writers before this thread loads any pointer of their structures
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+ReadEpoch::~ReadEpoch()
+{
+    auto& reader{threadReader()};
+    if(--reader.depth == 0)
+    {
+        reader.slot->epoch.store(notReading, std::memory_order_release);
+    }
+}
+
+std::uint64_t ReadEpoch::oldestPinned()
+{
+    auto oldest{globalEpoch.load()};
+    const auto used{usedReaderSlots.load()};
+    for(std::size_t index{0}; index < used; ++index)
+    {
+        const auto epoch{readerSlots[index].epoch.load()};
+        if(epoch not_eq notReading)
+        {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    return oldest;
+}
+
+std::uint64_t ReadEpoch::advance()
+{
+    return globalEpoch.fetch_add(1) + 1;
+}
+
+std::uint64_t ReadEpoch::current()
+{
+    return globalEpoch.load();
+}
+
+RetireList::~RetireList()
+{
+    for(const auto& object : retired)
+    {
+        object.destroy(object.object);
+    }
+}
+
+void RetireList::retire(const void* object, void (*destroy)(const void*))
+{
+    // the epoch is read after the object was unlinked, readers pinned before may still be reading it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    retired.push_back({ReadEpoch::current(), object, destroy});
+    if(retired.size() >= reclaimThreshold)
+    {
+        reclaim();
+    }
+}
+
+void RetireList::reclaim()
+{
+    // readers pinning from now on get a newer epoch than every retired object
+    ReadEpoch::advance();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto oldestPinned{ReadEpoch::oldestPinned()};
+    const auto firstKept{std::partition(retired.begin(), retired.end(), [oldestPinned](const Retired& object)
+    {
+        return object.epoch < oldestPinned;
+    })};
+    for(auto object{retired.begin()}; object not_eq firstKept; ++object)
+    {
+        object->destroy(object->object);
+    }
+    retired.erase(retired.begin(), firstKept);
+    // a reader pinned for long keeps objects alive, scanning again only pays off once many more are retired
+    reclaimThreshold = std::max(retireBatch, retired.size() * 2);
+}
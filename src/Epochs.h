@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Responsibility: let writers free the memory they replaced once no reader can still be reading it
+ * (epoch-based reclamation).
+ *
+ * There is a global epoch. A reader pins the current epoch in its own slot (every thread has one,
+ * in its own cache line) while it reads, so readers never write memory shared with other threads.
+ * A writer unlinks an object from its structure and retires it with the current epoch, and the
+ * object is freed once every pinned reader has an epoch greater than that, since readers pinning
+ * later cannot reach it anymore.
+ */
+class ReadEpoch
+{
+public:
+    /**
+     * Pins the current epoch until destroyed. Nested pins of the same thread keep the first one.
+     * Must be destroyed in the thread that created it.
+     */
+    ReadEpoch();
+    ~ReadEpoch();
+    ReadEpoch(const ReadEpoch&) = delete;
+    ReadEpoch& operator=(const ReadEpoch&) = delete;
+
+    static constexpr std::size_t maxThreads{1024};
+
+private:
+    friend class RetireList;
+
+    /**
+     * Oldest epoch pinned by a reader, or the current epoch if there is no reader.
+     */
+    static std::uint64_t oldestPinned();
+    static std::uint64_t advance();
+    static std::uint64_t current();
+};
+
+/**
+ * Responsibility: keep the objects retired by a writer until they can be freed.
+ *
+ * Not thread safe: every writer lock keeps its own list, so retiring does not contend between writers.
+ * Freeing is amortized, the readers are only scanned once the list doubled since the last scan
+ * (and at least every retireBatch retirements).
+ */
+class RetireList
+{
+public:
+    RetireList() = default;
+    RetireList(const RetireList&) = delete;
+    RetireList& operator=(const RetireList&) = delete;
+
+    /**
+     * Frees everything: the list is destroyed with its structure, so no reader can reach the objects.
+     */
+    ~RetireList();
+
+    /**
+     * The object must be already unlinked from the structure readers find it in.
+     */
+    template<typename T>
+    void retire(const T* object)
+    {
+        retire(object, [](const void* retiredObject) { delete static_cast<const T*>(retiredObject); });
+    }
+
+    /**
+     * Frees the objects no reader can be reading anymore.
+     */
+    void reclaim();
+
+    std::size_t size() const { return retired.size(); }
+
+private:
+    static constexpr std::size_t retireBatch{64};
+
+    struct Retired
+    {
+        std::uint64_t epoch;
+        const void* object;
+        void (*destroy)(const void*);
+    };
+
+    void retire(const void* object, void (*destroy)(const void*));
+
+    std::vector<Retired> retired;
+    std::size_t reclaimThreshold{retireBatch};
+};
@@ -0,0 +1,496 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Responsibility: map todo ids to values with an open-addressing hash table, so a lookup
+ * reads one or two contiguous cache lines instead of chasing a node pointer per bucket.
+ *
+ * The layout follows the SwissTable idea: one control byte per slot keeps 7 bits of the hash
+ * (or marks the slot as empty or deleted) and lookups compare 8 control bytes at once, only
+ * touching the slots whose control byte matches. Entries are stored inline next to their control
+ * bytes, so iterators and references are invalidated by any insertion that grows the table.
+ * The slot array is allocated from a memory resource (the default one unless given), like std::pmr containers.
+ */
+template<typename Value>
+class FlatIdMap
+{
+public:
+    struct Entry
+    {
+        std::int64_t first;
+        Value second;
+    };
+
+private:
+    static constexpr std::int8_t emptySlot{-128};  // 0b10000000
+    static constexpr std::int8_t deletedSlot{-2};  // 0b11111110
+    static constexpr std::size_t groupWidth{8};
+    static constexpr std::size_t notFound{~std::size_t{0}};
+    static constexpr std::uint64_t lsbs{0x0101010101010101ULL};
+    static constexpr std::uint64_t msbs{0x8080808080808080ULL};
+
+    /**
+     * The control bytes of a group are stored right before its entries, so a successful lookup
+     * usually reads the entry from the same or the adjacent cache line of the control bytes.
+     */
+    struct Group
+    {
+        std::int8_t control[groupWidth];
+        alignas(Entry) unsigned char storage[groupWidth * sizeof(Entry)];
+
+        Entry* entry(std::size_t position) { return reinterpret_cast<Entry*>(storage) + position; }
+        const Entry* entry(std::size_t position) const { return reinterpret_cast<const Entry*>(storage) + position; }
+    };
+
+public:
+    template<bool Const>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Entry*, Entry*>;
+        using reference = std::conditional_t<Const, const Entry&, Entry&>;
+
+        Iterator() = default;
+        Iterator(const Group* groups, std::size_t index, std::size_t slotCount)
+                :groups{groups}, index{index}, slotCount{slotCount}
+        {
+            skipFreeSlots();
+        }
+
+        // a mutable iterator is convertible to a const one
+        template<bool C = Const, typename = std::enable_if_t<not C>>
+        operator Iterator<true>() const { return {groups, index, slotCount}; }
+
+        reference operator*() const { return *operator->(); }
+        pointer operator->() const
+        {
+            return const_cast<pointer>(groups[index / groupWidth].entry(index % groupWidth));
+        }
+
+        Iterator& operator++()
+        {
+            ++index;
+            skipFreeSlots();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto copy{*this};
+            ++(*this);
+            return copy;
+        }
+
+        bool operator==(const Iterator& other) const { return index == other.index; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+
+    private:
+        friend class FlatIdMap;
+
+        void skipFreeSlots()
+        {
+            while(index != slotCount and groups[index / groupWidth].control[index % groupWidth] < 0)
+            {
+                ++index;
+            }
+        }
+
+        const Group* groups{nullptr};
+        std::size_t index{0};
+        std::size_t slotCount{0};
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatIdMap() = default;
+
+    explicit FlatIdMap(std::pmr::memory_resource* resource): resource{resource} {}
+
+    /**
+     * Copies use the default memory resource unless another one is given.
+     */
+    FlatIdMap(const FlatIdMap& other)
+            :FlatIdMap{other, std::pmr::get_default_resource()}
+    {
+    }
+
+    FlatIdMap(const FlatIdMap& other, std::pmr::memory_resource* resource)
+            :resource{resource}
+    {
+        reserve(other.size());
+        for(const auto& entry : other)
+        {
+            try_emplace(entry.first, entry.second);
+        }
+    }
+
+    FlatIdMap(FlatIdMap&& other) noexcept
+    {
+        swap(other);
+    }
+
+    FlatIdMap& operator=(FlatIdMap other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~FlatIdMap()
+    {
+        destroyEntries();
+        deallocate();
+    }
+
+    /**
+     * The memory resources are swapped with the entries.
+     */
+    void swap(FlatIdMap& other) noexcept
+    {
+        std::swap(resource, other.resource);
+        std::swap(groups, other.groups);
+        std::swap(slotCount, other.slotCount);
+        std::swap(fullCount, other.fullCount);
+        std::swap(deletedCount, other.deletedCount);
+    }
+
+    iterator begin() { return {groups, 0, slotCount}; }
+    iterator end() { return {groups, slotCount, slotCount}; }
+    const_iterator begin() const { return {groups, 0, slotCount}; }
+    const_iterator end() const { return {groups, slotCount, slotCount}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    std::size_t size() const { return fullCount; }
+    bool empty() const { return fullCount == 0; }
+    std::size_t capacity() const { return slotCount; }
+
+    /**
+     * Bytes owned by the table: one control byte plus one entry per slot, padding included.
+     */
+    std::size_t memoryUsage() const { return slotCount / groupWidth * sizeof(Group); }
+
+    iterator find(std::int64_t id)
+    {
+        const auto index{findIndex(id)};
+        return index == notFound ? end() : iteratorAt(index);
+    }
+
+    const_iterator find(std::int64_t id) const
+    {
+        const auto index{findIndex(id)};
+        return index == notFound ? end() : const_iterator{groups, index, slotCount};
+    }
+
+    bool contains(std::int64_t id) const { return findIndex(id) != notFound; }
+
+    /**
+     * Asks the cpu to load the group where the lookup of the id starts without waiting for it,
+     * so the cache misses of several lookups overlap instead of happening one after the other.
+     */
+    void prefetch(std::int64_t id) const
+    {
+        if(slotCount not_eq 0)
+        {
+            const auto groupMask{slotCount / groupWidth - 1};
+            __builtin_prefetch(&groups[(hashId(id) >> 7) & groupMask]);
+        }
+    }
+    std::size_t count(std::int64_t id) const { return contains(id) ? 1 : 0; }
+
+    Value& at(std::int64_t id)
+    {
+        const auto index{findIndex(id)};
+        if(index == notFound)
+        {
+            throw std::out_of_range("Id "+std::to_string(id)+" not found");
+        }
+        return entryAt(index).second;
+    }
+
+    const Value& at(std::int64_t id) const
+    {
+        return const_cast<FlatIdMap*>(this)->at(id);
+    }
+
+    Value& operator[](std::int64_t id)
+    {
+        return try_emplace(id).first->second;
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(std::int64_t id, Args&&... args)
+    {
+        const auto hash{hashId(id)};
+        auto index{findIndex(id, hash)};
+        if(index != notFound)
+        {
+            return {iteratorAt(index), false};
+        }
+        if(fullCount + deletedCount + 1 > maxLoad(slotCount))
+        {
+            rehash(fullCount + 1);
+        }
+        index = findInsertIndex(hash);
+        auto& control{controlAt(index)};
+        if(control == deletedSlot)
+        {
+            --deletedCount;
+        }
+        new (&entryAt(index)) Entry{id, Value(std::forward<Args>(args)...)};
+        control = fingerprint(hash);
+        ++fullCount;
+        return {iteratorAt(index), true};
+    }
+
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(std::int64_t id, V&& value)
+    {
+        auto result{try_emplace(id, std::forward<V>(value))};
+        if(not result.second)
+        {
+            result.first->second = std::forward<V>(value);
+        }
+        return result;
+    }
+
+    std::size_t erase(std::int64_t id)
+    {
+        const auto index{findIndex(id)};
+        if(index == notFound)
+        {
+            return 0;
+        }
+        eraseIndex(index);
+        return 1;
+    }
+
+    void erase(const_iterator position)
+    {
+        eraseIndex(position.index);
+    }
+
+    /**
+     * Removes every entry but keeps the slot array, so refilling the table does not allocate.
+     */
+    void clear()
+    {
+        destroyEntries();
+        for(std::size_t group{0}; group < slotCount / groupWidth; ++group)
+        {
+            std::memset(groups[group].control, emptySlot, groupWidth);
+        }
+        fullCount = 0;
+        deletedCount = 0;
+    }
+
+    void reserve(std::size_t count)
+    {
+        if(count > maxLoad(slotCount))
+        {
+            rehash(count);
+        }
+    }
+
+private:
+    static std::uint64_t hashId(std::int64_t id)
+    {
+        // fibonacci hashing folded onto the low bits, cheap and enough to spread sequential ids
+        auto hash{static_cast<std::uint64_t>(id) * 0x9E3779B97F4A7C15ULL};
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    static std::int8_t fingerprint(std::uint64_t hash)
+    {
+        return static_cast<std::int8_t>(hash & 0x7F);
+    }
+
+    static std::size_t maxLoad(std::size_t slots)
+    {
+        return slots - slots / 8; // 7/8 load factor
+    }
+
+    std::int8_t& controlAt(std::size_t index) { return groups[index / groupWidth].control[index % groupWidth]; }
+    Entry& entryAt(std::size_t index) { return *groups[index / groupWidth].entry(index % groupWidth); }
+    const Entry& entryAt(std::size_t index) const { return *groups[index / groupWidth].entry(index % groupWidth); }
+
+    /**
+     * Loads the control bytes of a group with byte i of the group in the byte i of the word.
+     */
+    std::uint64_t loadGroup(std::size_t group) const
+    {
+        std::uint64_t word;
+        std::memcpy(&word, groups[group].control, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word;
+    }
+
+    static std::uint64_t matchFingerprint(std::uint64_t group, std::int8_t fingerprint)
+    {
+        // bytes equal to the fingerprint become zero, then the classic "has zero byte" trick.
+        // It can report false positives, but only on full slots (empty and deleted bytes have the
+        // high bit set), so comparing the id of the entry is always safe.
+        const auto x{group ^ (lsbs * static_cast<std::uint8_t>(fingerprint))};
+        return (x - lsbs) & ~x & msbs;
+    }
+
+    static std::uint64_t matchEmpty(std::uint64_t group)
+    {
+        return (group & ~(group << 6)) & msbs;
+    }
+
+    static std::uint64_t matchEmptyOrDeleted(std::uint64_t group)
+    {
+        return (group & ~(group << 7)) & msbs;
+    }
+
+    static std::size_t lowestByte(std::uint64_t mask)
+    {
+        return static_cast<std::size_t>(__builtin_ctzll(mask)) / 8;
+    }
+
+    std::size_t findIndex(std::int64_t id) const
+    {
+        return findIndex(id, hashId(id));
+    }
+
+    std::size_t findIndex(std::int64_t id, std::uint64_t hash) const
+    {
+        if(slotCount == 0)
+        {
+            return notFound;
+        }
+        const auto groupMask{slotCount / groupWidth - 1};
+        auto group{(hash >> 7) & groupMask};
+        const auto fingerprintValue{fingerprint(hash)};
+        // triangular probing over groups visits every group once when the group count is a power of 2
+        for(std::size_t step{1}; ; ++step)
+        {
+            const auto word{loadGroup(group)};
+            for(auto matches{matchFingerprint(word, fingerprintValue)}; matches; matches &= matches - 1)
+            {
+                const auto position{lowestByte(matches)};
+                if(groups[group].entry(position)->first == id)
+                {
+                    return group * groupWidth + position;
+                }
+            }
+            if(matchEmpty(word))
+            {
+                return notFound;
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    std::size_t findInsertIndex(std::uint64_t hash) const
+    {
+        const auto groupMask{slotCount / groupWidth - 1};
+        auto group{(hash >> 7) & groupMask};
+        for(std::size_t step{1}; ; ++step)
+        {
+            const auto matches{matchEmptyOrDeleted(loadGroup(group))};
+            if(matches)
+            {
+                return group * groupWidth + lowestByte(matches);
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    iterator iteratorAt(std::size_t index)
+    {
+        return {groups, index, slotCount};
+    }
+
+    void eraseIndex(std::size_t index)
+    {
+        entryAt(index).~Entry();
+        // a slot can go back to empty if its group never got full, otherwise lookups must keep probing
+        if(matchEmpty(loadGroup(index / groupWidth)))
+        {
+            controlAt(index) = emptySlot;
+        } else
+        {
+            controlAt(index) = deletedSlot;
+            ++deletedCount;
+        }
+        --fullCount;
+    }
+
+    void rehash(std::size_t count)
+    {
+        auto newSlotCount{groupWidth};
+        while(maxLoad(newSlotCount) < count)
+        {
+            newSlotCount *= 2;
+        }
+
+        FlatIdMap rehashed{resource};
+        rehashed.allocate(newSlotCount);
+        for(std::size_t index{0}; index < slotCount; ++index)
+        {
+            if(controlAt(index) >= 0)
+            {
+                auto& entry{entryAt(index)};
+                const auto hash{hashId(entry.first)};
+                const auto newIndex{rehashed.findInsertIndex(hash)};
+                new (&rehashed.entryAt(newIndex)) Entry{entry.first, std::move(entry.second)};
+                rehashed.controlAt(newIndex) = fingerprint(hash);
+                ++rehashed.fullCount;
+            }
+        }
+        swap(rehashed);
+    }
+
+    void allocate(std::size_t slots)
+    {
+        groups = static_cast<Group*>(resource->allocate(slots / groupWidth * sizeof(Group), alignof(Group)));
+        slotCount = slots;
+        for(std::size_t group{0}; group < slotCount / groupWidth; ++group)
+        {
+            std::memset(groups[group].control, emptySlot, groupWidth);
+        }
+    }
+
+    void deallocate()
+    {
+        if(slotCount > 0)
+        {
+            resource->deallocate(groups, slotCount / groupWidth * sizeof(Group), alignof(Group));
+        }
+        groups = nullptr;
+        slotCount = 0;
+    }
+
+    void destroyEntries()
+    {
+        for(std::size_t index{0}; index < slotCount; ++index)
+        {
+            if(controlAt(index) >= 0)
+            {
+                entryAt(index).~Entry();
+            }
+        }
+    }
+
+    std::pmr::memory_resource* resource{std::pmr::get_default_resource()};
+    Group* groups{nullptr};
+    std::size_t slotCount{0};
+    std::size_t fullCount{0};
+    std::size_t deletedCount{0};
+};
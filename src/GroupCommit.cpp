@@ -0,0 +1,73 @@
+#include <stdexcept>
+#include "GroupCommit.h"
+#include "ChildStore.h"
+#include "ParentStore.h"
+
+GroupCommit::GroupCommit(std::shared_ptr<ParentStore> parent): parent{std::move(parent)}
+{
+}
+
+void GroupCommit::add(std::shared_ptr<ChildStore> child)
+{
+    if(child->parent not_eq parent or child->parentChild)
+    {
+        throw std::invalid_argument("Only the children of the parent store can be committed in its group");
+    }
+    queue.push_back(std::move(child));
+}
+
+std::vector<std::exception_ptr> GroupCommit::commit()
+{
+    std::vector<std::exception_ptr> results(queue.size());
+    std::vector<CommitDelta> deltas;
+    GroupWrites writes;
+    std::vector<ChildStore*> committedChildren;
+    committedChildren.reserve(queue.size());
+    for(std::size_t position{0}; position < queue.size(); ++position)
+    {
+        const auto& child{*queue[position]};
+        try
+        {
+            child.validateCommit();
+            child.validateGroupCommit(writes);
+            // accepted children change different todos, so each one is checked against the parent alone
+            child.checkChanges();
+        } catch(const CommitConflict&)
+        {
+            results[position] = std::current_exception();
+            continue;
+        } catch(const std::invalid_argument&)
+        {
+            results[position] = std::current_exception();
+            continue;
+        }
+        child.addGroupWrites(writes);
+        // their deltas are applied as they are
+        deltas.push_back(child.delta());
+        committedChildren.push_back(queue[position].get());
+    }
+
+    // like a single commit, the snapshots are released first so the parent only keeps the old versions
+    // of the committed todos if other children read them
+    for(const auto child : committedChildren)
+    {
+        child->parentSnapshot.reset();
+    }
+    try
+    {
+        parent->commitDeltas(deltas);
+    } catch(...)
+    {
+        for(const auto child : committedChildren)
+        {
+            child->parentSnapshot = parent->snapshot();
+        }
+        throw;
+    }
+    for(const auto child : committedChildren)
+    {
+        child->restart();
+    }
+    queue.clear();
+    return results;
+}
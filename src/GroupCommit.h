@@ -0,0 +1,44 @@
+#pragma once
+#include <exception>
+#include <memory>
+#include <vector>
+#include "TodoPatch.h"
+
+class ParentStore;
+class ChildStore;
+
+/**
+ * Responsibility: commit many children of a parent store in a single pass (group commit).
+ *
+ * Children are queued as their transactions finish and the queue is committed at once: every child is
+ * validated in queue order, against the parent like a single commit and against the children accepted
+ * before it in the group, and the changes of all the accepted ones are applied to the parent as a single
+ * version. Index maintenance is coalesced over the whole group (see ParentStore::commitDeltas), so the
+ * per commit overhead is paid once per group.
+ * Like the parent store, a group commit is not synchronized, it must be used by one thread at a time.
+ */
+class GroupCommit
+{
+public:
+    explicit GroupCommit(std::shared_ptr<ParentStore> parent);
+
+    /**
+     * The child must be a child of the parent store (not a nested one), and it must not be changed
+     * until the group is committed. Throws std::invalid_argument otherwise.
+     */
+    void add(std::shared_ptr<ChildStore> child);
+
+    /**
+     * Commits every queued child and empties the queue. The result of every child is in its queue position:
+     * nullptr if it was committed, or the CommitConflict or std::invalid_argument (an invalid change) that
+     * left it uncommitted (and unchanged, like a single failed commit). The committed children go on reading
+     * the new version of the parent.
+     */
+    std::vector<std::exception_ptr> commit();
+
+    std::size_t size() const { return queue.size(); }
+
+private:
+    std::shared_ptr<ParentStore> parent;
+    std::vector<std::shared_ptr<ChildStore>> queue;
+};
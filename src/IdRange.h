@@ -0,0 +1,217 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+
+/**
+ * Responsibility: produce query result ids on demand.
+ *
+ * Cursors read the ids straight from the internal storage of the indexes (and apply the
+ * child stores overlay on the fly), so nothing is materialized before the caller asks for it.
+ */
+class IdCursor
+{
+public:
+    virtual ~IdCursor() = default;
+
+    /**
+     * Writes up to capacity ids and returns how many were written, 0 once there are no more ids.
+     */
+    virtual std::size_t next(std::int64_t* ids, std::size_t capacity) = 0;
+};
+
+/**
+ * Responsibility: single pass range over the ids of a cursor, to be used in range-based for loops.
+ *
+ * Ids are pulled from the cursor in small batches kept inline, so iterating costs one
+ * virtual call per batch and no allocation per result. The range reads the store it comes from,
+ * so it must be consumed before that store (or its parent) is modified.
+ */
+class IdRange
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::int64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::int64_t*;
+        using reference = std::int64_t;
+
+        iterator() = default;
+        explicit iterator(IdRange* range): range{range}
+        {
+            ++(*this);
+        }
+
+        std::int64_t operator*() const { return current; }
+
+        iterator& operator++()
+        {
+            if(not range->next(current))
+            {
+                range = nullptr;
+            }
+            return *this;
+        }
+
+        void operator++(int) { ++(*this); }
+
+        bool operator==(const iterator& other) const { return range == other.range; }
+        bool operator!=(const iterator& other) const { return range != other.range; }
+
+    private:
+        IdRange* range{nullptr};
+        std::int64_t current{0};
+    };
+
+    IdRange() = default;
+    explicit IdRange(std::unique_ptr<IdCursor> cursor): cursor{std::move(cursor)} {}
+
+    /**
+     * Ids already consumed are not iterated again.
+     */
+    iterator begin() { return iterator{this}; }
+    iterator end() { return {}; }
+
+    /**
+     * Writes the next id and returns true, or returns false once there are no more ids.
+     */
+    bool next(std::int64_t& id)
+    {
+        if(position == size)
+        {
+            position = 0;
+            size = cursor ? cursor->next(buffer.data(), buffer.size()) : 0;
+            if(size == 0)
+            {
+                return false;
+            }
+        }
+        id = buffer[position++];
+        return true;
+    }
+
+private:
+    static constexpr std::size_t batchSize{64};
+
+    std::unique_ptr<IdCursor> cursor;
+    std::array<std::int64_t, batchSize> buffer;
+    std::size_t position{0};
+    std::size_t size{0};
+};
+
+/**
+ * Cursor over the elements [first, last) of an index, projecting every element to its id.
+ * The elements are read in place, the index is not copied.
+ */
+template<typename Iterator, typename Projection>
+class IteratorCursor: public IdCursor
+{
+public:
+    IteratorCursor(Iterator first, Iterator last, Projection projection)
+            : first{first}, last{last}, projection{projection}
+    {
+    }
+
+    std::size_t next(std::int64_t* ids, std::size_t capacity) override
+    {
+        std::size_t count{0};
+        for(; count < capacity and first not_eq last; ++first)
+        {
+            ids[count++] = projection(*first);
+        }
+        return count;
+    }
+
+private:
+    Iterator first;
+    Iterator last;
+    Projection projection;
+};
+
+template<typename Iterator, typename Projection>
+IdRange makeIdRange(Iterator first, Iterator last, Projection projection)
+{
+    return IdRange{std::make_unique<IteratorCursor<Iterator, Projection>>(first, last, projection)};
+}
+
+/**
+ * Ids of an underlying range without the ones hidden by an overlay, followed by the overlay own ids.
+ * Both are read lazily, the overlay is applied to every id while iterating. Child stores overlay
+ * their changes on the parent results, snapshots revert the changes made after them.
+ */
+template<typename IsHidden>
+class OverlayCursor: public IdCursor
+{
+public:
+    OverlayCursor(IdRange underlyingIds, IsHidden isHidden, IdRange ownIds)
+            : underlyingIds{std::move(underlyingIds)}, isHidden{std::move(isHidden)}, ownIds{std::move(ownIds)}
+    {
+    }
+
+    std::size_t next(std::int64_t* ids, std::size_t capacity) override
+    {
+        std::size_t count{0};
+        std::int64_t id;
+        while(count < capacity and underlyingIds.next(id))
+        {
+            if(not isHidden(id))
+            {
+                ids[count++] = id;
+            }
+        }
+        while(count < capacity and ownIds.next(id))
+        {
+            ids[count++] = id;
+        }
+        return count;
+    }
+
+private:
+    IdRange underlyingIds;
+    IsHidden isHidden;
+    IdRange ownIds;
+};
+
+template<typename IsHidden>
+IdRange makeOverlayRange(IdRange underlyingIds, IsHidden isHidden, IdRange ownIds)
+{
+    return IdRange{std::make_unique<OverlayCursor<IsHidden>>(std::move(underlyingIds), std::move(isHidden),
+                                                             std::move(ownIds))};
+}
+
+/**
+ * Cursor over ids copied out of a store, the range owns them. Used when the index they come from
+ * cannot be read after the query returns (e.g. it is protected by a lock).
+ */
+template<typename Container>
+class OwningCursor: public IdCursor
+{
+public:
+    explicit OwningCursor(Container ids): ids{std::move(ids)}, current{this->ids.begin()}
+    {
+    }
+
+    std::size_t next(std::int64_t* out, std::size_t capacity) override
+    {
+        std::size_t count{0};
+        for(; count < capacity and current not_eq ids.end(); ++current)
+        {
+            out[count++] = *current;
+        }
+        return count;
+    }
+
+private:
+    Container ids;
+    typename Container::const_iterator current;
+};
+
+template<typename Container>
+IdRange makeOwningIdRange(Container ids)
+{
+    return IdRange{std::make_unique<OwningCursor<Container>>(std::move(ids))};
+}
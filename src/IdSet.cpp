@@ -0,0 +1,401 @@
+#include <algorithm>
+#include "IdSet.h"
+
+IdSet::IdSet(std::initializer_list<std::int64_t> ids)
+        :IdSet{fromIds(ids)}
+{
+}
+
+IdSet IdSet::fromIds(std::vector<std::int64_t> ids)
+{
+    // Complexity O(N log N), a single sort instead of N insertions
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    IdSet set;
+    set.count = ids.size();
+    if(ids.size() == 1)
+    {
+        set.ids = ids.front();
+    } else if(ids.size() <= sortedLimit)
+    {
+        set.ids = std::move(ids);
+    } else
+    {
+        set.ids = toChunks(ids);
+    }
+    return set;
+}
+
+bool IdSet::insert(std::int64_t id)
+{
+    if(auto* sortedIds{std::get_if<SortedIds>(&ids)})
+    {
+        if(sortedIds->empty())
+        {
+            ids = id;
+            count = 1;
+            return true;
+        }
+        // Complexity O(log n) to find plus at most sortedLimit moves
+        const auto it{std::lower_bound(sortedIds->begin(), sortedIds->end(), id)};
+        if(it not_eq sortedIds->end() and *it == id)
+        {
+            return false;
+        }
+        sortedIds->insert(it, id);
+        ++count;
+        if(count > sortedLimit)
+        {
+            auto chunks{toChunks(*sortedIds)};
+            ids = std::move(chunks);
+        }
+        return true;
+    }
+
+    if(const auto* singleId{std::get_if<std::int64_t>(&ids)})
+    {
+        if(*singleId == id)
+        {
+            return false;
+        }
+        ids = SortedIds{std::min(*singleId, id), std::max(*singleId, id)};
+        count = 2;
+        return true;
+    }
+
+    // Complexity O(log chunks) to find the chunk, plus at most arrayChunkLimit moves inside it
+    auto& chunks{std::get<ChunkedIds>(ids)};
+    const auto key{chunkKey(id)};
+    auto chunkIt{std::lower_bound(chunks.begin(), chunks.end(), key,
+                                  [](const Chunk& chunk, std::int64_t key) { return chunk.key < key; })};
+    if(chunkIt == chunks.end() or chunkIt->key not_eq key)
+    {
+        chunkIt = chunks.insert(chunkIt, Chunk{key});
+    }
+    const auto inserted{chunkIt->insert(lowBits(id))};
+    if(inserted)
+    {
+        ++count;
+    }
+    return inserted;
+}
+
+bool IdSet::erase(std::int64_t id)
+{
+    if(const auto* singleId{std::get_if<std::int64_t>(&ids)})
+    {
+        if(*singleId not_eq id)
+        {
+            return false;
+        }
+        ids = SortedIds{};
+        count = 0;
+        return true;
+    }
+
+    if(auto* sortedIds{std::get_if<SortedIds>(&ids)})
+    {
+        const auto it{std::lower_bound(sortedIds->begin(), sortedIds->end(), id)};
+        if(it == sortedIds->end() or *it not_eq id)
+        {
+            return false;
+        }
+        sortedIds->erase(it);
+        --count;
+        if(count == 1)
+        {
+            const auto lastId{sortedIds->front()};
+            ids = lastId;
+        }
+        return true;
+    }
+
+    auto& chunks{std::get<ChunkedIds>(ids)};
+    const auto key{chunkKey(id)};
+    const auto chunkIt{std::lower_bound(chunks.begin(), chunks.end(), key,
+                                        [](const Chunk& chunk, std::int64_t key) { return chunk.key < key; })};
+    if(chunkIt == chunks.end() or chunkIt->key not_eq key or not chunkIt->erase(lowBits(id)))
+    {
+        return false;
+    }
+    --count;
+    if(chunkIt->cardinality == 0)
+    {
+        chunks.erase(chunkIt);
+    }
+    // going back to the sorted vector only at half the limit, so a set around the limit does not flip-flop
+    if(count <= sortedLimit / 2)
+    {
+        SortedIds sortedIds;
+        sortedIds.reserve(count);
+        for(const auto remainingId : *this)
+        {
+            sortedIds.push_back(remainingId);
+        }
+        if(count == 1)
+        {
+            ids = sortedIds.front();
+        } else
+        {
+            ids = std::move(sortedIds);
+        }
+    }
+    return true;
+}
+
+bool IdSet::contains(std::int64_t id) const
+{
+    if(const auto* singleId{std::get_if<std::int64_t>(&ids)})
+    {
+        return *singleId == id;
+    }
+    if(const auto* sortedIds{std::get_if<SortedIds>(&ids)})
+    {
+        return std::binary_search(sortedIds->begin(), sortedIds->end(), id);
+    }
+    const auto& chunks{std::get<ChunkedIds>(ids)};
+    const auto key{chunkKey(id)};
+    const auto chunkIt{std::lower_bound(chunks.begin(), chunks.end(), key,
+                                        [](const Chunk& chunk, std::int64_t key) { return chunk.key < key; })};
+    return chunkIt not_eq chunks.end() and chunkIt->key == key and chunkIt->contains(lowBits(id));
+}
+
+IdSet::const_iterator IdSet::begin() const
+{
+    const_iterator it;
+    it.set = this;
+    if(const auto* singleId{std::get_if<std::int64_t>(&ids)})
+    {
+        it.current = *singleId;
+    } else if(const auto* sortedIds{std::get_if<SortedIds>(&ids)})
+    {
+        if(not sortedIds->empty())
+        {
+            it.current = sortedIds->front();
+        }
+    } else
+    {
+        seekChunk(it);
+    }
+    return it;
+}
+
+IdSet::const_iterator IdSet::end() const
+{
+    const_iterator it;
+    it.set = this;
+    if(std::holds_alternative<std::int64_t>(ids))
+    {
+        it.position = 1;
+    } else if(const auto* sortedIds{std::get_if<SortedIds>(&ids)})
+    {
+        it.position = sortedIds->size();
+    } else
+    {
+        it.chunk = std::get<ChunkedIds>(ids).size();
+    }
+    return it;
+}
+
+bool IdSet::operator==(const IdSet& other) const
+{
+    return count == other.count and std::equal(begin(), end(), other.begin());
+}
+
+std::size_t IdSet::memoryUsage() const
+{
+    if(const auto* sortedIds{std::get_if<SortedIds>(&ids)})
+    {
+        return sortedIds->capacity() * sizeof(std::int64_t);
+    }
+    if(const auto* chunks{std::get_if<ChunkedIds>(&ids)})
+    {
+        auto bytes{chunks->capacity() * sizeof(Chunk)};
+        for(const auto& chunk : *chunks)
+        {
+            bytes += chunk.values.capacity() * sizeof(std::uint16_t) +
+                     chunk.bitmap.capacity() * sizeof(std::uint64_t);
+        }
+        return bytes;
+    }
+    return 0;
+}
+
+std::int64_t IdSet::chunkKey(std::int64_t id)
+{
+    // floor division so negative ids are also ordered by (key, low bits)
+    return id >= 0 ? id / 65536 : -((-(id + 1)) / 65536) - 1;
+}
+
+std::uint16_t IdSet::lowBits(std::int64_t id)
+{
+    return static_cast<std::uint16_t>(static_cast<std::uint64_t>(id) & 0xFFFFu);
+}
+
+std::int64_t IdSet::makeId(std::int64_t key, std::size_t low)
+{
+    return static_cast<std::int64_t>((static_cast<std::uint64_t>(key) << 16u) | low);
+}
+
+IdSet::ChunkedIds IdSet::toChunks(const SortedIds& sortedIds)
+{
+    ChunkedIds chunks;
+    for(const auto id : sortedIds)
+    {
+        const auto key{chunkKey(id)};
+        if(chunks.empty() or chunks.back().key not_eq key)
+        {
+            chunks.push_back(Chunk{key});
+        }
+        // ids are sorted, so appending keeps every chunk sorted
+        auto& chunk{chunks.back()};
+        if(chunk.bitmap.empty())
+        {
+            chunk.values.push_back(lowBits(id));
+            ++chunk.cardinality;
+            if(chunk.cardinality > arrayChunkLimit)
+            {
+                // let the chunk switch to a bitmap
+                chunk.values.pop_back();
+                --chunk.cardinality;
+                chunk.insert(lowBits(id));
+            }
+        } else
+        {
+            chunk.insert(lowBits(id));
+        }
+    }
+    return chunks;
+}
+
+void IdSet::advance(const_iterator& it) const
+{
+    ++it.position;
+    if(const auto* sortedIds{std::get_if<SortedIds>(&ids)})
+    {
+        if(it.position < sortedIds->size())
+        {
+            it.current = (*sortedIds)[it.position];
+        }
+    } else if(std::holds_alternative<ChunkedIds>(ids))
+    {
+        seekChunk(it);
+    }
+}
+
+void IdSet::seekChunk(const_iterator& it) const
+{
+    const auto& chunks{std::get<ChunkedIds>(ids)};
+    for(; it.chunk < chunks.size(); ++it.chunk, it.position = 0)
+    {
+        const auto& chunk{chunks[it.chunk]};
+        if(chunk.bitmap.empty())
+        {
+            if(it.position < chunk.values.size())
+            {
+                it.current = makeId(chunk.key, chunk.values[it.position]);
+                return;
+            }
+            continue;
+        }
+
+        auto wordIndex{it.position / 64};
+        if(wordIndex >= bitmapWords)
+        {
+            continue;
+        }
+        auto word{chunk.bitmap[wordIndex] & (~std::uint64_t{0} << (it.position % 64))};
+        while(word == 0 and ++wordIndex < bitmapWords)
+        {
+            word = chunk.bitmap[wordIndex];
+        }
+        if(word not_eq 0)
+        {
+            it.position = wordIndex * 64 + static_cast<std::size_t>(__builtin_ctzll(word));
+            it.current = makeId(chunk.key, it.position);
+            return;
+        }
+    }
+}
+
+bool IdSet::Chunk::insert(std::uint16_t low)
+{
+    if(not bitmap.empty())
+    {
+        auto& word{bitmap[low / 64]};
+        const auto mask{std::uint64_t{1} << (low % 64)};
+        if(word & mask)
+        {
+            return false;
+        }
+        word |= mask;
+        ++cardinality;
+        return true;
+    }
+
+    const auto it{std::lower_bound(values.begin(), values.end(), low)};
+    if(it not_eq values.end() and *it == low)
+    {
+        return false;
+    }
+    values.insert(it, low);
+    ++cardinality;
+    if(cardinality > arrayChunkLimit)
+    {
+        // a bitmap takes 8KB, less than an array of more than 4096 values
+        bitmap.assign(bitmapWords, 0);
+        for(const auto value : values)
+        {
+            bitmap[value / 64] |= std::uint64_t{1} << (value % 64);
+        }
+        std::vector<std::uint16_t>{}.swap(values);
+    }
+    return true;
+}
+
+bool IdSet::Chunk::erase(std::uint16_t low)
+{
+    if(not bitmap.empty())
+    {
+        auto& word{bitmap[low / 64]};
+        const auto mask{std::uint64_t{1} << (low % 64)};
+        if(not (word & mask))
+        {
+            return false;
+        }
+        word &= ~mask;
+        --cardinality;
+        if(cardinality <= arrayChunkLimit / 2)
+        {
+            values.reserve(cardinality);
+            for(std::size_t value{0}; value < bitmapWords * 64; ++value)
+            {
+                if(bitmap[value / 64] & (std::uint64_t{1} << (value % 64)))
+                {
+                    values.push_back(static_cast<std::uint16_t>(value));
+                }
+            }
+            std::vector<std::uint64_t>{}.swap(bitmap);
+        }
+        return true;
+    }
+
+    const auto it{std::lower_bound(values.begin(), values.end(), low)};
+    if(it == values.end() or *it not_eq low)
+    {
+        return false;
+    }
+    values.erase(it);
+    --cardinality;
+    return true;
+}
+
+bool IdSet::Chunk::contains(std::uint16_t low) const
+{
+    if(not bitmap.empty())
+    {
+        return bitmap[low / 64] & (std::uint64_t{1} << (low % 64));
+    }
+    return std::binary_search(values.begin(), values.end(), low);
+}
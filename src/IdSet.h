@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <variant>
+#include <vector>
+
+/**
+ * Responsibility: keep a set of todo ids (a posting list) with a representation that fits its size:
+ *  - a single id is kept inline, without any allocation,
+ *  - up to sortedLimit ids are kept in a small sorted vector,
+ *  - bigger sets are split roaring-style in chunks of 2^16 consecutive ids. Each chunk keeps the
+ *    low 16 bits of its ids in a sorted array, or in a 8KB bitmap once the chunk is dense.
+ *
+ * Ids are always iterated in ascending order, and copying a set is a couple of memcpy
+ * instead of allocating a node per id.
+ */
+class IdSet
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::int64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::int64_t*;
+        using reference = std::int64_t;
+
+        const_iterator() = default;
+
+        std::int64_t operator*() const { return current; }
+
+        const_iterator& operator++()
+        {
+            set->advance(*this);
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto copy{*this};
+            ++(*this);
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return chunk == other.chunk and position == other.position;
+        }
+
+        bool operator!=(const const_iterator& other) const { return not (*this == other); }
+
+    private:
+        friend class IdSet;
+
+        const IdSet* set{nullptr};
+        /**
+         * Chunk index, only used by chunked sets.
+         */
+        std::size_t chunk{0};
+        /**
+         * Index in the sorted vector or array chunk, or bit index in a bitmap chunk.
+         */
+        std::size_t position{0};
+        std::int64_t current{0};
+    };
+    using iterator = const_iterator;
+
+    static constexpr std::size_t sortedLimit{64};
+
+    IdSet() = default;
+    IdSet(std::initializer_list<std::int64_t> ids);
+
+    /**
+     * Builds a set from ids in any order (duplicates allowed) sorting them only once,
+     * much cheaper than inserting them one by one.
+     */
+    static IdSet fromIds(std::vector<std::int64_t> ids);
+
+    /**
+     * Returns false if the id was already in the set.
+     */
+    bool insert(std::int64_t id);
+
+    /**
+     * Returns false if the id was not in the set.
+     */
+    bool erase(std::int64_t id);
+
+    bool contains(std::int64_t id) const;
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    bool operator==(const IdSet& other) const;
+    bool operator!=(const IdSet& other) const { return not (*this == other); }
+
+    /**
+     * Heap bytes owned by the set (the inline representation does not own any).
+     */
+    std::size_t memoryUsage() const;
+
+private:
+    static constexpr std::size_t arrayChunkLimit{4096};
+    static constexpr std::size_t bitmapWords{(1u << 16u) / 64u};
+
+    struct Chunk
+    {
+        std::int64_t key;  // id >> 16
+        std::uint32_t cardinality{0};
+        std::vector<std::uint16_t> values;  // sorted, while cardinality <= arrayChunkLimit
+        std::vector<std::uint64_t> bitmap;  // bitmapWords words once the chunk is dense
+
+        bool insert(std::uint16_t low);
+        bool erase(std::uint16_t low);
+        bool contains(std::uint16_t low) const;
+    };
+
+    using SortedIds = std::vector<std::int64_t>;
+    using ChunkedIds = std::vector<Chunk>;
+
+    static std::int64_t chunkKey(std::int64_t id);
+    static std::uint16_t lowBits(std::int64_t id);
+    static std::int64_t makeId(std::int64_t key, std::size_t low);
+
+    static ChunkedIds toChunks(const SortedIds& sortedIds);
+
+    void advance(const_iterator& it) const;
+    /**
+     * Moves the iterator to the first id of a chunk at or after it.position, or to the next chunk.
+     */
+    void seekChunk(const_iterator& it) const;
+
+    /**
+     * Empty sets are an empty SortedIds, which does not allocate.
+     */
+    std::variant<SortedIds, std::int64_t, ChunkedIds> ids;
+    std::size_t count{0};
+};
@@ -1,119 +1,306 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include "ParentStore.h"
 #include "ChildStore.h"
+#include "StoreSnapshot.h"
 
-void ParentStore::insert(std::int64_t id, const TodoProperties& properties)
+std::shared_ptr<ParentStore> ParentStore::open(const std::string& logPath, WriteAheadLog::Options options)
+{
+    auto store{std::make_shared<ParentStore>()};
+    // the recovered changes are not logged again
+    WriteAheadLog::replay(logPath, *store);
+    store->log = std::make_shared<WriteAheadLog>(logPath, options);
+    return store;
+}
+
+void ParentStore::insert(std::int64_t id, TodoPatch patch)
 {
-    const auto titleIt{properties.find(titleKey)};
-    const auto titlePresent{titleIt not_eq properties.end()};
-    const auto descriptionIt{properties.find(descriptionKey)};
-    const auto descriptionPresent{descriptionIt not_eq properties.end()};
-    const auto timestampIt{properties.find(timestampKey)};
-    const auto timestampPresent{timestampIt not_eq properties.end()};
-    const auto allPropertiesPresent{titlePresent and descriptionPresent and timestampPresent};
-    if(not allPropertiesPresent)
+    if(not patch.complete())
     {
         throw std::invalid_argument("Missing properties when inserting a todo in the store. "
                                     "Please review that all properties are specified");
     }
-    const auto& title{std::get<std::string>(titleIt->second)};
-    const auto& description{std::get<std::string>(descriptionIt->second)};
-    const auto& timestamp{std::get<double>(timestampIt->second)};
-    todos[id]=Todo{id, title, description, timestamp}; // Complexity O(1), O(N) if rehashing is needed.
+
+    const auto existingSlot{todos.find(id)};
+    if(log)
+    {
+        log->append({TodoChange{TodoChange::Kind::insert, id, &patch}});
+    }
+    versions.next();
+    keepOldVersion(id, existingSlot);
+    if(existingSlot not_eq TodoColumns::npos)
+    {
+        // the todo is overwritten, so the old values must not be found when querying anymore
+        titleIds.remove(todos.title(existingSlot), id);
+        timestampIds.remove(todos.timestamp(existingSlot), id);
+    }
+    // Complexity O(1), O(N) if rehashing is needed. The strings of the patch are moved into the columns
+    const auto slot{todos.insert(Todo{id, std::move(patch.title), std::move(patch.description), patch.timestamp})};
 
     /**
      * lets keep a track of the ids related to title and timestamp in order to improve queries performance
      */
-    titleIds.insert(title, id); // Complexity O(1), O(N) if rehashing is needed.
-    timestampIds.insert(timestamp, id); // Complexity O(log n)
+    titleIds.insert(todos.title(slot), id); // Complexity O(1), O(N) if rehashing is needed.
+    timestampIds.insert(todos.timestamp(slot), id); // Complexity O(log n)
 }
 
-void ParentStore::update(std::int64_t id, const TodoProperties& properties)
+void ParentStore::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void ParentStore::insertBatch(const std::vector<Todo>& batch)
+{
+    todos.reserve(todos.size() + batch.size());
+    std::vector<TodoColumns::Slot> slots;
+    slots.reserve(batch.size());
+    // on a cold start there is nothing to overwrite, so the ids are not looked up twice
+    const auto mayOverwrite{todos.size() not_eq 0};
+    if(log)
+    {
+        log->append(batch);
+    }
+    // the whole batch is a single version
+    versions.next();
+    for(const auto& todo : batch)
+    {
+        const auto existingSlot{mayOverwrite ? todos.find(todo.id) : TodoColumns::npos};
+        keepOldVersion(todo.id, existingSlot);
+        if(existingSlot not_eq TodoColumns::npos)
+        {
+            // the todo is overwritten, so the old values must not be found when querying anymore
+            titleIds.remove(todos.title(existingSlot), todo.id);
+            timestampIds.remove(todos.timestamp(existingSlot), todo.id);
+        }
+        slots.push_back(todos.insert(todo)); // Complexity O(1), no rehashing after reserving
+    }
+
+    /**
+     * The indexes are built once every todo is in its slot, from the values kept in the columns,
+     * so an id repeated in the batch is indexed with its last values. Titles are grouped first,
+     * so every title posting list is built at once, and timestamps are sorted to fill the tree leaves sequentially.
+     */
+    std::vector<TimestampTree::Entry> timestampEntries;
+    timestampEntries.reserve(slots.size());
+    std::unordered_map<std::string_view, std::vector<std::int64_t>> idsByTitle;
+    for(const auto slot : slots)
+    {
+        const auto id{todos.id(slot)};
+        timestampEntries.push_back({todos.timestamp(slot), id});
+        idsByTitle[todos.title(slot)].push_back(id);
+    }
+    timestampIds.insert(std::move(timestampEntries)); // Complexity O(k log k + n)
+    for(auto& titleIdsPair : idsByTitle)
+    {
+        titleIds.insert(std::string{titleIdsPair.first}, std::move(titleIdsPair.second));
+    }
+}
+
+void ParentStore::update(std::int64_t id, const TodoPatch& patch)
 {
-    auto todoIt{todos.find(id)};
-    const auto idExists{todoIt not_eq todos.end()};
+    const auto slot{todos.find(id)};
+    const auto idExists{slot not_eq TodoColumns::npos};
 
     if(not idExists)
     {
         throw std::invalid_argument("Error updating properties. "
                                     "Todo with id "+std::to_string(id)+" not found");
     }
+    if(log)
+    {
+        log->append({TodoChange{TodoChange::Kind::update, id, &patch}});
+    }
+    versions.next();
+    keepOldVersion(id, slot);
 
-    for (const auto& property : properties)
+    // the indexes are only touched when the value changes
+    if(patch.has(TodoPropertyId::title) and patch.title not_eq todos.title(slot))
     {
-        if (property.first == titleKey)
-        {
-            const auto& newTitle{std::get<std::string>(property.second)};
-            const auto oldTitle{std::move(todoIt->second.title)};
-            todoIt->second.title = newTitle;
-            titleIds.updateProperty(oldTitle, newTitle, id);
-        } else if (property.first == descriptionKey)
-        {
-            todoIt->second.description = std::get<std::string>(property.second);
-        } else if (property.first == timestampKey)
-        {
-            const auto& newTimestamp{std::get<double>(property.second)};
-            const auto& oldTimestamp{todoIt->second.timestamp};
-            timestampIds.updateProperty(oldTimestamp, newTimestamp, id);
-            todoIt->second.timestamp = newTimestamp;
-        } else
-        {
-            throw std::invalid_argument("Unknown property: " + std::string(property.first));
-        }
+        const auto oldTitle{std::move(todos.title(slot))};
+        todos.title(slot) = patch.title;
+        titleIds.updateProperty(oldTitle, patch.title, id);
+    }
+    if(patch.has(TodoPropertyId::description))
+    {
+        todos.description(slot) = patch.description;
+    }
+    if(patch.has(TodoPropertyId::timestamp) and patch.timestamp not_eq todos.timestamp(slot))
+    {
+        timestampIds.updateProperty(todos.timestamp(slot), patch.timestamp, id);
+        todos.timestamp(slot) = patch.timestamp;
     }
 }
 
+void ParentStore::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void ParentStore::get(std::int64_t id, Todo& todo) const
+{
+    const auto slot{todos.find(id)};
+    if(slot == TodoColumns::npos)
+    {
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
+    }
+    // assigning the strings reuses the memory they already have
+    todo.id = id;
+    todo.title = todos.title(slot);
+    todo.description = todos.description(slot);
+    todo.timestamp = todos.timestamp(slot);
+}
+
+bool ParentStore::getIndexedValues(std::int64_t id, std::string& title, double& timestamp) const
+{
+    const auto slot{todos.find(id)};
+    if(slot == TodoColumns::npos)
+    {
+        return false;
+    }
+    title = todos.title(slot);
+    timestamp = todos.timestamp(slot);
+    return true;
+}
+
 TodoProperties ParentStore::get(std::int64_t id) const
 {
-    const auto& todo{todos.at(id)};
+    const auto slot{todos.find(id)};
+    if(slot == TodoColumns::npos)
+    {
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
+    }
     return {
-            {titleKey,       todo.title},
-            {descriptionKey, todo.description},
-            {timestampKey,   todo.timestamp}
+            {titleKey,       todos.title(slot)},
+            {descriptionKey, todos.description(slot)},
+            {timestampKey,   todos.timestamp(slot)}
     };
 }
 
+void ParentStore::getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& result) const
+{
+    result.resize(ids.size());
+
+    /**
+     * The ids are looked up in groups. The index entries of the next group are prefetched while
+     * the current one is resolved, and the values of the slots found are prefetched before copying them,
+     * so the cache misses of a group are paid at the same time instead of once per id.
+     */
+    constexpr std::size_t groupSize{8};
+    std::array<TodoColumns::Slot, groupSize> slots;
+    for(std::size_t i{0}; i < std::min(groupSize, ids.size()); ++i)
+    {
+        todos.prefetch(ids[i]);
+    }
+    for(std::size_t first{0}; first < ids.size(); first += groupSize)
+    {
+        const auto last{std::min(first + groupSize, ids.size())};
+        for(auto i{last}; i < std::min(last + groupSize, ids.size()); ++i)
+        {
+            todos.prefetch(ids[i]);
+        }
+        for(auto i{first}; i < last; ++i)
+        {
+            const auto slot{todos.find(ids[i])};
+            if(slot not_eq TodoColumns::npos)
+            {
+                todos.prefetchSlot(slot);
+            }
+            slots[i - first] = slot;
+        }
+        for(auto i{first}; i < last; ++i)
+        {
+            const auto slot{slots[i - first]};
+            auto& todo{result[i]};
+            if(slot == TodoColumns::npos)
+            {
+                todo.reset();
+                continue;
+            }
+            if(not todo)
+            {
+                todo.emplace();
+            }
+            // assigning the strings reuses the memory they already have
+            todo->id = ids[i];
+            todo->title = todos.title(slot);
+            todo->description = todos.description(slot);
+            todo->timestamp = todos.timestamp(slot);
+        }
+    }
+}
+
 void ParentStore::remove(std::int64_t id)
 {
     // find todos complexity O(1), worst case O(N)
-    auto it{todos.find(id)};
-    const auto todoExits{it not_eq todos.end()};
+    const auto slot{todos.find(id)};
+    const auto todoExits{slot not_eq TodoColumns::npos};
     if(not todoExits)
     {
         throw std::invalid_argument("Error removing todo. "
                                     "Todo with id "+std::to_string(id)+" not found");
     }
-    const auto &title{it->second.title};
+    if(log)
+    {
+        log->append({TodoChange{TodoChange::Kind::remove, id, nullptr}});
+    }
+    versions.next();
+    keepOldVersion(id, slot);
+
+    const auto &title{todos.title(slot)};
     titleIds.remove(title, id); // Complexity constant O(1), worst case O(N)
 
-    const auto &timestamp{it->second.timestamp};
+    const auto timestamp{todos.timestamp(slot)};
     timestampIds.remove(timestamp, id); // Complexity logarithmic O(log n)
 
-    todos.erase(it); // Complexity constant O(1)
+    todos.erase(slot); // Complexity constant O(1), the slot is reused by the next insertion
 }
 
 bool ParentStore::checkId(std::int64_t id) const
 {
-    return todos.find(id) not_eq todos.end();
+    return todos.find(id) not_eq TodoColumns::npos;
 }
 
-std::unordered_set<std::int64_t> ParentStore::query(const TodoProperty& property) const
+IdRange ParentStore::query(const TodoProperty& property) const
 {
     /**
      * Only title is supported but supporting also description is very trivial.
      */
-    std::unordered_set<std::int64_t> ids;
-    if(property.first == titleKey)
+    if(property.first not_eq titleKey)
+    {
+        return {};
+    }
+    // the ids are read from the title posting list while iterating, nothing is copied
+    const auto& ids{titleIds.getIds(std::get<std::string>(property.second))};
+    return makeIdRange(ids.begin(), ids.end(), [](std::int64_t id) { return id; });
+}
+
+IdRange ParentStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    return timestampIds.getRange(minTimeStamp, maxTimeStamp);
+}
+
+RangePage ParentStore::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                         std::size_t limit, const RangeCursor& cursor) const
+{
+    return timestampIds.getOrderedRange(minTimeStamp, maxTimeStamp, limit, cursor); // Complexity O(log n + limit)
+}
+
+std::size_t ParentStore::queryCount(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
     {
-        const auto& title{std::get<std::string>(property.second)};
-        ids = titleIds.getIds(title);
+        return 0;
     }
-    return ids;
+    return titleIds.count(std::get<std::string>(property.second)); // Complexity O(1)
 }
 
-std::unordered_set<std::int64_t> ParentStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+std::size_t ParentStore::rangeCount(double minTimeStamp, double maxTimeStamp) const
 {
-    return timestampIds.getRangeIds(minTimeStamp, maxTimeStamp);
+    return timestampIds.countRange(minTimeStamp, maxTimeStamp); // Complexity O(log n)
 }
 
 std::unique_ptr<Store> ParentStore::createChild()
@@ -121,11 +308,279 @@ std::unique_ptr<Store> ParentStore::createChild()
     /**
      * Children have a pointer to parent so they can get todos and performance id queries
      * from the parent without the need to copy all the parent todos into the child.
+     * Reads go through a snapshot of the parent, commits go to the parent itself.
      */
-    return std::make_unique<ChildStore>(shared_from_this());
+    return std::make_unique<ChildStore>(std::static_pointer_cast<ParentStore>(shared_from_this()), snapshot());
+}
+
+std::shared_ptr<ChildStore> ParentStore::acquireChild()
+{
+    return children->acquire(std::static_pointer_cast<ParentStore>(shared_from_this()));
 }
 
 void ParentStore::commit()
 {
     throw std::runtime_error("Parent store cannot commit, only child stores can");
 }
+
+void ParentStore::rollback()
+{
+    throw std::runtime_error("Parent store cannot roll back, only child stores can");
+}
+
+std::shared_ptr<StoreSnapshot> ParentStore::snapshot()
+{
+    // snapshots are read only, so the children created (or committed in a group) at the same version share one
+    auto snapshot{latestSnapshot.lock()};
+    if(not snapshot or snapshot->version() not_eq versions.current())
+    {
+        snapshot = std::make_shared<StoreSnapshot>(std::static_pointer_cast<ParentStore>(shared_from_this()),
+                                                   versions.pin());
+        latestSnapshot = snapshot;
+    }
+    return snapshot;
+}
+
+void ParentStore::commitChanges(const std::vector<TodoChange>& changes)
+{
+    checkChanges(changes);
+    if(log)
+    {
+        log->append(changes);
+    }
+    versions.next();
+
+    /**
+     * The indexed values of every todo before its first change. The columns are changed right away,
+     * the indexes once every change is applied, so a todo changed many times is reindexed once.
+     */
+    struct IndexedValues
+    {
+        bool indexed;
+        std::string title;
+        double timestamp;
+    };
+    FlatIdMap<IndexedValues> indexedValues;
+    indexedValues.reserve(changes.size());
+    for(const auto& change : changes)
+    {
+        const auto slot{todos.find(change.id)};
+        const auto firstChange{indexedValues.try_emplace(change.id)};
+        if(firstChange.second)
+        {
+            keepOldVersion(change.id, slot);
+            auto& values{firstChange.first->second};
+            values.indexed = slot not_eq TodoColumns::npos;
+            if(values.indexed)
+            {
+                values.title = todos.title(slot);
+                values.timestamp = todos.timestamp(slot);
+            }
+        }
+        switch(change.kind)
+        {
+            case TodoChange::Kind::insert:
+                todos.insert(Todo{change.id, change.patch->title, change.patch->description, change.patch->timestamp});
+                break;
+            case TodoChange::Kind::update:
+            {
+                Todo todo{change.id, todos.title(slot), todos.description(slot), todos.timestamp(slot)};
+                change.patch->applyTo(todo);
+                todos.title(slot) = std::move(todo.title);
+                todos.description(slot) = std::move(todo.description);
+                todos.timestamp(slot) = todo.timestamp;
+                break;
+            }
+            case TodoChange::Kind::remove:
+                todos.erase(slot);
+                break;
+        }
+    }
+
+    std::unordered_map<std::string_view, std::vector<std::int64_t>> addedTitleIds;
+    std::vector<TimestampTree::Entry> addedTimestamps;
+    for(const auto& todo : indexedValues)
+    {
+        const auto id{todo.first};
+        const auto& values{todo.second};
+        const auto slot{todos.find(id)};
+        const auto exists{slot not_eq TodoColumns::npos};
+        const auto titleChanged{not exists or not values.indexed or todos.title(slot) not_eq values.title};
+        const auto timestampChanged{not exists or not values.indexed or todos.timestamp(slot) not_eq values.timestamp};
+        if(values.indexed and titleChanged)
+        {
+            titleIds.remove(values.title, id);
+        }
+        if(values.indexed and timestampChanged)
+        {
+            timestampIds.remove(values.timestamp, id);
+        }
+        if(exists and titleChanged)
+        {
+            addedTitleIds[todos.title(slot)].push_back(id);
+        }
+        if(exists and timestampChanged)
+        {
+            addedTimestamps.push_back({todos.timestamp(slot), id});
+        }
+    }
+    for(auto& titleIdsPair : addedTitleIds)
+    {
+        titleIds.insert(std::string{titleIdsPair.first}, std::move(titleIdsPair.second));
+    }
+    timestampIds.insert(std::move(addedTimestamps));
+}
+
+void ParentStore::commitDeltas(const std::vector<CommitDelta>& deltas)
+{
+    // every todo is changed once, so its slot is looked up once to check the change and to apply it
+    std::vector<TodoColumns::Slot> slots;
+    for(const auto& delta : deltas)
+    {
+        for(const auto& change : delta.changes)
+        {
+            const auto slot{todos.find(change.id)};
+            checkChange(change, slot not_eq TodoColumns::npos);
+            slots.push_back(slot);
+        }
+    }
+    if(log)
+    {
+        logDeltas(deltas);
+    }
+    versions.next();
+
+    auto slot{slots.begin()};
+    std::vector<TimestampTree::Entry> hiddenTimestamps;
+    for(const auto& delta : deltas)
+    {
+        for(const auto& change : delta.changes)
+        {
+            keepOldVersion(change.id, *slot);
+            const auto hidden{delta.hiddenParentValues->find(change.id)};
+            if(hidden not_eq delta.hiddenParentValues->end() and *slot not_eq TodoColumns::npos)
+            {
+                // the values are read from the columns before changing them, without copying them
+                if((hidden->second & propertyBit(TodoPropertyId::title)) not_eq 0)
+                {
+                    titleIds.remove(todos.title(*slot), change.id);
+                }
+                if((hidden->second & propertyBit(TodoPropertyId::timestamp)) not_eq 0)
+                {
+                    hiddenTimestamps.push_back({todos.timestamp(*slot), change.id});
+                }
+            }
+            switch(change.kind)
+            {
+                case TodoChange::Kind::insert:
+                    todos.insert(Todo{change.id, change.patch->title, change.patch->description,
+                                      change.patch->timestamp});
+                    break;
+                case TodoChange::Kind::update:
+                {
+                    // only the properties present in the patch are written, Complexity O(1)
+                    const auto& patch{*change.patch};
+                    if(patch.has(TodoPropertyId::title))
+                    {
+                        todos.title(*slot) = patch.title;
+                    }
+                    if(patch.has(TodoPropertyId::description))
+                    {
+                        todos.description(*slot) = patch.description;
+                    }
+                    if(patch.has(TodoPropertyId::timestamp))
+                    {
+                        todos.timestamp(*slot) = patch.timestamp;
+                    }
+                    break;
+                }
+                case TodoChange::Kind::remove:
+                    todos.erase(*slot);
+                    break;
+            }
+            ++slot;
+        }
+
+        // the old entries go first, a todo can keep a value the delta removes and adds again.
+        // Removing an entry of a hidden value twice does nothing
+        titleIds.remove(*delta.removedTitleIds); // Complexity O(k log n)
+        timestampIds.remove(*delta.removedTimestampIds); // Complexity O(k log n), O(n + k) for big deltas
+        timestampIds.remove(std::move(hiddenTimestamps));
+        hiddenTimestamps.clear();
+        titleIds.insert(*delta.addedTitleIds);
+        timestampIds.insert(*delta.addedTimestampIds);
+    }
+}
+
+void ParentStore::logDeltas(const std::vector<CommitDelta>& deltas)
+{
+    if(deltas.size() == 1)
+    {
+        log->append(deltas.front().changes);
+        return;
+    }
+    // the commits of a group are a single version, so they are a single record
+    std::vector<const std::vector<TodoChange>*> changeLists;
+    changeLists.reserve(deltas.size());
+    for(const auto& delta : deltas)
+    {
+        changeLists.push_back(&delta.changes);
+    }
+    log->append(changeLists);
+}
+
+void ParentStore::checkChanges(const std::vector<TodoChange>& changes) const
+{
+    // whether every changed todo exists after the changes seen so far
+    FlatIdMap<bool> exists;
+    for(const auto& change : changes)
+    {
+        const auto existsIt{exists.find(change.id)};
+        checkChange(change, existsIt not_eq exists.end() ? existsIt->second
+                                                         : todos.find(change.id) not_eq TodoColumns::npos);
+        exists[change.id] = change.kind not_eq TodoChange::Kind::remove;
+    }
+}
+
+void ParentStore::checkChange(const TodoChange& change, bool todoExists)
+{
+    switch(change.kind)
+    {
+        case TodoChange::Kind::insert:
+            if(not change.patch->complete())
+            {
+                throw std::invalid_argument("Missing properties when inserting a todo in the store. "
+                                            "Please review that all properties are specified");
+            }
+            break;
+        case TodoChange::Kind::update:
+            if(not todoExists)
+            {
+                throw std::invalid_argument("Error updating properties. "
+                                            "Todo with id "+std::to_string(change.id)+" not found");
+            }
+            break;
+        case TodoChange::Kind::remove:
+            if(not todoExists)
+            {
+                throw std::invalid_argument("Error removing todo. "
+                                            "Todo with id "+std::to_string(change.id)+" not found");
+            }
+            break;
+    }
+}
+
+void ParentStore::keepOldVersion(std::int64_t id, TodoColumns::Slot slot)
+{
+    versions.log(id);
+    if(not versions.mustKeep(id))
+    {
+        return;
+    }
+    std::optional<Todo> oldTodo;
+    if(slot not_eq TodoColumns::npos)
+    {
+        oldTodo = Todo{id, todos.title(slot), todos.description(slot), todos.timestamp(slot)};
+    }
+    versions.keep(id, std::move(oldTodo));
+}
@@ -4,24 +4,126 @@
 #include <map>
 #include <list>
 #include <memory>
+#include "Arena.h"
+#include "ChildPool.h"
 #include "Store.h"
 #include "StringPropertyIds.h"
 #include "DoublePropertyIds.h"
+#include "TodoColumns.h"
+#include "TodoVersions.h"
+#include "WriteAheadLog.h"
+
+class StoreSnapshot;
+
+/**
+ * Everything a child commit changes in its parent store: the changed todos, at most one change per todo,
+ * and the index entries it removes (the parent values of the changed todos) and adds (their new values).
+ * The child already keeps these entries to answer its own queries, so they are not computed again.
+ * The parent values the child never looked up are not listed, only the ids with the mask of the properties
+ * to remove (hiddenParentValues), and the store removes the values it has.
+ */
+struct CommitDelta
+{
+    std::vector<TodoChange> changes;
+    const StringPropertyIds* removedTitleIds;
+    const DoublePropertyIds* removedTimestampIds;
+    const FlatIdMap<std::uint8_t>* hiddenParentValues;
+    const StringPropertyIds* addedTitleIds;
+    const DoublePropertyIds* addedTimestampIds;
+};
 
 class ParentStore: public Store
 {
 public:
+    /**
+     * Store recovered from the write-ahead log at the path (empty if it does not exist), which then logs
+     * every change of the store before applying it: insert, batch insertion, update, remove and the commits
+     * of its children. Only the changes are logged, a store built without a log keeps everything in memory.
+     */
+    static std::shared_ptr<ParentStore> open(const std::string& logPath, WriteAheadLog::Options options = {});
+
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
     void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
     void update(std::int64_t id, const TodoProperties& properties) override;
     TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
     void remove(std::int64_t id) override;
     bool checkId(std::int64_t id) const override;
-    std::unordered_set<std::int64_t> query(const TodoProperty& property) const override;
-    std::unordered_set<std::int64_t> rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    /**
+     * Children read the store through a snapshot pinned when they are created,
+     * so the changes committed by other children afterwards are not seen by them.
+     */
     std::unique_ptr<Store> createChild() override;
+    /**
+     * Child taken from the ones released before, with their containers still allocated, or a new one.
+     * It is rolled back and kept for the next call once the last reference to it is dropped, instead of being
+     * destroyed, so short transactions do not build their containers every time.
+     * Like createChild, the store must be owned by a std::shared_ptr.
+     */
+    std::shared_ptr<ChildStore> acquireChild();
     void commit() override;
+    void rollback() override;
+
+    /**
+     * Applies the changes of one or many commits in order as a single version. The index entries of every
+     * todo are changed once, from its values before the first change to the ones after the last, and the
+     * new ones are bulk inserted. All the changes are checked first, so if one of them is invalid
+     * (std::invalid_argument, like insert, update and remove) nothing is applied.
+     */
+    void commitChanges(const std::vector<TodoChange>& changes);
+
+    /**
+     * Applies the deltas of one or many commits as a single version, without looking up the old values
+     * of the changed todos: the index entries of every delta are removed and added in bulk as they are.
+     * Deltas must change different todos, and their removed entries must be the current values of the store
+     * (what the commit validation of the children guarantees). If a change is invalid (std::invalid_argument,
+     * like insert, update and remove) nothing is applied.
+     */
+    void commitDeltas(const std::vector<CommitDelta>& deltas);
+
+    /**
+     * Title and timestamp of a todo (the indexed properties), false if it does not exist.
+     * The description is not copied, it is the lookup of child stores hiding the parent index entries.
+     */
+    bool getIndexedValues(std::int64_t id, std::string& title, double& timestamp) const;
+
+    /**
+     * Read-only view of the store at its current version, shared with the other views taken
+     * at the same version. The store must be owned by a std::shared_ptr.
+     */
+    std::shared_ptr<StoreSnapshot> snapshot();
+
+    /**
+     * Commit sequence number, every insert, batch insertion, update and remove is a new version.
+     */
+    std::uint64_t version() const { return versions.current(); }
 private:
-    std::unordered_map<std::int64_t, Todo> todos;
+    friend class StoreSnapshot;
+    friend class ChildStore;
+
+    /**
+     * Keeps the todo as it is before the change of the current version if a snapshot still reads it.
+     */
+    void keepOldVersion(std::int64_t id, TodoColumns::Slot slot);
+
+    void logDeltas(const std::vector<CommitDelta>& deltas);
+    void checkChanges(const std::vector<TodoChange>& changes) const;
+    static void checkChange(const TodoChange& change, bool todoExists);
+
+    /**
+     * Columnar storage, each property is kept in its own contiguous column
+     * so scans and range filters only read the memory they need.
+     */
+    TodoColumns todos;
     /**
      * titleIds will keep track of all ids with the same title in order
      * to improve the querying by title.
@@ -32,6 +134,26 @@ private:
      * in order to improve the timestamp range query feature.
      */
     DoublePropertyIds timestampIds;
+    /**
+     * Old versions of the todos changed after the version of a snapshot still alive.
+     */
+    TodoVersions versions;
+    /**
+     * Last snapshot taken, reused while the version does not change.
+     */
+    std::weak_ptr<StoreSnapshot> latestSnapshot;
+    /**
+     * Arenas of the child changes, recycled from one child to the next.
+     */
+    std::shared_ptr<ArenaPool> arenas{std::make_shared<ArenaPool>()};
+    /**
+     * Children released by their users, reused by acquireChild.
+     */
+    std::shared_ptr<ChildPool> children{std::make_shared<ChildPool>()};
+    /**
+     * Where the changes are made durable, null when the store is not opened from a log.
+     */
+    std::shared_ptr<WriteAheadLog> log;
 };
 
 
@@ -0,0 +1,258 @@
+#include <stdexcept>
+#include "PersistentChildStore.h"
+#include "PersistentParentStore.h"
+
+PersistentChildStore::PersistentChildStore(std::shared_ptr<PersistentParentStore> parent)
+        : parent{std::move(parent)}
+{
+    restart();
+}
+
+PersistentChildStore::PersistentChildStore(std::shared_ptr<PersistentChildStore> parentChild)
+        : parentChild{std::move(parentChild)}
+{
+    restart();
+}
+
+void PersistentChildStore::insert(std::int64_t id, TodoPatch patch)
+{
+    if(not patch.complete())
+    {
+        throw std::invalid_argument("Missing properties when inserting a todo in the store. "
+                                    "Please review that all properties are specified");
+    }
+    todos.put(std::make_shared<const Todo>(Todo{id, std::move(patch.title), std::move(patch.description),
+                                                patch.timestamp}));
+    writtenIds.insert(id);
+}
+
+void PersistentChildStore::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void PersistentChildStore::insertBatch(const std::vector<Todo>& batch)
+{
+    for(const auto& todo : batch)
+    {
+        todos.put(std::make_shared<const Todo>(todo));
+        writtenIds.insert(todo.id);
+    }
+}
+
+void PersistentChildStore::update(std::int64_t id, const TodoPatch& patch)
+{
+    if(not todos.update(id, patch))
+    {
+        throw std::invalid_argument("Error updating properties. "
+                                    "Todo with id "+std::to_string(id)+" not found");
+    }
+    writtenIds.insert(id);
+}
+
+void PersistentChildStore::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void PersistentChildStore::get(std::int64_t id, Todo& todo) const
+{
+    readSet.ids.insert(id);
+    const auto* record{todos.find(id)};
+    if(not record)
+    {
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
+    }
+    todo.id = id;
+    todo.title = record->title;
+    todo.description = record->description;
+    todo.timestamp = record->timestamp;
+}
+
+TodoProperties PersistentChildStore::get(std::int64_t id) const
+{
+    Todo todo;
+    get(id, todo);
+    return toProperties(todo);
+}
+
+void PersistentChildStore::getMany(const std::vector<std::int64_t>& ids,
+                                   std::vector<std::optional<Todo>>& result) const
+{
+    result.resize(ids.size());
+    for(std::size_t i{0}; i < ids.size(); ++i)
+    {
+        readSet.ids.insert(ids[i]);
+        const auto* record{todos.find(ids[i])};
+        auto& todo{result[i]};
+        if(not record)
+        {
+            todo.reset();
+            continue;
+        }
+        if(not todo)
+        {
+            todo.emplace();
+        }
+        todo->id = record->id;
+        todo->title = record->title;
+        todo->description = record->description;
+        todo->timestamp = record->timestamp;
+    }
+}
+
+void PersistentChildStore::remove(std::int64_t id)
+{
+    if(not todos.remove(id))
+    {
+        throw std::invalid_argument("Error removing todo. "
+                                    "Todo with id "+std::to_string(id)+" not found");
+    }
+    writtenIds.insert(id);
+}
+
+bool PersistentChildStore::checkId(std::int64_t id) const
+{
+    readSet.ids.insert(id);
+    return todos.find(id) not_eq nullptr;
+}
+
+IdRange PersistentChildStore::query(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return {};
+    }
+    const auto& title{std::get<std::string>(property.second)};
+    readSet.titles.insert(title);
+    return todos.query(title);
+}
+
+IdRange PersistentChildStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    readSet.timestampRanges.emplace(minTimeStamp, maxTimeStamp);
+    return todos.rangeQuery(minTimeStamp, maxTimeStamp);
+}
+
+RangePage PersistentChildStore::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                                  std::size_t limit, const RangeCursor& cursor) const
+{
+    readSet.timestampRanges.emplace(minTimeStamp, maxTimeStamp);
+    return todos.rangeQueryOrdered(minTimeStamp, maxTimeStamp, limit, cursor);
+}
+
+std::size_t PersistentChildStore::queryCount(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return 0;
+    }
+    const auto& title{std::get<std::string>(property.second)};
+    readSet.titles.insert(title);
+    return todos.queryCount(title);
+}
+
+std::size_t PersistentChildStore::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    readSet.timestampRanges.emplace(minTimeStamp, maxTimeStamp);
+    return todos.rangeCount(minTimeStamp, maxTimeStamp);
+}
+
+std::unique_ptr<Store> PersistentChildStore::createChild()
+{
+    return std::make_unique<PersistentChildStore>(
+            std::static_pointer_cast<PersistentChildStore>(shared_from_this()));
+}
+
+void PersistentChildStore::commit()
+{
+    if(parentChild)
+    {
+        commitInto(parentChild->todos);
+        // the parent child validates what its nested child read and wrote when it commits
+        parentChild->readSet.merge(readSet);
+        for(const auto id : writtenIds)
+        {
+            parentChild->writtenIds.insert(id);
+        }
+    } else
+    {
+        std::lock_guard lock{parent->writerMutex};
+        auto target{*parent->latest()};
+        commitInto(target);
+        parent->publish(std::make_shared<const PersistentTodos>(std::move(target)));
+    }
+    restart();
+}
+
+void PersistentChildStore::rollback()
+{
+    restart();
+}
+
+void PersistentChildStore::restart()
+{
+    // Complexity O(1), the copy shares every node with the version of the parent
+    base = parent ? parent->latest() : std::make_shared<const PersistentTodos>(parentChild->todos);
+    todos = *base;
+    writtenIds = {};
+    readSet.clear();
+}
+
+void PersistentChildStore::validate(const PersistentTodos& target) const
+{
+    const auto validateId{[this, &target](std::int64_t id)
+                          {
+                              if(not target.sameTodo(*base, id))
+                              {
+                                  throw CommitConflict("Todo with id "+std::to_string(id)+
+                                                       " was changed by another commit");
+                              }
+                          }};
+    for(const auto id : writtenIds)
+    {
+        validateId(id);
+    }
+    for(const auto id : readSet.ids)
+    {
+        validateId(id);
+    }
+    for(const auto& title : readSet.titles)
+    {
+        if(not target.sameTitle(*base, title))
+        {
+            throw CommitConflict("Todos with title "+title+" were changed by another commit");
+        }
+    }
+    for(const auto& range : readSet.timestampRanges)
+    {
+        if(not target.sameRange(*base, range.first, range.second))
+        {
+            throw CommitConflict("Todos with timestamp between "+std::to_string(range.first)+" and "+
+                                 std::to_string(range.second)+" were changed by another commit");
+        }
+    }
+}
+
+void PersistentChildStore::commitInto(PersistentTodos& target) const
+{
+    // nothing was committed into the parent since the child was created, its version is the next one
+    if(target.sameVersion(*base))
+    {
+        target = todos;
+        return;
+    }
+    validate(target);
+    // Complexity O(k log n), the records of the child are shared, not copied
+    for(const auto id : writtenIds)
+    {
+        auto record{todos.record(id)};
+        if(record)
+        {
+            target.put(std::move(record));
+        } else
+        {
+            target.remove(id);
+        }
+    }
+}
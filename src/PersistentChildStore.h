@@ -0,0 +1,82 @@
+#pragma once
+#include <memory>
+#include "Store.h"
+#include "IdSet.h"
+#include "ReadSet.h"
+#include "PersistentTodos.h"
+
+class PersistentParentStore;
+
+/**
+ * Responsibility: a transaction over a PersistentParentStore (or over another persistent child).
+ *
+ * The child starts from the version of its parent in O(1) and changes its own copy of it, so it reads
+ * its todos and indexes directly, at the cost of a parent read, whatever it changed. It remembers the ids
+ * it wrote and what it read to validate its commit (optimistic concurrency control, like ChildStore).
+ * Updating or removing a todo that does not exist throws std::invalid_argument right away.
+ */
+class PersistentChildStore: public Store
+{
+public:
+    explicit PersistentChildStore(std::shared_ptr<PersistentParentStore> parent);
+    /**
+     * Nested child, it commits into its parent child.
+     */
+    explicit PersistentChildStore(std::shared_ptr<PersistentChildStore> parentChild);
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
+    void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
+    void update(std::int64_t id, const TodoProperties& properties) override;
+    TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
+    void remove(std::int64_t id) override;
+    bool checkId(std::int64_t id) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    /**
+     * The child must be owned by a std::shared_ptr, the nested child keeps it alive to commit into it.
+     */
+    std::unique_ptr<Store> createChild() override;
+    /**
+     * When nothing was committed into the parent since the child was created, its version replaces the one
+     * of the parent in O(1). Otherwise the commit is validated like the one of a ChildStore (CommitConflict,
+     * committing nothing) and the todos written by the child are put into the latest version of the parent.
+     * After committing, the child reads the new version of the parent.
+     */
+    void commit() override;
+    void rollback() override;
+
+private:
+    /**
+     * Goes on over the latest version of the parent, without changes nor reads.
+     */
+    void restart();
+
+    /**
+     * Throws CommitConflict if a todo the child read or wrote, a title it queried or a timestamp range
+     * it queried is not the same in the target than in the version the child started from.
+     */
+    void validate(const PersistentTodos& target) const;
+
+    /**
+     * Makes the target (the latest version of the parent) the version of the child plus the changes
+     * committed into it since the child was created.
+     */
+    void commitInto(PersistentTodos& target) const;
+
+    std::shared_ptr<PersistentParentStore> parent;
+    std::shared_ptr<PersistentChildStore> parentChild;
+    /**
+     * The version the child started from, which also keeps alive the records the validation compares.
+     */
+    std::shared_ptr<const PersistentTodos> base;
+    PersistentTodos todos;
+    IdSet writtenIds;
+    mutable ReadSet readSet;
+};
@@ -0,0 +1,357 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Responsibility: map keys to values with a hash array mapped trie (HAMT) whose versions share their nodes,
+ * so copying the map is O(1) and both copies can be changed independently (a persistent map).
+ *
+ * Every node takes 5 bits of the hash of the keys and keeps, in the order of those bits, the entries alone
+ * in their slot and the child nodes of the slots shared by several keys, with a bitmap of each to find
+ * the position of a slot with a popcount (the CHAMP layout). Changing a key copies the nodes of its path
+ * that are shared with another version (path copying, O(log32 n) nodes) and changes in place the ones only
+ * this map references, so a run of changes on a fresh copy only copies every node once.
+ * Keys whose 64 hash bits are all equal are kept in a list at the bottom of the trie.
+ * Copies can be read and changed from different threads, a single map cannot be changed while read.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class PersistentHashMap
+{
+public:
+    struct Entry
+    {
+        Key first;
+        Value second;
+    };
+
+private:
+    static constexpr unsigned bitsPerLevel{5};
+    static constexpr unsigned hashBits{64};
+
+    struct Node;
+    using NodePointer = std::shared_ptr<Node>;
+
+    /**
+     * Below hashBits the entries and children are sorted by their slot, at the bottom the entries
+     * are the keys with the same hash, in no order.
+     */
+    struct Node
+    {
+        std::uint32_t entryMap{0};
+        std::uint32_t childMap{0};
+        std::vector<Entry> entries;
+        std::vector<NodePointer> children;
+    };
+
+    static std::uint64_t hashOf(const Key& key) { return Hash{}(key); }
+    static std::uint32_t slotBit(std::uint64_t hash, unsigned shift) { return 1u << ((hash >> shift) & 31u); }
+    static std::size_t position(std::uint32_t map, std::uint32_t bit)
+    {
+        return static_cast<std::size_t>(__builtin_popcount(map & (bit - 1)));
+    }
+
+public:
+    /**
+     * Forward iterator over the entries, in the order of their hash. It does not keep the nodes alive,
+     * the map (or a copy of it) must outlive it.
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry*;
+        using reference = const Entry&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return frames.back().node->entries[frames.back().entry]; }
+        pointer operator->() const { return &**this; }
+
+        const_iterator& operator++()
+        {
+            ++frames.back().entry;
+            settle();
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto copy{*this};
+            ++(*this);
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            if(frames.empty() or other.frames.empty())
+            {
+                return frames.empty() == other.frames.empty();
+            }
+            return frames.back().node == other.frames.back().node and
+                   frames.back().entry == other.frames.back().entry;
+        }
+        bool operator!=(const const_iterator& other) const { return not (*this == other); }
+
+    private:
+        friend class PersistentHashMap;
+
+        struct Frame
+        {
+            const Node* node;
+            std::size_t entry;
+            std::size_t child;
+        };
+
+        explicit const_iterator(const Node* root)
+        {
+            if(root)
+            {
+                frames.push_back({root, 0, 0});
+                settle();
+            }
+        }
+
+        /**
+         * Entries of a node first, then the ones of its children, depth first.
+         */
+        void settle()
+        {
+            while(not frames.empty())
+            {
+                auto& frame{frames.back()};
+                if(frame.entry < frame.node->entries.size())
+                {
+                    return;
+                }
+                if(frame.child < frame.node->children.size())
+                {
+                    const auto* child{frame.node->children[frame.child++].get()};
+                    frames.push_back({child, 0, 0});
+                    continue;
+                }
+                frames.pop_back();
+            }
+        }
+
+        std::vector<Frame> frames;
+    };
+
+    std::size_t size() const { return entryCount; }
+    bool empty() const { return entryCount == 0; }
+
+    /**
+     * Returns nullptr if the key is not in the map. Complexity O(log32 n)
+     */
+    const Value* find(const Key& key) const
+    {
+        const auto hash{hashOf(key)};
+        const auto* node{root.get()};
+        for(unsigned shift{0}; node; shift += bitsPerLevel)
+        {
+            if(shift >= hashBits)
+            {
+                for(const auto& entry : node->entries)
+                {
+                    if(entry.first == key)
+                    {
+                        return &entry.second;
+                    }
+                }
+                return nullptr;
+            }
+            const auto bit{slotBit(hash, shift)};
+            if(node->entryMap & bit)
+            {
+                const auto& entry{node->entries[position(node->entryMap, bit)]};
+                return entry.first == key ? &entry.second : nullptr;
+            }
+            node = node->childMap & bit ? node->children[position(node->childMap, bit)].get() : nullptr;
+        }
+        return nullptr;
+    }
+
+    bool contains(const Key& key) const { return find(key) not_eq nullptr; }
+
+    /**
+     * Value of the key to be changed in place, a default constructed one is inserted if the key is not
+     * in the map. The reference is valid until the map is changed again. Complexity O(log32 n)
+     */
+    Value& operator[](const Key& key)
+    {
+        if(not root)
+        {
+            root = std::make_shared<Node>();
+        }
+        bool inserted{false};
+        auto& value{writableValue(root, hashOf(key), 0, key, inserted)};
+        entryCount += inserted ? 1 : 0;
+        return value;
+    }
+
+    /**
+     * Returns false if the key was already in the map, its value is replaced anyway.
+     */
+    bool insertOrAssign(const Key& key, Value value)
+    {
+        const auto previousCount{entryCount};
+        (*this)[key] = std::move(value);
+        return entryCount not_eq previousCount;
+    }
+
+    /**
+     * Returns false if the key was not in the map. Complexity O(log32 n)
+     */
+    bool erase(const Key& key)
+    {
+        // nothing is copied when there is nothing to remove
+        if(not contains(key))
+        {
+            return false;
+        }
+        erase(root, hashOf(key), 0, key);
+        if(--entryCount == 0)
+        {
+            root.reset();
+        }
+        return true;
+    }
+
+    /**
+     * True if both maps are the same version or come from it without changes, so they are equal without
+     * reading them. Maps with the same entries built by different changes are not the same version.
+     */
+    bool sameVersion(const PersistentHashMap& other) const { return root == other.root; }
+
+    const_iterator begin() const { return const_iterator{root.get()}; }
+    const_iterator end() const { return {}; }
+
+private:
+    /**
+     * Nodes referenced by another version are copied before being changed.
+     */
+    static Node& writable(NodePointer& node)
+    {
+        if(node.use_count() not_eq 1)
+        {
+            node = std::make_shared<Node>(*node);
+        }
+        return *node;
+    }
+
+    static Value& writableValue(NodePointer& nodePointer, std::uint64_t hash, unsigned shift,
+                                const Key& key, bool& inserted)
+    {
+        auto& node{writable(nodePointer)};
+        if(shift >= hashBits)
+        {
+            for(auto& entry : node.entries)
+            {
+                if(entry.first == key)
+                {
+                    return entry.second;
+                }
+            }
+            inserted = true;
+            node.entries.push_back({key, Value{}});
+            return node.entries.back().second;
+        }
+
+        const auto bit{slotBit(hash, shift)};
+        if(node.childMap & bit)
+        {
+            return writableValue(node.children[position(node.childMap, bit)], hash, shift + bitsPerLevel,
+                                 key, inserted);
+        }
+        if(node.entryMap & bit)
+        {
+            const auto entryPosition{position(node.entryMap, bit)};
+            if(node.entries[entryPosition].first == key)
+            {
+                return node.entries[entryPosition].second;
+            }
+            // the slot is shared by two keys now, both go down to a new child
+            auto child{std::make_shared<Node>()};
+            auto existing{std::move(node.entries[entryPosition])};
+            const auto existingHash{hashOf(existing.first)};
+            node.entries.erase(node.entries.begin() + static_cast<std::ptrdiff_t>(entryPosition));
+            node.entryMap &= ~bit;
+            node.children.insert(node.children.begin() + static_cast<std::ptrdiff_t>(position(node.childMap, bit)),
+                                 child);
+            node.childMap |= bit;
+            insertEntry(*child, existingHash, shift + bitsPerLevel, std::move(existing));
+            return writableValue(node.children[position(node.childMap, bit)], hash, shift + bitsPerLevel,
+                                 key, inserted);
+        }
+        inserted = true;
+        const auto entryPosition{position(node.entryMap, bit)};
+        node.entryMap |= bit;
+        return node.entries.insert(node.entries.begin() + static_cast<std::ptrdiff_t>(entryPosition),
+                                   Entry{key, Value{}})->second;
+    }
+
+    /**
+     * Inserts an entry in a new node, which is not shared yet.
+     */
+    static void insertEntry(Node& node, std::uint64_t hash, unsigned shift, Entry entry)
+    {
+        if(shift >= hashBits)
+        {
+            node.entries.push_back(std::move(entry));
+            return;
+        }
+        const auto bit{slotBit(hash, shift)};
+        node.entries.insert(node.entries.begin() + static_cast<std::ptrdiff_t>(position(node.entryMap, bit)),
+                            std::move(entry));
+        node.entryMap |= bit;
+    }
+
+    /**
+     * The key must be in the map. A child left with a single entry is replaced by it, so the trie
+     * does not keep the paths of removed keys.
+     */
+    static void erase(NodePointer& nodePointer, std::uint64_t hash, unsigned shift, const Key& key)
+    {
+        auto& node{writable(nodePointer)};
+        if(shift >= hashBits)
+        {
+            for(auto entry{node.entries.begin()}; entry not_eq node.entries.end(); ++entry)
+            {
+                if(entry->first == key)
+                {
+                    node.entries.erase(entry);
+                    return;
+                }
+            }
+            return;
+        }
+
+        const auto bit{slotBit(hash, shift)};
+        if(node.entryMap & bit)
+        {
+            node.entries.erase(node.entries.begin() + static_cast<std::ptrdiff_t>(position(node.entryMap, bit)));
+            node.entryMap &= ~bit;
+            return;
+        }
+        const auto childPosition{position(node.childMap, bit)};
+        auto& child{node.children[childPosition]};
+        erase(child, hash, shift + bitsPerLevel, key);
+        if(child->children.empty() and child->entries.size() == 1)
+        {
+            auto entry{std::move(writable(child).entries.front())};
+            node.children.erase(node.children.begin() + static_cast<std::ptrdiff_t>(childPosition));
+            node.childMap &= ~bit;
+            node.entries.insert(node.entries.begin() + static_cast<std::ptrdiff_t>(position(node.entryMap, bit)),
+                                std::move(entry));
+            node.entryMap |= bit;
+        }
+    }
+
+    NodePointer root;
+    std::size_t entryCount{0};
+};
@@ -0,0 +1,181 @@
+#include <stdexcept>
+#include "PersistentParentStore.h"
+#include "PersistentChildStore.h"
+
+void PersistentParentStore::insert(std::int64_t id, TodoPatch patch)
+{
+    if(not patch.complete())
+    {
+        throw std::invalid_argument("Missing properties when inserting a todo in the store. "
+                                    "Please review that all properties are specified");
+    }
+    // the strings of the patch are moved into the record
+    auto record{std::make_shared<const Todo>(Todo{id, std::move(patch.title), std::move(patch.description),
+                                                  patch.timestamp})};
+    change([&record](PersistentTodos& next) { next.put(std::move(record)); });
+}
+
+void PersistentParentStore::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void PersistentParentStore::insertBatch(const std::vector<Todo>& batch)
+{
+    // the whole batch is a single version
+    change([&batch](PersistentTodos& next) { next.insertBatch(batch); });
+}
+
+void PersistentParentStore::update(std::int64_t id, const TodoPatch& patch)
+{
+    change([id, &patch](PersistentTodos& next)
+           {
+               if(not next.update(id, patch))
+               {
+                   throw std::invalid_argument("Error updating properties. "
+                                               "Todo with id "+std::to_string(id)+" not found");
+               }
+           });
+}
+
+void PersistentParentStore::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void PersistentParentStore::get(std::int64_t id, Todo& todo) const
+{
+    const auto current{latest()};
+    const auto* record{current->find(id)};
+    if(not record)
+    {
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
+    }
+    // assigning the strings reuses the memory they already have
+    todo.id = id;
+    todo.title = record->title;
+    todo.description = record->description;
+    todo.timestamp = record->timestamp;
+}
+
+TodoProperties PersistentParentStore::get(std::int64_t id) const
+{
+    Todo todo;
+    get(id, todo);
+    return toProperties(todo);
+}
+
+void PersistentParentStore::getMany(const std::vector<std::int64_t>& ids,
+                                    std::vector<std::optional<Todo>>& result) const
+{
+    result.resize(ids.size());
+    // every todo is read from the same version
+    const auto current{latest()};
+    for(std::size_t i{0}; i < ids.size(); ++i)
+    {
+        const auto* record{current->find(ids[i])};
+        auto& todo{result[i]};
+        if(not record)
+        {
+            todo.reset();
+            continue;
+        }
+        if(not todo)
+        {
+            todo.emplace();
+        }
+        todo->id = record->id;
+        todo->title = record->title;
+        todo->description = record->description;
+        todo->timestamp = record->timestamp;
+    }
+}
+
+void PersistentParentStore::remove(std::int64_t id)
+{
+    change([id](PersistentTodos& next)
+           {
+               if(not next.remove(id))
+               {
+                   throw std::invalid_argument("Error removing todo. "
+                                               "Todo with id "+std::to_string(id)+" not found");
+               }
+           });
+}
+
+bool PersistentParentStore::checkId(std::int64_t id) const
+{
+    return latest()->find(id) not_eq nullptr;
+}
+
+IdRange PersistentParentStore::query(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return {};
+    }
+    // the range keeps the posting list it reads, so it is not changed by the writes done meanwhile
+    return latest()->query(std::get<std::string>(property.second));
+}
+
+IdRange PersistentParentStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    return latest()->rangeQuery(minTimeStamp, maxTimeStamp);
+}
+
+RangePage PersistentParentStore::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                                   std::size_t limit, const RangeCursor& cursor) const
+{
+    return latest()->rangeQueryOrdered(minTimeStamp, maxTimeStamp, limit, cursor);
+}
+
+std::size_t PersistentParentStore::queryCount(const TodoProperty& property) const
+{
+    if(property.first not_eq titleKey)
+    {
+        return 0;
+    }
+    return latest()->queryCount(std::get<std::string>(property.second));
+}
+
+std::size_t PersistentParentStore::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    return latest()->rangeCount(minTimeStamp, maxTimeStamp);
+}
+
+std::unique_ptr<Store> PersistentParentStore::createChild()
+{
+    return std::make_unique<PersistentChildStore>(
+            std::static_pointer_cast<PersistentParentStore>(shared_from_this()));
+}
+
+void PersistentParentStore::commit()
+{
+    throw std::runtime_error("Parent store cannot commit, only child stores can");
+}
+
+void PersistentParentStore::rollback()
+{
+    throw std::runtime_error("Parent store cannot roll back, only child stores can");
+}
+
+std::shared_ptr<const PersistentTodos> PersistentParentStore::latest() const
+{
+    return std::atomic_load_explicit(&todos, std::memory_order_acquire);
+}
+
+void PersistentParentStore::publish(std::shared_ptr<const PersistentTodos> next)
+{
+    std::atomic_store_explicit(&todos, std::move(next), std::memory_order_release);
+    currentVersion.fetch_add(1, std::memory_order_acq_rel);
+}
+
+template<typename Change>
+void PersistentParentStore::change(Change change)
+{
+    std::lock_guard lock{writerMutex};
+    // Complexity O(1), the copy shares every node with the current version until it is changed
+    auto next{std::make_shared<PersistentTodos>(*latest())};
+    change(*next);
+    publish(std::move(next));
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "Store.h"
+#include "PersistentTodos.h"
+
+/**
+ * Responsibility: a parent store whose versions are persistent structures, published through an atomic pointer.
+ *
+ * The current version is an immutable PersistentTodos. Readers load it without locking and read it as it is,
+ * writers are serialized by a mutex, change a copy of it (path copying) and publish the copy. So a child
+ * is an O(1) structural snapshot of the store, it changes its own copy and reads it without merging
+ * any overlay with the parent, and committing it when nothing was committed since it was created is a swap
+ * of the published version. Long running reads (a child never committed) keep reading their version while
+ * the store is changed, the old nodes are freed once the last version using them is released.
+ */
+class PersistentParentStore: public Store
+{
+public:
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
+    void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
+    void update(std::int64_t id, const TodoProperties& properties) override;
+    TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
+    void remove(std::int64_t id) override;
+    bool checkId(std::int64_t id) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    /**
+     * The child starts from the current version in O(1). The store must be owned by a std::shared_ptr.
+     */
+    std::unique_ptr<Store> createChild() override;
+    void commit() override;
+    void rollback() override;
+
+    /**
+     * Commit sequence number, every insert, batch insertion, update, remove and child commit is a new version.
+     */
+    std::uint64_t version() const { return currentVersion.load(std::memory_order_acquire); }
+
+private:
+    friend class PersistentChildStore;
+
+    std::shared_ptr<const PersistentTodos> latest() const;
+
+    /**
+     * Publishes the version changed by a writer, the writer mutex must be locked.
+     */
+    void publish(std::shared_ptr<const PersistentTodos> next);
+
+    /**
+     * Applies the change to a copy of the current version and publishes it, nothing is published
+     * if the change throws.
+     */
+    template<typename Change>
+    void change(Change change);
+
+    mutable std::mutex writerMutex;
+    // only accessed through the atomic shared_ptr functions
+    std::shared_ptr<const PersistentTodos> todos{std::make_shared<const PersistentTodos>()};
+    std::atomic<std::uint64_t> currentVersion{0};
+};
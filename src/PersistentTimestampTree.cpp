@@ -0,0 +1,359 @@
+#include <algorithm>
+#include "PersistentTimestampTree.h"
+
+PersistentTimestampTree::const_iterator& PersistentTimestampTree::const_iterator::operator++()
+{
+    ++path.back().index;
+    skipLeafEnd();
+    return *this;
+}
+
+PersistentTimestampTree::const_iterator& PersistentTimestampTree::const_iterator::operator--()
+{
+    if(path.empty())
+    {
+        descendLast(root);
+        return *this;
+    }
+    if(path.back().index > 0)
+    {
+        --path.back().index;
+        return *this;
+    }
+    // the last entry of the previous leaf, below the closest ancestor with a previous child
+    path.pop_back();
+    while(not path.empty())
+    {
+        auto& step{path.back()};
+        if(step.index > 0)
+        {
+            --step.index;
+            descendLast(step.node->children[step.index].get());
+            return *this;
+        }
+        path.pop_back();
+    }
+    return *this;
+}
+
+void PersistentTimestampTree::const_iterator::descendFirst(const Node* node)
+{
+    while(not node->leaf())
+    {
+        path.push_back({node, 0});
+        node = node->children.front().get();
+    }
+    path.push_back({node, 0});
+}
+
+void PersistentTimestampTree::const_iterator::descendLast(const Node* node)
+{
+    while(not node->leaf())
+    {
+        path.push_back({node, node->children.size() - 1});
+        node = node->children.back().get();
+    }
+    path.push_back({node, node->entries.size() - 1});
+}
+
+void PersistentTimestampTree::const_iterator::skipLeafEnd()
+{
+    if(path.empty() or path.back().index < path.back().node->entries.size())
+    {
+        return;
+    }
+    // the first entry of the next leaf, below the closest ancestor with a next child
+    path.pop_back();
+    while(not path.empty())
+    {
+        auto& step{path.back()};
+        if(++step.index < step.node->children.size())
+        {
+            descendFirst(step.node->children[step.index].get());
+            return;
+        }
+        path.pop_back();
+    }
+}
+
+bool PersistentTimestampTree::insert(const Entry& entry)
+{
+    // nothing is copied when the entry is already there
+    if(contains(entry))
+    {
+        return false;
+    }
+    if(not root)
+    {
+        root = std::make_shared<Node>();
+    }
+    // Complexity O(log n), the nodes of the path are copied if they are shared
+    auto split{insert(root, entry)};
+    if(split)
+    {
+        auto newRoot{std::make_shared<Node>()};
+        newRoot->size = root->size + split->right->size;
+        newRoot->keys.push_back(split->separator);
+        newRoot->children.push_back(std::move(root));
+        newRoot->children.push_back(std::move(split->right));
+        root = std::move(newRoot);
+    }
+    return true;
+}
+
+bool PersistentTimestampTree::erase(const Entry& entry)
+{
+    // nothing is copied when the entry is not there
+    if(not contains(entry))
+    {
+        return false;
+    }
+    erase(root, entry);
+    if(root->size == 0)
+    {
+        root.reset();
+        return true;
+    }
+    while(not root->leaf() and root->children.size() == 1)
+    {
+        auto child{root->children.front()};
+        root = std::move(child);
+    }
+    return true;
+}
+
+bool PersistentTimestampTree::contains(const Entry& entry) const
+{
+    if(not root)
+    {
+        return false;
+    }
+    const auto* node{root.get()};
+    while(not node->leaf())
+    {
+        const auto childIndex{std::upper_bound(node->keys.begin(), node->keys.end(), entry) - node->keys.begin()};
+        node = node->children[static_cast<std::size_t>(childIndex)].get();
+    }
+    return std::binary_search(node->entries.begin(), node->entries.end(), entry);
+}
+
+PersistentTimestampTree::const_iterator PersistentTimestampTree::lowerBound(const Entry& entry) const
+{
+    return partitionPoint([&entry](const Entry& other) { return other < entry; });
+}
+
+PersistentTimestampTree::const_iterator PersistentTimestampTree::lowerBound(double timestamp) const
+{
+    return partitionPoint([timestamp](const Entry& other) { return other.timestamp < timestamp; });
+}
+
+PersistentTimestampTree::const_iterator PersistentTimestampTree::upperBound(double timestamp) const
+{
+    return partitionPoint([timestamp](const Entry& other) { return other.timestamp <= timestamp; });
+}
+
+std::size_t PersistentTimestampTree::count(double minTimestamp, double maxTimestamp) const
+{
+    if(maxTimestamp < minTimestamp)
+    {
+        return 0;
+    }
+    return rank([maxTimestamp](const Entry& entry) { return entry.timestamp <= maxTimestamp; }) -
+           rank([minTimestamp](const Entry& entry) { return entry.timestamp < minTimestamp; });
+}
+
+PersistentTimestampTree::const_iterator PersistentTimestampTree::begin() const
+{
+    const_iterator first{root.get()};
+    if(root)
+    {
+        first.descendFirst(root.get());
+    }
+    return first;
+}
+
+PersistentTimestampTree::const_iterator PersistentTimestampTree::end() const
+{
+    return const_iterator{root.get()};
+}
+
+void PersistentTimestampTree::assignSorted(const std::vector<Entry>& sortedEntries)
+{
+    root.reset();
+    if(sortedEntries.empty())
+    {
+        return;
+    }
+
+    struct Subtree
+    {
+        NodePointer node;
+        Entry first;
+    };
+    std::vector<Subtree> level;
+    for(std::size_t first{0}; first < sortedEntries.size(); first += leafCapacity)
+    {
+        auto leaf{std::make_shared<Node>()};
+        const auto last{std::min(first + leafCapacity, sortedEntries.size())};
+        leaf->entries.assign(sortedEntries.begin() + static_cast<std::ptrdiff_t>(first),
+                             sortedEntries.begin() + static_cast<std::ptrdiff_t>(last));
+        leaf->size = leaf->entries.size();
+        level.push_back({std::move(leaf), sortedEntries[first]});
+    }
+    while(level.size() > 1)
+    {
+        std::vector<Subtree> upperLevel;
+        for(std::size_t first{0}; first < level.size(); first += innerCapacity)
+        {
+            auto inner{std::make_shared<Node>()};
+            const auto last{std::min(first + innerCapacity, level.size())};
+            for(auto child{first}; child < last; ++child)
+            {
+                if(child not_eq first)
+                {
+                    inner->keys.push_back(level[child].first);
+                }
+                inner->size += level[child].node->size;
+                inner->children.push_back(std::move(level[child].node));
+            }
+            upperLevel.push_back({std::move(inner), level[first].first});
+        }
+        level = std::move(upperLevel);
+    }
+    root = std::move(level.front().node);
+}
+
+PersistentTimestampTree::Node& PersistentTimestampTree::writable(NodePointer& node)
+{
+    // nodes referenced by another version are copied before being changed
+    if(node.use_count() not_eq 1)
+    {
+        node = std::make_shared<Node>(*node);
+    }
+    return *node;
+}
+
+std::optional<PersistentTimestampTree::Split> PersistentTimestampTree::insert(NodePointer& nodePointer,
+                                                                              const Entry& entry)
+{
+    auto& node{writable(nodePointer)};
+    ++node.size;
+    if(node.leaf())
+    {
+        node.entries.insert(std::lower_bound(node.entries.begin(), node.entries.end(), entry), entry);
+        if(node.entries.size() <= leafCapacity)
+        {
+            return std::nullopt;
+        }
+        auto right{std::make_shared<Node>()};
+        const auto half{static_cast<std::ptrdiff_t>(node.entries.size() / 2)};
+        right->entries.assign(node.entries.begin() + half, node.entries.end());
+        node.entries.erase(node.entries.begin() + half, node.entries.end());
+        right->size = right->entries.size();
+        node.size = node.entries.size();
+        const auto separator{right->entries.front()};
+        return Split{separator, std::move(right)};
+    }
+
+    const auto childIndex{std::upper_bound(node.keys.begin(), node.keys.end(), entry) - node.keys.begin()};
+    auto split{insert(node.children[static_cast<std::size_t>(childIndex)], entry)};
+    if(not split)
+    {
+        return std::nullopt;
+    }
+    node.keys.insert(node.keys.begin() + childIndex, split->separator);
+    node.children.insert(node.children.begin() + childIndex + 1, std::move(split->right));
+    if(node.children.size() <= innerCapacity)
+    {
+        return std::nullopt;
+    }
+    // the middle key goes up, the right half of the children and keys goes to the new node
+    auto right{std::make_shared<Node>()};
+    const auto half{static_cast<std::ptrdiff_t>(node.children.size() / 2)};
+    const auto separator{node.keys[static_cast<std::size_t>(half - 1)]};
+    right->children.assign(std::make_move_iterator(node.children.begin() + half),
+                           std::make_move_iterator(node.children.end()));
+    right->keys.assign(node.keys.begin() + half, node.keys.end());
+    node.children.erase(node.children.begin() + half, node.children.end());
+    node.keys.erase(node.keys.begin() + half - 1, node.keys.end());
+    for(const auto& child : right->children)
+    {
+        right->size += child->size;
+    }
+    node.size -= right->size;
+    return Split{separator, std::move(right)};
+}
+
+void PersistentTimestampTree::erase(NodePointer& nodePointer, const Entry& entry)
+{
+    auto& node{writable(nodePointer)};
+    --node.size;
+    if(node.leaf())
+    {
+        node.entries.erase(std::lower_bound(node.entries.begin(), node.entries.end(), entry));
+        return;
+    }
+
+    const auto childIndex{std::upper_bound(node.keys.begin(), node.keys.end(), entry) - node.keys.begin()};
+    auto& child{node.children[static_cast<std::size_t>(childIndex)]};
+    erase(child, entry);
+    if(child->size not_eq 0)
+    {
+        return;
+    }
+    // the keys around an empty child still separate its neighbours, one of them is dropped with it
+    node.children.erase(node.children.begin() + childIndex);
+    if(not node.keys.empty())
+    {
+        node.keys.erase(node.keys.begin() + (childIndex > 0 ? childIndex - 1 : 0));
+    }
+}
+
+template<typename IsBefore>
+PersistentTimestampTree::const_iterator PersistentTimestampTree::partitionPoint(IsBefore isBefore) const
+{
+    // Complexity O(log n)
+    const_iterator position{root.get()};
+    if(not root)
+    {
+        return position;
+    }
+    const auto* node{root.get()};
+    while(not node->leaf())
+    {
+        const auto childIndex{std::partition_point(node->keys.begin(), node->keys.end(), isBefore) -
+                              node->keys.begin()};
+        position.path.push_back({node, static_cast<std::size_t>(childIndex)});
+        node = node->children[static_cast<std::size_t>(childIndex)].get();
+    }
+    const auto entryIndex{std::partition_point(node->entries.begin(), node->entries.end(), isBefore) -
+                          node->entries.begin()};
+    position.path.push_back({node, static_cast<std::size_t>(entryIndex)});
+    // the entry may be the first one of the next leaf, the key separating both was not before
+    position.skipLeafEnd();
+    return position;
+}
+
+template<typename IsBefore>
+std::size_t PersistentTimestampTree::rank(IsBefore isBefore) const
+{
+    // Complexity O(log n), the children before the one of the partition point are counted whole
+    std::size_t before{0};
+    if(not root)
+    {
+        return before;
+    }
+    const auto* node{root.get()};
+    while(not node->leaf())
+    {
+        const auto childIndex{static_cast<std::size_t>(
+                std::partition_point(node->keys.begin(), node->keys.end(), isBefore) - node->keys.begin())};
+        for(std::size_t child{0}; child < childIndex; ++child)
+        {
+            before += node->children[child]->size;
+        }
+        node = node->children[childIndex].get();
+    }
+    return before + static_cast<std::size_t>(
+            std::partition_point(node->entries.begin(), node->entries.end(), isBefore) - node->entries.begin());
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "TimestampTree.h"
+
+/**
+ * Responsibility: keep (timestamp, id) pairs sorted in a B+-tree whose versions share their nodes,
+ * so copying the tree is O(1) and both copies can be changed independently (a persistent tree).
+ *
+ * Changing an entry copies the nodes of its path that are shared with another version (path copying,
+ * O(log n) nodes) and changes in place the ones only this tree references. Nodes are split when full
+ * like in TimestampTree, but they are not merged when they get too empty, only dropped once empty.
+ * Leaves are not linked (a link would be a path to every leaf), iterators keep the path from the root
+ * instead. Inner nodes keep the number of entries below them, so ranges are counted in O(log n).
+ * Copies can be read and changed from different threads, a single tree cannot be changed while read.
+ */
+class PersistentTimestampTree
+{
+public:
+    using Entry = TimestampTree::Entry;
+
+    static constexpr std::size_t leafCapacity{64};
+    static constexpr std::size_t innerCapacity{64};
+
+private:
+    struct Node;
+    using NodePointer = std::shared_ptr<Node>;
+
+    struct Node
+    {
+        std::size_t size{0};
+        // leaves only
+        std::vector<Entry> entries;
+        // inner nodes only, keys[i] is the first entry of children[i+1]
+        std::vector<Entry> keys;
+        std::vector<NodePointer> children;
+
+        bool leaf() const { return children.empty(); }
+    };
+
+public:
+    /**
+     * Bidirectional iterator over the entries in ascending order. It does not keep the nodes alive,
+     * the tree (or a copy of it) must outlive it.
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry*;
+        using reference = const Entry&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return path.back().node->entries[path.back().index]; }
+        pointer operator->() const { return &**this; }
+
+        const_iterator& operator++();
+        const_iterator operator++(int)
+        {
+            auto copy{*this};
+            ++(*this);
+            return copy;
+        }
+
+        const_iterator& operator--();
+        const_iterator operator--(int)
+        {
+            auto copy{*this};
+            --(*this);
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            if(path.empty() or other.path.empty())
+            {
+                return path.empty() == other.path.empty();
+            }
+            return path.back().node == other.path.back().node and path.back().index == other.path.back().index;
+        }
+        bool operator!=(const const_iterator& other) const { return not (*this == other); }
+
+    private:
+        friend class PersistentTimestampTree;
+
+        struct Step
+        {
+            const Node* node;
+            std::size_t index;
+        };
+
+        explicit const_iterator(const Node* root): root{root} {}
+
+        void descendFirst(const Node* node);
+        void descendLast(const Node* node);
+        /**
+         * Moves to the first entry of the next leaf if the position is past the end of its leaf.
+         */
+        void skipLeafEnd();
+
+        const Node* root{nullptr};
+        // the node and child (or entry) index of every level, empty at the end
+        std::vector<Step> path;
+    };
+
+    /**
+     * Returns false if the pair was already in the tree.
+     */
+    bool insert(const Entry& entry);
+
+    /**
+     * Returns false if the pair was not in the tree.
+     */
+    bool erase(const Entry& entry);
+
+    bool contains(const Entry& entry) const;
+
+    /**
+     * First entry not less than the given one.
+     */
+    const_iterator lowerBound(const Entry& entry) const;
+
+    /**
+     * First entry with a timestamp not less than the given one.
+     */
+    const_iterator lowerBound(double timestamp) const;
+
+    /**
+     * First entry with a timestamp greater than the given one.
+     */
+    const_iterator upperBound(double timestamp) const;
+
+    /**
+     * Number of entries with a timestamp in [minTimestamp, maxTimestamp]. Complexity O(log n)
+     */
+    std::size_t count(double minTimestamp, double maxTimestamp) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    std::size_t size() const { return root ? root->size : 0; }
+    bool empty() const { return size() == 0; }
+
+    /**
+     * True if both trees are the same version or come from it without changes, so they are equal without
+     * reading them.
+     */
+    bool sameVersion(const PersistentTimestampTree& other) const { return root == other.root; }
+
+    /**
+     * Replaces the content of the tree with entries that are already sorted and unique,
+     * filling the leaves sequentially in O(N) instead of N insertions.
+     */
+    void assignSorted(const std::vector<Entry>& sortedEntries);
+
+private:
+    struct Split
+    {
+        Entry separator;
+        NodePointer right;
+    };
+
+    static Node& writable(NodePointer& node);
+    static std::optional<Split> insert(NodePointer& node, const Entry& entry);
+    static void erase(NodePointer& node, const Entry& entry);
+
+    /**
+     * Position of the first entry for which isBefore is false, isBefore must be true for
+     * a (possibly empty) prefix of the entries.
+     */
+    template<typename IsBefore>
+    const_iterator partitionPoint(IsBefore isBefore) const;
+
+    /**
+     * Number of entries for which isBefore is true, with the same condition than partitionPoint.
+     */
+    template<typename IsBefore>
+    std::size_t rank(IsBefore isBefore) const;
+
+    NodePointer root;
+};
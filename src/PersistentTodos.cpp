@@ -0,0 +1,242 @@
+#include <algorithm>
+#include "PersistentTodos.h"
+
+namespace
+{
+    /**
+     * Cursor over the elements [first, last) of a copy of a persistent index, which keeps the nodes read
+     * alive whatever happens to the version the index comes from.
+     */
+    template<typename Index, typename Iterator, typename Projection>
+    class PersistentCursor: public IdCursor
+    {
+    public:
+        PersistentCursor(Index index, Iterator first, Iterator last, Projection projection)
+                : index{std::move(index)}, first{std::move(first)}, last{std::move(last)}, projection{projection}
+        {
+        }
+
+        std::size_t next(std::int64_t* ids, std::size_t capacity) override
+        {
+            std::size_t count{0};
+            for(; count < capacity and first not_eq last; ++first)
+            {
+                ids[count++] = projection(*first);
+            }
+            return count;
+        }
+
+    private:
+        Index index;
+        Iterator first;
+        Iterator last;
+        Projection projection;
+    };
+
+    template<typename Index, typename Iterator, typename Projection>
+    IdRange makePersistentRange(const Index& index, Iterator first, Iterator last, Projection projection)
+    {
+        // copying the index is O(1), its iterators read the same nodes
+        return IdRange{std::make_unique<PersistentCursor<Index, Iterator, Projection>>(
+                index, std::move(first), std::move(last), projection)};
+    }
+}
+
+const Todo* PersistentTodos::find(std::int64_t id) const
+{
+    const auto* record{todos.find(id)};
+    return record ? record->get() : nullptr;
+}
+
+PersistentTodos::Record PersistentTodos::record(std::int64_t id) const
+{
+    const auto* record{todos.find(id)};
+    return record ? *record : nullptr;
+}
+
+void PersistentTodos::put(Record record)
+{
+    const auto id{record->id};
+    const auto* existing{todos.find(id)};
+    const auto* oldTodo{existing ? existing->get() : nullptr};
+    // the indexes are only touched when the value changes
+    if(not oldTodo or oldTodo->title not_eq record->title)
+    {
+        if(oldTodo)
+        {
+            unindexTitle(oldTodo->title, id);
+        }
+        indexTitle(record->title, id);
+    }
+    if(not oldTodo or oldTodo->timestamp not_eq record->timestamp)
+    {
+        if(oldTodo)
+        {
+            timestampIds.erase({oldTodo->timestamp, id});
+        }
+        timestampIds.insert({record->timestamp, id});
+    }
+    // the old record is released last, its values were read until now
+    todos[id].swap(record);
+}
+
+bool PersistentTodos::update(std::int64_t id, const TodoPatch& patch)
+{
+    const auto* oldTodo{find(id)};
+    if(not oldTodo)
+    {
+        return false;
+    }
+    // records are never changed in place, other versions may read the old one
+    auto todo{std::make_shared<Todo>(*oldTodo)};
+    patch.applyTo(*todo);
+    put(std::move(todo));
+    return true;
+}
+
+bool PersistentTodos::remove(std::int64_t id)
+{
+    const auto record{this->record(id)};
+    if(not record)
+    {
+        return false;
+    }
+    unindexTitle(record->title, id);
+    timestampIds.erase({record->timestamp, id});
+    todos.erase(id);
+    return true;
+}
+
+void PersistentTodos::insertBatch(const std::vector<Todo>& batch)
+{
+    if(not todos.empty())
+    {
+        for(const auto& todo : batch)
+        {
+            put(std::make_shared<const Todo>(todo));
+        }
+        return;
+    }
+
+    // on a cold start there is nothing to unindex, an id repeated in the batch is indexed with its last values
+    for(const auto& todo : batch)
+    {
+        auto& record{todos[todo.id]};
+        if(record)
+        {
+            unindexTitle(record->title, todo.id);
+        }
+        record = std::make_shared<const Todo>(todo);
+        indexTitle(record->title, todo.id);
+    }
+    std::vector<PersistentTimestampTree::Entry> timestampEntries;
+    timestampEntries.reserve(todos.size());
+    for(const auto& record : todos)
+    {
+        timestampEntries.push_back({record.second->timestamp, record.first});
+    }
+    std::sort(timestampEntries.begin(), timestampEntries.end());
+    timestampIds.assignSorted(timestampEntries); // Complexity O(k log k)
+}
+
+IdRange PersistentTodos::query(const std::string& title) const
+{
+    const auto* ids{titleIds.find(title)};
+    if(not ids)
+    {
+        return {};
+    }
+    return makePersistentRange(*ids, ids->begin(), ids->end(),
+                               [](const PostingList::Entry& entry) { return entry.first; });
+}
+
+std::size_t PersistentTodos::queryCount(const std::string& title) const
+{
+    const auto* ids{titleIds.find(title)};
+    return ids ? ids->size() : 0;
+}
+
+IdRange PersistentTodos::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    if(maxTimeStamp < minTimeStamp)
+    {
+        return {};
+    }
+    // two bound searches O(log n), nothing is read until the range is iterated
+    return makePersistentRange(timestampIds, timestampIds.lowerBound(minTimeStamp),
+                               timestampIds.upperBound(maxTimeStamp),
+                               [](const PersistentTimestampTree::Entry& entry) { return entry.id; });
+}
+
+RangePage PersistentTodos::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                             std::size_t limit, const RangeCursor& cursor) const
+{
+    return readOrderedPage(timestampIds, minTimeStamp, maxTimeStamp, limit, cursor);
+}
+
+std::size_t PersistentTodos::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    return timestampIds.count(minTimeStamp, maxTimeStamp);
+}
+
+bool PersistentTodos::sameVersion(const PersistentTodos& other) const
+{
+    return todos.sameVersion(other.todos) and titleIds.sameVersion(other.titleIds) and
+           timestampIds.sameVersion(other.timestampIds);
+}
+
+bool PersistentTodos::sameTodo(const PersistentTodos& other, std::int64_t id) const
+{
+    // a changed todo is a new record, the old one is kept alive by the older version so its address is not reused
+    return find(id) == other.find(id);
+}
+
+bool PersistentTodos::sameTitle(const PersistentTodos& other, const std::string& title) const
+{
+    const auto* ids{titleIds.find(title)};
+    const auto* otherIds{other.titleIds.find(title)};
+    if(not ids or not otherIds)
+    {
+        return ids == otherIds;
+    }
+    return ids->sameVersion(*otherIds);
+}
+
+bool PersistentTodos::sameRange(const PersistentTodos& other, double minTimeStamp, double maxTimeStamp) const
+{
+    if(timestampIds.sameVersion(other.timestampIds))
+    {
+        return true;
+    }
+    if(rangeCount(minTimeStamp, maxTimeStamp) not_eq other.rangeCount(minTimeStamp, maxTimeStamp))
+    {
+        return false;
+    }
+    auto entry{timestampIds.lowerBound(minTimeStamp)};
+    const auto last{timestampIds.upperBound(maxTimeStamp)};
+    auto otherEntry{other.timestampIds.lowerBound(minTimeStamp)};
+    for(; entry not_eq last; ++entry, ++otherEntry)
+    {
+        if(*entry not_eq *otherEntry)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PersistentTodos::indexTitle(const std::string& title, std::int64_t id)
+{
+    titleIds[title][id];
+}
+
+void PersistentTodos::unindexTitle(const std::string& title, std::int64_t id)
+{
+    auto& ids{titleIds[title]};
+    ids.erase(id);
+    // empty posting lists are dropped, so the titles of removed todos are not kept
+    if(ids.empty())
+    {
+        titleIds.erase(title);
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Todo.h"
+#include "TodoPatch.h"
+#include "IdRange.h"
+#include "RangePage.h"
+#include "PersistentHashMap.h"
+#include "PersistentTimestampTree.h"
+
+/**
+ * Responsibility: one version of the todos of a persistent store with its title and timestamp indexes.
+ *
+ * The todos are immutable records in a persistent hash trie by id, the titles map to persistent sets of ids
+ * and the timestamps are kept in a persistent B+-tree, so copying a version is O(1) (the three roots) and
+ * changing a copy path-copies O(log n) nodes without changing the version it comes from.
+ * A version reads like a parent store, without any overlay: a copy changed by a transaction is already
+ * the todos it sees. Query ranges keep their own copy of the index they read, so they stay valid
+ * whatever is changed afterwards.
+ */
+class PersistentTodos
+{
+public:
+    using Record = std::shared_ptr<const Todo>;
+
+    /**
+     * Returns nullptr if the todo does not exist.
+     */
+    const Todo* find(std::int64_t id) const;
+    Record record(std::int64_t id) const;
+    std::size_t size() const { return todos.size(); }
+
+    /**
+     * Inserts the todo, or replaces it if it exists. The index entries are only changed for the values
+     * that are not the same. Complexity O(log n)
+     */
+    void put(Record record);
+
+    /**
+     * Returns false if the todo does not exist. Complexity O(log n)
+     */
+    bool update(std::int64_t id, const TodoPatch& patch);
+    bool remove(std::int64_t id);
+
+    /**
+     * The same than putting the todos in order one by one. The timestamp index of an empty version is
+     * built from the sorted entries in O(N) instead.
+     */
+    void insertBatch(const std::vector<Todo>& batch);
+
+    IdRange query(const std::string& title) const;
+    std::size_t queryCount(const std::string& title) const;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const;
+
+    /**
+     * True if both versions are the same one or copies of it without changes. Complexity O(1)
+     */
+    bool sameVersion(const PersistentTodos& other) const;
+
+    /**
+     * Tell if a todo, the ids with a title or the ids in a timestamp range are the same in both versions,
+     * as the validation of the commits needs: records and posting lists are compared by identity in O(log n),
+     * so a todo written again with the same values is not the same, and ranges are compared entry by entry
+     * in O(range) unless both trees are the same version.
+     */
+    bool sameTodo(const PersistentTodos& other, std::int64_t id) const;
+    bool sameTitle(const PersistentTodos& other, const std::string& title) const;
+    bool sameRange(const PersistentTodos& other, double minTimeStamp, double maxTimeStamp) const;
+
+private:
+    /**
+     * Value of the posting lists, only the ids are used.
+     */
+    struct Indexed
+    {
+    };
+    using PostingList = PersistentHashMap<std::int64_t, Indexed>;
+
+    void indexTitle(const std::string& title, std::int64_t id);
+    void unindexTitle(const std::string& title, std::int64_t id);
+
+    PersistentHashMap<std::int64_t, Record> todos;
+    PersistentHashMap<std::string, PostingList> titleIds;
+    PersistentTimestampTree timestampIds;
+};
@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "TimestampTree.h"
+
+enum class RangeOrder
+{
+    ascending,
+    descending
+};
+
+/**
+ * Responsibility: tell an ordered range query where to continue.
+ *
+ * A default cursor starts at the beginning of the range (its end when descending). The cursor of
+ * the next page keeps the (timestamp, id) of the last todo returned, so the next page is found
+ * with a single tree search, no matter how many pages were read before.
+ */
+struct RangeCursor
+{
+    RangeOrder order{RangeOrder::ascending};
+    std::optional<TimestampTree::Entry> last;
+};
+
+/**
+ * Todos of an ordered range query sorted by (timestamp, id), with the cursor of the
+ * next page when there are more todos in the range.
+ */
+struct RangePage
+{
+    std::vector<TimestampTree::Entry> todos;
+    std::optional<RangeCursor> next;
+};
+
+/**
+ * Ordered page of the entries of a sorted tree (TimestampTree or PersistentTimestampTree) in the range,
+ * found with a bound search and read sequentially from there.
+ */
+template<typename Tree>
+RangePage readOrderedPage(const Tree& tree, double minValue, double maxValue, std::size_t limit,
+                          const RangeCursor& cursor)
+{
+    if(limit == 0)
+    {
+        throw std::invalid_argument("The limit of an ordered range query must be greater than 0");
+    }
+
+    RangePage page;
+    const auto& last{cursor.last};
+    const auto first{tree.begin()};
+    const auto end{tree.end()};
+    if(cursor.order == RangeOrder::ascending)
+    {
+        auto it{tree.lowerBound(minValue)};
+        if(last and last->timestamp >= minValue)
+        {
+            // continue right after the last pair of the previous page
+            it = tree.lowerBound(*last);
+            if(it not_eq end and *it == *last)
+            {
+                ++it;
+            }
+        }
+        const auto inRange{[&end, maxValue](const typename Tree::const_iterator& position)
+                           {
+                               return position not_eq end and position->timestamp <= maxValue;
+                           }};
+        for(; page.todos.size() < limit and inRange(it); ++it)
+        {
+            page.todos.push_back(*it);
+        }
+        if(inRange(it))
+        {
+            page.next = RangeCursor{cursor.order, page.todos.back()};
+        }
+    } else
+    {
+        // the iterator points right after the next pair to return
+        auto it{tree.upperBound(maxValue)};
+        if(last and last->timestamp <= maxValue)
+        {
+            it = tree.lowerBound(*last);
+        }
+        const auto previousInRange{[&first, minValue](const typename Tree::const_iterator& position)
+                                   {
+                                       return position not_eq first and std::prev(position)->timestamp >= minValue;
+                                   }};
+        while(page.todos.size() < limit and previousInRange(it))
+        {
+            page.todos.push_back(*--it);
+        }
+        if(previousInRange(it))
+        {
+            page.next = RangeCursor{cursor.order, page.todos.back()};
+        }
+    }
+    return page;
+}
+
+/**
+ * Ordered page of an overlay (a child store, a snapshot) over an underlying store: the pages of the
+ * underlying store without the todos hidden by the overlay, merged with the overlay own todos.
+ * underlyingPage(pageSize, cursor) and ownPage(pageSize) return the ordered pages of both.
+ */
+template<typename UnderlyingPage, typename IsHidden, typename OwnPage>
+RangePage mergeOverlayPage(std::size_t limit, const RangeCursor& cursor,
+                           UnderlyingPage underlyingPage, IsHidden isHidden, OwnPage ownPage)
+{
+    if(limit == 0)
+    {
+        throw std::invalid_argument("The limit of an ordered range query must be greater than 0");
+    }
+    // one todo more than the limit tells if there is a next page
+    const auto pageSize{limit + 1};
+
+    // hidden todos are skipped, so more underlying pages may be needed
+    std::vector<TimestampTree::Entry> underlyingTodos;
+    std::optional<RangeCursor> underlyingCursor{cursor};
+    while(underlyingTodos.size() < pageSize and underlyingCursor)
+    {
+        auto page{underlyingPage(pageSize, *underlyingCursor)};
+        for(const auto& todo : page.todos)
+        {
+            if(not isHidden(todo))
+            {
+                underlyingTodos.push_back(todo);
+            }
+        }
+        underlyingCursor = page.next;
+    }
+    const auto ownTodos{ownPage(pageSize).todos};
+
+    std::vector<TimestampTree::Entry> todos;
+    todos.reserve(underlyingTodos.size() + ownTodos.size());
+    const auto ascending{cursor.order == RangeOrder::ascending};
+    std::merge(underlyingTodos.begin(), underlyingTodos.end(), ownTodos.begin(), ownTodos.end(),
+               std::back_inserter(todos),
+               [ascending](const TimestampTree::Entry& lhs, const TimestampTree::Entry& rhs)
+               {
+                   return ascending ? lhs < rhs : rhs < lhs;
+               });
+
+    RangePage page;
+    if(todos.size() > limit)
+    {
+        todos.resize(limit);
+        page.next = RangeCursor{cursor.order, todos.back()};
+    }
+    page.todos = std::move(todos);
+    return page;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include "IdSet.h"
+
+/**
+ * Responsibility: remember what a child store read from its parent, so its commit can be validated.
+ *
+ * A commit is rejected if a todo read by id, a title queried or a timestamp range queried
+ * was changed by another commit after the child was created.
+ */
+struct ReadSet
+{
+    IdSet ids;
+    std::unordered_set<std::string> titles;
+    std::set<std::pair<double, double>> timestampRanges;
+
+    /**
+     * The title hash table keeps its buckets.
+     */
+    void clear()
+    {
+        ids = {};
+        titles.clear();
+        timestampRanges.clear();
+    }
+
+    void merge(const ReadSet& other)
+    {
+        for(const auto id : other.ids)
+        {
+            ids.insert(id);
+        }
+        titles.insert(other.titles.begin(), other.titles.end());
+        timestampRanges.insert(other.timestampRanges.begin(), other.timestampRanges.end());
+    }
+};
+
+/**
+ * What the commits accepted before in a group commit change in the parent: the ids they write and the
+ * titles and timestamps those todos have before and after. The next commits of the group are validated
+ * against them, like against the commits done after their snapshot.
+ */
+struct GroupWrites
+{
+    IdSet ids;
+    std::unordered_set<std::string> titles;
+    std::set<double> timestamps;
+};
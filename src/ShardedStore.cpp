@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include "ShardedStore.h"
+#include "ShardedTransaction.h"
+
+ShardedStore::ShardedStore(std::size_t shardCount): pool{shardCount > 0 ? shardCount - 1 : 0}
+{
+    if(shardCount == 0)
+    {
+        throw std::invalid_argument("A sharded store needs at least one shard");
+    }
+    shards.reserve(shardCount);
+    for(std::size_t shard{0}; shard < shardCount; ++shard)
+    {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+std::size_t ShardedStore::defaultShardCount()
+{
+    // hardware_concurrency may be unknown (0)
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ShardedStore::insert(std::int64_t id, TodoPatch patch)
+{
+    const auto& shard{*shards[shardIndex(id)]};
+    std::unique_lock lock{shard.mutex};
+    shard.store->insert(id, std::move(patch));
+}
+
+void ShardedStore::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void ShardedStore::insertBatch(const std::vector<Todo>& todos)
+{
+    if(shards.size() == 1)
+    {
+        std::unique_lock lock{shards.front()->mutex};
+        shards.front()->store->insertBatch(todos);
+        return;
+    }
+    // every task picks the todos of its shard, so copying them is split between the cores too
+    pool.run(shards.size(), [this, &todos](std::size_t shard)
+    {
+        std::vector<Todo> shardTodos;
+        shardTodos.reserve(todos.size() / shards.size());
+        for(const auto& todo : todos)
+        {
+            if(shardIndex(todo.id) == shard)
+            {
+                shardTodos.push_back(todo);
+            }
+        }
+        std::unique_lock lock{shards[shard]->mutex};
+        shards[shard]->store->insertBatch(shardTodos);
+    });
+}
+
+void ShardedStore::update(std::int64_t id, const TodoPatch& patch)
+{
+    const auto& shard{*shards[shardIndex(id)]};
+    std::unique_lock lock{shard.mutex};
+    shard.store->update(id, patch);
+}
+
+void ShardedStore::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void ShardedStore::get(std::int64_t id, Todo& todo) const
+{
+    const auto& shard{*shards[shardIndex(id)]};
+    std::shared_lock lock{shard.mutex};
+    shard.store->get(id, todo);
+}
+
+TodoProperties ShardedStore::get(std::int64_t id) const
+{
+    Todo todo;
+    get(id, todo);
+    return toProperties(todo);
+}
+
+void ShardedStore::getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const
+{
+    getManyByShard(ids, todos, [this](std::size_t shard, const std::vector<std::int64_t>& shardIds,
+                                      std::vector<std::optional<Todo>>& shardTodos)
+    {
+        std::shared_lock lock{shards[shard]->mutex};
+        shards[shard]->store->getMany(shardIds, shardTodos);
+    });
+}
+
+void ShardedStore::remove(std::int64_t id)
+{
+    const auto& shard{*shards[shardIndex(id)]};
+    std::unique_lock lock{shard.mutex};
+    shard.store->remove(id);
+}
+
+bool ShardedStore::checkId(std::int64_t id) const
+{
+    const auto& shard{*shards[shardIndex(id)]};
+    std::shared_lock lock{shard.mutex};
+    return shard.store->checkId(id);
+}
+
+IdRange ShardedStore::query(const TodoProperty& property) const
+{
+    const auto locks{lockShared()};
+    return collectIds([this, &property](std::size_t shard) { return shards[shard]->store->query(property); });
+}
+
+IdRange ShardedStore::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    const auto locks{lockShared()};
+    return collectIds([this, minTimeStamp, maxTimeStamp](std::size_t shard)
+                      {
+                          return shards[shard]->store->rangeQuery(minTimeStamp, maxTimeStamp);
+                      });
+}
+
+RangePage ShardedStore::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                          std::size_t limit, const RangeCursor& cursor) const
+{
+    const auto locks{lockShared()};
+    return mergePages(limit, cursor, [&](std::size_t shard)
+    {
+        return shards[shard]->store->rangeQueryOrdered(minTimeStamp, maxTimeStamp, limit, cursor);
+    });
+}
+
+std::size_t ShardedStore::queryCount(const TodoProperty& property) const
+{
+    // counts are O(1) or O(log n) per shard, cheaper than waking up the pool
+    const auto locks{lockShared()};
+    std::size_t count{0};
+    for(const auto& shard : shards)
+    {
+        count += shard->store->queryCount(property);
+    }
+    return count;
+}
+
+std::size_t ShardedStore::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    const auto locks{lockShared()};
+    std::size_t count{0};
+    for(const auto& shard : shards)
+    {
+        count += shard->store->rangeCount(minTimeStamp, maxTimeStamp);
+    }
+    return count;
+}
+
+std::unique_ptr<Store> ShardedStore::createChild()
+{
+    return std::make_unique<ShardedTransaction>(std::static_pointer_cast<ShardedStore>(shared_from_this()));
+}
+
+void ShardedStore::commit()
+{
+    throw std::runtime_error("Parent store cannot commit, only child stores can");
+}
+
+void ShardedStore::rollback()
+{
+    throw std::runtime_error("Parent store cannot roll back, only child stores can");
+}
+
+std::size_t ShardedStore::shardIndex(std::int64_t id) const
+{
+    // the high bits of a multiplicative hash, so consecutive ids go to different shards
+    return ((std::uint64_t(id) * 0x9E3779B97F4A7C15ULL) >> 32) % shards.size();
+}
+
+std::vector<std::shared_lock<std::shared_mutex>> ShardedStore::lockShared() const
+{
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shards.size());
+    for(const auto& shard : shards)
+    {
+        locks.emplace_back(shard->mutex);
+    }
+    return locks;
+}
+
+std::vector<std::unique_lock<std::shared_mutex>> ShardedStore::lockExclusive() const
+{
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(shards.size());
+    for(const auto& shard : shards)
+    {
+        locks.emplace_back(shard->mutex);
+    }
+    return locks;
+}
+
+void ShardedStore::getManyByShard(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos,
+                                  const std::function<void(std::size_t shard, const std::vector<std::int64_t>& shardIds,
+                                                           std::vector<std::optional<Todo>>& shardTodos)>&
+                                  shardGetMany) const
+{
+    // every shard gets its ids in a single call (and a single lock), the todos are put back in the ids order
+    std::vector<std::vector<std::int64_t>> shardIds(shards.size());
+    std::vector<std::vector<std::size_t>> shardPositions(shards.size());
+    for(std::size_t position{0}; position < ids.size(); ++position)
+    {
+        const auto shard{shardIndex(ids[position])};
+        shardIds[shard].push_back(ids[position]);
+        shardPositions[shard].push_back(position);
+    }
+    todos.resize(ids.size());
+    std::vector<std::optional<Todo>> shardTodos;
+    for(std::size_t shard{0}; shard < shards.size(); ++shard)
+    {
+        if(shardIds[shard].empty())
+        {
+            continue;
+        }
+        shardGetMany(shard, shardIds[shard], shardTodos);
+        for(std::size_t i{0}; i < shardTodos.size(); ++i)
+        {
+            todos[shardPositions[shard][i]] = std::move(shardTodos[i]);
+        }
+    }
+}
+
+IdRange ShardedStore::collectIds(const std::function<IdRange(std::size_t shard)>& shardQuery) const
+{
+    // the lazy ranges of the shards are consumed in their own task, while the shards are locked
+    std::vector<std::vector<std::int64_t>> shardIds(shards.size());
+    pool.run(shards.size(), [&shardQuery, &shardIds](std::size_t shard)
+    {
+        for(const auto id : shardQuery(shard))
+        {
+            shardIds[shard].push_back(id);
+        }
+    });
+    std::size_t idCount{0};
+    for(const auto& ids : shardIds)
+    {
+        idCount += ids.size();
+    }
+    std::vector<std::int64_t> ids;
+    ids.reserve(idCount);
+    for(const auto& oneShardIds : shardIds)
+    {
+        ids.insert(ids.end(), oneShardIds.begin(), oneShardIds.end());
+    }
+    return makeOwningIdRange(std::move(ids));
+}
+
+RangePage ShardedStore::mergePages(std::size_t limit, const RangeCursor& cursor,
+                                   const std::function<RangePage(std::size_t shard)>& shardPage) const
+{
+    if(limit == 0)
+    {
+        throw std::invalid_argument("The limit of an ordered range query must be greater than 0");
+    }
+    // every shard resumes after the (timestamp, id) of the cursor, so their first pages hold the whole page
+    std::vector<RangePage> pages(shards.size());
+    pool.run(shards.size(), [&shardPage, &pages](std::size_t shard) { pages[shard] = shardPage(shard); });
+
+    const auto ascending{cursor.order == RangeOrder::ascending};
+    std::vector<TimestampTree::Entry> todos;
+    auto more{false};
+    for(const auto& page : pages)
+    {
+        todos.insert(todos.end(), page.todos.begin(), page.todos.end());
+        more = more or page.next;
+    }
+    // only the first limit todos are sorted, the rest of the shard pages is dropped
+    const auto kept{std::min(limit, todos.size())};
+    more = more or todos.size() > limit;
+    std::partial_sort(todos.begin(), todos.begin() + kept, todos.end(),
+                      [ascending](const TimestampTree::Entry& lhs, const TimestampTree::Entry& rhs)
+                      {
+                          return ascending ? lhs < rhs : rhs < lhs;
+                      });
+    todos.resize(kept);
+
+    RangePage page;
+    if(more)
+    {
+        page.next = RangeCursor{cursor.order, todos.back()};
+    }
+    page.todos = std::move(todos);
+    return page;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+#include "Store.h"
+#include "ParentStore.h"
+#include "ThreadPool.h"
+
+/**
+ * Responsibility: spread the todos over several parent stores (shards) by a hash of their id,
+ * so writes to different shards run in parallel and big queries are split between cores.
+ *
+ * Point operations go straight to the shard of the id and only lock it, reading under a shared
+ * lock and writing under an exclusive one. Queries lock every shard (always in the same order,
+ * so they see a commit spanning shards either whole or not at all), run on every shard in parallel
+ * on a thread pool and merge the results. Query results are copied, the shards are unlocked when
+ * the query returns. Children are transactions spanning every shard (see ShardedTransaction).
+ * The store must be owned by a std::shared_ptr to create children.
+ */
+class ShardedStore: public Store
+{
+public:
+    /**
+     * One shard per core by default, the thread pool has a worker less since the caller works too.
+     */
+    explicit ShardedStore(std::size_t shardCount = defaultShardCount());
+
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
+    void insert(std::int64_t id, const TodoProperties& properties) override;
+    /**
+     * The todos are split by shard and every shard loads its part in parallel.
+     */
+    void insertBatch(const std::vector<Todo>& todos) override;
+    void update(std::int64_t id, const TodoProperties& properties) override;
+    TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
+    void remove(std::int64_t id) override;
+    bool checkId(std::int64_t id) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    /**
+     * Transaction with a child store of every shard, all of them created at once so they read
+     * the same commits.
+     */
+    std::unique_ptr<Store> createChild() override;
+    void commit() override;
+    void rollback() override;
+
+    std::size_t shardCount() const { return shards.size(); }
+    static std::size_t defaultShardCount();
+
+private:
+    friend class ShardedTransaction;
+
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::shared_ptr<ParentStore> store{std::make_shared<ParentStore>()};
+    };
+
+    std::size_t shardIndex(std::int64_t id) const;
+
+    /**
+     * Every shard locked, in shard order so fan-outs and commits never deadlock.
+     */
+    std::vector<std::shared_lock<std::shared_mutex>> lockShared() const;
+    std::vector<std::unique_lock<std::shared_mutex>> lockExclusive() const;
+
+    /**
+     * Splits the ids by shard, calls shardGetMany once per shard and puts the todos back in the ids order.
+     * Fan-outs: the query of every shard runs in parallel and the results are merged.
+     * The shards must be locked by the caller, the queries of the transactions are fanned out the same way.
+     */
+    void getManyByShard(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos,
+                        const std::function<void(std::size_t shard, const std::vector<std::int64_t>& shardIds,
+                                                 std::vector<std::optional<Todo>>& shardTodos)>& shardGetMany) const;
+    IdRange collectIds(const std::function<IdRange(std::size_t shard)>& shardQuery) const;
+    RangePage mergePages(std::size_t limit, const RangeCursor& cursor,
+                         const std::function<RangePage(std::size_t shard)>& shardPage) const;
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    mutable ThreadPool pool;
+};
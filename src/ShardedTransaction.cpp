@@ -0,0 +1,185 @@
+#include <mutex>
+#include <shared_mutex>
+#include "ShardedTransaction.h"
+#include "ShardedStore.h"
+#include "StoreSnapshot.h"
+
+ShardedTransaction::ShardedTransaction(std::shared_ptr<ShardedStore> store): store{std::move(store)}
+{
+    // every shard is locked while the snapshots are taken, so the children see the same commits
+    const auto locks{this->store->lockExclusive()};
+    children.reserve(this->store->shards.size());
+    for(const auto& shard : this->store->shards)
+    {
+        children.push_back(std::make_shared<ChildStore>(shard->store, shard->store->snapshot()));
+    }
+}
+
+ShardedTransaction::ShardedTransaction(std::shared_ptr<ShardedStore> store,
+                                       const std::vector<std::shared_ptr<ChildStore>>& parentChildren)
+        : store{std::move(store)}
+{
+    const auto locks{this->store->lockExclusive()};
+    children.reserve(parentChildren.size());
+    for(const auto& parentChild : parentChildren)
+    {
+        children.push_back(std::make_shared<ChildStore>(parentChild));
+    }
+}
+
+ShardedTransaction::~ShardedTransaction()
+{
+    // releasing the snapshots of the children changes the old versions kept by the shards
+    const auto locks{store->lockExclusive()};
+    children.clear();
+}
+
+void ShardedTransaction::insert(std::int64_t id, TodoPatch patch)
+{
+    const auto shard{store->shardIndex(id)};
+    std::unique_lock lock{store->shards[shard]->mutex};
+    children[shard]->insert(id, std::move(patch));
+}
+
+void ShardedTransaction::insert(std::int64_t id, const TodoProperties& properties)
+{
+    insert(id, TodoPatch::fromProperties(properties));
+}
+
+void ShardedTransaction::insertBatch(const std::vector<Todo>& todos)
+{
+    for(const auto& todo : todos)
+    {
+        insert(todo.id, TodoPatch::fromTodo(todo));
+    }
+}
+
+void ShardedTransaction::update(std::int64_t id, const TodoPatch& patch)
+{
+    const auto shard{store->shardIndex(id)};
+    std::unique_lock lock{store->shards[shard]->mutex};
+    children[shard]->update(id, patch);
+}
+
+void ShardedTransaction::update(std::int64_t id, const TodoProperties& properties)
+{
+    update(id, TodoPatch::fromProperties(properties));
+}
+
+void ShardedTransaction::get(std::int64_t id, Todo& todo) const
+{
+    // reads only change the read set of the child, which is used by one thread, and the changes cached by
+    // the snapshot, which are synchronized, so other transactions can read the shard meanwhile
+    const auto shard{store->shardIndex(id)};
+    std::shared_lock lock{store->shards[shard]->mutex};
+    children[shard]->get(id, todo);
+}
+
+TodoProperties ShardedTransaction::get(std::int64_t id) const
+{
+    const auto shard{store->shardIndex(id)};
+    std::shared_lock lock{store->shards[shard]->mutex};
+    return children[shard]->get(id);
+}
+
+void ShardedTransaction::getMany(const std::vector<std::int64_t>& ids,
+                                 std::vector<std::optional<Todo>>& todos) const
+{
+    store->getManyByShard(ids, todos, [this](std::size_t shard, const std::vector<std::int64_t>& shardIds,
+                                             std::vector<std::optional<Todo>>& shardTodos)
+    {
+        std::shared_lock lock{store->shards[shard]->mutex};
+        children[shard]->getMany(shardIds, shardTodos);
+    });
+}
+
+void ShardedTransaction::remove(std::int64_t id)
+{
+    const auto shard{store->shardIndex(id)};
+    std::unique_lock lock{store->shards[shard]->mutex};
+    children[shard]->remove(id);
+}
+
+bool ShardedTransaction::checkId(std::int64_t id) const
+{
+    const auto shard{store->shardIndex(id)};
+    std::shared_lock lock{store->shards[shard]->mutex};
+    return children[shard]->checkId(id);
+}
+
+IdRange ShardedTransaction::query(const TodoProperty& property) const
+{
+    const auto locks{store->lockShared()};
+    return store->collectIds([this, &property](std::size_t shard) { return children[shard]->query(property); });
+}
+
+IdRange ShardedTransaction::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    const auto locks{store->lockShared()};
+    return store->collectIds([this, minTimeStamp, maxTimeStamp](std::size_t shard)
+                             {
+                                 return children[shard]->rangeQuery(minTimeStamp, maxTimeStamp);
+                             });
+}
+
+RangePage ShardedTransaction::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                                std::size_t limit, const RangeCursor& cursor) const
+{
+    const auto locks{store->lockShared()};
+    return store->mergePages(limit, cursor, [&](std::size_t shard)
+    {
+        return children[shard]->rangeQueryOrdered(minTimeStamp, maxTimeStamp, limit, cursor);
+    });
+}
+
+std::size_t ShardedTransaction::queryCount(const TodoProperty& property) const
+{
+    const auto locks{store->lockShared()};
+    std::size_t count{0};
+    for(const auto& child : children)
+    {
+        count += child->queryCount(property);
+    }
+    return count;
+}
+
+std::size_t ShardedTransaction::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    const auto locks{store->lockShared()};
+    std::size_t count{0};
+    for(const auto& child : children)
+    {
+        count += child->rangeCount(minTimeStamp, maxTimeStamp);
+    }
+    return count;
+}
+
+std::unique_ptr<Store> ShardedTransaction::createChild()
+{
+    return std::make_unique<ShardedTransaction>(store, children);
+}
+
+void ShardedTransaction::commit()
+{
+    const auto locks{store->lockExclusive()};
+    // no shard changes while locked, so children validated and checked here cannot fail when committing
+    for(const auto& child : children)
+    {
+        child->validateCommit();
+        child->checkChanges();
+    }
+    for(const auto& child : children)
+    {
+        child->commit();
+    }
+}
+
+void ShardedTransaction::rollback()
+{
+    // the children take new snapshots of their shards, releasing the old ones changes the versions kept
+    const auto locks{store->lockExclusive()};
+    for(const auto& child : children)
+    {
+        child->rollback();
+    }
+}
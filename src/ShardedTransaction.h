@@ -0,0 +1,64 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Store.h"
+#include "ChildStore.h"
+
+class ShardedStore;
+
+/**
+ * Responsibility: child store of a sharded store, spanning all its shards.
+ *
+ * It keeps a child store of every shard and routes every operation to the child of the shard of
+ * the id (or fans queries out to all of them), under the lock of the shard since the children read
+ * their shard while other threads write it: a shared one for reads, an exclusive one for writes. Committing
+ * locks every shard, validates and checks the changes of every child and only then commits them, so either
+ * every shard gets the changes or (CommitConflict, std::invalid_argument) none does.
+ * Like a child store, a transaction is used by one thread at a time.
+ */
+class ShardedTransaction: public Store
+{
+public:
+    /**
+     * Transaction over the shards of the store, which must be owned by a std::shared_ptr.
+     */
+    explicit ShardedTransaction(std::shared_ptr<ShardedStore> store);
+    /**
+     * Nested transaction, with a nested child of every child of its parent transaction.
+     */
+    ShardedTransaction(std::shared_ptr<ShardedStore> store,
+                       const std::vector<std::shared_ptr<ChildStore>>& parentChildren);
+    ~ShardedTransaction() override;
+
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
+    void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
+    void update(std::int64_t id, const TodoProperties& properties) override;
+    TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
+    void remove(std::int64_t id) override;
+    bool checkId(std::int64_t id) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    std::unique_ptr<Store> createChild() override;
+    /**
+     * Throws CommitConflict, committing nothing in any shard, if the child of any shard conflicts,
+     * and std::invalid_argument if a change of any shard cannot be applied.
+     */
+    void commit() override;
+    /**
+     * Rolls back the child of every shard.
+     */
+    void rollback() override;
+
+private:
+    std::shared_ptr<ShardedStore> store;
+    // one per shard, owned by std::shared_ptr since nested children keep their parent child alive
+    std::vector<std::shared_ptr<ChildStore>> children;
+};
@@ -1,20 +1,77 @@
 #pragma once
 #include "Todo.h"
+#include "TodoPatch.h"
 #include <memory>
-#include <unordered_set>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "IdRange.h"
+#include "RangePage.h"
+
+/**
+ * Thrown when committing a child store whose reads or writes were changed by another commit
+ * after the child was created. Nothing is committed, the transaction can be retried with a new child.
+ */
+class CommitConflict: public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
 
 class Store: public std::enable_shared_from_this<Store>
 {
 public:
+    virtual ~Store() = default;
+
+    /**
+     * Typed overloads, the patch of an insertion must have every property.
+     * get throws std::out_of_range if the todo does not exist, the strings of the todo keep their memory.
+     */
+    virtual void insert(std::int64_t id, TodoPatch patch) = 0;
+    virtual void update(std::int64_t id, const TodoPatch& patch) = 0;
+    virtual void get(std::int64_t id, Todo& todo) const = 0;
+
+    /**
+     * String keyed adapters of the typed overloads.
+     */
     virtual void insert(std::int64_t id, const TodoProperties& properties) = 0;
+    /**
+     * Inserts all the todos at once, the same than inserting them in order one by one.
+     */
+    virtual void insertBatch(const std::vector<Todo>& todos) = 0;
     virtual void update(std::int64_t id, const TodoProperties& properties) = 0;
     virtual TodoProperties get(std::int64_t id) const = 0;
+    /**
+     * Gets the todos of many ids at once, todos[i] is the todo of ids[i] or empty if it is not found.
+     * The todos vector can be reused between calls, the strings already in it keep their memory.
+     */
+    virtual void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const = 0;
     virtual void remove(std::int64_t id) = 0;
     virtual bool checkId(std::int64_t id) const = 0;
-    virtual std::unordered_set<std::int64_t> query(const TodoProperty& property) const = 0;
-    virtual std::unordered_set<std::int64_t> rangeQuery(double minTimeStamp, double maxTimeStamp) const = 0;
+    /**
+     * Query results are lazy ranges read from the store indexes while iterating,
+     * so they must be consumed before modifying the store.
+     */
+    virtual IdRange query(const TodoProperty& property) const = 0;
+    virtual IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const = 0;
+    /**
+     * Page of up to limit todos of the range sorted by timestamp (and id), starting after the cursor.
+     * The page carries the cursor of the next one while there are more todos in the range.
+     */
+    virtual RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                        std::size_t limit, const RangeCursor& cursor) const = 0;
+    /**
+     * Same number of ids than iterating query and rangeQuery, without reading them.
+     */
+    virtual std::size_t queryCount(const TodoProperty& property) const = 0;
+    virtual std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const = 0;
     virtual std::unique_ptr<Store> createChild() = 0;
     virtual void commit() = 0;
+    /**
+     * Discards every change of a child store, which goes on as a new transaction over the latest version
+     * of its parent like after committing. Parent stores throw std::runtime_error, like when committing.
+     */
+    virtual void rollback() = 0;
 };
 
 
@@ -0,0 +1,271 @@
+#include <stdexcept>
+#include "StoreSnapshot.h"
+#include "ParentStore.h"
+
+StoreSnapshot::StoreSnapshot(std::shared_ptr<ParentStore> store, std::uint64_t version)
+        :store{std::move(store)}, snapshotVersion{version}, changesSinceSnapshot{version}
+{
+}
+
+StoreSnapshot::~StoreSnapshot()
+{
+    store->versions.unpin(snapshotVersion);
+}
+
+bool StoreSnapshot::changed(std::int64_t id) const
+{
+    // the store keeps the old version of every todo changed after the snapshot
+    return store->versions.find(id, snapshotVersion) not_eq nullptr;
+}
+
+const IdSet& StoreSnapshot::changedIds() const
+{
+    return changes().ids;
+}
+
+bool StoreSnapshot::changedTitle(const std::string& title) const
+{
+    if(store->versions.current() == snapshotVersion)
+    {
+        return false;
+    }
+    // only the changed todos can enter or leave the title
+    const auto& changed{changes()};
+    return changed.oldTitleIds.getIds(title) not_eq changed.currentTitleIds.getIds(title);
+}
+
+bool StoreSnapshot::changedRange(double minTimeStamp, double maxTimeStamp) const
+{
+    if(store->versions.current() == snapshotVersion)
+    {
+        return false;
+    }
+    const auto& changed{changes()};
+    return changed.oldTimestampIds.getRangeIds(minTimeStamp, maxTimeStamp) not_eq
+           changed.currentTimestampIds.getRangeIds(minTimeStamp, maxTimeStamp);
+}
+
+void StoreSnapshot::insert(std::int64_t, TodoPatch)
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+void StoreSnapshot::update(std::int64_t, const TodoPatch&)
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+void StoreSnapshot::get(std::int64_t id, Todo& todo) const
+{
+    const auto oldVersion{store->versions.find(id, snapshotVersion)};
+    if(oldVersion == nullptr)
+    {
+        store->get(id, todo);
+        return;
+    }
+    if(not oldVersion->todo)
+    {
+        throw std::out_of_range("Todo with id "+std::to_string(id)+" not found");
+    }
+    todo = *oldVersion->todo;
+}
+
+bool StoreSnapshot::getIndexedValues(std::int64_t id, std::string& title, double& timestamp) const
+{
+    const auto oldVersion{store->versions.find(id, snapshotVersion)};
+    if(oldVersion == nullptr)
+    {
+        return store->getIndexedValues(id, title, timestamp);
+    }
+    if(not oldVersion->todo)
+    {
+        return false;
+    }
+    title = oldVersion->todo->title;
+    timestamp = oldVersion->todo->timestamp;
+    return true;
+}
+
+void StoreSnapshot::insert(std::int64_t, const TodoProperties&)
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+void StoreSnapshot::insertBatch(const std::vector<Todo>&)
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+void StoreSnapshot::update(std::int64_t, const TodoProperties&)
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+TodoProperties StoreSnapshot::get(std::int64_t id) const
+{
+    Todo todo;
+    get(id, todo);
+    return toProperties(todo);
+}
+
+void StoreSnapshot::getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const
+{
+    store->getMany(ids, todos);
+    if(store->versions.current() == snapshotVersion)
+    {
+        return;
+    }
+    for(std::size_t i{0}; i < ids.size(); ++i)
+    {
+        const auto oldVersion{store->versions.find(ids[i], snapshotVersion)};
+        if(oldVersion not_eq nullptr)
+        {
+            todos[i] = oldVersion->todo;
+        }
+    }
+}
+
+void StoreSnapshot::remove(std::int64_t)
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+bool StoreSnapshot::checkId(std::int64_t id) const
+{
+    const auto oldVersion{store->versions.find(id, snapshotVersion)};
+    return oldVersion == nullptr ? store->checkId(id) : oldVersion->todo.has_value();
+}
+
+IdRange StoreSnapshot::query(const TodoProperty& property) const
+{
+    if(store->versions.current() == snapshotVersion or property.first not_eq titleKey)
+    {
+        return store->query(property);
+    }
+    const auto& changed{changes()};
+    const auto& oldIds{changed.oldTitleIds.getIds(std::get<std::string>(property.second))};
+    return makeOverlayRange(store->query(property),
+                            [&changedIds = changed.ids](std::int64_t id) { return changedIds.contains(id); },
+                            makeIdRange(oldIds.begin(), oldIds.end(), [](std::int64_t id) { return id; }));
+}
+
+IdRange StoreSnapshot::rangeQuery(double minTimeStamp, double maxTimeStamp) const
+{
+    if(store->versions.current() == snapshotVersion)
+    {
+        return store->rangeQuery(minTimeStamp, maxTimeStamp);
+    }
+    const auto& changed{changes()};
+    return makeOverlayRange(store->rangeQuery(minTimeStamp, maxTimeStamp),
+                            [&changedIds = changed.ids](std::int64_t id) { return changedIds.contains(id); },
+                            changed.oldTimestampIds.getRange(minTimeStamp, maxTimeStamp));
+}
+
+RangePage StoreSnapshot::rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                           std::size_t limit, const RangeCursor& cursor) const
+{
+    if(store->versions.current() == snapshotVersion)
+    {
+        return store->rangeQueryOrdered(minTimeStamp, maxTimeStamp, limit, cursor);
+    }
+    const auto& changed{changes()};
+    return mergeOverlayPage(limit, cursor,
+                            [&](std::size_t pageSize, const RangeCursor& storeCursor)
+                            {
+                                return store->rangeQueryOrdered(minTimeStamp, maxTimeStamp, pageSize, storeCursor);
+                            },
+                            [&changed](const TimestampTree::Entry& todo) { return changed.ids.contains(todo.id); },
+                            [&](std::size_t pageSize)
+                            {
+                                return changed.oldTimestampIds.getOrderedRange(minTimeStamp, maxTimeStamp,
+                                                                               pageSize, cursor);
+                            });
+}
+
+std::size_t StoreSnapshot::queryCount(const TodoProperty& property) const
+{
+    if(store->versions.current() == snapshotVersion or property.first not_eq titleKey)
+    {
+        return store->queryCount(property);
+    }
+    const auto& changed{changes()};
+    const auto& title{std::get<std::string>(property.second)};
+    return store->queryCount(property) - changed.currentTitleIds.count(title) + changed.oldTitleIds.count(title);
+}
+
+std::size_t StoreSnapshot::rangeCount(double minTimeStamp, double maxTimeStamp) const
+{
+    if(store->versions.current() == snapshotVersion)
+    {
+        return store->rangeCount(minTimeStamp, maxTimeStamp);
+    }
+    const auto& changed{changes()};
+    return store->rangeCount(minTimeStamp, maxTimeStamp) -
+           changed.currentTimestampIds.countRange(minTimeStamp, maxTimeStamp) +
+           changed.oldTimestampIds.countRange(minTimeStamp, maxTimeStamp);
+}
+
+std::unique_ptr<Store> StoreSnapshot::createChild()
+{
+    throw std::runtime_error("Store snapshots cannot create children, the parent store can");
+}
+
+void StoreSnapshot::commit()
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+void StoreSnapshot::rollback()
+{
+    throw std::runtime_error("Store snapshots are read only");
+}
+
+const StoreSnapshot::Changes& StoreSnapshot::changes() const
+{
+    const auto storeVersion{store->versions.current()};
+    if(changesSinceSnapshot.storeVersion.load(std::memory_order_acquire) == storeVersion)
+    {
+        return changesSinceSnapshot;
+    }
+
+    std::lock_guard lock{changesMutex};
+    auto& changes{changesSinceSnapshot};
+    const auto collectedVersion{changes.storeVersion.load(std::memory_order_relaxed)};
+    if(collectedVersion == storeVersion)
+    {
+        return changes;
+    }
+    // only the indexed values are read: the old ones as they were at the snapshot, the current ones from the store
+    std::string title;
+    double timestamp;
+    store->versions.forEachChangeAfter(collectedVersion, [&](std::int64_t id)
+    {
+        if(changes.ids.insert(id))
+        {
+            const auto& snapshotTodo{store->versions.find(id, snapshotVersion)->todo};
+            if(snapshotTodo)
+            {
+                changes.oldTitleIds.insert(snapshotTodo->title, id);
+                changes.oldTimestampIds.insert(snapshotTodo->timestamp, id);
+            }
+        } else
+        {
+            // the current values collected before are not current anymore
+            const auto collected{changes.currentValues.find(id)};
+            if(collected not_eq changes.currentValues.end())
+            {
+                changes.currentTitleIds.remove(collected->second.title, id);
+                changes.currentTimestampIds.remove(collected->second.timestamp, id);
+                changes.currentValues.erase(collected);
+            }
+        }
+        if(store->getIndexedValues(id, title, timestamp))
+        {
+            changes.currentTitleIds.insert(title, id);
+            changes.currentTimestampIds.insert(timestamp, id);
+            changes.currentValues.try_emplace(id, Changes::IndexedValues{title, timestamp});
+        }
+    });
+    changes.storeVersion.store(storeVersion, std::memory_order_release);
+    return changes;
+}
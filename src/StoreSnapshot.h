@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "Store.h"
+#include "FlatIdMap.h"
+#include "IdSet.h"
+#include "StringPropertyIds.h"
+#include "DoublePropertyIds.h"
+
+class ParentStore;
+
+/**
+ * Responsibility: read a parent store as it was at a given version, without locks and without copying it.
+ *
+ * The snapshot pins its version while it is alive, so the parent store keeps the old version of every
+ * todo changed afterwards. Reads go to the parent store and the todos changed since the snapshot
+ * are reverted on the fly: their current values are hidden and their old values are returned instead.
+ * The snapshot is read only, and can be read from many threads while its store is not changed.
+ */
+class StoreSnapshot: public Store
+{
+public:
+    StoreSnapshot(std::shared_ptr<ParentStore> store, std::uint64_t version);
+    ~StoreSnapshot() override;
+    StoreSnapshot(const StoreSnapshot&) = delete;
+    StoreSnapshot& operator=(const StoreSnapshot&) = delete;
+
+    std::uint64_t version() const { return snapshotVersion; }
+
+    /**
+     * Tell if a todo, the ids with a title or the ids in a timestamp range
+     * are not the same in the store than in the snapshot anymore.
+     */
+    bool changed(std::int64_t id) const;
+    bool changedTitle(const std::string& title) const;
+    bool changedRange(double minTimeStamp, double maxTimeStamp) const;
+    /**
+     * Ids of the todos changed in the store since the snapshot.
+     */
+    const IdSet& changedIds() const;
+
+    /**
+     * Title and timestamp of a todo at the snapshot version, false if it did not exist.
+     */
+    bool getIndexedValues(std::int64_t id, std::string& title, double& timestamp) const;
+
+    void insert(std::int64_t id, TodoPatch patch) override;
+    void update(std::int64_t id, const TodoPatch& patch) override;
+    void get(std::int64_t id, Todo& todo) const override;
+    void insert(std::int64_t id, const TodoProperties& properties) override;
+    void insertBatch(const std::vector<Todo>& todos) override;
+    void update(std::int64_t id, const TodoProperties& properties) override;
+    TodoProperties get(std::int64_t id) const override;
+    void getMany(const std::vector<std::int64_t>& ids, std::vector<std::optional<Todo>>& todos) const override;
+    void remove(std::int64_t id) override;
+    bool checkId(std::int64_t id) const override;
+    IdRange query(const TodoProperty& property) const override;
+    IdRange rangeQuery(double minTimeStamp, double maxTimeStamp) const override;
+    RangePage rangeQueryOrdered(double minTimeStamp, double maxTimeStamp,
+                                std::size_t limit, const RangeCursor& cursor) const override;
+    std::size_t queryCount(const TodoProperty& property) const override;
+    std::size_t rangeCount(double minTimeStamp, double maxTimeStamp) const override;
+    std::unique_ptr<Store> createChild() override;
+    void commit() override;
+    void rollback() override;
+
+private:
+    /**
+     * Ids of the todos changed since the snapshot, with the current titles and timestamps to be hidden
+     * and the old ones to be returned instead. When the store changed since the last read, they are extended
+     * with the todos changed since the version they were collected up to, in O(changes since that version).
+     */
+    struct Changes
+    {
+        struct IndexedValues
+        {
+            std::string title;
+            double timestamp;
+        };
+
+        std::atomic<std::uint64_t> storeVersion;
+        IdSet ids;
+        /**
+         * The values in the current indexes of every changed todo that exists now, removed when it changes again.
+         */
+        FlatIdMap<IndexedValues> currentValues;
+        StringPropertyIds oldTitleIds;
+        DoublePropertyIds oldTimestampIds;
+        StringPropertyIds currentTitleIds;
+        DoublePropertyIds currentTimestampIds;
+    };
+    const Changes& changes() const;
+
+    std::shared_ptr<ParentStore> store;
+    std::uint64_t snapshotVersion;
+    /**
+     * Readers of the store can read the snapshot concurrently, while the store does not change:
+     * the first one to find the changes behind the store extends them, under the mutex.
+     */
+    mutable std::mutex changesMutex;
+    mutable Changes changesSinceSnapshot;
+};
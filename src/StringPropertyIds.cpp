@@ -1,20 +1,83 @@
 #include "StringPropertyIds.h"
 
+StringPropertyIds::StringPropertyIds(std::pmr::memory_resource* resource)
+        :propertyIds{resource}
+{
+}
+
+StringPropertyIds::StringPropertyIds(const StringPropertyIds& other, std::pmr::memory_resource* resource)
+        :propertyIds{other.propertyIds, resource}
+{
+}
+
 void StringPropertyIds::insert(const std::string& property, std::int64_t id)
 {
-    // Complexity O(1), O(N) if rehashing is needed.
+    // Complexity O(1), O(N) if rehashing is needed. Plus O(log n) inserting in the posting list
     propertyIds[property].insert(id);
 }
 
-std::unordered_set<std::int64_t> StringPropertyIds::getIds(const std::string& property) const
+void StringPropertyIds::insert(const std::string& property, std::vector<std::int64_t> ids)
 {
-    // Find complexity average constant O(1), worst case O(N) (In case all keys are in same bucket)
-    std::unordered_set<std::int64_t> ids;
-    if(propertyIds.find(property) not_eq propertyIds.end())
+    auto& propertyIdSet{propertyIds[property]};
+    if(propertyIdSet.empty())
     {
-        ids = propertyIds.at(property);
+        propertyIdSet = IdSet::fromIds(std::move(ids)); // Complexity O(N log N)
+        return;
+    }
+    for(const auto id : ids)
+    {
+        propertyIdSet.insert(id);
     }
-    return ids;
+}
+
+void StringPropertyIds::insert(const StringPropertyIds& other)
+{
+    for(const auto& otherIds : other.propertyIds)
+    {
+        auto& propertyIdSet{propertyIds[otherIds.first]};
+        if(propertyIdSet.empty())
+        {
+            propertyIdSet = otherIds.second; // Complexity O(k), the posting list is copied as it is
+            continue;
+        }
+        for(const auto id : otherIds.second)
+        {
+            propertyIdSet.insert(id);
+        }
+    }
+}
+
+void StringPropertyIds::remove(const StringPropertyIds& other)
+{
+    for(const auto& otherIds : other.propertyIds)
+    {
+        const auto it{propertyIds.find(otherIds.first)};
+        if(it == propertyIds.end())
+        {
+            continue;
+        }
+        for(const auto id : otherIds.second)
+        {
+            it->second.erase(id); // Complexity O(log n)
+        }
+        if(it->second.empty())
+        {
+            propertyIds.erase(it);
+        }
+    }
+}
+
+const IdSet& StringPropertyIds::getIds(const std::string& property) const
+{
+    static const IdSet noIds;
+    // Find complexity average constant O(1), worst case O(N) (In case all keys are in same bucket)
+    const auto it{propertyIds.find(property)};
+    return it not_eq propertyIds.end() ? it->second : noIds;
+}
+
+std::size_t StringPropertyIds::count(const std::string& property) const
+{
+    return getIds(property).size();
 }
 
 void StringPropertyIds::updateProperty(const std::string &oldProperty,
@@ -32,10 +95,8 @@ void StringPropertyIds::remove(const std::string &property, std::int64_t id)
     const auto propertyExists{it not_eq propertyIds.end()};
     if(propertyExists)
     {
-        if (it->second.size() > 1)
-        {
-            it->second.erase(id); // Complexity O(1), worst case O(N)
-        } else
+        it->second.erase(id); // Complexity O(log n)
+        if (it->second.empty())
         {
             propertyIds.erase(it); // Complexity O(1)
         }
@@ -1,6 +1,10 @@
 #pragma once
-#include <unordered_set>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
 #include <unordered_map>
+#include <vector>
+#include "IdSet.h"
 
 /**
  * Responsibility: keep a set of ids related to a string property so
@@ -9,14 +13,39 @@
 class StringPropertyIds
 {
 public:
+    StringPropertyIds() = default;
+    /**
+     * The index nodes are allocated from the memory resource (copies use the default one unless given).
+     * The properties longer than the small string buffer and the posting lists of many ids are not.
+     */
+    explicit StringPropertyIds(std::pmr::memory_resource* resource);
+    StringPropertyIds(const StringPropertyIds& other, std::pmr::memory_resource* resource);
+
     void insert(const std::string& property, std::int64_t id);
 
     /**
-     * We could return here a const& in order to avoid an extra copying
-     * In this case the client could only read the ids.
-     * Another alternative would be create a view with C++20 features (or rangeV3, boost)
+     * Bulk version of insert for many ids with the same property,
+     * a new property builds its posting list with a single sort.
+     */
+    void insert(const std::string& property, std::vector<std::int64_t> ids);
+
+    /**
+     * Returns a const& to the ids kept in the index to avoid copying them, so the client can only read them.
+     * The reference is valid until the index is modified.
+     */
+    /**
+     * Bulk versions of insert and remove with every (property, id) pair of another index,
+     * one hash lookup per property instead of one per pair.
+     */
+    void insert(const StringPropertyIds& other);
+    void remove(const StringPropertyIds& other);
+
+    const IdSet& getIds(const std::string& property) const;
+
+    /**
+     * Number of ids with the given property, the size of its posting list. Complexity O(1)
      */
-    std::unordered_set<std::int64_t> getIds(const std::string& property) const;
+    std::size_t count(const std::string& property) const;
 
     void updateProperty(const std::string &oldProperty,
                         const std::string &newProperty,
@@ -26,9 +55,10 @@ public:
 private:
      /**
       * Unordered container was chosen because it performance better and there is not need
-      * to have the ids in a specific order
+      * to have the properties in a specific order. The ids of every property are kept in
+      * a compact posting list, so a property with a single todo does not allocate a hash table.
       */
-    std::unordered_map<std::string, std::unordered_set<std::int64_t>> propertyIds;
+    std::pmr::unordered_map<std::string, IdSet> propertyIds;
 };
 
 
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(std::size_t workerCount)
+{
+    workers.reserve(workerCount);
+    for(std::size_t worker{0}; worker < workerCount; ++worker)
+    {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    batchAdded.notify_all();
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(std::size_t taskCount, const std::function<void(std::size_t)>& task)
+{
+    if(taskCount == 0)
+    {
+        return;
+    }
+    const auto batch{std::make_shared<Batch>(taskCount, task)};
+    // the caller takes tasks too, so one helper less is needed
+    const auto helpers{std::min(workers.size(), taskCount - 1)};
+    if(helpers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            batches.insert(batches.end(), helpers, batch);
+        }
+        batchAdded.notify_all();
+    }
+    batch->work();
+    batch->wait();
+    if(batch->error)
+    {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    while(true)
+    {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            batchAdded.wait(lock, [this] { return stopping or not batches.empty(); });
+            if(stopping)
+            {
+                return;
+            }
+            batch = std::move(batches.front());
+            batches.pop_front();
+        }
+        // a batch whose tasks were all taken meanwhile is done here without touching its task
+        batch->work();
+    }
+}
+
+void ThreadPool::Batch::work()
+{
+    for(auto index{nextTask++}; index < taskCount; index = nextTask++)
+    {
+        std::exception_ptr taskError;
+        try
+        {
+            task(index);
+        } catch(...)
+        {
+            taskError = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock{mutex};
+        if(taskError and not error)
+        {
+            error = taskError;
+        }
+        if(++doneTasks == taskCount)
+        {
+            allDone.notify_all();
+        }
+    }
+}
+
+void ThreadPool::Batch::wait()
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    allDone.wait(lock, [this] { return doneTasks == taskCount; });
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Responsibility: run the tasks of a fan-out (e.g. one per shard) in parallel.
+ *
+ * The calling thread takes tasks too, and the workers only help with the tasks nobody took yet,
+ * so a fan-out never waits for a busy worker and it can be run from several threads at the same time.
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(std::size_t workerCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Runs task(0) ... task(taskCount - 1) and returns once all of them are done.
+     * The first exception thrown by a task is rethrown, once all of them are done.
+     */
+    void run(std::size_t taskCount, const std::function<void(std::size_t)>& task);
+
+private:
+    /**
+     * Tasks of a run, claimed one by one by the caller and the workers helping it.
+     */
+    struct Batch
+    {
+        Batch(std::size_t taskCount, const std::function<void(std::size_t)>& task)
+                : taskCount{taskCount}, task{task}
+        {
+        }
+
+        void work();
+        void wait();
+
+        const std::size_t taskCount;
+        // only called for the tasks claimed before the run returns, so it is still alive
+        const std::function<void(std::size_t)>& task;
+        std::atomic<std::size_t> nextTask{0};
+        std::mutex mutex;
+        std::condition_variable allDone;
+        std::size_t doneTasks{0};
+        std::exception_ptr error;
+    };
+
+    void workerLoop();
+
+    std::mutex mutex;
+    std::condition_variable batchAdded;
+    std::deque<std::shared_ptr<Batch>> batches;
+    bool stopping{false};
+    std::vector<std::thread> workers;
+};
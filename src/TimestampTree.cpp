@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <limits>
+#include "TimestampTree.h"
+
+namespace
+{
+    constexpr std::size_t minLeafFill{TimestampTree::leafCapacity / 4};
+    constexpr std::size_t minInnerFill{TimestampTree::innerCapacity / 4};
+}
+
+TimestampTree::TimestampTree()
+        :TimestampTree{std::pmr::get_default_resource()}
+{
+}
+
+TimestampTree::TimestampTree(std::pmr::memory_resource* resource)
+        :resource{resource}, root{create<Leaf>()}
+{
+    firstLeaf = lastLeaf = static_cast<Leaf*>(root);
+}
+
+TimestampTree::TimestampTree(const TimestampTree& other)
+        :TimestampTree{other, std::pmr::get_default_resource()}
+{
+}
+
+TimestampTree::TimestampTree(const TimestampTree& other, std::pmr::memory_resource* resource)
+        :TimestampTree{resource}
+{
+    assignSorted(std::vector<Entry>(other.begin(), other.end()));
+}
+
+TimestampTree::TimestampTree(TimestampTree&& other) noexcept
+        :TimestampTree{other.resource}
+{
+    swap(other);
+}
+
+TimestampTree& TimestampTree::operator=(TimestampTree other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+TimestampTree::~TimestampTree()
+{
+    destroy(root);
+}
+
+void TimestampTree::swap(TimestampTree& other) noexcept
+{
+    std::swap(resource, other.resource);
+    std::swap(root, other.root);
+    std::swap(firstLeaf, other.firstLeaf);
+    std::swap(lastLeaf, other.lastLeaf);
+    std::swap(entryCount, other.entryCount);
+}
+
+bool TimestampTree::insert(const Entry& entry)
+{
+    // Complexity O(log n), the height of the tree
+    Split split{entry, nullptr};
+    const auto inserted{insert(root, entry, split)};
+    if(split.right)
+    {
+        // the root was split, the tree grows one level
+        auto* newRoot{create<Inner>()};
+        newRoot->children[0] = root;
+        newRoot->children[1] = split.right;
+        newRoot->counts[0] = subtreeCount(root);
+        newRoot->counts[1] = subtreeCount(split.right);
+        newRoot->keys[0] = split.separator;
+        newRoot->size = 2;
+        root = newRoot;
+    }
+    if(inserted)
+    {
+        ++entryCount;
+    }
+    return inserted;
+}
+
+bool TimestampTree::erase(const Entry& entry)
+{
+    // Complexity O(log n), the height of the tree
+    const auto erased{erase(root, entry)};
+    if(not root->leaf and root->size == 1)
+    {
+        // the root has a single child left, the tree shrinks one level
+        auto* oldRoot{static_cast<Inner*>(root)};
+        root = oldRoot->children[0];
+        release(oldRoot);
+    }
+    if(erased)
+    {
+        --entryCount;
+    }
+    return erased;
+}
+
+TimestampTree::const_iterator TimestampTree::lowerBound(const Entry& entry) const
+{
+    const auto* leaf{findLeaf(entry)};
+    const auto index{static_cast<std::size_t>(std::lower_bound(leaf->entries, leaf->entries + leaf->size, entry) -
+                                              leaf->entries)};
+    if(index == leaf->size and leaf->next)
+    {
+        // every entry of the leaf is smaller, the bound is the first entry of the next one
+        return {leaf->next, 0};
+    }
+    return {leaf, index};
+}
+
+TimestampTree::const_iterator TimestampTree::lowerBound(double timestamp) const
+{
+    return lowerBound(Entry{timestamp, std::numeric_limits<std::int64_t>::min()});
+}
+
+TimestampTree::const_iterator TimestampTree::upperBound(double timestamp) const
+{
+    const Entry lastPossibleEntry{timestamp, std::numeric_limits<std::int64_t>::max()};
+    auto it{lowerBound(lastPossibleEntry)};
+    if(it not_eq end() and *it == lastPossibleEntry)
+    {
+        ++it;
+    }
+    return it;
+}
+
+std::size_t TimestampTree::rank(const Entry& entry) const
+{
+    return rank(entry, false);
+}
+
+std::size_t TimestampTree::count(double minTimestamp, double maxTimestamp) const
+{
+    if(maxTimestamp < minTimestamp)
+    {
+        return 0;
+    }
+    const auto entriesBefore{rank({minTimestamp, std::numeric_limits<std::int64_t>::min()}, false)};
+    const auto entriesUntilEnd{rank({maxTimestamp, std::numeric_limits<std::int64_t>::max()}, true)};
+    return entriesUntilEnd - entriesBefore;
+}
+
+TimestampTree::const_iterator TimestampTree::begin() const
+{
+    return {firstLeaf, 0};
+}
+
+TimestampTree::const_iterator TimestampTree::end() const
+{
+    return {lastLeaf, lastLeaf->size};
+}
+
+void TimestampTree::assignSorted(const std::vector<Entry>& sortedEntries)
+{
+    destroy(root);
+    entryCount = sortedEntries.size();
+    if(sortedEntries.empty())
+    {
+        root = firstLeaf = lastLeaf = create<Leaf>();
+        return;
+    }
+
+    // spread the entries evenly so no leaf (nor inner node) ends up almost empty
+    std::vector<Node*> level;
+    std::vector<Entry> levelMinimums;
+    const auto leafCount{(sortedEntries.size() + leafCapacity - 1) / leafCapacity};
+    Leaf* previousLeaf{nullptr};
+    for(std::size_t leafIndex{0}, begin{0}; leafIndex < leafCount; ++leafIndex)
+    {
+        const auto end{sortedEntries.size() * (leafIndex + 1) / leafCount};
+        auto* leaf{create<Leaf>()};
+        std::copy(sortedEntries.begin() + begin, sortedEntries.begin() + end, leaf->entries);
+        leaf->size = static_cast<std::uint32_t>(end - begin);
+        leaf->previous = previousLeaf;
+        if(previousLeaf)
+        {
+            previousLeaf->next = leaf;
+        }
+        previousLeaf = leaf;
+        level.push_back(leaf);
+        levelMinimums.push_back(sortedEntries[begin]);
+        begin = end;
+    }
+    firstLeaf = static_cast<Leaf*>(level.front());
+    lastLeaf = previousLeaf;
+
+    while(level.size() > 1)
+    {
+        std::vector<Node*> parentLevel;
+        std::vector<Entry> parentMinimums;
+        const auto innerCount{(level.size() + innerCapacity - 1) / innerCapacity};
+        for(std::size_t innerIndex{0}, begin{0}; innerIndex < innerCount; ++innerIndex)
+        {
+            const auto end{level.size() * (innerIndex + 1) / innerCount};
+            auto* inner{create<Inner>()};
+            for(auto child{begin}; child < end; ++child)
+            {
+                inner->children[child - begin] = level[child];
+                inner->counts[child - begin] = subtreeCount(level[child]);
+                if(child > begin)
+                {
+                    inner->keys[child - begin - 1] = levelMinimums[child];
+                }
+            }
+            inner->size = static_cast<std::uint32_t>(end - begin);
+            parentLevel.push_back(inner);
+            parentMinimums.push_back(levelMinimums[begin]);
+            begin = end;
+        }
+        level = std::move(parentLevel);
+        levelMinimums = std::move(parentMinimums);
+    }
+    root = level.front();
+}
+
+bool TimestampTree::insert(Node* node, const Entry& entry, Split& split)
+{
+    if(node->leaf)
+    {
+        auto* leaf{static_cast<Leaf*>(node)};
+        auto* position{std::lower_bound(leaf->entries, leaf->entries + leaf->size, entry)};
+        if(position not_eq leaf->entries + leaf->size and *position == entry)
+        {
+            return false;
+        }
+        std::copy_backward(position, leaf->entries + leaf->size, leaf->entries + leaf->size + 1);
+        *position = entry;
+        ++leaf->size;
+
+        if(leaf->size > leafCapacity)
+        {
+            // move the upper half to a new leaf linked right after this one
+            auto* right{create<Leaf>()};
+            const auto leftSize{leaf->size / 2};
+            std::copy(leaf->entries + leftSize, leaf->entries + leaf->size, right->entries);
+            right->size = leaf->size - leftSize;
+            leaf->size = leftSize;
+
+            right->previous = leaf;
+            right->next = leaf->next;
+            if(leaf->next)
+            {
+                leaf->next->previous = right;
+            } else
+            {
+                lastLeaf = right;
+            }
+            leaf->next = right;
+            split = {right->entries[0], right};
+        }
+        return true;
+    }
+
+    auto* inner{static_cast<Inner*>(node)};
+    const auto childIndex{static_cast<std::size_t>(std::upper_bound(inner->keys, inner->keys + inner->size - 1, entry) -
+                                                   inner->keys)};
+    Split childSplit{entry, nullptr};
+    const auto inserted{insert(inner->children[childIndex], entry, childSplit)};
+    if(inserted)
+    {
+        ++inner->counts[childIndex];
+    }
+    if(childSplit.right)
+    {
+        std::copy_backward(inner->keys + childIndex, inner->keys + inner->size - 1, inner->keys + inner->size);
+        std::copy_backward(inner->children + childIndex + 1, inner->children + inner->size,
+                           inner->children + inner->size + 1);
+        std::copy_backward(inner->counts + childIndex + 1, inner->counts + inner->size,
+                           inner->counts + inner->size + 1);
+        inner->keys[childIndex] = childSplit.separator;
+        inner->children[childIndex + 1] = childSplit.right;
+        inner->counts[childIndex + 1] = subtreeCount(childSplit.right);
+        inner->counts[childIndex] -= inner->counts[childIndex + 1];
+        ++inner->size;
+
+        if(inner->size > innerCapacity)
+        {
+            // the key between both halves moves up to the parent
+            auto* right{create<Inner>()};
+            const auto leftSize{inner->size / 2};
+            right->size = inner->size - leftSize;
+            std::copy(inner->children + leftSize, inner->children + inner->size, right->children);
+            std::copy(inner->counts + leftSize, inner->counts + inner->size, right->counts);
+            std::copy(inner->keys + leftSize, inner->keys + inner->size - 1, right->keys);
+            split = {inner->keys[leftSize - 1], right};
+            inner->size = leftSize;
+        }
+    }
+    return inserted;
+}
+
+bool TimestampTree::erase(Node* node, const Entry& entry)
+{
+    if(node->leaf)
+    {
+        auto* leaf{static_cast<Leaf*>(node)};
+        auto* position{std::lower_bound(leaf->entries, leaf->entries + leaf->size, entry)};
+        if(position == leaf->entries + leaf->size or *position not_eq entry)
+        {
+            return false;
+        }
+        std::copy(position + 1, leaf->entries + leaf->size, position);
+        --leaf->size;
+        return true;
+    }
+
+    auto* inner{static_cast<Inner*>(node)};
+    const auto childIndex{static_cast<std::size_t>(std::upper_bound(inner->keys, inner->keys + inner->size - 1, entry) -
+                                                   inner->keys)};
+    auto* child{inner->children[childIndex]};
+    const auto erased{erase(child, entry)};
+    if(not erased)
+    {
+        return false;
+    }
+    --inner->counts[childIndex];
+    const auto minFill{child->leaf ? minLeafFill : minInnerFill};
+    if(child->size < minFill)
+    {
+        rebalanceChild(inner, childIndex);
+    }
+    return true;
+}
+
+void TimestampTree::rebalanceChild(Inner* parent, std::size_t childIndex)
+{
+    auto* child{parent->children[childIndex]};
+    auto* left{childIndex > 0 ? parent->children[childIndex - 1] : nullptr};
+    auto* right{childIndex + 1 < parent->size ? parent->children[childIndex + 1] : nullptr};
+    const auto capacity{child->leaf ? leafCapacity : innerCapacity};
+
+    if(left and left->size + child->size <= capacity)
+    {
+        mergeChildren(parent, childIndex - 1);
+    } else if(right and child->size + right->size <= capacity)
+    {
+        mergeChildren(parent, childIndex);
+    } else if(left)
+    {
+        // the left sibling cannot be merged, so it is full enough to give its last entry
+        if(child->leaf)
+        {
+            auto* leaf{static_cast<Leaf*>(child)};
+            auto* leftLeaf{static_cast<Leaf*>(left)};
+            std::copy_backward(leaf->entries, leaf->entries + leaf->size, leaf->entries + leaf->size + 1);
+            leaf->entries[0] = leftLeaf->entries[leftLeaf->size - 1];
+            parent->keys[childIndex - 1] = leaf->entries[0];
+            --parent->counts[childIndex - 1];
+            ++parent->counts[childIndex];
+        } else
+        {
+            auto* inner{static_cast<Inner*>(child)};
+            auto* leftInner{static_cast<Inner*>(left)};
+            std::copy_backward(inner->keys, inner->keys + inner->size - 1, inner->keys + inner->size);
+            std::copy_backward(inner->children, inner->children + inner->size, inner->children + inner->size + 1);
+            std::copy_backward(inner->counts, inner->counts + inner->size, inner->counts + inner->size + 1);
+            inner->children[0] = leftInner->children[leftInner->size - 1];
+            inner->counts[0] = leftInner->counts[leftInner->size - 1];
+            parent->counts[childIndex - 1] -= inner->counts[0];
+            parent->counts[childIndex] += inner->counts[0];
+            inner->keys[0] = parent->keys[childIndex - 1];
+            parent->keys[childIndex - 1] = leftInner->keys[leftInner->size - 2];
+        }
+        --left->size;
+        ++child->size;
+    } else
+    {
+        // same with the first entry of the right sibling
+        if(child->leaf)
+        {
+            auto* leaf{static_cast<Leaf*>(child)};
+            auto* rightLeaf{static_cast<Leaf*>(right)};
+            leaf->entries[leaf->size] = rightLeaf->entries[0];
+            std::copy(rightLeaf->entries + 1, rightLeaf->entries + rightLeaf->size, rightLeaf->entries);
+            parent->keys[childIndex] = rightLeaf->entries[0];
+            ++parent->counts[childIndex];
+            --parent->counts[childIndex + 1];
+        } else
+        {
+            auto* inner{static_cast<Inner*>(child)};
+            auto* rightInner{static_cast<Inner*>(right)};
+            inner->keys[inner->size - 1] = parent->keys[childIndex];
+            inner->children[inner->size] = rightInner->children[0];
+            inner->counts[inner->size] = rightInner->counts[0];
+            parent->counts[childIndex] += rightInner->counts[0];
+            parent->counts[childIndex + 1] -= rightInner->counts[0];
+            parent->keys[childIndex] = rightInner->keys[0];
+            std::copy(rightInner->keys + 1, rightInner->keys + rightInner->size - 1, rightInner->keys);
+            std::copy(rightInner->children + 1, rightInner->children + rightInner->size, rightInner->children);
+            std::copy(rightInner->counts + 1, rightInner->counts + rightInner->size, rightInner->counts);
+        }
+        --right->size;
+        ++child->size;
+    }
+}
+
+void TimestampTree::mergeChildren(Inner* parent, std::size_t leftIndex)
+{
+    auto* left{parent->children[leftIndex]};
+    auto* right{parent->children[leftIndex + 1]};
+    if(left->leaf)
+    {
+        auto* leftLeaf{static_cast<Leaf*>(left)};
+        auto* rightLeaf{static_cast<Leaf*>(right)};
+        std::copy(rightLeaf->entries, rightLeaf->entries + rightLeaf->size, leftLeaf->entries + leftLeaf->size);
+        leftLeaf->next = rightLeaf->next;
+        if(rightLeaf->next)
+        {
+            rightLeaf->next->previous = leftLeaf;
+        } else
+        {
+            lastLeaf = leftLeaf;
+        }
+        leftLeaf->size += rightLeaf->size;
+        release(rightLeaf);
+    } else
+    {
+        auto* leftInner{static_cast<Inner*>(left)};
+        auto* rightInner{static_cast<Inner*>(right)};
+        // the separator of both nodes in the parent goes down between their keys
+        leftInner->keys[leftInner->size - 1] = parent->keys[leftIndex];
+        std::copy(rightInner->keys, rightInner->keys + rightInner->size - 1, leftInner->keys + leftInner->size);
+        std::copy(rightInner->children, rightInner->children + rightInner->size,
+                  leftInner->children + leftInner->size);
+        std::copy(rightInner->counts, rightInner->counts + rightInner->size, leftInner->counts + leftInner->size);
+        leftInner->size += rightInner->size;
+        release(rightInner);
+    }
+
+    std::copy(parent->keys + leftIndex + 1, parent->keys + parent->size - 1, parent->keys + leftIndex);
+    std::copy(parent->children + leftIndex + 2, parent->children + parent->size, parent->children + leftIndex + 1);
+    parent->counts[leftIndex] += parent->counts[leftIndex + 1];
+    std::copy(parent->counts + leftIndex + 2, parent->counts + parent->size, parent->counts + leftIndex + 1);
+    --parent->size;
+}
+
+std::size_t TimestampTree::rank(const Entry& entry, bool inclusive) const
+{
+    // the entries of the children on the left of the path are added without visiting them
+    std::size_t entriesBefore{0};
+    const auto* node{root};
+    while(not node->leaf)
+    {
+        const auto* inner{static_cast<const Inner*>(node)};
+        const auto childIndex{std::upper_bound(inner->keys, inner->keys + inner->size - 1, entry) - inner->keys};
+        for(auto child{0}; child < childIndex; ++child)
+        {
+            entriesBefore += inner->counts[child];
+        }
+        node = inner->children[childIndex];
+    }
+    const auto* leaf{static_cast<const Leaf*>(node)};
+    const auto* position{inclusive ? std::upper_bound(leaf->entries, leaf->entries + leaf->size, entry) :
+                         std::lower_bound(leaf->entries, leaf->entries + leaf->size, entry)};
+    return entriesBefore + static_cast<std::size_t>(position - leaf->entries);
+}
+
+std::size_t TimestampTree::subtreeCount(const Node* node)
+{
+    if(node->leaf)
+    {
+        return node->size;
+    }
+    const auto* inner{static_cast<const Inner*>(node)};
+    std::size_t entries{0};
+    for(std::size_t child{0}; child < inner->size; ++child)
+    {
+        entries += inner->counts[child];
+    }
+    return entries;
+}
+
+void TimestampTree::destroy(Node* node)
+{
+    if(node->leaf)
+    {
+        release(static_cast<Leaf*>(node));
+        return;
+    }
+    auto* inner{static_cast<Inner*>(node)};
+    for(std::size_t child{0}; child < inner->size; ++child)
+    {
+        destroy(inner->children[child]);
+    }
+    release(inner);
+}
+
+template<typename NodeType>
+NodeType* TimestampTree::create()
+{
+    return new (resource->allocate(sizeof(NodeType), alignof(NodeType))) NodeType;
+}
+
+template<typename NodeType>
+void TimestampTree::release(NodeType* node)
+{
+    node->~NodeType();
+    resource->deallocate(node, sizeof(NodeType), alignof(NodeType));
+}
+
+const TimestampTree::Leaf* TimestampTree::findLeaf(const Entry& entry) const
+{
+    const auto* node{root};
+    while(not node->leaf)
+    {
+        const auto* inner{static_cast<const Inner*>(node)};
+        const auto childIndex{std::upper_bound(inner->keys, inner->keys + inner->size - 1, entry) - inner->keys};
+        node = inner->children[childIndex];
+    }
+    return static_cast<const Leaf*>(node);
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * Responsibility: keep (timestamp, id) pairs sorted in a B+-tree with wide nodes.
+ *
+ * Leaves hold up to leafCapacity pairs in a contiguous array and are linked to their neighbours,
+ * so a range scan is a lower bound search (O(log n)) followed by sequential reads, instead of
+ * walking one red-black tree node per timestamp. Inserting and removing are O(log n), nodes
+ * are split when full and merged with a sibling (or borrow from it) when they get too empty.
+ * Inner nodes also keep the number of entries below every child, so the position of an entry
+ * and the number of entries in a range are found in O(log n) without reading the leaves.
+ * Nodes are allocated from a memory resource, the default one unless given.
+ */
+class TimestampTree
+{
+public:
+    struct Entry
+    {
+        double timestamp;
+        std::int64_t id;
+
+        bool operator<(const Entry& other) const
+        {
+            return timestamp < other.timestamp or (timestamp == other.timestamp and id < other.id);
+        }
+        bool operator==(const Entry& other) const { return timestamp == other.timestamp and id == other.id; }
+        bool operator!=(const Entry& other) const { return not (*this == other); }
+    };
+
+    static constexpr std::size_t leafCapacity{64};
+    static constexpr std::size_t innerCapacity{64};
+
+private:
+    struct Node
+    {
+        bool leaf;
+        std::uint32_t size{0};
+    };
+
+    struct Leaf: Node
+    {
+        Leaf(): Node{true} {}
+        // one extra entry so a full leaf can take the insertion before being split
+        Entry entries[leafCapacity + 1];
+        Leaf* previous{nullptr};
+        Leaf* next{nullptr};
+    };
+
+    struct Inner: Node
+    {
+        Inner(): Node{false} {}
+        // child i holds the entries in [keys[i-1], keys[i]), counts[i] of them
+        Entry keys[innerCapacity];
+        Node* children[innerCapacity + 1];
+        std::size_t counts[innerCapacity + 1];
+    };
+
+public:
+    /**
+     * Bidirectional iterator over the entries in ascending order.
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry*;
+        using reference = const Entry&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return leaf->entries[index]; }
+        pointer operator->() const { return &leaf->entries[index]; }
+
+        const_iterator& operator++()
+        {
+            if(++index == leaf->size and leaf->next)
+            {
+                leaf = leaf->next;
+                index = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto copy{*this};
+            ++(*this);
+            return copy;
+        }
+
+        const_iterator& operator--()
+        {
+            if(index == 0 and leaf->previous)
+            {
+                leaf = leaf->previous;
+                index = leaf->size;
+            }
+            --index;
+            return *this;
+        }
+
+        const_iterator operator--(int)
+        {
+            auto copy{*this};
+            --(*this);
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const { return leaf == other.leaf and index == other.index; }
+        bool operator!=(const const_iterator& other) const { return not (*this == other); }
+
+    private:
+        friend class TimestampTree;
+        const_iterator(const Leaf* leaf, std::size_t index): leaf{leaf}, index{index} {}
+
+        const Leaf* leaf{nullptr};
+        std::size_t index{0};
+    };
+
+    TimestampTree();
+    explicit TimestampTree(std::pmr::memory_resource* resource);
+    /**
+     * Copies use the default memory resource unless another one is given.
+     */
+    TimestampTree(const TimestampTree& other);
+    TimestampTree(const TimestampTree& other, std::pmr::memory_resource* resource);
+    TimestampTree(TimestampTree&& other) noexcept;
+    TimestampTree& operator=(TimestampTree other) noexcept;
+    ~TimestampTree();
+
+    /**
+     * The memory resources are swapped with the entries.
+     */
+    void swap(TimestampTree& other) noexcept;
+
+    /**
+     * Returns false if the pair was already in the tree.
+     */
+    bool insert(const Entry& entry);
+
+    /**
+     * Returns false if the pair was not in the tree.
+     */
+    bool erase(const Entry& entry);
+
+    /**
+     * First entry not less than the given one.
+     */
+    const_iterator lowerBound(const Entry& entry) const;
+
+    /**
+     * First entry with a timestamp not less than the given one.
+     */
+    const_iterator lowerBound(double timestamp) const;
+
+    /**
+     * First entry with a timestamp greater than the given one.
+     */
+    const_iterator upperBound(double timestamp) const;
+
+    /**
+     * Number of entries less than the given one. Complexity O(log n)
+     */
+    std::size_t rank(const Entry& entry) const;
+
+    /**
+     * Number of entries with a timestamp in [minTimestamp, maxTimestamp]. Complexity O(log n)
+     */
+    std::size_t count(double minTimestamp, double maxTimestamp) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    std::size_t size() const { return entryCount; }
+    bool empty() const { return entryCount == 0; }
+
+    /**
+     * Replaces the content of the tree with entries that are already sorted and unique,
+     * filling the leaves sequentially in O(N) instead of N insertions.
+     */
+    void assignSorted(const std::vector<Entry>& sortedEntries);
+
+private:
+    struct Split
+    {
+        Entry separator;
+        Node* right;
+    };
+
+    bool insert(Node* node, const Entry& entry, Split& split);
+    bool erase(Node* node, const Entry& entry);
+    void rebalanceChild(Inner* parent, std::size_t childIndex);
+    void mergeChildren(Inner* parent, std::size_t leftIndex);
+    std::size_t rank(const Entry& entry, bool inclusive) const;
+    static std::size_t subtreeCount(const Node* node);
+    void destroy(Node* node);
+    template<typename NodeType>
+    NodeType* create();
+    template<typename NodeType>
+    void release(NodeType* node);
+    const Leaf* findLeaf(const Entry& entry) const;
+
+    std::pmr::memory_resource* resource;
+    Node* root;
+    Leaf* firstLeaf;
+    Leaf* lastLeaf;
+    std::size_t entryCount{0};
+};
@@ -0,0 +1,58 @@
+#include "TodoColumns.h"
+
+TodoColumns::Slot TodoColumns::insert(Todo todo)
+{
+    auto slot{find(todo.id)};
+    if(slot == npos)
+    {
+        if(freeSlots.empty())
+        {
+            // grow all the columns at once, amortized O(1)
+            slot = ids.size();
+            ids.emplace_back();
+            timestamps.emplace_back();
+            titles.emplace_back();
+            descriptions.emplace_back();
+            occupiedSlots.push_back(false);
+        } else
+        {
+            // reuse the last freed slot, it is the most likely to be still in cache
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        slots[todo.id] = slot; // Complexity O(1), O(N) if rehashing is needed.
+    }
+
+    ids[slot] = todo.id;
+    timestamps[slot] = todo.timestamp;
+    titles[slot] = std::move(todo.title);
+    descriptions[slot] = std::move(todo.description);
+    occupiedSlots[slot] = true;
+    return slot;
+}
+
+TodoColumns::Slot TodoColumns::find(std::int64_t id) const
+{
+    const auto it{slots.find(id)};
+    return it not_eq slots.end() ? it->second : npos;
+}
+
+void TodoColumns::erase(Slot slot)
+{
+    slots.erase(ids[slot]);
+    occupiedSlots[slot] = false;
+    // release the string buffers now instead of keeping them until the slot is reused
+    std::string{}.swap(titles[slot]);
+    std::string{}.swap(descriptions[slot]);
+    freeSlots.push_back(slot);
+}
+
+void TodoColumns::reserve(std::size_t capacity)
+{
+    slots.reserve(capacity);
+    ids.reserve(capacity);
+    timestamps.reserve(capacity);
+    titles.reserve(capacity);
+    descriptions.reserve(capacity);
+    occupiedSlots.reserve(capacity);
+}
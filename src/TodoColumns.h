@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "FlatIdMap.h"
+#include "Todo.h"
+
+/**
+ * Responsibility: keep the todo records in a struct-of-arrays layout so scanning a single
+ * property (e.g. every timestamp) only pulls that property through the cache.
+ *
+ * Every record lives in a slot. A slot is an index shared by all the columns, and the
+ * slots of removed records are reused by the next insertions so the columns stay dense.
+ */
+class TodoColumns
+{
+public:
+    using Slot = std::size_t;
+    static constexpr Slot npos{std::numeric_limits<Slot>::max()};
+
+    /**
+     * Stores the todo in a free slot (or in the slot it already had if the id exists).
+     */
+    Slot insert(Todo todo);
+
+    /**
+     * Returns npos if the id is not stored.
+     */
+    Slot find(std::int64_t id) const;
+
+    void erase(Slot slot);
+
+    /**
+     * Cache hints for batched lookups: first the primary index entry of an id, then the values of its slot.
+     */
+    void prefetch(std::int64_t id) const { slots.prefetch(id); }
+    void prefetchSlot(Slot slot) const
+    {
+        __builtin_prefetch(&timestamps[slot]);
+        __builtin_prefetch(&titles[slot]);
+        __builtin_prefetch(&descriptions[slot]);
+    }
+
+    std::int64_t id(Slot slot) const { return ids[slot]; }
+    const std::string& title(Slot slot) const { return titles[slot]; }
+    std::string& title(Slot slot) { return titles[slot]; }
+    const std::string& description(Slot slot) const { return descriptions[slot]; }
+    std::string& description(Slot slot) { return descriptions[slot]; }
+    double timestamp(Slot slot) const { return timestamps[slot]; }
+    double& timestamp(Slot slot) { return timestamps[slot]; }
+
+    /**
+     * Free slots keep their last values, so scans over the columns have to skip them.
+     */
+    bool occupied(Slot slot) const { return occupiedSlots[slot]; }
+
+    /**
+     * Number of slots in the columns (occupied or not), the upper bound when scanning.
+     */
+    std::size_t slotCount() const { return ids.size(); }
+
+    std::size_t size() const { return slotCount() - freeSlots.size(); }
+
+    void reserve(std::size_t capacity);
+
+    /**
+     * Read only access to a whole column for analytics-style scans.
+     */
+    const std::vector<std::int64_t>& idColumn() const { return ids; }
+    const std::vector<double>& timestampColumn() const { return timestamps; }
+    const std::vector<std::string>& titleColumn() const { return titles; }
+    const std::vector<std::string>& descriptionColumn() const { return descriptions; }
+
+private:
+    /**
+     * Primary index, an open-addressing table keeps the id->slot lookup in one or two cache lines.
+     */
+    FlatIdMap<Slot> slots;
+    std::vector<Slot> freeSlots;
+
+    /**
+     * Columns, all of them with the same length and indexed by slot.
+     */
+    std::vector<std::int64_t> ids;
+    std::vector<double> timestamps;
+    std::vector<std::string> titles;
+    std::vector<std::string> descriptions;
+    std::vector<bool> occupiedSlots;
+};
@@ -0,0 +1,89 @@
+#include <stdexcept>
+#include "TodoPatch.h"
+
+TodoPatch TodoPatch::fromTodo(Todo todo)
+{
+    return {allProperties, std::move(todo.title), std::move(todo.description), todo.timestamp};
+}
+
+TodoPatch TodoPatch::fromProperties(const TodoProperties& properties)
+{
+    TodoPatch patch;
+    for(const auto& property : properties)
+    {
+        if(property.first == titleKey)
+        {
+            patch.setTitle(std::get<std::string>(property.second));
+        } else if(property.first == descriptionKey)
+        {
+            patch.setDescription(std::get<std::string>(property.second));
+        } else if(property.first == timestampKey)
+        {
+            patch.setTimestamp(std::get<double>(property.second));
+        } else
+        {
+            throw std::invalid_argument("Unknown property: " + std::string(property.first));
+        }
+    }
+    return patch;
+}
+
+TodoProperties TodoPatch::toProperties() const
+{
+    TodoProperties properties;
+    if(has(TodoPropertyId::title))
+    {
+        properties.emplace(titleKey, title);
+    }
+    if(has(TodoPropertyId::description))
+    {
+        properties.emplace(descriptionKey, description);
+    }
+    if(has(TodoPropertyId::timestamp))
+    {
+        properties.emplace(timestampKey, timestamp);
+    }
+    return properties;
+}
+
+void TodoPatch::merge(const TodoPatch& other)
+{
+    if(other.has(TodoPropertyId::title))
+    {
+        title = other.title;
+    }
+    if(other.has(TodoPropertyId::description))
+    {
+        description = other.description;
+    }
+    if(other.has(TodoPropertyId::timestamp))
+    {
+        timestamp = other.timestamp;
+    }
+    present |= other.present;
+}
+
+void TodoPatch::applyTo(Todo& todo) const
+{
+    if(has(TodoPropertyId::title))
+    {
+        todo.title = title;
+    }
+    if(has(TodoPropertyId::description))
+    {
+        todo.description = description;
+    }
+    if(has(TodoPropertyId::timestamp))
+    {
+        todo.timestamp = timestamp;
+    }
+}
+
+TodoProperties toProperties(const Todo& todo)
+{
+    return {
+            {titleKey,       todo.title},
+            {descriptionKey, todo.description},
+            {timestampKey,   todo.timestamp}
+    };
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Todo.h"
+
+/**
+ * Compile-time schema of the todo properties, the bit of every property in a patch.
+ */
+enum class TodoPropertyId: std::uint8_t
+{
+    title,
+    description,
+    timestamp
+};
+
+constexpr std::uint8_t propertyBit(TodoPropertyId property)
+{
+    return static_cast<std::uint8_t>(1u << static_cast<unsigned>(property));
+}
+
+/**
+ * Responsibility: typed set of todo properties for the hot path of the stores.
+ *
+ * A fixed layout with a presence bitmask replaces the TodoProperties hash map, so building,
+ * reading and merging a patch does not allocate a table nor hash the property names,
+ * and the type of every property is checked by the compiler.
+ */
+struct TodoPatch
+{
+    std::uint8_t present{0};
+    std::string title;
+    std::string description;
+    double timestamp{0.0};
+
+    static constexpr std::uint8_t allProperties{propertyBit(TodoPropertyId::title) |
+                                                propertyBit(TodoPropertyId::description) |
+                                                propertyBit(TodoPropertyId::timestamp)};
+
+    bool has(TodoPropertyId property) const { return (present & propertyBit(property)) not_eq 0; }
+    bool complete() const { return present == allProperties; }
+    bool empty() const { return present == 0; }
+
+    TodoPatch& setTitle(std::string value)
+    {
+        title = std::move(value);
+        present |= propertyBit(TodoPropertyId::title);
+        return *this;
+    }
+
+    TodoPatch& setDescription(std::string value)
+    {
+        description = std::move(value);
+        present |= propertyBit(TodoPropertyId::description);
+        return *this;
+    }
+
+    TodoPatch& setTimestamp(double value)
+    {
+        timestamp = value;
+        present |= propertyBit(TodoPropertyId::timestamp);
+        return *this;
+    }
+
+    /**
+     * Patch with every property of the todo
+     */
+    static TodoPatch fromTodo(Todo todo);
+
+    /**
+     * Adapter for the string keyed properties, throws std::invalid_argument with unknown properties.
+     */
+    static TodoPatch fromProperties(const TodoProperties& properties);
+    TodoProperties toProperties() const;
+
+    /**
+     * The properties present in the other patch overwrite the ones of this one.
+     */
+    void merge(const TodoPatch& other);
+
+    /**
+     * Writes the present properties into the todo.
+     */
+    void applyTo(Todo& todo) const;
+};
+
+TodoProperties toProperties(const Todo& todo);
+
+/**
+ * One change of a commit, applied in order to the parent store. The patch is not owned, it is kept
+ * by the child store committing it (nullptr when removing).
+ */
+struct TodoChange
+{
+    enum class Kind: std::uint8_t
+    {
+        insert,
+        update,
+        remove
+    };
+
+    Kind kind;
+    std::int64_t id;
+    const TodoPatch* patch;
+};
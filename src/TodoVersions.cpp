@@ -0,0 +1,80 @@
+#include "TodoVersions.h"
+
+bool TodoVersions::mustKeep(std::int64_t id) const
+{
+    if(pinnedVersions.empty())
+    {
+        return false;
+    }
+    // a snapshot pinned after the last kept version reads the current todo, which is about to change
+    const auto it{oldVersions.find(id)};
+    return it == oldVersions.end() or it->second.back().version <= pinnedVersions.rbegin()->first;
+}
+
+void TodoVersions::keep(std::int64_t id, std::optional<Todo> todo)
+{
+    oldVersions[id].push_back({currentVersion, std::move(todo)});
+    changes.push_back({currentVersion, id});
+}
+
+void TodoVersions::log(std::int64_t id)
+{
+    if(not pinnedVersions.empty())
+    {
+        changeLog.push_back({currentVersion, id});
+    }
+}
+
+std::uint64_t TodoVersions::pin()
+{
+    ++pinnedVersions[currentVersion];
+    return currentVersion;
+}
+
+void TodoVersions::unpin(std::uint64_t version)
+{
+    const auto pinned{pinnedVersions.find(version)};
+    if(pinned == pinnedVersions.end())
+    {
+        return;
+    }
+    if(--pinned->second == 0)
+    {
+        pinnedVersions.erase(pinned);
+    }
+
+    // versions kept for changes not after the oldest pinned snapshot are not read by anyone anymore
+    while(not changes.empty() and
+          (pinnedVersions.empty() or changes.front().version <= pinnedVersions.begin()->first))
+    {
+        const auto it{oldVersions.find(changes.front().id)};
+        auto& todoVersions{it->second};
+        todoVersions.pop_front();
+        if(todoVersions.empty())
+        {
+            oldVersions.erase(it);
+        }
+        changes.pop_front();
+    }
+    while(not changeLog.empty() and
+          (pinnedVersions.empty() or changeLog.front().version <= pinnedVersions.begin()->first))
+    {
+        changeLog.pop_front();
+    }
+}
+
+const TodoVersions::OldVersion* TodoVersions::find(std::int64_t id, std::uint64_t version) const
+{
+    const auto it{oldVersions.find(id)};
+    if(it == oldVersions.end())
+    {
+        return nullptr;
+    }
+    const auto& todoVersions{it->second};
+    const auto oldVersion{std::upper_bound(todoVersions.begin(), todoVersions.end(), version,
+                                           [](std::uint64_t version, const OldVersion& oldVersion)
+                                           {
+                                               return version < oldVersion.version;
+                                           })};
+    return oldVersion == todoVersions.end() ? nullptr : &*oldVersion;
+}
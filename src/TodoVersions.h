@@ -0,0 +1,134 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <utility>
+#include "FlatIdMap.h"
+#include "Todo.h"
+
+/**
+ * Responsibility: keep the old versions of the todos while a snapshot of the store needs them.
+ *
+ * Every change of the store gets a new commit sequence number and a snapshot pinned at version v
+ * sees the changes up to v. The state of a todo before a change is only kept when a pinned
+ * snapshot could still read it, and it is discarded once no snapshot older than the change
+ * is pinned anymore, so a store without snapshots keeps nothing.
+ */
+class TodoVersions
+{
+public:
+    /**
+     * The todo before the change made at version, empty if it did not exist.
+     */
+    struct OldVersion
+    {
+        std::uint64_t version;
+        std::optional<Todo> todo;
+    };
+
+    std::uint64_t current() const { return currentVersion; }
+
+    /**
+     * Starts the version of the next change.
+     */
+    void next() { ++currentVersion; }
+
+    /**
+     * True if a pinned snapshot still reads the todo as it is before the current change.
+     */
+    bool mustKeep(std::int64_t id) const;
+
+    /**
+     * Keeps the todo as it is before the current change.
+     */
+    void keep(std::int64_t id, std::optional<Todo> todo);
+
+    /**
+     * Logs that the todo changes at the current version, while a snapshot is pinned.
+     * Unlike the old versions, every change is logged, so the snapshots can tell what changed after any version.
+     */
+    void log(std::int64_t id);
+
+    /**
+     * Pins the current version until it is unpinned, returns that version.
+     */
+    std::uint64_t pin();
+    void unpin(std::uint64_t version);
+
+    /**
+     * The todo at the given version, nullptr if it did not change since then.
+     * Complexity O(1) plus the search among the old versions of the todo.
+     */
+    const OldVersion* find(std::int64_t id, std::uint64_t version) const;
+
+    /**
+     * Calls visit(id, todoAtVersion) once per todo changed after the given version,
+     * the todo being empty if it did not exist at that version. Complexity O(changes since the version).
+     */
+    template<typename Visit>
+    void forEachChangedSince(std::uint64_t version, Visit visit) const
+    {
+        const auto first{std::upper_bound(changes.begin(), changes.end(), version,
+                                          [](std::uint64_t version, const Change& change)
+                                          {
+                                              return version < change.version;
+                                          })};
+        for(auto it{first}; it not_eq changes.end(); ++it)
+        {
+            // the first change after the version is the one that kept the todo at that version
+            const auto oldVersion{find(it->id, version)};
+            if(oldVersion->version == it->version)
+            {
+                visit(it->id, oldVersion->todo);
+            }
+        }
+    }
+
+    /**
+     * Calls visit(id) for every change logged after the given version, once per change of the todo.
+     * Complexity O(changes since the version).
+     */
+    template<typename Visit>
+    void forEachChangeAfter(std::uint64_t version, Visit visit) const
+    {
+        const auto first{std::upper_bound(changeLog.begin(), changeLog.end(), version,
+                                          [](std::uint64_t version, const Change& change)
+                                          {
+                                              return version < change.version;
+                                          })};
+        for(auto it{first}; it not_eq changeLog.end(); ++it)
+        {
+            visit(it->id);
+        }
+    }
+
+    /**
+     * Number of old versions kept.
+     */
+    std::size_t size() const { return changes.size(); }
+
+private:
+    struct Change
+    {
+        std::uint64_t version;
+        std::int64_t id;
+    };
+
+    std::uint64_t currentVersion{0};
+    /**
+     * Number of snapshots pinned at every version.
+     */
+    std::map<std::uint64_t, std::size_t> pinnedVersions;
+    /**
+     * Old versions of every todo sorted by version, and every kept version in the order it was kept,
+     * so the oldest ones are discarded first, from the front of both.
+     */
+    FlatIdMap<std::deque<OldVersion>> oldVersions;
+    std::deque<Change> changes;
+    /**
+     * Every change made while a snapshot is pinned, discarded with the old versions.
+     */
+    std::deque<Change> changeLog;
+};
@@ -0,0 +1,387 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "WriteAheadLog.h"
+#include "ParentStore.h"
+
+namespace
+{
+    enum class RecordKind: std::uint8_t
+    {
+        changes,
+        batch
+    };
+
+    // payload size and checksum
+    constexpr std::size_t headerSize{2 * sizeof(std::uint32_t)};
+
+    std::uint32_t checksum(const char* data, std::size_t size)
+    {
+        // FNV-1a, enough to tell a torn or partially written record
+        std::uint32_t hash{2166136261u};
+        for(std::size_t i{0}; i < size; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    template<typename Value>
+    void put(std::string& record, Value value)
+    {
+        record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putString(std::string& record, const std::string& value)
+    {
+        put(record, static_cast<std::uint32_t>(value.size()));
+        record.append(value);
+    }
+
+    void putChange(std::string& record, const TodoChange& change)
+    {
+        put(record, static_cast<std::uint8_t>(change.kind));
+        put(record, change.id);
+        if(change.kind == TodoChange::Kind::remove)
+        {
+            return;
+        }
+        // only the properties present in the patch are written
+        const auto& patch{*change.patch};
+        put(record, patch.present);
+        if(patch.has(TodoPropertyId::title))
+        {
+            putString(record, patch.title);
+        }
+        if(patch.has(TodoPropertyId::description))
+        {
+            putString(record, patch.description);
+        }
+        if(patch.has(TodoPropertyId::timestamp))
+        {
+            put(record, patch.timestamp);
+        }
+    }
+
+    void beginRecord(std::string& record, RecordKind kind, std::size_t count)
+    {
+        record.assign(headerSize, '\0');
+        put(record, kind);
+        put(record, static_cast<std::uint32_t>(count));
+    }
+
+    /**
+     * Reads the values of a record, failing instead of reading past its end.
+     */
+    class RecordReader
+    {
+    public:
+        RecordReader(const char* data, std::size_t size): position{data}, end{data + size} {}
+
+        template<typename Value>
+        bool get(Value& value)
+        {
+            if(static_cast<std::size_t>(end - position) < sizeof(value))
+            {
+                return false;
+            }
+            std::memcpy(&value, position, sizeof(value));
+            position += sizeof(value);
+            return true;
+        }
+
+        bool getString(std::string& value)
+        {
+            std::uint32_t size;
+            if(not get(size) or static_cast<std::size_t>(end - position) < size)
+            {
+                return false;
+            }
+            value.assign(position, size);
+            position += size;
+            return true;
+        }
+
+        bool getChange(TodoChange& change, TodoPatch& patch)
+        {
+            std::uint8_t kind;
+            if(not get(kind) or kind > static_cast<std::uint8_t>(TodoChange::Kind::remove) or not get(change.id))
+            {
+                return false;
+            }
+            change.kind = static_cast<TodoChange::Kind>(kind);
+            change.patch = nullptr;
+            if(change.kind == TodoChange::Kind::remove)
+            {
+                return true;
+            }
+            change.patch = &patch;
+            return get(patch.present) and
+                   (not patch.has(TodoPropertyId::title) or getString(patch.title)) and
+                   (not patch.has(TodoPropertyId::description) or getString(patch.description)) and
+                   (not patch.has(TodoPropertyId::timestamp) or get(patch.timestamp));
+        }
+
+        bool atEnd() const { return position == end; }
+
+    private:
+        const char* position;
+        const char* end;
+    };
+
+    /**
+     * Applies the payload of a record to the store, false if it cannot be decoded.
+     */
+    bool replayRecord(const char* payload, std::size_t size, ParentStore& store)
+    {
+        RecordReader reader{payload, size};
+        RecordKind kind;
+        std::uint32_t count;
+        if(not reader.get(kind) or not reader.get(count))
+        {
+            return false;
+        }
+        if(kind == RecordKind::batch)
+        {
+            std::vector<Todo> todos(count);
+            for(auto& todo : todos)
+            {
+                if(not reader.get(todo.id) or not reader.getString(todo.title) or
+                   not reader.getString(todo.description) or not reader.get(todo.timestamp))
+                {
+                    return false;
+                }
+            }
+            if(not reader.atEnd())
+            {
+                return false;
+            }
+            store.insertBatch(todos);
+            return true;
+        }
+
+        // the patches are not moved once decoded, the changes point to them
+        std::vector<TodoPatch> patches(count);
+        std::vector<TodoChange> changes(count);
+        for(std::size_t i{0}; i < count; ++i)
+        {
+            if(not reader.getChange(changes[i], patches[i]))
+            {
+                return false;
+            }
+        }
+        if(not reader.atEnd())
+        {
+            return false;
+        }
+        store.commitChanges(changes);
+        return true;
+    }
+
+    std::system_error logError(int error, const std::string& what)
+    {
+        return std::system_error{error, std::generic_category(), what};
+    }
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path): WriteAheadLog{path, Options{}} {}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, Options options)
+        : file{::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)}, options{options}
+{
+    if(file < 0)
+    {
+        throw logError(errno, "Opening the write-ahead log "+path+" failed");
+    }
+    struct stat status{};
+    if(::fstat(file, &status) not_eq 0)
+    {
+        const auto error{errno};
+        ::close(file);
+        throw logError(error, "Opening the write-ahead log "+path+" failed");
+    }
+    fileSize = static_cast<std::uint64_t>(status.st_size);
+    if(options.sync == SyncPolicy::interval)
+    {
+        syncer = std::thread{[this] { syncInBackground(); }};
+    }
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    stopSyncing.notify_one();
+    if(syncer.joinable())
+    {
+        syncer.join();
+    }
+    if(unsynced)
+    {
+        ::fdatasync(file);
+    }
+    ::close(file);
+}
+
+void WriteAheadLog::append(const std::vector<TodoChange>& changes)
+{
+    std::lock_guard lock{mutex};
+    beginRecord(record, RecordKind::changes, changes.size());
+    for(const auto& change : changes)
+    {
+        putChange(record, change);
+    }
+    writeRecord();
+}
+
+void WriteAheadLog::append(const std::vector<const std::vector<TodoChange>*>& changeLists)
+{
+    std::size_t count{0};
+    for(const auto* changes : changeLists)
+    {
+        count += changes->size();
+    }
+    std::lock_guard lock{mutex};
+    beginRecord(record, RecordKind::changes, count);
+    for(const auto* changes : changeLists)
+    {
+        for(const auto& change : *changes)
+        {
+            putChange(record, change);
+        }
+    }
+    writeRecord();
+}
+
+void WriteAheadLog::append(const std::vector<Todo>& insertedTodos)
+{
+    std::lock_guard lock{mutex};
+    beginRecord(record, RecordKind::batch, insertedTodos.size());
+    for(const auto& todo : insertedTodos)
+    {
+        put(record, todo.id);
+        putString(record, todo.title);
+        putString(record, todo.description);
+        put(record, todo.timestamp);
+    }
+    writeRecord();
+}
+
+void WriteAheadLog::sync()
+{
+    std::lock_guard lock{mutex};
+    if(::fdatasync(file) not_eq 0)
+    {
+        throw logError(errno, "Syncing the write-ahead log failed");
+    }
+    unsynced = false;
+}
+
+std::uint64_t WriteAheadLog::size() const
+{
+    std::lock_guard lock{mutex};
+    return fileSize;
+}
+
+std::size_t WriteAheadLog::replay(const std::string& path, ParentStore& store)
+{
+    std::ifstream input{path, std::ios::binary};
+    if(not input)
+    {
+        return 0;
+    }
+    const std::string log{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+
+    std::size_t records{0};
+    std::size_t offset{0};
+    while(log.size() - offset >= headerSize)
+    {
+        std::uint32_t payloadSize;
+        std::uint32_t payloadChecksum;
+        std::memcpy(&payloadSize, log.data() + offset, sizeof(payloadSize));
+        std::memcpy(&payloadChecksum, log.data() + offset + sizeof(payloadSize), sizeof(payloadChecksum));
+        const auto* payload{log.data() + offset + headerSize};
+        if(log.size() - offset - headerSize < payloadSize or checksum(payload, payloadSize) not_eq payloadChecksum or
+           not replayRecord(payload, payloadSize, store))
+        {
+            break;
+        }
+        offset += headerSize + payloadSize;
+        ++records;
+    }
+    // the next records are appended right after the last complete one
+    if(offset < log.size() and ::truncate(path.c_str(), static_cast<off_t>(offset)) not_eq 0)
+    {
+        throw logError(errno, "Cutting off the torn record of the write-ahead log "+path+" failed");
+    }
+    return records;
+}
+
+void WriteAheadLog::writeRecord()
+{
+    if(const auto error{syncError.exchange(0)})
+    {
+        throw logError(error, "Syncing the write-ahead log failed");
+    }
+    const auto payloadSize{static_cast<std::uint32_t>(record.size() - headerSize)};
+    const auto payloadChecksum{checksum(record.data() + headerSize, payloadSize)};
+    std::memcpy(record.data(), &payloadSize, sizeof(payloadSize));
+    std::memcpy(record.data() + sizeof(payloadSize), &payloadChecksum, sizeof(payloadChecksum));
+
+    // a record left in the log without its change applied would be replayed, so failed records are cut off
+    const auto cutOff{[this](int error, const char* what)
+                      {
+                          [[maybe_unused]] const auto cut{::ftruncate(file, static_cast<off_t>(fileSize))};
+                          return logError(error, what);
+                      }};
+    const auto* data{record.data()};
+    auto remaining{record.size()};
+    while(remaining > 0)
+    {
+        const auto written{::write(file, data, remaining)};
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throw cutOff(errno, "Writing the write-ahead log failed");
+        }
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    if(options.sync == SyncPolicy::everyCommit and ::fdatasync(file) not_eq 0)
+    {
+        throw cutOff(errno, "Syncing the write-ahead log failed");
+    }
+    fileSize += record.size();
+    unsynced = options.sync == SyncPolicy::interval;
+}
+
+void WriteAheadLog::syncInBackground()
+{
+    std::unique_lock lock{mutex};
+    while(not stopping)
+    {
+        stopSyncing.wait_for(lock, options.interval, [this] { return stopping; });
+        if(not unsynced)
+        {
+            continue;
+        }
+        // the records written meanwhile are synced at once, appending does not wait for it
+        unsynced = false;
+        lock.unlock();
+        if(::fdatasync(file) not_eq 0)
+        {
+            syncError = errno;
+        }
+        lock.lock();
+    }
+}
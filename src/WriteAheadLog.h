@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Todo.h"
+#include "TodoPatch.h"
+
+class ParentStore;
+
+/**
+ * Responsibility: make the changes of a parent store durable, appending them to a file before they are applied.
+ *
+ * Every version of the store (a change, a batch insertion, the changes of one or many child commits) is one
+ * record: its size, a checksum and the changes in a compact binary form, in the byte order of the machine.
+ * The records are written to the file when the store changes, so a crash of the process loses nothing,
+ * and the sync policy tells when they reach the disk, what a crash of the machine can lose:
+ *  - everyCommit syncs every record before the change is applied, nothing is lost,
+ *  - interval syncs from a background thread every interval, once for all the records written meanwhile
+ *    (a group commit), the changes of the last interval can be lost,
+ *  - none leaves it to the operating system.
+ * Replaying the log stops at the first incomplete or corrupted record (a torn write) and cuts it off.
+ * Thread safe. Write and sync failures throw std::system_error, and the change is not applied.
+ */
+class WriteAheadLog
+{
+public:
+    enum class SyncPolicy
+    {
+        everyCommit,
+        interval,
+        none
+    };
+
+    struct Options
+    {
+        SyncPolicy sync{SyncPolicy::everyCommit};
+        std::chrono::milliseconds interval{10};
+    };
+
+    /**
+     * Opens the log to append records after the ones it has, creating it if it does not exist.
+     */
+    explicit WriteAheadLog(const std::string& path);
+    WriteAheadLog(const std::string& path, Options options);
+    /**
+     * The records written and not synced yet are synced.
+     */
+    ~WriteAheadLog();
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * Appends the changes as a single record, replayed as a single version.
+     */
+    void append(const std::vector<TodoChange>& changes);
+    void append(const std::vector<const std::vector<TodoChange>*>& changeLists);
+    /**
+     * Appends the insertion of a batch of todos.
+     */
+    void append(const std::vector<Todo>& insertedTodos);
+
+    /**
+     * Syncs the records written so far, whatever the policy.
+     */
+    void sync();
+
+    /**
+     * Bytes of the complete records in the log.
+     */
+    std::uint64_t size() const;
+
+    /**
+     * Applies every complete record of the log at the path to the store, in order, and cuts off the bytes
+     * after the last one. Returns the number of records replayed, 0 if the log does not exist.
+     */
+    static std::size_t replay(const std::string& path, ParentStore& store);
+
+private:
+    void writeRecord();
+    void syncInBackground();
+
+    int file;
+    Options options;
+    mutable std::mutex mutex;
+    // the record being encoded, kept to reuse its memory
+    std::string record;
+    std::uint64_t fileSize{0};
+    bool unsynced{false};
+    bool stopping{false};
+    // errno of the last background sync that failed, thrown by the next append
+    std::atomic<int> syncError{0};
+    std::condition_variable stopSyncing;
+    std::thread syncer;
+};
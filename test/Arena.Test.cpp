@@ -0,0 +1,118 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include "Arena.h"
+
+SCENARIO("Arena")
+{
+    GIVEN("An arena with small blocks")
+    {
+        Arena arena{256};
+
+        WHEN("Memory is allocated with different alignments")
+        {
+            auto* first{arena.allocate(3, 1)};
+            auto* second{arena.allocate(8, 8)};
+            auto* third{arena.allocate(64, 32)};
+
+            THEN("Every allocation is aligned and does not overlap the previous ones")
+            {
+                REQUIRE(reinterpret_cast<std::uintptr_t>(second) % 8 == 0);
+                REQUIRE(reinterpret_cast<std::uintptr_t>(third) % 32 == 0);
+                REQUIRE(static_cast<std::byte*>(second) >= static_cast<std::byte*>(first) + 3);
+                REQUIRE(static_cast<std::byte*>(third) >= static_cast<std::byte*>(second) + 8);
+                REQUIRE(arena.used() >= 75);
+                REQUIRE(arena.capacity() == 256);
+            }
+        }
+
+        WHEN("More memory than a block is allocated")
+        {
+            for(auto allocation{0}; allocation < 100; ++allocation)
+            {
+                arena.deallocate(arena.allocate(40, 8), 40, 8);
+            }
+            const auto capacity{arena.capacity()};
+
+            THEN("New blocks are added, deallocating does not give memory back")
+            {
+                REQUIRE(capacity >= 4000);
+                REQUIRE(arena.used() >= 4000);
+            }
+
+            AND_WHEN("The arena is reset and filled again")
+            {
+                arena.reset();
+                const auto* first{static_cast<std::byte*>(arena.allocate(40, 8))};
+                for(auto allocation{1}; allocation < 100; ++allocation)
+                {
+                    REQUIRE(arena.allocate(40, 8) not_eq nullptr);
+                }
+
+                THEN("The memory of the previous blocks is reused without adding blocks")
+                {
+                    REQUIRE(arena.capacity() == capacity);
+                    REQUIRE(static_cast<std::byte*>(arena.allocate(0, 1)) == first + 4000);
+                }
+            }
+        }
+    }
+
+    GIVEN("A pool of arenas")
+    {
+        const auto pool{std::make_shared<ArenaPool>()};
+
+        WHEN("An arena is released")
+        {
+            auto lease{pool->acquire()};
+            const auto* arena{lease.get()};
+            REQUIRE(lease->allocate(100, 8) not_eq nullptr);
+            lease.reset();
+
+            THEN("It is reset and given to the next one acquiring an arena")
+            {
+                REQUIRE(pool->pooledArenas() == 1);
+                const auto recycled{pool->acquire()};
+                REQUIRE(recycled.get() == arena);
+                REQUIRE(recycled->used() == 0);
+                REQUIRE(pool->pooledArenas() == 0);
+            }
+        }
+
+        WHEN("Several arenas are in use at the same time")
+        {
+            auto first{pool->acquire()};
+            auto second{pool->acquire()};
+
+            THEN("Each one gets its own arena")
+            {
+                REQUIRE(first.get() not_eq second.get());
+            }
+        }
+
+        WHEN("An arena grown over the maximum capacity is released")
+        {
+            auto lease{pool->acquire()};
+            REQUIRE(lease->allocate(ArenaPool::maxArenaCapacity + 1, 8) not_eq nullptr);
+            lease.reset();
+
+            THEN("It is freed instead of being kept")
+            {
+                REQUIRE(pool->pooledArenas() == 0);
+            }
+        }
+
+        WHEN("The pool is released while one of its arenas is in use")
+        {
+            auto otherPool{std::make_shared<ArenaPool>()};
+            auto lease{otherPool->acquire()};
+            otherPool.reset();
+
+            THEN("The arena keeps the pool alive until it is released")
+            {
+                REQUIRE(lease->allocate(8, 8) not_eq nullptr);
+                REQUIRE(lease.get_deleter().pool->pooledArenas() == 0);
+                lease.reset();
+            }
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 #include <Store.h>
 #include <ParentStore.h>
+#include <ChildStore.h>
 #include "TestUtils.h"
 
 using namespace std::string_literals;
@@ -29,6 +30,15 @@ SCENARIO("Child store")
                 REQUIRE(TestUtils::compareTodoProperties(retrievedProperties, firstTodoProperties));
             }
 
+            THEN("Getting a todo the parent does not have throws, like the parent")
+            {
+                constexpr auto id{1000};
+                REQUIRE_THROWS_AS(child->get(id), std::out_of_range);
+                Todo todo;
+                REQUIRE_THROWS_AS(child->get(id, todo), std::out_of_range);
+                REQUIRE_THROWS_AS(store->get(id), std::out_of_range);
+            }
+
             WHEN("Updating child properties")
             {
                 constexpr auto id{0};
@@ -89,6 +99,55 @@ SCENARIO("Child store")
                 }
             }
 
+            WHEN("Inserting a batch of child todos")
+            {
+                child->insertBatch({{222, "Clean the car"s, "before going to the wedding"s, 1100.0},
+                                    {223, "Buy Milk"s, "again"s, 1150.0}});
+
+                THEN("The todos are found in the child and not in the parent")
+                {
+                    REQUIRE(child->checkId(222));
+                    REQUIRE(child->queryCount({titleKey, "Buy Milk"s}) == 3);
+                    REQUIRE_FALSE(store->checkId(223));
+                }
+            }
+
+            WHEN("Getting many todos after changing them in the child")
+            {
+                child->insert(222, TestUtils::createProperties("Clean the car"s, "before the wedding"s, 1100.0));
+                child->update(1, {{titleKey, "Buy Cream"s}});
+                child->remove(2);
+                std::vector<std::optional<Todo>> todos;
+                child->getMany({222, 1, 2, 3}, todos);
+
+                THEN("The todos have the child changes")
+                {
+                    REQUIRE(todos[0]->title == "Clean the car"s);
+                    REQUIRE(todos[1]->title == "Buy Cream"s);
+                    REQUIRE(todos[1]->description == "don't forget!"s);
+                    REQUIRE_FALSE(todos[2]);
+                    REQUIRE(todos[3]->title == "Call mom"s);
+                }
+            }
+
+            WHEN("Changing child todos with typed patches")
+            {
+                child->insert(222, TodoPatch{}.setTitle("Clean the car"s).setDescription("soon"s).setTimestamp(1100.0));
+                child->update(222, TodoPatch{}.setDescription("before the wedding"s));
+                child->update(0, TodoPatch{}.setTimestamp(900.0));
+
+                THEN("The typed get returns the child version")
+                {
+                    Todo todo;
+                    child->get(222, todo);
+                    REQUIRE(todo.description == "before the wedding"s);
+                    child->get(0, todo);
+                    REQUIRE(todo.title == "Buy Milk"s);
+                    REQUIRE(todo.timestamp == 900.0);
+                    REQUIRE(child->rangeCount(0.0, 1000.0) == 2);
+                }
+            }
+
             WHEN("Removing todo from child")
             {
                 constexpr auto id{0};
@@ -113,8 +172,9 @@ SCENARIO("Child store")
                     child->commit();
                     THEN("Todo is removed from parent")
                     {
-                        const auto& retrievedProperties{child->get(id)};
-                        REQUIRE(retrievedProperties.empty());
+                        // the committed child reads the parent again, where the todo is missing
+                        REQUIRE_THROWS_AS(child->get(id), std::out_of_range);
+                        REQUIRE_FALSE(child->checkId(id));
                         REQUIRE_FALSE(store->checkId(id));
                     }
                 }
@@ -138,7 +198,7 @@ SCENARIO("Child store queries")
         THEN("A set of todo ids can be queried from the store")
         {
             TodoProperty queryProperty{titleKey, "Buy Milk"s};
-            auto ids{child->query(queryProperty)};
+            auto ids{TestUtils::collectIds(child->query(queryProperty))};
             std::unordered_set<std::int64_t> expectedIds{0, 1};
             REQUIRE(std::is_permutation(expectedIds.cbegin(), expectedIds.cend(), ids.cbegin()));
 
@@ -152,7 +212,7 @@ SCENARIO("Child store queries")
 
                 THEN("The new id is returned when querying")
                 {
-                    ids = child->query(queryProperty);
+                    ids = TestUtils::collectIds(child->query(queryProperty));
                     expectedIds = {0, 1, id};
                     REQUIRE(std::is_permutation(expectedIds.cbegin(), expectedIds.cend(), ids.cbegin()));
                 }
@@ -166,7 +226,7 @@ SCENARIO("Child store queries")
 
                 THEN("The query result do not include the updated todo id")
                 {
-                    ids = child->query(queryProperty);
+                    ids = TestUtils::collectIds(child->query(queryProperty));
                     expectedIds = {0};
                     REQUIRE(ids == expectedIds);
                 }
@@ -174,12 +234,41 @@ SCENARIO("Child store queries")
                 THEN("The updated todo can be retrieved when querying with the updated title")
                 {
                     queryProperty = {"title", "Buy Cereals"s};
-                    ids = child->query(queryProperty);
+                    ids = TestUtils::collectIds(child->query(queryProperty));
                     expectedIds = {1};
                     REQUIRE(ids == expectedIds);
                 }
             }
 
+            AND_WHEN("A todo title is updated twice")
+            {
+                constexpr auto idToUpdate{1};
+                child->update(idToUpdate, {{"title", "Buy Cereals"s}});
+                child->update(idToUpdate, {{"title", "Buy Milk"s}});
+
+                THEN("Only the last title is found when querying")
+                {
+                    ids = TestUtils::collectIds(child->query(queryProperty));
+                    expectedIds = {0, idToUpdate};
+                    REQUIRE(ids == expectedIds);
+                    REQUIRE(TestUtils::collectIds(child->query({titleKey, "Buy Cereals"s})).empty());
+                }
+            }
+
+            AND_WHEN("A todo inserted in the child is removed")
+            {
+                child->insert(newTodoId, newTodoProperties);
+                child->remove(newTodoId);
+
+                THEN("It is not found when querying")
+                {
+                    ids = TestUtils::collectIds(child->query(queryProperty));
+                    expectedIds = {0, 1};
+                    REQUIRE(ids == expectedIds);
+                    REQUIRE_FALSE(child->checkId(newTodoId));
+                }
+            }
+
             AND_WHEN("An id is removed")
             {
                 constexpr auto idToBeRemoved{1};
@@ -187,7 +276,7 @@ SCENARIO("Child store queries")
 
                 THEN("The query result do not include the updated todo id")
                 {
-                    ids = child->query(queryProperty);
+                    ids = TestUtils::collectIds(child->query(queryProperty));
                     expectedIds = {0};
                     REQUIRE(ids == expectedIds);
                 }
@@ -198,7 +287,7 @@ SCENARIO("Child store queries")
         {
             auto minTimeStamp{1000.0};
             auto maxTimeStamp{1300.0};
-            auto ids{child->rangeQuery(minTimeStamp, maxTimeStamp)};
+            auto ids{TestUtils::collectIds(child->rangeQuery(minTimeStamp, maxTimeStamp))};
             std::unordered_set<std::int64_t> expectedIds{2, 3};
             REQUIRE(std::is_permutation(expectedIds.cbegin(), expectedIds.cend(), ids.cbegin()));
 
@@ -209,7 +298,7 @@ SCENARIO("Child store queries")
                 THEN("It is included in the range query")
                 {
                     expectedIds = {2, 3, newTodoId};
-                    ids = child->rangeQuery(minTimeStamp, maxTimeStamp);
+                    ids = TestUtils::collectIds(child->rangeQuery(minTimeStamp, maxTimeStamp));
                     REQUIRE(std::is_permutation(expectedIds.cbegin(), expectedIds.cend(), ids.cbegin()));
                 }
             }
@@ -217,12 +306,12 @@ SCENARIO("Child store queries")
             AND_WHEN("A timestamp is updated")
             {
                 constexpr auto idToUpdate{3};
-                const TodoProperties propertiesToUpdate{{"timestamp", 1800}};
+                const TodoProperties propertiesToUpdate{{"timestamp", 1800.0}};
                 child->update(idToUpdate, propertiesToUpdate);
 
                 THEN("The query do not include the updated todo id")
                 {
-                    ids = child->rangeQuery(minTimeStamp, maxTimeStamp);
+                    ids = TestUtils::collectIds(child->rangeQuery(minTimeStamp, maxTimeStamp));
                     expectedIds = {2};
                     REQUIRE(ids == expectedIds);
                 }
@@ -231,7 +320,7 @@ SCENARIO("Child store queries")
                 {
                     minTimeStamp = 1500;
                     maxTimeStamp = 2000;
-                    ids = child->rangeQuery(minTimeStamp, maxTimeStamp);
+                    ids = TestUtils::collectIds(child->rangeQuery(minTimeStamp, maxTimeStamp));
                     expectedIds = {3};
                     REQUIRE(ids == expectedIds);
                 }
@@ -244,7 +333,7 @@ SCENARIO("Child store queries")
                 THEN("The range query does not include that id")
                 {
                     expectedIds = {3};
-                    ids = child->rangeQuery(minTimeStamp, maxTimeStamp);
+                    ids = TestUtils::collectIds(child->rangeQuery(minTimeStamp, maxTimeStamp));
                     REQUIRE(ids == expectedIds);
                 }
             }
@@ -280,10 +369,16 @@ SCENARIO("Multiple children")
             {
                 firstChild->commit();
 
-                THEN("The todo is present in both the parent and the second child")
+                THEN("The todo is present in the parent but not in the second child, created before the commit")
                 {
                     REQUIRE(store->checkId(newTodoId));
-                    REQUIRE(secondChild->checkId(newTodoId));
+                    REQUIRE_FALSE(secondChild->checkId(newTodoId));
+                    REQUIRE(secondChild->queryCount({titleKey, "Buy Milk"s}) == 2);
+                }
+
+                THEN("A child created after the commit has the todo")
+                {
+                    REQUIRE(store->createChild()->checkId(newTodoId));
                 }
             }
         }
@@ -303,9 +398,18 @@ SCENARIO("Multiple children")
                     REQUIRE(TestUtils::compareTodoProperties(retrievedProperties, propertiesToUpdateSecondChild));
                 }
 
-                AND_WHEN("Second child is committed")
+                THEN("The second child commit is rejected and the parent keeps the first child properties")
+                {
+                    REQUIRE_THROWS_AS(secondChild->commit(), CommitConflict);
+                    const auto& retrievedProperties{store->get(todoIdToUpdate)};
+                    REQUIRE(TestUtils::compareTodoProperties(retrievedProperties, propertiesToUpdateFirstChild));
+                }
+
+                AND_WHEN("The second child changes are retried in a new child")
                 {
-                    secondChild->commit();
+                    auto retriedChild{store->createChild()};
+                    retriedChild->update(todoIdToUpdate, propertiesToUpdateSecondChild);
+                    retriedChild->commit();
 
                     THEN("Parent properties match the ones updated by the second child")
                     {
@@ -317,3 +421,826 @@ SCENARIO("Multiple children")
         }
     }
 }
+
+SCENARIO("Child store counts")
+{
+    const TodoProperty queryProperty{titleKey, "Buy Milk"s};
+    constexpr auto minTimeStamp{1000.0};
+    constexpr auto maxTimeStamp{1300.0};
+
+    GIVEN("A child store with some todos inserted in the parent")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto child{store->createChild()};
+
+        THEN("The counts are the ones from the parent")
+        {
+            REQUIRE(child->queryCount(queryProperty) == 2);
+            REQUIRE(child->rangeCount(minTimeStamp, maxTimeStamp) == 2);
+        }
+
+        WHEN("Todos are inserted, updated and removed in the child")
+        {
+            child->insert(123, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 1150.0));
+            child->update(0, {{titleKey, "Buy Cereals"s}});
+            child->update(2, {{timestampKey, 1250.0}});
+            child->update(2, {{timestampKey, 5000.0}});
+            child->remove(3);
+            child->remove(1);
+            child->insert(1, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+
+            THEN("The counts match the number of ids returned by the queries")
+            {
+                REQUIRE(child->queryCount(queryProperty) == TestUtils::collectIds(child->query(queryProperty)).size());
+                REQUIRE(child->queryCount(queryProperty) == 2);
+                REQUIRE(child->rangeCount(minTimeStamp, maxTimeStamp) ==
+                        TestUtils::collectIds(child->rangeQuery(minTimeStamp, maxTimeStamp)).size());
+                REQUIRE(child->rangeCount(minTimeStamp, maxTimeStamp) == 2);
+            }
+
+            THEN("The parent counts do not change")
+            {
+                REQUIRE(store->queryCount(queryProperty) == 2);
+                REQUIRE(store->rangeCount(minTimeStamp, maxTimeStamp) == 2);
+            }
+
+            AND_WHEN("The child is committed")
+            {
+                const auto childTitleIds{TestUtils::collectIds(child->query(queryProperty))};
+                const auto childRangeIds{TestUtils::collectIds(child->rangeQuery(minTimeStamp, maxTimeStamp))};
+                child->commit();
+
+                THEN("The parent indexes have the child values")
+                {
+                    REQUIRE(TestUtils::collectIds(store->query(queryProperty)) == childTitleIds);
+                    REQUIRE(TestUtils::collectIds(store->rangeQuery(minTimeStamp, maxTimeStamp)) == childRangeIds);
+                    REQUIRE(store->queryCount(queryProperty) == 2);
+                    REQUIRE(store->rangeCount(minTimeStamp, maxTimeStamp) == 2);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Child store ordered range queries")
+{
+    GIVEN("A child store with some todos inserted in the parent")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto child{store->createChild()};
+
+        WHEN("Todos are inserted, updated and removed in the child")
+        {
+            child->insert(123, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 1100.0));
+            child->update(0, {{timestampKey, 900.0}});
+            child->remove(3);
+
+            THEN("The todos are returned by timestamp in pages")
+            {
+                auto page{child->rangeQueryOrdered(0.0, 3000000.0, 2, RangeCursor{})};
+                REQUIRE(page.todos == std::vector<TimestampTree::Entry>{{900.0, 0}, {1000.0, 2}});
+                REQUIRE(page.next);
+                page = child->rangeQueryOrdered(0.0, 3000000.0, 2, *page.next);
+                REQUIRE(page.todos == std::vector<TimestampTree::Entry>{{1100.0, 123}, {2400050.12555, 1}});
+                REQUIRE_FALSE(page.next);
+            }
+
+            THEN("The todos can be returned from the latest one")
+            {
+                const auto page{child->rangeQueryOrdered(0.0, 2000.0, 10, RangeCursor{RangeOrder::descending})};
+                REQUIRE(page.todos == std::vector<TimestampTree::Entry>{{1100.0, 123}, {1000.0, 2}, {900.0, 0}});
+                REQUIRE_FALSE(page.next);
+            }
+        }
+    }
+}
+
+SCENARIO("Nested child stores")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A child store with some changes and a child created from it")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        std::shared_ptr<Store> child{store->createChild()};
+        child->update(1, {{titleKey, "Buy Cereals"s}});
+        child->insert(123, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 1150.0));
+        auto nestedChild{child->createChild()};
+
+        THEN("The nested child has the changes of its parent child")
+        {
+            REQUIRE(std::get<std::string>(nestedChild->get(1).at(titleKey)) == "Buy Cereals");
+            REQUIRE(nestedChild->checkId(123));
+            REQUIRE(TestUtils::collectIds(nestedChild->query(milkProperty)) ==
+                    std::unordered_set<std::int64_t>{0, 123});
+            REQUIRE(nestedChild->rangeCount(1000.0, 1300.0) == 3);
+            // the overlay is still shared, so both children see the parent values looked up by the nested one
+            REQUIRE(TestUtils::collectIds(child->query(milkProperty)) == std::unordered_set<std::int64_t>{0, 123});
+        }
+
+        WHEN("Todos are changed in the nested child")
+        {
+            nestedChild->update(0, {{titleKey, "Buy Cream"s}});
+            nestedChild->update(123, {{timestampKey, 5000.0}});
+            nestedChild->remove(2);
+
+            THEN("The changes are only found in the nested child")
+            {
+                REQUIRE(TestUtils::collectIds(nestedChild->query(milkProperty)) ==
+                        std::unordered_set<std::int64_t>{123});
+                REQUIRE(TestUtils::collectIds(child->query(milkProperty)) ==
+                        std::unordered_set<std::int64_t>{0, 123});
+                REQUIRE(TestUtils::collectIds(nestedChild->rangeQuery(1000.0, 1300.0)) ==
+                        std::unordered_set<std::int64_t>{3});
+                REQUIRE_FALSE(nestedChild->checkId(2));
+                REQUIRE(child->checkId(2));
+            }
+
+            AND_WHEN("The nested child is committed")
+            {
+                nestedChild->commit();
+
+                THEN("Its changes are found in the parent child but not in the store")
+                {
+                    REQUIRE(TestUtils::collectIds(child->query(milkProperty)) == std::unordered_set<std::int64_t>{123});
+                    REQUIRE_FALSE(child->checkId(2));
+                    REQUIRE(store->checkId(2));
+                    REQUIRE_FALSE(store->checkId(123));
+                }
+
+                AND_WHEN("The parent child is committed")
+                {
+                    child->commit();
+
+                    THEN("The changes of both children are found in the store")
+                    {
+                        REQUIRE(TestUtils::collectIds(store->query(milkProperty)) ==
+                                std::unordered_set<std::int64_t>{123});
+                        REQUIRE(std::get<std::string>(store->get(1).at(titleKey)) == "Buy Cereals");
+                        REQUIRE(std::get<double>(store->get(123).at(timestampKey)) == 5000.0);
+                        REQUIRE_FALSE(store->checkId(2));
+                    }
+                }
+            }
+        }
+
+        WHEN("Both children change todos before the nested child is committed")
+        {
+            nestedChild->update(0, {{titleKey, "Buy Cream"s}});
+            child->update(3, {{titleKey, "Buy Milk"s}});
+            child->remove(123);
+            nestedChild->commit();
+
+            THEN("The parent child keeps its own changes and gets the ones of the nested child")
+            {
+                REQUIRE(TestUtils::collectIds(child->query(milkProperty)) == std::unordered_set<std::int64_t>{3});
+                REQUIRE(std::get<std::string>(child->get(0).at(titleKey)) == "Buy Cream");
+                REQUIRE(std::get<std::string>(child->get(1).at(titleKey)) == "Buy Cereals");
+                REQUIRE_FALSE(child->checkId(123));
+            }
+        }
+    }
+
+    GIVEN("A child store and a nested child created from it")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto child{store->acquireChild()};
+        child->update(1, {{titleKey, "Buy Cereals"s}});
+        auto nestedChild{std::make_shared<ChildStore>(child)};
+
+        WHEN("Both children update the same todo and the nested child commits")
+        {
+            child->update(0, {{descriptionKey, "from the parent child"s}});
+            nestedChild->update(0, {{descriptionKey, "from the nested child"s}});
+
+            THEN("The nested commit conflicts and the parent child keeps its value")
+            {
+                REQUIRE_THROWS_AS(nestedChild->commit(), CommitConflict);
+                REQUIRE(std::get<std::string>(child->get(0).at(descriptionKey)) == "from the parent child");
+            }
+        }
+
+        WHEN("The parent child changes a todo, a title and a range the nested child read")
+        {
+            nestedChild->get(2);
+            nestedChild->queryCount({titleKey, "Call mom"s});
+            nestedChild->rangeCount(2000000.0, 2392349.0);
+            nestedChild->update(3, {{descriptionKey, "later"s}});
+            const auto changeParentChild{GENERATE(0, 1, 2)};
+            if(changeParentChild == 0)
+            {
+                child->update(2, {{descriptionKey, "changed"s}});
+            } else if(changeParentChild == 1)
+            {
+                child->insert(10, TestUtils::createProperties("Call mom"s, "again"s, 10.0));
+            } else
+            {
+                child->remove(0);
+            }
+
+            THEN("The nested commit conflicts")
+            {
+                REQUIRE_THROWS_AS(nestedChild->commit(), CommitConflict);
+                REQUIRE(std::get<std::string>(child->get(3).at(descriptionKey)) == "is her birthday");
+            }
+        }
+
+        WHEN("The parent child changes other todos before the nested child commits")
+        {
+            nestedChild->get(2);
+            nestedChild->update(3, {{descriptionKey, "later"s}});
+            child->update(0, {{descriptionKey, "changed"s}});
+            child->update(1, {{titleKey, "Buy Cereals"s}});
+            nestedChild->commit();
+
+            THEN("Both changes are kept")
+            {
+                REQUIRE(std::get<std::string>(child->get(0).at(descriptionKey)) == "changed");
+                REQUIRE(std::get<std::string>(child->get(3).at(descriptionKey)) == "later");
+            }
+        }
+
+        WHEN("The parent child commits a todo into the store before the nested child changes it")
+        {
+            child->update(0, {{descriptionKey, "committed"s}});
+            child->commit();
+            nestedChild->update(0, {{descriptionKey, "stale"s}});
+
+            THEN("The nested commit conflicts")
+            {
+                REQUIRE_THROWS_AS(nestedChild->commit(), CommitConflict);
+                REQUIRE(std::get<std::string>(child->get(0).at(descriptionKey)) == "committed");
+            }
+
+            AND_WHEN("The nested child is rolled back")
+            {
+                nestedChild->rollback();
+
+                THEN("It reads its parent child again, with what it committed")
+                {
+                    REQUIRE(std::get<std::string>(nestedChild->get(0).at(descriptionKey)) == "committed");
+                    REQUIRE(std::get<std::string>(nestedChild->get(1).at(titleKey)) == "Buy Cereals");
+                }
+            }
+        }
+
+        WHEN("The parent child commits and the nested child commits other todos")
+        {
+            child->insert(10, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+            child->commit();
+            nestedChild->update(3, {{descriptionKey, "later"s}});
+            nestedChild->commit();
+
+            THEN("The nested child reads its parent child with the todos committed meanwhile")
+            {
+                REQUIRE(nestedChild->checkId(10));
+                REQUIRE(std::get<std::string>(nestedChild->get(3).at(descriptionKey)) == "later");
+                child->commit();
+                REQUIRE(std::get<std::string>(store->get(3).at(descriptionKey)) == "later");
+                REQUIRE(store->checkId(10));
+            }
+        }
+    }
+
+    GIVEN("Five levels of nested children, each one updating a different todo")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        std::vector<std::shared_ptr<Store>> children{store->createChild()};
+        for(auto level{1}; level < 5; ++level)
+        {
+            children.back()->update(level % 4, {{timestampKey, 100.0 * level}});
+            children.push_back(children.back()->createChild());
+        }
+        children.back()->insert(5, TestUtils::createProperties("Buy Milk"s, "deepest"s, 500.0));
+
+        THEN("The deepest child has the changes of every level")
+        {
+            REQUIRE(children.back()->rangeCount(0.0, 500.0) == 5);
+            REQUIRE(children.front()->rangeCount(0.0, 500.0) == 1);
+            REQUIRE(TestUtils::collectIds(children.back()->query(milkProperty)) ==
+                    std::unordered_set<std::int64_t>{0, 1, 5});
+        }
+
+        WHEN("Every level is committed from the deepest one")
+        {
+            for(auto it{children.rbegin()}; it not_eq children.rend(); ++it)
+            {
+                (*it)->commit();
+            }
+
+            THEN("The store has the changes of every level")
+            {
+                REQUIRE(store->rangeCount(0.0, 500.0) == 5);
+                REQUIRE(store->checkId(5));
+            }
+        }
+    }
+}
+
+SCENARIO("Child store commit conflicts")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("Two children of a store with some todos")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto child{store->createChild()};
+        auto otherChild{store->createChild()};
+
+        WHEN("The children change different todos")
+        {
+            child->update(0, {{descriptionKey, "of oats"s}});
+            otherChild->update(2, {{descriptionKey, "mandarin"s}});
+
+            THEN("Both can commit")
+            {
+                otherChild->commit();
+                child->commit();
+                REQUIRE(std::get<std::string>(store->get(0).at(descriptionKey)) == "of oats");
+                REQUIRE(std::get<std::string>(store->get(2).at(descriptionKey)) == "mandarin");
+            }
+        }
+
+        WHEN("A child updates a todo that does not exist in the parent")
+        {
+            child->update(0, {{descriptionKey, "of oats"s}});
+            child->update(123, {{descriptionKey, "of oats"s}});
+
+            THEN("Nothing is committed and the child still reads its changes")
+            {
+                const auto version{store->version()};
+                REQUIRE_THROWS_AS(child->commit(), std::invalid_argument);
+                REQUIRE(store->version() == version);
+                REQUIRE(std::get<std::string>(store->get(0).at(descriptionKey)) == "make of almonds!");
+                REQUIRE(std::get<std::string>(child->get(0).at(descriptionKey)) == "of oats");
+            }
+        }
+
+        WHEN("A child reads a todo that another child changes and commits")
+        {
+            Todo todo;
+            child->get(3, todo);
+            child->update(0, {{descriptionKey, "of oats"s}});
+            otherChild->update(3, {{timestampKey, 1300.0}});
+            otherChild->commit();
+
+            THEN("The commit of the child is rejected and nothing is committed")
+            {
+                REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+                REQUIRE(std::get<std::string>(store->get(0).at(descriptionKey)) == "make of almonds!");
+            }
+        }
+
+        WHEN("A child queries a title and another child commits a todo with that title")
+        {
+            child->query(milkProperty);
+            child->insert(123, TestUtils::createProperties("Call dad"s, "is his birthday"s, 1300.0));
+            otherChild->insert(124, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 1100.0));
+            otherChild->commit();
+
+            THEN("The commit of the child is rejected")
+            {
+                REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+                REQUIRE_FALSE(store->checkId(123));
+            }
+        }
+
+        WHEN("A child queries a title and another child only changes the description of a todo with that title")
+        {
+            child->queryCount(milkProperty);
+            child->insert(123, TestUtils::createProperties("Call dad"s, "is his birthday"s, 1300.0));
+            otherChild->update(1, {{descriptionKey, "of oats"s}});
+            otherChild->commit();
+
+            THEN("The child can commit, the query result did not change")
+            {
+                child->commit();
+                REQUIRE(store->checkId(123));
+            }
+        }
+
+        WHEN("A child queries a timestamp range and another child commits a todo inside and outside of it")
+        {
+            child->rangeCount(1000.0, 1300.0);
+            child->insert(123, TestUtils::createProperties("Call dad"s, "is his birthday"s, 5000.0));
+
+            AND_WHEN("The todo is inside the range")
+            {
+                otherChild->update(0, {{timestampKey, 1100.0}});
+                otherChild->commit();
+
+                THEN("The commit of the child is rejected")
+                {
+                    REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+                }
+            }
+
+            AND_WHEN("The todo is outside the range")
+            {
+                otherChild->update(0, {{timestampKey, 2000.0}});
+                otherChild->commit();
+
+                THEN("The child can commit")
+                {
+                    child->commit();
+                    REQUIRE(store->checkId(123));
+                }
+            }
+        }
+
+        WHEN("A child commits")
+        {
+            child->update(0, {{titleKey, "Buy Cereals"s}});
+            child->commit();
+
+            THEN("It reads the committed parent and can commit again")
+            {
+                REQUIRE(TestUtils::collectIds(child->query(milkProperty)) == std::unordered_set<std::int64_t>{1});
+                child->update(0, {{titleKey, "Buy Cream"s}});
+                child->commit();
+                REQUIRE(std::get<std::string>(store->get(0).at(titleKey)) == "Buy Cream");
+            }
+        }
+    }
+}
+
+SCENARIO("Committing a child that changes many todos")
+{
+    GIVEN("A parent store with many todos and a child changing most of them")
+    {
+        auto store{std::make_shared<ParentStore>()};
+        for(std::int64_t id{0}; id < 1000; ++id)
+        {
+            store->insert(id, TestUtils::createProperties("Title "s+std::to_string(id % 10), "description"s,
+                                                          double(id)));
+        }
+        auto child{store->createChild()};
+        for(std::int64_t id{0}; id < 1000; id += 2)
+        {
+            child->update(id, {{titleKey, "Title "s+std::to_string(id % 7)}, {timestampKey, double(id) + 0.5}});
+        }
+        for(std::int64_t id{1}; id < 1000; id += 6)
+        {
+            child->remove(id);
+        }
+        for(std::int64_t id{1000}; id < 1200; ++id)
+        {
+            child->insert(id, TestUtils::createProperties("Title 3"s, "description"s, double(id)));
+        }
+
+        THEN("The counts of small and large results match the queries, whatever parent values are hidden")
+        {
+            for(auto title{0}; title < 10; ++title)
+            {
+                const TodoProperty titleProperty{titleKey, "Title "s+std::to_string(title)};
+                REQUIRE(child->queryCount(titleProperty) == TestUtils::collectIds(child->query(titleProperty)).size());
+            }
+            REQUIRE(child->rangeCount(300.0, 320.0) == TestUtils::collectIds(child->rangeQuery(300.0, 320.0)).size());
+            REQUIRE(child->rangeCount(300.0, 320.0) == 16);
+            REQUIRE(child->rangeCount(0.0, 1200.0) == TestUtils::collectIds(child->rangeQuery(0.0, 1200.0)).size());
+            REQUIRE(child->rangeCount(0.0, 1200.0) == 1033);
+            REQUIRE(child->rangeCount(300.0, 320.0) == 16);
+        }
+
+        WHEN("The child is committed")
+        {
+            std::vector<std::unordered_set<std::int64_t>> childTitleIds;
+            for(auto title{0}; title < 10; ++title)
+            {
+                const TodoProperty titleProperty{titleKey, "Title "s+std::to_string(title)};
+                childTitleIds.push_back(TestUtils::collectIds(child->query(titleProperty)));
+            }
+            const auto childRangeIds{TestUtils::collectIds(child->rangeQuery(100.0, 1100.0))};
+            child->commit();
+
+            THEN("The parent queries return the same ids than the child queries before committing")
+            {
+                for(auto title{0}; title < 10; ++title)
+                {
+                    const TodoProperty titleProperty{titleKey, "Title "s+std::to_string(title)};
+                    REQUIRE(TestUtils::collectIds(store->query(titleProperty)) == childTitleIds[title]);
+                    REQUIRE(store->queryCount(titleProperty) == childTitleIds[title].size());
+                }
+                REQUIRE(TestUtils::collectIds(store->rangeQuery(100.0, 1100.0)) == childRangeIds);
+                REQUIRE(store->rangeCount(100.0, 1100.0) == childRangeIds.size());
+            }
+        }
+    }
+}
+
+SCENARIO("Rolling back a child store")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A child that changed and read some todos of its parent")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        const std::shared_ptr<Store> child{store->createChild()};
+        child->update(0, {{titleKey, "Buy Cream"s}});
+        child->remove(1);
+        child->insert(10, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+        child->get(2);
+
+        WHEN("The child is rolled back")
+        {
+            child->rollback();
+
+            THEN("It reads the parent as it is")
+            {
+                REQUIRE(std::get<std::string>(child->get(0).at(titleKey)) == "Buy Milk");
+                REQUIRE(child->checkId(1));
+                REQUIRE_FALSE(child->checkId(10));
+                REQUIRE(TestUtils::collectIds(child->query(milkProperty)) ==
+                        TestUtils::collectIds(store->query(milkProperty)));
+                REQUIRE(child->queryCount(milkProperty) == 2);
+                REQUIRE(child->rangeCount(1000.0, 1300.0) == 2);
+            }
+
+            THEN("Committing it does not change the parent")
+            {
+                child->commit();
+                REQUIRE(std::get<std::string>(store->get(0).at(titleKey)) == "Buy Milk");
+                REQUIRE(store->checkId(1));
+                REQUIRE_FALSE(store->checkId(10));
+            }
+
+            AND_WHEN("It changes todos again")
+            {
+                child->update(3, {{titleKey, "Buy Milk"s}});
+                child->remove(0);
+
+                THEN("Only the new changes are committed")
+                {
+                    child->commit();
+                    REQUIRE(store->queryCount(milkProperty) == 2);
+                    REQUIRE_FALSE(store->checkId(0));
+                    REQUIRE(store->checkId(1));
+                    REQUIRE_FALSE(store->checkId(10));
+                }
+            }
+        }
+
+        WHEN("Another child commits the todo it read and then the child is rolled back")
+        {
+            auto otherChild{store->createChild()};
+            otherChild->update(2, {{descriptionKey, "changed"s}});
+            otherChild->commit();
+            child->rollback();
+
+            THEN("It reads the latest version of the parent, and the discarded reads do not conflict")
+            {
+                REQUIRE(std::get<std::string>(child->get(2).at(descriptionKey)) == "changed");
+                child->update(3, {{descriptionKey, "later"s}});
+                REQUIRE_NOTHROW(child->commit());
+                REQUIRE(std::get<std::string>(store->get(3).at(descriptionKey)) == "later");
+            }
+        }
+
+        WHEN("A nested child changes todos and is rolled back")
+        {
+            const std::shared_ptr<Store> nestedChild{child->createChild()};
+            nestedChild->remove(2);
+            nestedChild->update(3, {{titleKey, "Buy Milk"s}});
+            nestedChild->rollback();
+
+            THEN("It reads its parent child again, with the changes of the parent child")
+            {
+                REQUIRE(nestedChild->checkId(2));
+                REQUIRE_FALSE(nestedChild->checkId(1));
+                REQUIRE(nestedChild->queryCount(milkProperty) == 1);
+                nestedChild->commit();
+                REQUIRE(child->checkId(2));
+                REQUIRE(std::get<std::string>(child->get(3).at(titleKey)) == "Call mom");
+            }
+        }
+    }
+}
+
+SCENARIO("Children pooled by the parent store")
+{
+    GIVEN("A child taken from the pool of a store")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto child{store->acquireChild()};
+        const auto* firstChild{child.get()};
+        child->update(0, {{titleKey, "Buy Cream"s}});
+        child->insert(10, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+
+        WHEN("It is released without committing and another child is taken")
+        {
+            child.reset();
+            store->update(1, {{descriptionKey, "changed"s}});
+            auto reusedChild{store->acquireChild()};
+
+            THEN("The same child is reused, without its changes and reading the latest version of the store")
+            {
+                REQUIRE(reusedChild.get() == firstChild);
+                REQUIRE(std::get<std::string>(reusedChild->get(0).at(titleKey)) == "Buy Milk");
+                REQUIRE_FALSE(reusedChild->checkId(10));
+                REQUIRE(std::get<std::string>(reusedChild->get(1).at(descriptionKey)) == "changed");
+                reusedChild->remove(3);
+                reusedChild->commit();
+                REQUIRE_FALSE(store->checkId(3));
+                REQUIRE(std::get<std::string>(store->get(0).at(titleKey)) == "Buy Milk");
+            }
+
+            THEN("Other children taken meanwhile are new ones")
+            {
+                auto otherChild{store->acquireChild()};
+                REQUIRE(otherChild.get() not_eq reusedChild.get());
+            }
+        }
+
+        WHEN("It is committed and released")
+        {
+            child->commit();
+            child.reset();
+
+            THEN("The idle child does not keep the store alive")
+            {
+                const std::weak_ptr<ParentStore> releasedStore{store};
+                store.reset();
+                REQUIRE(releasedStore.expired());
+            }
+        }
+    }
+
+    GIVEN("A pool with an idle child and a child in use")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto pool{std::make_shared<ChildPool>()};
+        auto idleChild{pool->acquire(store)};
+        auto usedChild{pool->acquire(store)};
+        idleChild.reset();
+        REQUIRE(pool->pooledChildren() == 1);
+
+        WHEN("The pool is dropped")
+        {
+            const std::weak_ptr<ChildPool> droppedPool{pool};
+            pool.reset();
+
+            THEN("It is destroyed with its idle child, and the child in use is freed once released")
+            {
+                REQUIRE(droppedPool.expired());
+                usedChild->remove(3);
+                usedChild->commit();
+                usedChild.reset();
+                REQUIRE_FALSE(store->checkId(3));
+            }
+        }
+    }
+}
+
+SCENARIO("Child store savepoints")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+    const TodoProperty creamProperty{titleKey, "Buy Cream"s};
+
+    GIVEN("A child that changed a todo, took a savepoint and changed more todos after it")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto child{store->acquireChild()};
+        child->update(0, {{titleKey, "Buy Cream"s}});
+        REQUIRE(child->queryCount(milkProperty) == 1);
+        const auto savepoint{child->savepoint()};
+        child->remove(1);
+        child->update(2, {{titleKey, "Buy Milk"s}});
+        child->insert(10, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+        child->update(0, {{titleKey, "Buy Tea"s}});
+        REQUIRE(child->queryCount(milkProperty) == 2);
+        REQUIRE(child->rangeCount(1000.0, 1300.0) == 3);
+
+        WHEN("The child is rolled back to the savepoint")
+        {
+            child->rollbackTo(savepoint);
+
+            THEN("It reads the todos as they were when the savepoint was taken")
+            {
+                REQUIRE(std::get<std::string>(child->get(0).at(titleKey)) == "Buy Cream");
+                REQUIRE(child->checkId(1));
+                REQUIRE_FALSE(child->checkId(10));
+                REQUIRE(TestUtils::collectIds(child->query(milkProperty)) == std::unordered_set<std::int64_t>{1});
+                REQUIRE(TestUtils::collectIds(child->query(creamProperty)) == std::unordered_set<std::int64_t>{0});
+                REQUIRE(child->queryCount(milkProperty) == 1);
+                REQUIRE(TestUtils::collectIds(child->rangeQuery(1000.0, 1300.0)) ==
+                        std::unordered_set<std::int64_t>{2, 3});
+                REQUIRE(child->rangeCount(1000.0, 1300.0) == 2);
+            }
+
+            THEN("Committing it commits only the changes done before the savepoint")
+            {
+                child->commit();
+                REQUIRE(std::get<std::string>(store->get(0).at(titleKey)) == "Buy Cream");
+                REQUIRE(store->checkId(1));
+                REQUIRE_FALSE(store->checkId(10));
+                REQUIRE(store->queryCount(milkProperty) == 1);
+            }
+
+            AND_WHEN("It changes todos again and is rolled back to the same savepoint")
+            {
+                child->remove(3);
+                child->update(0, {{titleKey, "Buy Milk"s}});
+                child->rollbackTo(savepoint);
+
+                THEN("The new changes are undone too")
+                {
+                    REQUIRE(child->checkId(3));
+                    REQUIRE(std::get<std::string>(child->get(0).at(titleKey)) == "Buy Cream");
+                    REQUIRE(child->queryCount(milkProperty) == 1);
+                }
+            }
+        }
+
+        WHEN("A later savepoint is taken and the child is rolled back to the first one")
+        {
+            const auto laterSavepoint{child->savepoint()};
+            child->remove(3);
+            child->rollbackTo(savepoint);
+
+            THEN("The changes after both are undone and the later savepoint is released")
+            {
+                REQUIRE(child->checkId(3));
+                REQUIRE(child->checkId(1));
+                REQUIRE_THROWS_AS(child->rollbackTo(laterSavepoint), std::invalid_argument);
+            }
+        }
+
+        WHEN("A later savepoint is taken and the child is rolled back to it")
+        {
+            const auto laterSavepoint{child->savepoint()};
+            child->remove(3);
+            child->update(2, {{titleKey, "Call mom"s}});
+            child->rollbackTo(laterSavepoint);
+
+            THEN("Only the changes after the later savepoint are undone")
+            {
+                REQUIRE(child->checkId(3));
+                REQUIRE_FALSE(child->checkId(1));
+                REQUIRE(std::get<std::string>(child->get(2).at(titleKey)) == "Buy Milk");
+                REQUIRE(child->queryCount(milkProperty) == 2);
+                REQUIRE(child->queryCount({titleKey, "Call mom"s}) == 1);
+            }
+        }
+
+        WHEN("The child commits")
+        {
+            child->commit();
+
+            THEN("Its savepoints are released")
+            {
+                REQUIRE_THROWS_AS(child->rollbackTo(savepoint), std::invalid_argument);
+                REQUIRE_FALSE(store->checkId(1));
+            }
+        }
+
+        WHEN("A nested child takes a savepoint, changes todos and is rolled back to it")
+        {
+            auto nestedChild{std::make_shared<ChildStore>(child)};
+            nestedChild->update(3, {{titleKey, "Buy Milk"s}});
+            const auto nestedSavepoint{nestedChild->savepoint()};
+            nestedChild->remove(2);
+            nestedChild->update(3, {{titleKey, "Buy Cream"s}});
+            nestedChild->rollbackTo(nestedSavepoint);
+
+            THEN("It reads its changes before the savepoint, and its parent child is not changed")
+            {
+                REQUIRE(nestedChild->checkId(2));
+                REQUIRE(nestedChild->queryCount(milkProperty) == 3);
+                REQUIRE(child->queryCount(milkProperty) == 2);
+                nestedChild->commit();
+                REQUIRE(child->queryCount(milkProperty) == 3);
+                REQUIRE(child->checkId(2));
+            }
+        }
+    }
+
+    GIVEN("A child that looked the parent values of a todo it changed up, and took a savepoint")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        auto child{store->acquireChild()};
+        const auto savepoint{child->savepoint()};
+        child->update(3, TodoPatch{}.setTitle("Buy Bread"s).setTimestamp(1250.0));
+        // the counts over the whole store look the hidden parent values up
+        REQUIRE(child->rangeCount(0.0, 3000000.0) == 4);
+        REQUIRE(child->queryCount({titleKey, "Call mom"s}) == 0);
+        child->savepoint();
+
+        WHEN("The todo is changed again and the child is rolled back to the first savepoint")
+        {
+            child->update(3, TodoPatch{}.setTitle("Buy Tea"s).setTimestamp(1150.0));
+            child->rollbackTo(savepoint);
+
+            THEN("The parent values are found again, in the child and in the parent once committed")
+            {
+                REQUIRE(child->rangeCount(1100.0, 1300.0) == 1);
+                REQUIRE(child->queryCount({titleKey, "Call mom"s}) == 1);
+                child->commit();
+                REQUIRE(std::get<double>(store->get(3).at(timestampKey)) == 1200.0);
+                REQUIRE(store->rangeCount(1100.0, 1300.0) == 1);
+                REQUIRE(TestUtils::collectIds(store->rangeQuery(1100.0, 1300.0)) ==
+                        std::unordered_set<std::int64_t>{3});
+                REQUIRE(store->queryCount({titleKey, "Call mom"s}) == 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,219 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include <ConcurrentChildStore.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+    std::shared_ptr<ConcurrentParentStore> createDummyConcurrentStore()
+    {
+        auto store{std::make_shared<ConcurrentParentStore>()};
+        store->insert(0, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 2392348.12233));
+        store->insert(1, TestUtils::createProperties("Buy Milk"s, "don't forget!"s, 2400050.12555));
+        store->insert(2, TestUtils::createProperties("Study Chinese"s, "worth it!"s, 1000.0));
+        store->insert(3, TestUtils::createProperties("Call mom"s, "is her birthday"s, 1200.0));
+        return store;
+    }
+
+    Todo getTodo(const Store& store, std::int64_t id)
+    {
+        Todo todo;
+        store.get(id, todo);
+        return todo;
+    }
+}
+
+SCENARIO("Concurrent child store")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A concurrent store with some todos and a child changing some of them")
+    {
+        auto store{createDummyConcurrentStore()};
+        const std::shared_ptr<Store> child{store->createChild()};
+        child->update(0, {{titleKey, "Buy Cream"s}});
+        child->remove(1);
+        child->insert(10, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+
+        THEN("The child reads its changes and the store does not")
+        {
+            REQUIRE(getTodo(*child, 0).title == "Buy Cream");
+            REQUIRE_FALSE(child->checkId(1));
+            REQUIRE_THROWS_AS(child->get(1), std::out_of_range);
+            REQUIRE(TestUtils::collectIds(child->query(milkProperty)) == std::unordered_set<std::int64_t>{10});
+            REQUIRE(child->rangeCount(1000.0, 1300.0) == 3);
+            REQUIRE(child->rangeQueryOrdered(0.0, 3000000.0, 2, RangeCursor{RangeOrder::descending}).todos ==
+                    std::vector<TimestampTree::Entry>{{2392348.12233, 0}, {1200.0, 3}});
+            REQUIRE(getTodo(*store, 0).title == "Buy Milk");
+            REQUIRE(store->checkId(1));
+            REQUIRE(store->queryCount(milkProperty) == 2);
+            REQUIRE(store->rangeCount(1000.0, 1300.0) == 2);
+        }
+
+        THEN("Todos that do not exist in the child cannot be updated nor removed")
+        {
+            REQUIRE_THROWS_AS(child->update(1, {{titleKey, "Buy Cream"s}}), std::invalid_argument);
+            REQUIRE_THROWS_AS(child->remove(1), std::invalid_argument);
+            REQUIRE_THROWS_AS(child->remove(100), std::invalid_argument);
+        }
+
+        WHEN("The child is committed")
+        {
+            child->commit();
+
+            THEN("The store reads the changes and its indexes are updated")
+            {
+                REQUIRE(getTodo(*store, 0).title == "Buy Cream");
+                REQUIRE_FALSE(store->checkId(1));
+                REQUIRE(TestUtils::collectIds(store->query(milkProperty)) == std::unordered_set<std::int64_t>{10});
+                REQUIRE(store->rangeCount(1000.0, 1300.0) == 3);
+            }
+
+            THEN("The child reads the store again and can commit again")
+            {
+                REQUIRE(child->checkId(10));
+                child->remove(10);
+                child->commit();
+                REQUIRE(store->queryCount(milkProperty) == 0);
+            }
+        }
+
+        WHEN("The store changes todos the child did not read before it commits")
+        {
+            store->update(2, TodoPatch{}.setDescription("changed"s));
+            store->insert(20, TodoPatch{}.setTitle("Buy Bread"s).setDescription(""s).setTimestamp(5.0));
+            child->commit();
+
+            THEN("The changes of both are kept")
+            {
+                REQUIRE(getTodo(*store, 0).title == "Buy Cream");
+                REQUIRE(getTodo(*store, 2).description == "changed");
+                REQUIRE(store->checkId(20));
+            }
+        }
+
+        WHEN("The store changes a todo the child read before it commits")
+        {
+            child->get(3);
+            store->update(3, TodoPatch{}.setDescription("tomorrow"s));
+
+            THEN("Committing throws and nothing is committed")
+            {
+                REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+                REQUIRE(getTodo(*store, 0).title == "Buy Milk");
+                REQUIRE(store->checkId(1));
+                REQUIRE_FALSE(store->checkId(10));
+            }
+
+            THEN("Once rolled back, it reads the store again and can commit new changes")
+            {
+                child->rollback();
+                REQUIRE(getTodo(*child, 3).description == "tomorrow");
+                REQUIRE(child->checkId(1));
+                child->remove(3);
+                child->commit();
+                REQUIRE_FALSE(store->checkId(3));
+            }
+        }
+
+        WHEN("The store changes the todos of a title or a range the child queried before it commits")
+        {
+            const std::shared_ptr<Store> titleChild{store->createChild()};
+            titleChild->queryCount({titleKey, "Call mom"s});
+            titleChild->insert(30, TodoPatch{}.setTitle("Call dad"s).setDescription(""s).setTimestamp(1.0));
+            const std::shared_ptr<Store> rangeChild{store->createChild()};
+            rangeChild->rangeQuery(1000.0, 1300.0);
+            rangeChild->insert(31, TodoPatch{}.setTitle("Call dad"s).setDescription(""s).setTimestamp(1.0));
+            const std::shared_ptr<Store> otherRangeChild{store->createChild()};
+            otherRangeChild->rangeCount(0.0, 10.0);
+            otherRangeChild->insert(32, TodoPatch{}.setTitle("Call dad"s).setDescription(""s).setTimestamp(20.0));
+            store->insert(40, TodoPatch{}.setTitle("Call mom"s).setDescription(""s).setTimestamp(1250.0));
+
+            THEN("Only the children that read them throw")
+            {
+                REQUIRE_THROWS_AS(titleChild->commit(), CommitConflict);
+                REQUIRE_THROWS_AS(rangeChild->commit(), CommitConflict);
+                otherRangeChild->commit();
+                REQUIRE_FALSE(store->checkId(30));
+                REQUIRE_FALSE(store->checkId(31));
+                REQUIRE(store->checkId(32));
+            }
+        }
+
+        WHEN("A nested child changes todos")
+        {
+            const std::shared_ptr<Store> nestedChild{child->createChild()};
+            nestedChild->remove(2);
+            nestedChild->update(10, TodoPatch{}.setTitle("Buy Bread"s));
+
+            THEN("It commits into its parent child, which commits into the store")
+            {
+                REQUIRE(child->checkId(2));
+                nestedChild->commit();
+                REQUIRE_FALSE(child->checkId(2));
+                REQUIRE(getTodo(*child, 10).title == "Buy Bread");
+                REQUIRE(store->checkId(2));
+                child->commit();
+                REQUIRE_FALSE(store->checkId(2));
+                REQUIRE(getTodo(*store, 10).title == "Buy Bread");
+                REQUIRE(getTodo(*store, 0).title == "Buy Cream");
+            }
+
+            THEN("It cannot commit once its parent child changed after it was created")
+            {
+                child->remove(3);
+                REQUIRE_THROWS_AS(nestedChild->commit(), CommitConflict);
+                REQUIRE(child->checkId(2));
+            }
+        }
+    }
+
+    GIVEN("A concurrent store with some todos")
+    {
+        auto store{createDummyConcurrentStore()};
+
+        WHEN("Many threads commit children at the same time, all of them changing the same todo")
+        {
+            constexpr auto threadCount{4};
+            constexpr auto commitsPerThread{200};
+            std::atomic<int> conflicts{0};
+            store->update(2, TodoPatch{}.setDescription("0"s));
+            std::vector<std::thread> threads;
+            for(auto thread{0}; thread < threadCount; ++thread)
+            {
+                threads.emplace_back([&store, &conflicts, thread]
+                {
+                    for(auto i{0}; i < commitsPerThread; ++i)
+                    {
+                        const std::shared_ptr<Store> child{store->createChild()};
+                        const auto counter{std::stoi(getTodo(*child, 2).description)};
+                        child->update(2, TodoPatch{}.setDescription(std::to_string(counter + 1)));
+                        child->insert(100 + thread * commitsPerThread + i,
+                                      TodoPatch{}.setTitle("Buy Bread"s).setDescription(""s).setTimestamp(1.0));
+                        try
+                        {
+                            child->commit();
+                        } catch(const CommitConflict&)
+                        {
+                            ++conflicts;
+                        }
+                    }
+                });
+            }
+            for(auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            THEN("No committed increment is lost")
+            {
+                const auto committed{std::stoi(getTodo(*store, 2).description)};
+                REQUIRE(committed + conflicts == threadCount * commitsPerThread);
+                REQUIRE(store->queryCount({titleKey, "Buy Bread"s}) == std::size_t(committed));
+            }
+        }
+    }
+}
@@ -0,0 +1,170 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include <ConcurrentParentStore.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+SCENARIO("Concurrent store")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A concurrent store with some todos")
+    {
+        ConcurrentParentStore store;
+        for(std::int64_t id{0}; id < 100; ++id)
+        {
+            store.insert(id, TodoPatch{}.setTitle(id % 2 == 0 ? "Buy Milk"s : "Call mom"s)
+                                        .setDescription("soon"s)
+                                        .setTimestamp(double(id)));
+        }
+
+        THEN("The todos can be retrieved and queried")
+        {
+            Todo todo;
+            store.get(42, todo);
+            REQUIRE(todo.title == "Buy Milk");
+            REQUIRE(store.checkId(99));
+            REQUIRE_FALSE(store.checkId(100));
+            REQUIRE(store.queryCount(milkProperty) == 50);
+            const std::unordered_set<std::int64_t> expectedIds{10, 11, 12};
+            REQUIRE(TestUtils::collectIds(store.rangeQuery(10.0, 12.0)) == expectedIds);
+            REQUIRE(store.rangeCount(10.0, 19.0) == 10);
+            REQUIRE(store.rangeQueryOrdered(0.0, 100.0, 2, RangeCursor{RangeOrder::descending}).todos ==
+                    std::vector<TimestampTree::Entry>{{99.0, 99}, {98.0, 98}});
+        }
+
+        WHEN("Todos are updated and removed")
+        {
+            store.update(42, TodoPatch{}.setTitle("Call mom"s).setTimestamp(1000.0));
+            store.remove(44);
+
+            THEN("The indexes are updated")
+            {
+                const auto ids{TestUtils::collectIds(store.query(milkProperty))};
+                REQUIRE(ids.size() == 48);
+                REQUIRE(ids.count(42) == 0);
+                REQUIRE(ids.count(44) == 0);
+                REQUIRE(store.rangeCount(1000.0, 1000.0) == 1);
+                REQUIRE_THROWS_AS(store.update(44, TodoPatch{}.setTitle("Call mom"s)), std::invalid_argument);
+                std::vector<std::optional<Todo>> todos;
+                store.getMany({42, 44}, todos);
+                REQUIRE(todos[0]->title == "Call mom");
+                REQUIRE_FALSE(todos[1]);
+            }
+        }
+
+        WHEN("Every todo gets a title of its own and then the titles they had")
+        {
+            for(std::int64_t id{0}; id < 100; ++id)
+            {
+                store.update(id, TodoPatch{}.setTitle("Task "s+std::to_string(id)));
+            }
+            const auto ownTitleCount{store.queryCount({titleKey, "Task 42"s})};
+            for(std::int64_t id{0}; id < 100; ++id)
+            {
+                store.update(id, TodoPatch{}.setTitle(id % 2 == 0 ? "Buy Milk"s : "Call mom"s));
+            }
+
+            THEN("Every title finds its todos")
+            {
+                REQUIRE(ownTitleCount == 1);
+                REQUIRE(store.queryCount({titleKey, "Task 42"s}) == 0);
+                REQUIRE(TestUtils::collectIds(store.query({titleKey, "Task 42"s})).empty());
+                REQUIRE(store.queryCount(milkProperty) == 50);
+                REQUIRE(TestUtils::collectIds(store.query({titleKey, "Call mom"s})).size() == 50);
+            }
+        }
+
+        WHEN("Threads read todos while others rewrite them")
+        {
+            for(std::int64_t id{0}; id < 10; ++id)
+            {
+                store.update(id, TodoPatch{}.setTitle("Buy Milk"s).setDescription("12345678"s));
+            }
+            std::atomic<bool> done{false};
+            std::atomic<int> tornReads{0};
+            std::vector<std::thread> readers;
+            for(auto thread{0}; thread < 4; ++thread)
+            {
+                readers.emplace_back([&store, &done, &tornReads]
+                {
+                    Todo todo;
+                    while(not done)
+                    {
+                        for(std::int64_t id{0}; id < 10; ++id)
+                        {
+                            store.get(id, todo);
+                            // title and description are always written together
+                            if(todo.title.size() not_eq todo.description.size())
+                            {
+                                ++tornReads;
+                            }
+                        }
+                        // the timestamps of the todos that are not rewritten never change
+                        if(store.rangeCount(50.0, 99.0) not_eq 50 or
+                           TestUtils::collectIds(store.rangeQuery(50.0, 99.0)).size() not_eq 50 or
+                           store.rangeQueryOrdered(50.0, 99.0, 10, RangeCursor{}).todos.size() not_eq 10)
+                        {
+                            ++tornReads;
+                        }
+                    }
+                });
+            }
+            for(auto i{0}; i < 2000; ++i)
+            {
+                const auto id{std::int64_t(i % 10)};
+                store.update(id, i % 2 == 0 ? TodoPatch{}.setTitle("Buy Milk"s).setDescription("12345678"s)
+                                            : TodoPatch{}.setTitle("Call mom and dad"s)
+                                                         .setDescription("1234567890123456"s));
+                store.remove(id + 10);
+                store.insert(id + 10, TodoPatch{}.setTitle("Buy Milk"s).setDescription("new"s).setTimestamp(0.0));
+            }
+            done = true;
+            for(auto& reader : readers)
+            {
+                reader.join();
+            }
+
+            THEN("No reader sees a half written todo")
+            {
+                REQUIRE(tornReads == 0);
+                REQUIRE(store.checkId(15));
+            }
+        }
+
+        WHEN("Many threads insert, update and read todos at the same time")
+        {
+            constexpr auto threadCount{8};
+            constexpr std::int64_t todosPerThread{500};
+            std::vector<std::thread> threads;
+            for(auto thread{0}; thread < threadCount; ++thread)
+            {
+                threads.emplace_back([&store, thread]
+                {
+                    Todo todo;
+                    for(std::int64_t i{0}; i < todosPerThread; ++i)
+                    {
+                        const auto id{1000 + thread * todosPerThread + i};
+                        store.insert(id, TodoPatch{}.setTitle("Buy Milk"s).setDescription("new"s).setTimestamp(5000.0));
+                        store.update(id, TodoPatch{}.setTitle("Buy Bread"s));
+                        store.get(i % 100, todo);
+                        store.query({titleKey, "Buy Bread"s});
+                    }
+                });
+            }
+            for(auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            THEN("Every change is found")
+            {
+                REQUIRE(store.queryCount({titleKey, "Buy Bread"s}) == threadCount * todosPerThread);
+                REQUIRE(store.queryCount(milkProperty) == 50);
+                REQUIRE(store.rangeCount(5000.0, 5000.0) == threadCount * todosPerThread);
+            }
+        }
+    }
+}
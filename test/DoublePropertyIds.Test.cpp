@@ -1,4 +1,5 @@
 #include <catch2/catch.hpp>
+#include <numeric>
 #include "DoublePropertyIds.h"
 
 using namespace std::string_literals;
@@ -21,7 +22,7 @@ SCENARIO("Collect ids from double properties")
 
             THEN("A set of ids can be retrieved giving the a property range value")
             {
-                const std::unordered_set<std::int64_t> expectedIds{0, 1};
+                const IdSet expectedIds{0, 1};
                 const auto minValue{100.0};
                 const auto maxValue{200.0};
                 const auto ids{doublePropertyIds.getRangeIds(minValue, maxValue)};
@@ -37,7 +38,7 @@ SCENARIO("Collect ids from double properties")
 
                 THEN("Retrieving ids from range does not include the id updated")
                 {
-                    const std::unordered_set<std::int64_t> expectedIds{1};
+                    const IdSet expectedIds{1};
                     const auto minValue{100.0};
                     const auto maxValue{200.0};
                     const auto ids{doublePropertyIds.getRangeIds(minValue, maxValue)};
@@ -53,13 +54,94 @@ SCENARIO("Collect ids from double properties")
 
                 THEN("The id is not included when retrieving the ids of a range property value")
                 {
-                    const std::unordered_set<std::int64_t> expectedIds{1};
+                    const IdSet expectedIds{1};
                     const auto minValue{100.0};
                     const auto maxValue{200.0};
                     const auto ids{doublePropertyIds.getRangeIds(minValue, maxValue)};
                     REQUIRE(ids == expectedIds);
                 }
             }
+
+            AND_WHEN("The properties and ids of another container are removed and inserted")
+            {
+                DoublePropertyIds removedIds;
+                removedIds.insert(100.0, 0);
+                removedIds.insert(300.0, 2);
+                DoublePropertyIds addedIds;
+                addedIds.insert(150.0, 0);
+                addedIds.insert(300.0, 2);
+                addedIds.insert(400.0, 3);
+                doublePropertyIds.remove(removedIds);
+                doublePropertyIds.insert(addedIds);
+
+                THEN("The ranges have the ids of both containers applied")
+                {
+                    REQUIRE(doublePropertyIds.getRangeIds(100.0, 200.0) == IdSet{0, 1});
+                    REQUIRE(doublePropertyIds.getRangeIds(250.0, 400.0) == IdSet{2, 3});
+                    REQUIRE(doublePropertyIds.countRange(0.0, 1000.0) == 4);
+                }
+
+                THEN("Pairs in any order can be removed at once")
+                {
+                    doublePropertyIds.remove({{400.0, 3}, {150.0, 0}, {150.0, 0}});
+                    REQUIRE(doublePropertyIds.getRangeIds(0.0, 1000.0) == IdSet{1, 2});
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Ordered pages of double properties")
+{
+    GIVEN("A double property id container with many properties")
+    {
+        DoublePropertyIds doublePropertyIds;
+        for(auto id{0}; id < 100; ++id)
+        {
+            doublePropertyIds.insert(double(id / 2), id);
+        }
+
+        THEN("A range can be read in ascending pages")
+        {
+            std::vector<std::int64_t> ids;
+            std::optional<RangeCursor> cursor{RangeCursor{}};
+            while(cursor)
+            {
+                const auto page{doublePropertyIds.getOrderedRange(10.0, 19.0, 3, *cursor)};
+                REQUIRE(page.todos.size() <= 3);
+                for(const auto& todo : page.todos)
+                {
+                    ids.push_back(todo.id);
+                }
+                cursor = page.next;
+            }
+            std::vector<std::int64_t> expectedIds(20);
+            std::iota(expectedIds.begin(), expectedIds.end(), 20);
+            REQUIRE(ids == expectedIds);
+        }
+
+        THEN("A range can be read in descending pages")
+        {
+            auto page{doublePropertyIds.getOrderedRange(10.0, 19.0, 15, RangeCursor{RangeOrder::descending})};
+            REQUIRE(page.todos.front().id == 39);
+            REQUIRE(page.next);
+            page = doublePropertyIds.getOrderedRange(10.0, 19.0, 15, *page.next);
+            REQUIRE(page.todos.size() == 5);
+            REQUIRE(page.todos.front().id == 24);
+            REQUIRE(page.todos.back().id == 20);
+            REQUIRE_FALSE(page.next);
+        }
+
+        THEN("A page that ends with the range has no next page")
+        {
+            const auto page{doublePropertyIds.getOrderedRange(0.0, 1.0, 4, RangeCursor{})};
+            REQUIRE(page.todos.size() == 4);
+            REQUIRE_FALSE(page.next);
+        }
+
+        THEN("A zero limit is not valid")
+        {
+            REQUIRE_THROWS_AS(doublePropertyIds.getOrderedRange(0.0, 1.0, 0, RangeCursor{}), std::invalid_argument);
         }
     }
 }
@@ -0,0 +1,96 @@
+#include <catch2/catch.hpp>
+#include <thread>
+#include "Epochs.h"
+
+namespace
+{
+    /**
+     * Counts the live instances, to know when the retire list frees them.
+     */
+    struct Tracked
+    {
+        explicit Tracked(int& liveCount): liveCount{liveCount} { ++liveCount; }
+        ~Tracked() { --liveCount; }
+        int& liveCount;
+    };
+}
+
+SCENARIO("Epoch-based reclamation")
+{
+    GIVEN("A retire list")
+    {
+        int liveCount{0};
+        RetireList retired;
+
+        WHEN("Objects are retired while no thread is reading")
+        {
+            retired.retire(new Tracked{liveCount});
+            retired.retire(new Tracked{liveCount});
+            retired.reclaim();
+
+            THEN("They are freed")
+            {
+                REQUIRE(liveCount == 0);
+                REQUIRE(retired.size() == 0);
+            }
+        }
+
+        WHEN("An object is retired while a thread is reading")
+        {
+            auto epoch{std::make_unique<ReadEpoch>()};
+            retired.retire(new Tracked{liveCount});
+            retired.reclaim();
+
+            THEN("It is kept until the reader is done")
+            {
+                REQUIRE(liveCount == 1);
+                epoch.reset();
+                retired.reclaim();
+                REQUIRE(liveCount == 0);
+            }
+
+            THEN("Nested reads keep the first epoch pinned")
+            {
+                {
+                    const ReadEpoch nestedEpoch;
+                }
+                retired.reclaim();
+                REQUIRE(liveCount == 1);
+            }
+        }
+
+        WHEN("A thread starts reading once the epoch moved on after an object was retired")
+        {
+            auto epoch{std::make_unique<ReadEpoch>()};
+            retired.retire(new Tracked{liveCount});
+            // the object is kept, but reclaiming moves the epoch on
+            retired.reclaim();
+            epoch.reset();
+            std::thread reader{[&retired]
+            {
+                const ReadEpoch epoch;
+                retired.reclaim();
+            }};
+            reader.join();
+
+            THEN("It cannot be reading the object, so the object is freed")
+            {
+                REQUIRE(liveCount == 0);
+            }
+        }
+
+        WHEN("The retire list is destroyed")
+        {
+            const ReadEpoch epoch;
+            {
+                RetireList destroyedList;
+                destroyedList.retire(new Tracked{liveCount});
+            }
+
+            THEN("Its objects are freed, the structure they belonged to is gone")
+            {
+                REQUIRE(liveCount == 0);
+            }
+        }
+    }
+}
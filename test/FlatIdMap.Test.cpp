@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+#include <unordered_map>
+#include "Arena.h"
+#include "FlatIdMap.h"
+
+using namespace std::string_literals;
+
+SCENARIO("Flat id map")
+{
+    GIVEN("An empty flat id map")
+    {
+        FlatIdMap<std::string> map;
+
+        THEN("No id can be found")
+        {
+            REQUIRE(map.empty());
+            REQUIRE(map.find(0) == map.end());
+            REQUIRE_THROWS_AS(map.at(0), std::out_of_range);
+        }
+
+        WHEN("Some ids are inserted")
+        {
+            map[1] = "Buy Milk"s;
+            map[-5] = "Call mom"s;
+            map.try_emplace(42, "Study Chinese"s);
+
+            THEN("The values can be retrieved by id")
+            {
+                REQUIRE(map.size() == 3);
+                REQUIRE(map.at(1) == "Buy Milk"s);
+                REQUIRE(map.at(-5) == "Call mom"s);
+                REQUIRE(map.find(42)->second == "Study Chinese"s);
+                REQUIRE_FALSE(map.contains(2));
+            }
+
+            THEN("Inserting an existing id does not overwrite the value")
+            {
+                const auto result{map.try_emplace(1, "Buy Cream"s)};
+                REQUIRE_FALSE(result.second);
+                REQUIRE(map.at(1) == "Buy Milk"s);
+            }
+
+            AND_WHEN("An id is erased")
+            {
+                REQUIRE(map.erase(1) == 1);
+
+                THEN("It cannot be found anymore and the rest can")
+                {
+                    REQUIRE(map.size() == 2);
+                    REQUIRE_FALSE(map.contains(1));
+                    REQUIRE(map.at(42) == "Study Chinese"s);
+                    REQUIRE(map.erase(1) == 0);
+                }
+            }
+
+            AND_WHEN("The map is cleared")
+            {
+                const auto capacity{map.capacity()};
+                map.clear();
+
+                THEN("It is empty but keeps its capacity")
+                {
+                    REQUIRE(map.empty());
+                    REQUIRE(map.begin() == map.end());
+                    REQUIRE(map.capacity() == capacity);
+                }
+            }
+        }
+    }
+
+    GIVEN("A map filled with many ids")
+    {
+        constexpr auto totalIds{100000};
+        FlatIdMap<std::int64_t> map;
+        for(std::int64_t id{0}; id < totalIds; ++id)
+        {
+            map[id * 3] = id;
+        }
+
+        THEN("All of them can be found and iterated")
+        {
+            REQUIRE(map.size() == totalIds);
+            std::int64_t sum{0};
+            for(const auto& entry : map)
+            {
+                REQUIRE(entry.first == entry.second * 3);
+                sum += entry.second;
+            }
+            REQUIRE(sum == std::int64_t{totalIds} * (totalIds - 1) / 2);
+        }
+
+        WHEN("Half of them are erased and new ones are inserted")
+        {
+            for(std::int64_t id{0}; id < totalIds; id += 2)
+            {
+                map.erase(id * 3);
+            }
+            for(std::int64_t id{0}; id < totalIds; id += 2)
+            {
+                map[id * 3 + 1] = id;
+            }
+
+            THEN("The map behaves like a std::unordered_map")
+            {
+                std::unordered_map<std::int64_t, std::int64_t> expected;
+                for(std::int64_t id{0}; id < totalIds; ++id)
+                {
+                    expected[id % 2 == 0 ? id * 3 + 1 : id * 3] = id;
+                }
+                REQUIRE(map.size() == expected.size());
+                for(const auto& entry : expected)
+                {
+                    REQUIRE(map.at(entry.first) == entry.second);
+                }
+                REQUIRE_FALSE(map.contains(0));
+            }
+        }
+    }
+
+    GIVEN("A map allocated from an arena")
+    {
+        Arena arena;
+        FlatIdMap<std::string> map{&arena};
+        for(std::int64_t id{0}; id < 1000; ++id)
+        {
+            map[id] = "Buy Milk"s;
+        }
+
+        THEN("Its slots are taken from the arena, and so are the ones of a copy in the same arena")
+        {
+            REQUIRE(map.size() == 1000);
+            REQUIRE(arena.used() >= map.memoryUsage());
+            const auto used{arena.used()};
+            const FlatIdMap<std::string> copy{map, &arena};
+            REQUIRE(copy.at(999) == "Buy Milk"s);
+            REQUIRE(arena.used() > used);
+        }
+
+        THEN("A copy without a memory resource uses the default one")
+        {
+            const auto used{arena.used()};
+            const FlatIdMap<std::string> copy{map};
+            REQUIRE(copy.size() == 1000);
+            REQUIRE(arena.used() == used);
+        }
+    }
+}
@@ -0,0 +1,136 @@
+#include <catch2/catch.hpp>
+#include <GroupCommit.h>
+#include <ChildStore.h>
+#include <ParentStore.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+    std::shared_ptr<ChildStore> createChild(ParentStore& store)
+    {
+        return std::shared_ptr<ChildStore>{static_cast<ChildStore*>(store.createChild().release())};
+    }
+}
+
+SCENARIO("Group commit")
+{
+    GIVEN("A store and a group commit of it")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        GroupCommit group{store};
+
+        WHEN("Children changing different todos are committed in a group")
+        {
+            auto firstChild{createChild(*store)};
+            auto secondChild{createChild(*store)};
+            auto thirdChild{createChild(*store)};
+            firstChild->update(0, TodoPatch{}.setTitle("Buy Cream"s));
+            secondChild->remove(1);
+            thirdChild->insert(10, TodoPatch{}.setTitle("Buy Cream"s).setDescription("new"s).setTimestamp(1.0));
+            const auto initialVersion{store->version()};
+            group.add(firstChild);
+            group.add(secondChild);
+            group.add(thirdChild);
+            const auto results{group.commit()};
+
+            THEN("All of them are committed as a single version")
+            {
+                REQUIRE(results == std::vector<std::exception_ptr>(3));
+                REQUIRE(group.size() == 0);
+                REQUIRE(store->version() == initialVersion + 1);
+                REQUIRE(store->queryCount({titleKey, "Buy Cream"s}) == 2);
+                REQUIRE_FALSE(store->checkId(1));
+            }
+
+            THEN("The committed children read the new version")
+            {
+                REQUIRE_FALSE(firstChild->checkId(1));
+                REQUIRE(secondChild->checkId(10));
+            }
+        }
+
+        WHEN("A child conflicts with a child committed before it in the group")
+        {
+            auto firstChild{createChild(*store)};
+            auto conflictingChild{createChild(*store)};
+            auto queryingChild{createChild(*store)};
+            firstChild->update(0, TodoPatch{}.setTitle("Buy Cream"s));
+            conflictingChild->update(0, TodoPatch{}.setDescription("later"s));
+            queryingChild->queryCount({titleKey, "Buy Milk"s});
+            queryingChild->insert(20, TodoPatch{}.setTitle("Call dad"s).setDescription("new"s).setTimestamp(1.0));
+            group.add(firstChild);
+            group.add(conflictingChild);
+            group.add(queryingChild);
+            const auto results{group.commit()};
+
+            THEN("Only the conflicting children are not committed")
+            {
+                REQUIRE_FALSE(results[0]);
+                REQUIRE_THROWS_AS(std::rethrow_exception(results[1]), CommitConflict);
+                REQUIRE_THROWS_AS(std::rethrow_exception(results[2]), CommitConflict);
+                Todo todo;
+                store->get(0, todo);
+                REQUIRE(todo.title == "Buy Cream");
+                REQUIRE(todo.description == "make of almonds!");
+                REQUIRE_FALSE(store->checkId(20));
+            }
+        }
+
+        WHEN("A child of the group has an invalid change")
+        {
+            auto firstChild{createChild(*store)};
+            auto invalidChild{createChild(*store)};
+            auto lastChild{createChild(*store)};
+            firstChild->update(0, TodoPatch{}.setTitle("Buy Cream"s));
+            invalidChild->update(2, TodoPatch{}.setDescription("later"s));
+            invalidChild->update(100, TodoPatch{}.setDescription("later"s));
+            lastChild->remove(1);
+            group.add(firstChild);
+            group.add(invalidChild);
+            group.add(lastChild);
+            const auto results{group.commit()};
+
+            THEN("Only that child is not committed, and the queue is emptied")
+            {
+                REQUIRE_FALSE(results[0]);
+                REQUIRE_THROWS_AS(std::rethrow_exception(results[1]), std::invalid_argument);
+                REQUIRE_FALSE(results[2]);
+                REQUIRE(group.size() == 0);
+                Todo todo;
+                store->get(0, todo);
+                REQUIRE(todo.title == "Buy Cream");
+                store->get(2, todo);
+                REQUIRE(todo.description not_eq "later");
+                REQUIRE_FALSE(store->checkId(1));
+            }
+        }
+
+        WHEN("A child conflicts with a commit done after its snapshot")
+        {
+            auto child{createChild(*store)};
+            child->get(3);
+            child->insert(20, TodoPatch{}.setTitle("Call dad"s).setDescription("new"s).setTimestamp(1.0));
+            store->update(3, TodoPatch{}.setDescription("tomorrow"s));
+            group.add(child);
+
+            THEN("It is not committed")
+            {
+                REQUIRE_THROWS_AS(std::rethrow_exception(group.commit().front()), CommitConflict);
+                REQUIRE_FALSE(store->checkId(20));
+            }
+        }
+
+        WHEN("A nested child is added")
+        {
+            std::shared_ptr<ChildStore> child{createChild(*store)};
+            std::shared_ptr<ChildStore> nestedChild{static_cast<ChildStore*>(child->createChild().release())};
+
+            THEN("It is rejected, it commits into its parent child")
+            {
+                REQUIRE_THROWS_AS(group.add(nestedChild), std::invalid_argument);
+            }
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include <catch2/catch.hpp>
+#include <set>
+#include "IdSet.h"
+
+namespace
+{
+    std::vector<std::int64_t> toVector(const IdSet& ids)
+    {
+        return {ids.begin(), ids.end()};
+    }
+}
+
+SCENARIO("Compact id set")
+{
+    GIVEN("An empty id set")
+    {
+        IdSet ids;
+
+        THEN("It does not contain ids and does not own memory")
+        {
+            REQUIRE(ids.empty());
+            REQUIRE(ids.begin() == ids.end());
+            REQUIRE(ids.memoryUsage() == 0);
+        }
+
+        WHEN("A single id is inserted")
+        {
+            REQUIRE(ids.insert(42));
+
+            THEN("It is kept inline")
+            {
+                REQUIRE(ids.size() == 1);
+                REQUIRE(ids.contains(42));
+                REQUIRE(ids.memoryUsage() == 0);
+                REQUIRE(toVector(ids) == std::vector<std::int64_t>{42});
+            }
+
+            THEN("Inserting it again does nothing")
+            {
+                REQUIRE_FALSE(ids.insert(42));
+                REQUIRE(ids.size() == 1);
+            }
+        }
+
+        WHEN("A few ids are inserted in any order")
+        {
+            for(const auto id : {5, -3, 12, 7})
+            {
+                ids.insert(id);
+            }
+
+            THEN("They are iterated in ascending order")
+            {
+                REQUIRE(toVector(ids) == std::vector<std::int64_t>{-3, 5, 7, 12});
+                REQUIRE(ids == IdSet{12, 7, 5, -3});
+            }
+
+            AND_WHEN("All but one are erased")
+            {
+                REQUIRE(ids.erase(5));
+                REQUIRE(ids.erase(12));
+                REQUIRE(ids.erase(-3));
+                REQUIRE_FALSE(ids.erase(100));
+
+                THEN("The last one is kept inline")
+                {
+                    REQUIRE(toVector(ids) == std::vector<std::int64_t>{7});
+                    REQUIRE(ids.memoryUsage() == 0);
+                }
+            }
+        }
+    }
+
+    GIVEN("A big set of consecutive and sparse ids, negative ones included")
+    {
+        std::set<std::int64_t> expectedIds;
+        IdSet ids;
+        for(std::int64_t id{-70000}; id < 70000; id += 3)
+        {
+            expectedIds.insert(id);
+            ids.insert(id);
+        }
+        for(std::int64_t id{1}; id < 1000; ++id)
+        {
+            expectedIds.insert(id * 10000019);
+            ids.insert(id * 10000019);
+        }
+
+        THEN("It behaves like an ordered set")
+        {
+            REQUIRE(ids.size() == expectedIds.size());
+            REQUIRE(toVector(ids) == std::vector<std::int64_t>{expectedIds.begin(), expectedIds.end()});
+            REQUIRE(ids.contains(-69997));
+            REQUIRE_FALSE(ids.contains(-69998));
+        }
+
+        THEN("It takes much less memory than an id per node")
+        {
+            REQUIRE(ids.memoryUsage() < ids.size() * sizeof(std::int64_t));
+        }
+
+        THEN("Building it from unsorted ids gives the same set")
+        {
+            std::vector<std::int64_t> unsortedIds{expectedIds.rbegin(), expectedIds.rend()};
+            REQUIRE(IdSet::fromIds(unsortedIds) == ids);
+        }
+
+        WHEN("Most of the ids are erased")
+        {
+            auto remaining{expectedIds.size()};
+            for(const auto id : expectedIds)
+            {
+                if(remaining-- > 3)
+                {
+                    REQUIRE(ids.erase(id));
+                }
+            }
+
+            THEN("The remaining ids are kept")
+            {
+                const std::vector<std::int64_t> lastIds{std::prev(expectedIds.end(), 3), expectedIds.end()};
+                REQUIRE(toVector(ids) == lastIds);
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "catch2/catch.hpp"
+#include <algorithm>
 #include <Store.h>
 #include <ParentStore.h>
 #include "TestUtils.h"
@@ -36,6 +37,23 @@ SCENARIO("Basic store")
             }
 
 
+            THEN("The todo can be updated and retrieved with typed patches")
+            {
+                store.update(id, TodoPatch{}.setTitle("Buy Chocolate"s));
+                Todo todo;
+                store.get(id, todo);
+                REQUIRE(todo.id == id);
+                REQUIRE(todo.title == "Buy Chocolate"s);
+                REQUIRE(todo.description == "make of almonds!"s);
+                REQUIRE(TestUtils::collectIds(store.query({titleKey, "Buy Chocolate"s})) ==
+                        std::unordered_set<std::int64_t>{id});
+            }
+
+            THEN("A todo cannot be inserted with a partial patch")
+            {
+                REQUIRE_THROWS_AS(store.insert(1, TodoPatch{}.setTitle("Buy Chocolate"s)), std::invalid_argument);
+            }
+
             WHEN("The todo can be removed from the store")
             {
                 store.remove(id);
@@ -56,7 +74,7 @@ SCENARIO("Store queries")
         THEN("A set of todo ids can be queried from the store")
         {
             TodoProperty queryProperty{titleKey, "Buy Milk"s};
-            auto ids{store.query(queryProperty)};
+            auto ids{TestUtils::collectIds(store.query(queryProperty))};
             std::unordered_set<std::int64_t> expectedIds{0, 1};
             REQUIRE(std::is_permutation(expectedIds.cbegin(), expectedIds.cend(), ids.cbegin()));
 
@@ -68,7 +86,7 @@ SCENARIO("Store queries")
 
                 THEN("The query result do not include the updated todo id")
                 {
-                    ids = store.query(queryProperty);
+                    ids = TestUtils::collectIds(store.query(queryProperty));
                     expectedIds = {0};
                     REQUIRE(ids == expectedIds);
                 }
@@ -76,7 +94,7 @@ SCENARIO("Store queries")
                 THEN("The updated todo can be retrieved when querying with the updated title")
                 {
                     queryProperty = {titleKey, "Buy Cereals"s};
-                    ids = store.query(queryProperty);
+                    ids = TestUtils::collectIds(store.query(queryProperty));
                     expectedIds = {1};
                     REQUIRE(ids == expectedIds);
                 }
@@ -89,7 +107,7 @@ SCENARIO("Store queries")
 
                 THEN("The query result do not include the updated todo id")
                 {
-                    ids = store.query(queryProperty);
+                    ids = TestUtils::collectIds(store.query(queryProperty));
                     expectedIds = {0};
                     REQUIRE(ids == expectedIds);
                 }
@@ -100,19 +118,19 @@ SCENARIO("Store queries")
         {
             auto minTimeStamp{1000.0};
             auto maxTimeStamp{1300.0};
-            auto ids{store.rangeQuery(minTimeStamp, maxTimeStamp)};
+            auto ids{TestUtils::collectIds(store.rangeQuery(minTimeStamp, maxTimeStamp))};
             std::unordered_set<std::int64_t> expectedIds{2, 3};
             REQUIRE(std::is_permutation(expectedIds.cbegin(), expectedIds.cend(), ids.cbegin()));
 
             AND_WHEN("A timestamp is updated")
             {
                 constexpr auto idToUpdate{3};
-                const TodoProperties propertiesToUpdate{{"timestamp", 1800}};
+                const TodoProperties propertiesToUpdate{{"timestamp", 1800.0}};
                 store.update(idToUpdate, propertiesToUpdate);
 
                 THEN("The query do not include the updated todo id")
                 {
-                    ids = store.rangeQuery(minTimeStamp, maxTimeStamp);
+                    ids = TestUtils::collectIds(store.rangeQuery(minTimeStamp, maxTimeStamp));
                     expectedIds = {2};
                     REQUIRE(ids == expectedIds);
                 }
@@ -121,7 +139,7 @@ SCENARIO("Store queries")
                 {
                     minTimeStamp = 1500;
                     maxTimeStamp = 2000;
-                    ids = store.rangeQuery(minTimeStamp, maxTimeStamp);
+                    ids = TestUtils::collectIds(store.rangeQuery(minTimeStamp, maxTimeStamp));
                     expectedIds = {3};
                     REQUIRE(ids == expectedIds);
                 }
@@ -134,10 +152,197 @@ SCENARIO("Store queries")
                 THEN("The range query does not include that id")
                 {
                     expectedIds = {3};
-                    ids = store.rangeQuery(minTimeStamp, maxTimeStamp);
+                    ids = TestUtils::collectIds(store.rangeQuery(minTimeStamp, maxTimeStamp));
                     REQUIRE(ids == expectedIds);
                 }
             }
         }
     }
-}
\ No newline at end of file
+}
+SCENARIO("Lazy query results")
+{
+    GIVEN("A store with many todos with the same title")
+    {
+        constexpr auto totalTodos{1000};
+        ParentStore store;
+        for(auto id{0}; id < totalTodos; ++id)
+        {
+            store.insert(id, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, double(id)));
+        }
+
+        THEN("The ids can be counted without iterating them")
+        {
+            REQUIRE(store.queryCount({titleKey, "Buy Milk"s}) == totalTodos);
+            REQUIRE(store.queryCount({titleKey, "Buy Cream"s}) == 0);
+            REQUIRE(store.rangeCount(100.0, 199.5) == 100);
+        }
+
+        THEN("Every id is iterated once")
+        {
+            REQUIRE(TestUtils::collectIds(store.query({titleKey, "Buy Milk"s})).size() == totalTodos);
+            REQUIRE(TestUtils::collectIds(store.rangeQuery(0.0, totalTodos)).size() == totalTodos);
+        }
+
+        THEN("The range query results are iterated by timestamp")
+        {
+            auto ids{store.rangeQuery(100.0, 199.0)};
+            std::int64_t expectedId{100};
+            for(const auto id : ids)
+            {
+                REQUIRE(id == expectedId++);
+            }
+            REQUIRE(expectedId == 200);
+        }
+
+        THEN("Only the consumed ids are read")
+        {
+            auto ids{store.query({titleKey, "Buy Milk"s})};
+            std::int64_t id;
+            REQUIRE(ids.next(id));
+            REQUIRE(id == 0);
+            REQUIRE(ids.next(id));
+            REQUIRE(id == 1);
+        }
+
+        THEN("A range with no ids is empty")
+        {
+            auto ids{store.rangeQuery(2000.0, 1000.0)};
+            REQUIRE(ids.begin() == ids.end());
+        }
+    }
+}
+
+SCENARIO("Batch insertion")
+{
+    GIVEN("A store with some todos")
+    {
+        ParentStore store{TestUtils::createDummyParentStore()};
+
+        WHEN("A batch of todos is inserted")
+        {
+            std::vector<Todo> todos;
+            for(std::int64_t id{100}; id < 1100; ++id)
+            {
+                todos.push_back({id, id % 2 == 0 ? "Buy Milk"s : "Walk the dog"s, "batch"s, double(id)});
+            }
+            // overwrites a todo already in the store and a todo of the batch
+            todos.push_back({0, "Walk the dog"s, "batch"s, 50.0});
+            todos.push_back({100, "Buy Cream"s, "batch"s, 60.0});
+            store.insertBatch(todos);
+
+            THEN("Every todo can be retrieved")
+            {
+                const auto expectedProperties{TestUtils::createProperties("Walk the dog"s, "batch"s, 1001.0)};
+                REQUIRE(TestUtils::compareTodoProperties(store.get(1001), expectedProperties));
+                REQUIRE(store.checkId(1099));
+            }
+
+            THEN("The todos are found by title and timestamp with their last values")
+            {
+                REQUIRE(store.queryCount({titleKey, "Buy Milk"s}) == 1 + 499);
+                REQUIRE(store.queryCount({titleKey, "Walk the dog"s}) == 500 + 1);
+                REQUIRE(TestUtils::collectIds(store.query({titleKey, "Buy Cream"s})) ==
+                        std::unordered_set<std::int64_t>{100});
+                REQUIRE(TestUtils::collectIds(store.rangeQuery(0.0, 100.0)) == std::unordered_set<std::int64_t>{0, 100});
+                REQUIRE(store.rangeCount(0.0, 2000.0) == 3 + 1000);
+            }
+        }
+    }
+}
+
+SCENARIO("Getting many todos at once")
+{
+    GIVEN("A store with some todos")
+    {
+        ParentStore store{TestUtils::createDummyParentStore()};
+
+        WHEN("Many ids are requested, some of them not in the store")
+        {
+            std::vector<std::optional<Todo>> todos;
+            store.getMany({3, 42, 0}, todos);
+
+            THEN("Every todo is returned in the position of its id")
+            {
+                REQUIRE(todos.size() == 3);
+                REQUIRE(todos[0]->id == 3);
+                REQUIRE(todos[0]->title == "Call mom"s);
+                REQUIRE_FALSE(todos[1]);
+                REQUIRE(todos[2]->description == "make of almonds!"s);
+                REQUIRE(todos[2]->timestamp == 2392348.12233);
+            }
+
+            AND_WHEN("The same buffer is used again")
+            {
+                std::vector<std::int64_t> ids(20, 2);
+                ids.front() = 1;
+                store.getMany(ids, todos);
+
+                THEN("It only contains the new todos")
+                {
+                    REQUIRE(todos.size() == ids.size());
+                    REQUIRE(todos.front()->title == "Buy Milk"s);
+                    REQUIRE(std::all_of(todos.begin() + 1, todos.end(),
+                                        [](const auto& todo) { return todo and todo->title == "Study Chinese"s; }));
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Committing many changes at once")
+{
+    GIVEN("A store with some todos")
+    {
+        auto store{TestUtils::createDummyParentStore()};
+        const auto inserted{TodoPatch{}.setTitle("Buy Bread"s).setDescription("new"s).setTimestamp(5.0)};
+        const auto renamed{TodoPatch{}.setTitle("Buy Cream"s)};
+        const auto renamedAgain{TodoPatch{}.setTitle("Buy Milk"s).setTimestamp(7.0)};
+        const auto initialVersion{store.version()};
+
+        WHEN("The changes of several commits are applied")
+        {
+            store.commitChanges({{TodoChange::Kind::insert, 10, &inserted},
+                                 {TodoChange::Kind::update, 0, &renamed},
+                                 {TodoChange::Kind::update, 0, &renamedAgain},
+                                 {TodoChange::Kind::remove, 2, nullptr},
+                                 {TodoChange::Kind::update, 10, &renamed}});
+
+            THEN("The todos and indexes have the values after the last change, in a single version")
+            {
+                REQUIRE(store.version() == initialVersion + 1);
+                Todo todo;
+                store.get(0, todo);
+                REQUIRE(todo.title == "Buy Milk");
+                REQUIRE(todo.timestamp == 7.0);
+                store.get(10, todo);
+                REQUIRE(todo.title == "Buy Cream");
+                REQUIRE_FALSE(store.checkId(2));
+                REQUIRE(TestUtils::collectIds(store.query({titleKey, "Buy Milk"s})) ==
+                        std::unordered_set<std::int64_t>{0, 1});
+                REQUIRE(TestUtils::collectIds(store.query({titleKey, "Buy Cream"s})) ==
+                        std::unordered_set<std::int64_t>{10});
+                REQUIRE(store.queryCount({titleKey, "Study Chinese"s}) == 0);
+                REQUIRE(TestUtils::collectIds(store.rangeQuery(0.0, 10.0)) == std::unordered_set<std::int64_t>{0, 10});
+                REQUIRE(store.rangeCount(1000.0, 1000.0) == 0);
+            }
+        }
+
+        WHEN("One of the changes is not valid")
+        {
+            const auto commit{[&]
+            {
+                store.commitChanges({{TodoChange::Kind::update, 0, &renamed},
+                                     {TodoChange::Kind::remove, 2, nullptr},
+                                     {TodoChange::Kind::update, 2, &renamed}});
+            }};
+
+            THEN("Nothing is applied")
+            {
+                REQUIRE_THROWS_AS(commit(), std::invalid_argument);
+                REQUIRE(store.version() == initialVersion);
+                REQUIRE(store.checkId(2));
+                REQUIRE(store.queryCount({titleKey, "Buy Cream"s}) == 0);
+            }
+        }
+    }
+}
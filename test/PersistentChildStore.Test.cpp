@@ -0,0 +1,255 @@
+#include <catch2/catch.hpp>
+#include <PersistentParentStore.h>
+#include <PersistentChildStore.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+    std::shared_ptr<PersistentParentStore> createDummyPersistentStore()
+    {
+        auto store{std::make_shared<PersistentParentStore>()};
+        store->insert(0, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 2392348.12233));
+        store->insert(1, TestUtils::createProperties("Buy Milk"s, "don't forget!"s, 2400050.12555));
+        store->insert(2, TestUtils::createProperties("Study Chinese"s, "worth it!"s, 1000.0));
+        store->insert(3, TestUtils::createProperties("Call mom"s, "is her birthday"s, 1200.0));
+        return store;
+    }
+}
+
+SCENARIO("Persistent child store")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A persistent store with some todos and a child changing some of them")
+    {
+        auto store{createDummyPersistentStore()};
+        const std::shared_ptr<Store> child{store->createChild()};
+        child->update(0, {{titleKey, "Buy Cream"s}});
+        child->remove(1);
+        child->insert(10, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+
+        THEN("The child reads its changes and the store does not")
+        {
+            REQUIRE(std::get<std::string>(child->get(0).at(titleKey)) == "Buy Cream");
+            REQUIRE_FALSE(child->checkId(1));
+            REQUIRE(TestUtils::collectIds(child->query(milkProperty)) == std::unordered_set<std::int64_t>{10});
+            REQUIRE(child->rangeCount(1000.0, 1300.0) == 3);
+            REQUIRE(std::get<std::string>(store->get(0).at(titleKey)) == "Buy Milk");
+            REQUIRE(store->checkId(1));
+            REQUIRE(store->queryCount(milkProperty) == 2);
+        }
+
+        THEN("Todos that do not exist in the child cannot be updated nor removed")
+        {
+            REQUIRE_THROWS_AS(child->update(1, {{titleKey, "Buy Cream"s}}), std::invalid_argument);
+            REQUIRE_THROWS_AS(child->remove(1), std::invalid_argument);
+        }
+
+        WHEN("The child is committed")
+        {
+            child->commit();
+
+            THEN("The store reads the changes, as a single new version")
+            {
+                REQUIRE(store->version() == 5);
+                REQUIRE(std::get<std::string>(store->get(0).at(titleKey)) == "Buy Cream");
+                REQUIRE_FALSE(store->checkId(1));
+                REQUIRE(TestUtils::collectIds(store->query(milkProperty)) == std::unordered_set<std::int64_t>{10});
+                REQUIRE(store->rangeCount(1000.0, 1300.0) == 3);
+            }
+
+            THEN("The child reads the new version and can commit again")
+            {
+                child->remove(10);
+                child->commit();
+                REQUIRE(store->queryCount(milkProperty) == 0);
+            }
+        }
+
+        WHEN("The store is changed before the child commits")
+        {
+            store->update(2, {{descriptionKey, "changed"s}});
+            store->insert(20, TestUtils::createProperties("Buy Bread"s, ""s, 5.0));
+            child->commit();
+
+            THEN("The changes of both are kept")
+            {
+                REQUIRE(std::get<std::string>(store->get(0).at(titleKey)) == "Buy Cream");
+                REQUIRE(std::get<std::string>(store->get(2).at(descriptionKey)) == "changed");
+                REQUIRE(store->checkId(20));
+                REQUIRE_FALSE(store->checkId(1));
+                REQUIRE(store->queryCount(milkProperty) == 1);
+                REQUIRE(store->rangeCount(1000.0, 1300.0) == 3);
+            }
+        }
+
+        WHEN("The child is rolled back")
+        {
+            store->update(2, {{descriptionKey, "changed"s}});
+            child->rollback();
+
+            THEN("It reads the latest version of the store, without its changes")
+            {
+                REQUIRE(std::get<std::string>(child->get(0).at(titleKey)) == "Buy Milk");
+                REQUIRE(child->checkId(1));
+                REQUIRE(std::get<std::string>(child->get(2).at(descriptionKey)) == "changed");
+                child->commit();
+                REQUIRE(store->queryCount(milkProperty) == 2);
+            }
+        }
+
+        WHEN("A nested child changes todos")
+        {
+            const std::shared_ptr<Store> nestedChild{child->createChild()};
+            nestedChild->remove(2);
+            nestedChild->update(10, {{titleKey, "Buy Bread"s}});
+
+            THEN("Its parent child does not read them until it commits")
+            {
+                REQUIRE(child->checkId(2));
+                REQUIRE(child->queryCount(milkProperty) == 1);
+                nestedChild->commit();
+                REQUIRE_FALSE(child->checkId(2));
+                REQUIRE(child->queryCount(milkProperty) == 0);
+                REQUIRE(store->checkId(2));
+            }
+
+            THEN("Committing the parent child after it commits the changes of both")
+            {
+                child->update(3, {{titleKey, "Buy Milk"s}});
+                nestedChild->commit();
+                child->commit();
+                REQUIRE_FALSE(store->checkId(2));
+                REQUIRE(TestUtils::collectIds(store->query(milkProperty)) == std::unordered_set<std::int64_t>{3});
+                REQUIRE(store->queryCount({titleKey, "Buy Bread"s}) == 1);
+            }
+        }
+    }
+
+    GIVEN("A child reading a version of the store that keeps being changed")
+    {
+        auto store{createDummyPersistentStore()};
+        const std::shared_ptr<Store> report{store->createChild()};
+        for(std::int64_t id{100}; id < 200; ++id)
+        {
+            store->insert(id, TestUtils::createProperties("Buy Milk"s, "later"s, 1100.0));
+        }
+        store->remove(3);
+
+        THEN("It reads the version it was created from")
+        {
+            REQUIRE(report->queryCount(milkProperty) == 2);
+            REQUIRE(report->rangeCount(1000.0, 1300.0) == 2);
+            REQUIRE(report->checkId(3));
+            REQUIRE(store->queryCount(milkProperty) == 102);
+        }
+    }
+}
+
+SCENARIO("Persistent child store optimistic concurrency control")
+{
+    GIVEN("Two children of the same persistent store")
+    {
+        auto store{createDummyPersistentStore()};
+        auto child{store->createChild()};
+        auto otherChild{store->createChild()};
+
+        WHEN("The children change different todos")
+        {
+            child->update(0, {{titleKey, "Buy Cream"s}});
+            otherChild->update(1, {{titleKey, "Buy Bread"s}});
+
+            THEN("Both can commit")
+            {
+                REQUIRE_NOTHROW(child->commit());
+                REQUIRE_NOTHROW(otherChild->commit());
+                REQUIRE(store->queryCount({titleKey, "Buy Milk"s}) == 0);
+            }
+        }
+
+        WHEN("A child reads a todo that another child changes and commits")
+        {
+            child->get(2);
+            child->update(3, {{titleKey, "Buy Cream"s}});
+            otherChild->update(2, {{descriptionKey, "changed"s}});
+            otherChild->commit();
+
+            THEN("The commit of the child is rejected and nothing is committed")
+            {
+                REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+                REQUIRE(store->queryCount({titleKey, "Buy Cream"s}) == 0);
+                REQUIRE(std::get<std::string>(child->get(3).at(titleKey)) == "Buy Cream");
+            }
+        }
+
+        WHEN("Both children change the same todo")
+        {
+            child->update(2, {{titleKey, "Buy Cream"s}});
+            otherChild->update(2, {{titleKey, "Buy Bread"s}});
+            otherChild->commit();
+
+            THEN("The first one committing wins")
+            {
+                REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+                REQUIRE(store->queryCount({titleKey, "Buy Bread"s}) == 1);
+            }
+        }
+
+        WHEN("A child queries a title and another child commits a todo with that title")
+        {
+            child->queryCount({titleKey, "Buy Milk"s});
+            child->update(3, {{descriptionKey, "later"s}});
+            otherChild->insert(10, TestUtils::createProperties("Buy Milk"s, "again"s, 1100.0));
+            otherChild->commit();
+
+            THEN("The commit of the child is rejected")
+            {
+                REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+            }
+        }
+
+        WHEN("A child queries a title and another child only changes the description of a todo with that title")
+        {
+            child->query({titleKey, "Buy Milk"s});
+            child->update(3, {{descriptionKey, "later"s}});
+            otherChild->update(0, {{descriptionKey, "changed"s}});
+            otherChild->commit();
+
+            THEN("The child can commit, the query result did not change")
+            {
+                REQUIRE_NOTHROW(child->commit());
+            }
+        }
+
+        WHEN("A child queries a timestamp range and another child commits a todo inside and outside of it")
+        {
+            child->rangeQuery(900.0, 1300.0);
+            child->update(3, {{descriptionKey, "later"s}});
+
+            AND_WHEN("The todo is inside the range")
+            {
+                otherChild->update(0, {{timestampKey, 1100.0}});
+                otherChild->commit();
+
+                THEN("The commit of the child is rejected")
+                {
+                    REQUIRE_THROWS_AS(child->commit(), CommitConflict);
+                }
+            }
+
+            AND_WHEN("The todo is outside the range")
+            {
+                otherChild->update(0, {{timestampKey, 5000.0}});
+                otherChild->commit();
+
+                THEN("The child can commit")
+                {
+                    REQUIRE_NOTHROW(child->commit());
+                    REQUIRE(std::get<double>(store->get(0).at(timestampKey)) == 5000.0);
+                }
+            }
+        }
+    }
+}
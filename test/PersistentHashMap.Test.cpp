@@ -0,0 +1,150 @@
+#include <catch2/catch.hpp>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "PersistentHashMap.h"
+
+namespace
+{
+    /**
+     * Every key has the same hash, so they all end in the list at the bottom of the trie.
+     */
+    struct CollidingHash
+    {
+        std::size_t operator()(std::int64_t) const { return 7; }
+    };
+
+    template<typename Map>
+    std::unordered_map<std::int64_t, std::int64_t> toMap(const Map& map)
+    {
+        std::unordered_map<std::int64_t, std::int64_t> entries;
+        for(const auto& entry : map)
+        {
+            entries.emplace(entry.first, entry.second);
+        }
+        return entries;
+    }
+}
+
+SCENARIO("Persistent hash map")
+{
+    GIVEN("A map with some entries")
+    {
+        PersistentHashMap<std::string, int> map;
+        REQUIRE(map.insertOrAssign("Buy Milk", 1));
+        REQUIRE(map.insertOrAssign("Call mom", 2));
+        map["Study Chinese"] = 3;
+
+        THEN("The values can be found by key")
+        {
+            REQUIRE(map.size() == 3);
+            REQUIRE(*map.find("Buy Milk") == 1);
+            REQUIRE(*map.find("Study Chinese") == 3);
+            REQUIRE(map.find("Buy Cream") == nullptr);
+        }
+
+        THEN("Assigning an existing key replaces its value")
+        {
+            REQUIRE_FALSE(map.insertOrAssign("Buy Milk", 4));
+            REQUIRE(*map.find("Buy Milk") == 4);
+            REQUIRE(map.size() == 3);
+        }
+
+        WHEN("The map is copied and the copy is changed")
+        {
+            auto copy{map};
+            REQUIRE(copy.sameVersion(map));
+            copy["Buy Milk"] = 5;
+            REQUIRE(copy.erase("Call mom"));
+            copy["Buy Cream"] = 6;
+
+            THEN("The original map keeps its entries")
+            {
+                REQUIRE_FALSE(copy.sameVersion(map));
+                REQUIRE(map.size() == 3);
+                REQUIRE(*map.find("Buy Milk") == 1);
+                REQUIRE(*map.find("Call mom") == 2);
+                REQUIRE(map.find("Buy Cream") == nullptr);
+                REQUIRE(copy.size() == 3);
+                REQUIRE(*copy.find("Buy Milk") == 5);
+                REQUIRE(copy.find("Call mom") == nullptr);
+            }
+        }
+
+        WHEN("Every key is erased")
+        {
+            REQUIRE(map.erase("Buy Milk"));
+            REQUIRE_FALSE(map.erase("Buy Milk"));
+            REQUIRE(map.erase("Call mom"));
+            REQUIRE(map.erase("Study Chinese"));
+
+            THEN("The map is empty")
+            {
+                REQUIRE(map.empty());
+                REQUIRE(map.begin() == map.end());
+            }
+        }
+    }
+
+    GIVEN("A map with many random insertions and removals, copied in the middle")
+    {
+        PersistentHashMap<std::int64_t, std::int64_t> map;
+        std::unordered_map<std::int64_t, std::int64_t> expectedEntries;
+        PersistentHashMap<std::int64_t, std::int64_t> middleMap;
+        std::unordered_map<std::int64_t, std::int64_t> expectedMiddleEntries;
+        std::mt19937_64 random{42};
+        std::uniform_int_distribution<std::int64_t> keys{-5000, 5000};
+        for(std::int64_t i{0}; i < 40000; ++i)
+        {
+            if(i == 20000)
+            {
+                middleMap = map;
+                expectedMiddleEntries = expectedEntries;
+            }
+            const auto key{keys(random) * (i % 7 == 0 ? 1000003 : 1)};
+            if(random() % 3 < (i < 20000 ? 2u : 1u))
+            {
+                REQUIRE(map.insertOrAssign(key, i) == expectedEntries.insert_or_assign(key, i).second);
+            } else
+            {
+                REQUIRE(map.erase(key) == (expectedEntries.erase(key) == 1));
+            }
+        }
+
+        THEN("Both versions keep the same entries than an unordered map")
+        {
+            REQUIRE(map.size() == expectedEntries.size());
+            REQUIRE(toMap(map) == expectedEntries);
+            REQUIRE(middleMap.size() == expectedMiddleEntries.size());
+            REQUIRE(toMap(middleMap) == expectedMiddleEntries);
+            for(const auto& entry : expectedEntries)
+            {
+                REQUIRE(*map.find(entry.first) == entry.second);
+            }
+        }
+    }
+
+    GIVEN("A map whose keys have the same hash")
+    {
+        PersistentHashMap<std::int64_t, std::int64_t, CollidingHash> map;
+        for(std::int64_t key{0}; key < 10; ++key)
+        {
+            map[key] = key * 10;
+        }
+        const auto copy{map};
+        REQUIRE(map.erase(3));
+        REQUIRE_FALSE(map.erase(3));
+        map[4] = 0;
+
+        THEN("They are told apart by comparing them")
+        {
+            REQUIRE(map.size() == 9);
+            REQUIRE(map.find(3) == nullptr);
+            REQUIRE(*map.find(4) == 0);
+            REQUIRE(*map.find(9) == 90);
+            REQUIRE(toMap(map).size() == 9);
+            REQUIRE(*copy.find(3) == 30);
+            REQUIRE(*copy.find(4) == 40);
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include <PersistentParentStore.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+SCENARIO("Persistent store")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A persistent store with some todos")
+    {
+        auto store{std::make_shared<PersistentParentStore>()};
+        for(std::int64_t id{0}; id < 100; ++id)
+        {
+            store->insert(id, TodoPatch{}.setTitle(id % 2 == 0 ? "Buy Milk"s : "Call mom"s)
+                                         .setDescription("soon"s)
+                                         .setTimestamp(double(id)));
+        }
+
+        THEN("The todos can be retrieved and queried")
+        {
+            Todo todo;
+            store->get(42, todo);
+            REQUIRE(todo.title == "Buy Milk");
+            REQUIRE(std::get<std::string>(store->get(43).at(titleKey)) == "Call mom");
+            REQUIRE_THROWS_AS(store->get(100), std::out_of_range);
+            REQUIRE(store->checkId(99));
+            REQUIRE_FALSE(store->checkId(100));
+            REQUIRE(store->queryCount(milkProperty) == 50);
+            REQUIRE(TestUtils::collectIds(store->query(milkProperty)).size() == 50);
+            const std::unordered_set<std::int64_t> expectedIds{10, 11, 12};
+            REQUIRE(TestUtils::collectIds(store->rangeQuery(10.0, 12.0)) == expectedIds);
+            REQUIRE(store->rangeCount(10.0, 19.0) == 10);
+            REQUIRE(store->rangeQueryOrdered(0.0, 100.0, 2, RangeCursor{RangeOrder::descending}).todos ==
+                    std::vector<TimestampTree::Entry>{{99.0, 99}, {98.0, 98}});
+            REQUIRE(store->version() == 100);
+        }
+
+        THEN("A todo cannot be inserted with a partial patch, nor updated or removed if it does not exist")
+        {
+            REQUIRE_THROWS_AS(store->insert(100, TodoPatch{}.setTitle("Buy Milk"s)), std::invalid_argument);
+            REQUIRE_THROWS_AS(store->update(100, TodoPatch{}.setTitle("Buy Milk"s)), std::invalid_argument);
+            REQUIRE_THROWS_AS(store->remove(100), std::invalid_argument);
+            REQUIRE(store->version() == 100);
+        }
+
+        WHEN("Todos are updated, overwritten and removed")
+        {
+            store->update(42, TodoPatch{}.setTitle("Call mom"s).setTimestamp(1000.0));
+            store->insert(40, TodoPatch{}.setTitle("Buy Bread"s).setDescription(""s).setTimestamp(2000.0));
+            store->remove(44);
+
+            THEN("The indexes are updated")
+            {
+                const auto ids{TestUtils::collectIds(store->query(milkProperty))};
+                REQUIRE(ids.size() == 47);
+                REQUIRE(ids.count(40) == 0);
+                REQUIRE(ids.count(42) == 0);
+                REQUIRE(ids.count(44) == 0);
+                REQUIRE(store->queryCount({titleKey, "Buy Bread"s}) == 1);
+                REQUIRE(store->rangeCount(1000.0, 2000.0) == 2);
+                REQUIRE(store->rangeCount(40.0, 44.0) == 2);
+                std::vector<std::optional<Todo>> todos;
+                store->getMany({42, 44}, todos);
+                REQUIRE(todos[0]->title == "Call mom");
+                REQUIRE_FALSE(todos[1]);
+            }
+        }
+
+        WHEN("The store is queried and changed before reading the results")
+        {
+            auto milkIds{store->query(milkProperty)};
+            auto rangeIds{store->rangeQuery(0.0, 9.0)};
+            store->remove(0);
+            store->update(2, TodoPatch{}.setTitle("Call mom"s).setTimestamp(1000.0));
+
+            THEN("The results are the ids of the version queried")
+            {
+                REQUIRE(TestUtils::collectIds(std::move(milkIds)).size() == 50);
+                REQUIRE(TestUtils::collectIds(std::move(rangeIds)).size() == 10);
+                REQUIRE(store->queryCount(milkProperty) == 48);
+            }
+        }
+
+        WHEN("A batch of todos is inserted")
+        {
+            store->insertBatch({{1, "Buy Bread", "", 3000.0}, {200, "Buy Bread", "", 3001.0}});
+
+            THEN("The todos are found by title and timestamp with their new values, in a single version")
+            {
+                REQUIRE(store->version() == 101);
+                REQUIRE(store->queryCount({titleKey, "Buy Bread"s}) == 2);
+                REQUIRE(store->queryCount({titleKey, "Call mom"s}) == 49);
+                REQUIRE(store->rangeCount(3000.0, 3001.0) == 2);
+                REQUIRE(store->rangeCount(1.0, 1.0) == 0);
+            }
+        }
+
+        WHEN("Threads read todos while others rewrite them")
+        {
+            for(std::int64_t id{0}; id < 10; ++id)
+            {
+                store->update(id, TodoPatch{}.setTitle("Buy Milk"s).setDescription("12345678"s));
+            }
+            std::atomic<bool> done{false};
+            std::atomic<int> tornReads{0};
+            std::vector<std::thread> readers;
+            for(auto thread{0}; thread < 4; ++thread)
+            {
+                readers.emplace_back([&store, &done, &tornReads]
+                {
+                    Todo todo;
+                    while(not done)
+                    {
+                        for(std::int64_t id{0}; id < 10; ++id)
+                        {
+                            store->get(id, todo);
+                            // title and description are always written together
+                            if(todo.title.size() not_eq todo.description.size())
+                            {
+                                ++tornReads;
+                            }
+                        }
+                    }
+                });
+            }
+            for(auto i{0}; i < 2000; ++i)
+            {
+                const auto id{std::int64_t(i % 10)};
+                store->update(id, i % 2 == 0 ? TodoPatch{}.setTitle("Buy Milk"s).setDescription("12345678"s)
+                                             : TodoPatch{}.setTitle("Call mom and dad"s)
+                                                          .setDescription("1234567890123456"s));
+            }
+            done = true;
+            for(auto& reader : readers)
+            {
+                reader.join();
+            }
+
+            THEN("No reader sees a half written todo")
+            {
+                REQUIRE(tornReads == 0);
+            }
+        }
+
+        WHEN("Many threads commit children changing different todos")
+        {
+            std::vector<std::thread> writers;
+            for(std::int64_t thread{0}; thread < 4; ++thread)
+            {
+                writers.emplace_back([&store, thread]
+                {
+                    for(std::int64_t id{thread}; id < 100; id += 4)
+                    {
+                        auto child{store->createChild()};
+                        child->update(id, TodoPatch{}.setTitle("Buy Bread"s));
+                        child->commit();
+                    }
+                });
+            }
+            for(auto& writer : writers)
+            {
+                writer.join();
+            }
+
+            THEN("Every change is found")
+            {
+                REQUIRE(store->queryCount({titleKey, "Buy Bread"s}) == 100);
+                REQUIRE(store->queryCount(milkProperty) == 0);
+                REQUIRE(store->version() == 200);
+            }
+        }
+    }
+}
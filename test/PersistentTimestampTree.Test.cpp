@@ -0,0 +1,176 @@
+#include <catch2/catch.hpp>
+#include <random>
+#include <set>
+#include "PersistentTimestampTree.h"
+
+namespace
+{
+    using Entry = PersistentTimestampTree::Entry;
+
+    std::vector<Entry> toVector(const PersistentTimestampTree& tree)
+    {
+        return {tree.begin(), tree.end()};
+    }
+}
+
+SCENARIO("Persistent timestamp B+-tree")
+{
+    GIVEN("An empty tree")
+    {
+        PersistentTimestampTree tree;
+
+        THEN("It has no entries")
+        {
+            REQUIRE(tree.empty());
+            REQUIRE(tree.begin() == tree.end());
+            REQUIRE(tree.lowerBound(0.0) == tree.end());
+        }
+
+        WHEN("Some entries are inserted")
+        {
+            tree.insert({300.0, 3});
+            tree.insert({100.0, 1});
+            tree.insert({200.0, 2});
+            tree.insert({100.0, 0});
+
+            THEN("They are iterated sorted by timestamp and id, forwards and backwards")
+            {
+                const std::vector<Entry> expectedEntries{{100.0, 0}, {100.0, 1}, {200.0, 2}, {300.0, 3}};
+                REQUIRE(toVector(tree) == expectedEntries);
+                auto it{tree.end()};
+                REQUIRE(*--it == Entry{300.0, 3});
+                REQUIRE(*--it == Entry{200.0, 2});
+            }
+
+            THEN("Inserting an existing pair does nothing")
+            {
+                REQUIRE_FALSE(tree.insert({200.0, 2}));
+                REQUIRE(tree.size() == 4);
+            }
+
+            THEN("Ranges can be found with bounds and counted without iterating them")
+            {
+                REQUIRE(*tree.lowerBound(150.0) == Entry{200.0, 2});
+                REQUIRE(*tree.upperBound(100.0) == Entry{200.0, 2});
+                REQUIRE(*tree.lowerBound(Entry{100.0, 1}) == Entry{100.0, 1});
+                REQUIRE(tree.upperBound(300.0) == tree.end());
+                REQUIRE(tree.count(100.0, 200.0) == 3);
+                REQUIRE(tree.count(150.0, 160.0) == 0);
+                REQUIRE(tree.count(300.0, 100.0) == 0);
+            }
+
+            AND_WHEN("The tree is copied and the copy is changed")
+            {
+                auto copy{tree};
+                REQUIRE(copy.sameVersion(tree));
+                REQUIRE(copy.erase({100.0, 1}));
+                REQUIRE(copy.insert({400.0, 4}));
+
+                THEN("The original tree keeps its entries")
+                {
+                    REQUIRE_FALSE(copy.sameVersion(tree));
+                    const std::vector<Entry> expectedEntries{{100.0, 0}, {100.0, 1}, {200.0, 2}, {300.0, 3}};
+                    REQUIRE(toVector(tree) == expectedEntries);
+                    const std::vector<Entry> expectedCopyEntries{{100.0, 0}, {200.0, 2}, {300.0, 3}, {400.0, 4}};
+                    REQUIRE(toVector(copy) == expectedCopyEntries);
+                }
+            }
+        }
+    }
+
+    GIVEN("A tree with many random insertions and removals, copied in the middle")
+    {
+        PersistentTimestampTree tree;
+        std::set<Entry> expectedEntries;
+        PersistentTimestampTree middleTree;
+        std::set<Entry> expectedMiddleEntries;
+        std::mt19937_64 random{42};
+        std::uniform_int_distribution<int> timestamps{0, 2000};
+        std::uniform_int_distribution<std::int64_t> ids{0, 50};
+        for(auto i{0}; i < 60000; ++i)
+        {
+            if(i == 30000)
+            {
+                middleTree = tree;
+                expectedMiddleEntries = expectedEntries;
+            }
+            const Entry entry{double(timestamps(random)), ids(random)};
+            // insert twice as often as erase at the beginning, and the other way around at the end
+            if(random() % 3 < (i < 30000 ? 2u : 1u))
+            {
+                REQUIRE(tree.insert(entry) == expectedEntries.insert(entry).second);
+            } else
+            {
+                REQUIRE(tree.erase(entry) == (expectedEntries.erase(entry) == 1));
+            }
+        }
+
+        THEN("Both versions keep the same entries than an ordered set")
+        {
+            REQUIRE(tree.size() == expectedEntries.size());
+            REQUIRE(toVector(tree) == std::vector<Entry>{expectedEntries.begin(), expectedEntries.end()});
+            REQUIRE(middleTree.size() == expectedMiddleEntries.size());
+            REQUIRE(toVector(middleTree) ==
+                    std::vector<Entry>{expectedMiddleEntries.begin(), expectedMiddleEntries.end()});
+        }
+
+        THEN("Every range is read and counted as in the ordered set")
+        {
+            for(auto timestamp{0.0}; timestamp < 2000.0; timestamp += 97.0)
+            {
+                const std::vector<Entry> range{tree.lowerBound(timestamp), tree.upperBound(timestamp + 50.0)};
+                const std::vector<Entry> expectedRange{expectedEntries.lower_bound({timestamp, 0}),
+                                                       expectedEntries.upper_bound({timestamp + 50.0, 1000})};
+                REQUIRE(range == expectedRange);
+                REQUIRE(tree.count(timestamp, timestamp + 50.0) == expectedRange.size());
+            }
+            REQUIRE(tree.count(0.0, 2000.0) == expectedEntries.size());
+        }
+
+        THEN("The entries are iterated backwards in reverse order")
+        {
+            std::vector<Entry> reversed;
+            for(auto it{tree.end()}; it not_eq tree.begin();)
+            {
+                reversed.push_back(*--it);
+            }
+            REQUIRE(reversed == std::vector<Entry>{expectedEntries.rbegin(), expectedEntries.rend()});
+        }
+
+        WHEN("Every entry is erased")
+        {
+            for(const auto& entry : expectedEntries)
+            {
+                REQUIRE(tree.erase(entry));
+            }
+
+            THEN("The tree is empty and the copy is not changed")
+            {
+                REQUIRE(tree.empty());
+                REQUIRE(tree.begin() == tree.end());
+                REQUIRE(middleTree.size() == expectedMiddleEntries.size());
+            }
+        }
+    }
+
+    GIVEN("A tree built from sorted entries")
+    {
+        std::vector<Entry> sortedEntries;
+        for(std::int64_t id{0}; id < 10000; ++id)
+        {
+            sortedEntries.push_back({double(id / 3), id});
+        }
+        PersistentTimestampTree tree;
+        tree.assignSorted(sortedEntries);
+
+        THEN("It has the same entries and can keep changing")
+        {
+            REQUIRE(toVector(tree) == sortedEntries);
+            REQUIRE(tree.insert({-1.0, 0}));
+            REQUIRE(tree.erase({0.0, 0}));
+            REQUIRE(tree.begin()->timestamp == -1.0);
+            REQUIRE(tree.size() == sortedEntries.size());
+            REQUIRE(tree.count(0.0, 9.0) == 29);
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include <catch2/catch.hpp>
+#include <thread>
+#include <ShardedStore.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+    Todo getTodo(const Store& store, std::int64_t id)
+    {
+        Todo todo;
+        store.get(id, todo);
+        return todo;
+    }
+}
+
+SCENARIO("Sharded store")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A sharded store with some todos inserted in a batch")
+    {
+        auto store{std::make_shared<ShardedStore>(4)};
+        std::vector<Todo> todos;
+        for(std::int64_t id{0}; id < 100; ++id)
+        {
+            todos.push_back({id, id % 2 == 0 ? "Buy Milk"s : "Call mom"s, "soon"s, double(id)});
+        }
+        store->insertBatch(todos);
+
+        THEN("The todos are found in whatever shard they are")
+        {
+            REQUIRE(store->shardCount() == 4);
+            REQUIRE(getTodo(*store, 42).title == "Buy Milk"s);
+            REQUIRE(store->checkId(99));
+            REQUIRE_FALSE(store->checkId(100));
+            std::vector<std::optional<Todo>> foundTodos;
+            store->getMany({7, 100, 3}, foundTodos);
+            REQUIRE(foundTodos[0]->id == 7);
+            REQUIRE_FALSE(foundTodos[1]);
+            REQUIRE(foundTodos[2]->id == 3);
+        }
+
+        THEN("Queries merge the results of every shard")
+        {
+            REQUIRE(TestUtils::collectIds(store->query(milkProperty)).size() == 50);
+            REQUIRE(store->queryCount(milkProperty) == 50);
+            const std::unordered_set<std::int64_t> expectedIds{10, 11, 12};
+            REQUIRE(TestUtils::collectIds(store->rangeQuery(10.0, 12.0)) == expectedIds);
+            REQUIRE(store->rangeCount(10.0, 19.0) == 10);
+        }
+
+        THEN("Ordered range queries are paged across shards")
+        {
+            std::vector<TimestampTree::Entry> readTodos;
+            RangeCursor cursor{RangeOrder::descending};
+            while(true)
+            {
+                auto page{store->rangeQueryOrdered(20.0, 59.0, 7, cursor)};
+                readTodos.insert(readTodos.end(), page.todos.begin(), page.todos.end());
+                if(not page.next)
+                {
+                    break;
+                }
+                cursor = *page.next;
+            }
+            REQUIRE(readTodos.size() == 40);
+            REQUIRE(readTodos.front() == TimestampTree::Entry{59.0, 59});
+            REQUIRE(std::is_sorted(readTodos.rbegin(), readTodos.rend()));
+        }
+
+        WHEN("A transaction changes todos of several shards")
+        {
+            auto transaction{store->createChild()};
+            transaction->update(0, TodoPatch{}.setTitle("Call mom"s));
+            transaction->remove(1);
+            transaction->insert(100, TodoPatch{}.setTitle("Buy Milk"s).setDescription("new"s).setTimestamp(100.0));
+
+            THEN("The changes are only seen by the transaction until it commits")
+            {
+                REQUIRE(transaction->queryCount(milkProperty) == 50);
+                REQUIRE_FALSE(transaction->checkId(1));
+                REQUIRE(store->checkId(1));
+                REQUIRE(store->queryCount(milkProperty) == 50);
+                REQUIRE_FALSE(store->checkId(100));
+
+                transaction->commit();
+                REQUIRE(getTodo(*store, 0).title == "Call mom"s);
+                REQUIRE_FALSE(store->checkId(1));
+                REQUIRE(store->checkId(100));
+            }
+
+            THEN("A nested transaction commits into it")
+            {
+                auto nestedTransaction{transaction->createChild()};
+                nestedTransaction->remove(2);
+                nestedTransaction->commit();
+                REQUIRE_FALSE(transaction->checkId(2));
+                REQUIRE(store->checkId(2));
+                transaction->commit();
+                REQUIRE_FALSE(store->checkId(2));
+            }
+
+            AND_WHEN("Another commit changed one of its todos meanwhile")
+            {
+                store->update(100 - 2, TodoPatch{}.setDescription("later"s));
+                transaction->get(98);
+                auto otherTransaction{store->createChild()};
+                otherTransaction->update(1, TodoPatch{}.setDescription("first"s));
+                otherTransaction->commit();
+
+                THEN("Nothing is committed in any shard")
+                {
+                    REQUIRE_THROWS_AS(transaction->commit(), CommitConflict);
+                    REQUIRE(getTodo(*store, 0).title == "Buy Milk"s);
+                    REQUIRE_FALSE(store->checkId(100));
+                    REQUIRE(getTodo(*store, 1).description == "first"s);
+                }
+
+                THEN("Once rolled back, it reads every shard again and can commit new changes")
+                {
+                    transaction->rollback();
+                    REQUIRE(getTodo(*transaction, 0).title == "Buy Milk"s);
+                    REQUIRE(getTodo(*transaction, 1).description == "first"s);
+                    REQUIRE_FALSE(transaction->checkId(100));
+                    transaction->remove(2);
+                    transaction->commit();
+                    REQUIRE_FALSE(store->checkId(2));
+                    REQUIRE(getTodo(*store, 0).title == "Buy Milk"s);
+                }
+            }
+        }
+
+        WHEN("A transaction updates todos of every shard and a todo that does not exist")
+        {
+            auto transaction{store->createChild()};
+            for(std::int64_t id{0}; id < 8; ++id)
+            {
+                transaction->update(id, TodoPatch{}.setDescription("later"s));
+            }
+            transaction->update(1000, TodoPatch{}.setDescription("later"s));
+
+            THEN("Committing it fails and nothing is committed in any shard")
+            {
+                REQUIRE_THROWS_AS(transaction->commit(), std::invalid_argument);
+                for(std::int64_t id{0}; id < 8; ++id)
+                {
+                    REQUIRE(getTodo(*store, id).description == "soon"s);
+                }
+            }
+        }
+
+        WHEN("Many threads write and query at the same time")
+        {
+            std::vector<std::thread> threads;
+            for(auto thread{0}; thread < 4; ++thread)
+            {
+                threads.emplace_back([&store, thread]
+                {
+                    for(std::int64_t i{0}; i < 200; ++i)
+                    {
+                        const auto id{1000 + thread * 200 + i};
+                        store->insert(id, TodoPatch{}.setTitle("Buy Bread"s).setDescription("new"s)
+                                                     .setTimestamp(500.0));
+                        store->query({titleKey, "Buy Bread"s});
+                        if(i % 10 == 0)
+                        {
+                            auto transaction{store->createChild()};
+                            transaction->update(id, TodoPatch{}.setDescription("committed"s));
+                            transaction->queryCount({titleKey, "Call mom"s});
+                            transaction->get(id);
+                            transaction->commit();
+                        }
+                    }
+                });
+            }
+            for(auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            THEN("Every change is found")
+            {
+                REQUIRE(store->queryCount({titleKey, "Buy Bread"s}) == 800);
+                REQUIRE(store->rangeCount(500.0, 500.0) == 800);
+                REQUIRE(getTodo(*store, 1010).description == "committed"s);
+            }
+        }
+    }
+}
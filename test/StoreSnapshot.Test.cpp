@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+#include <future>
+#include <ParentStore.h>
+#include <StoreSnapshot.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+SCENARIO("Store snapshots")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A snapshot of a store with some todos")
+    {
+        auto store{std::make_shared<ParentStore>(TestUtils::createDummyParentStore())};
+        const auto snapshot{store->snapshot()};
+        REQUIRE(snapshot->version() == store->version());
+
+        WHEN("The store changes after the snapshot")
+        {
+            store->update(0, {{titleKey, "Buy Cereals"s}});
+            store->update(2, {{timestampKey, 5000.0}});
+            store->update(2, {{timestampKey, 6000.0}});
+            store->remove(3);
+            store->insert(123, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 1100.0));
+
+            THEN("The snapshot reads the todos as they were")
+            {
+                Todo todo;
+                snapshot->get(0, todo);
+                REQUIRE(todo.title == "Buy Milk");
+                snapshot->get(2, todo);
+                REQUIRE(todo.timestamp == 1000.0);
+                REQUIRE(snapshot->checkId(3));
+                REQUIRE_FALSE(snapshot->checkId(123));
+                REQUIRE_THROWS_AS(snapshot->get(123, todo), std::out_of_range);
+
+                std::vector<std::optional<Todo>> todos;
+                snapshot->getMany({0, 3, 123}, todos);
+                REQUIRE(todos[0]->title == "Buy Milk");
+                REQUIRE(todos[1]->title == "Call mom");
+                REQUIRE_FALSE(todos[2]);
+            }
+
+            THEN("The snapshot reads the indexed values of the todos as they were")
+            {
+                std::string title;
+                double timestamp;
+                REQUIRE(snapshot->getIndexedValues(0, title, timestamp));
+                REQUIRE(title == "Buy Milk");
+                REQUIRE(snapshot->getIndexedValues(2, title, timestamp));
+                REQUIRE(timestamp == 1000.0);
+                REQUIRE(snapshot->getIndexedValues(3, title, timestamp));
+                REQUIRE_FALSE(snapshot->getIndexedValues(123, title, timestamp));
+                REQUIRE(store->getIndexedValues(123, title, timestamp));
+                REQUIRE(timestamp == 1100.0);
+            }
+
+            THEN("The snapshot queries and counts return the todos as they were")
+            {
+                REQUIRE(TestUtils::collectIds(snapshot->query(milkProperty)) == std::unordered_set<std::int64_t>{0, 1});
+                REQUIRE(snapshot->queryCount(milkProperty) == 2);
+                REQUIRE(TestUtils::collectIds(snapshot->rangeQuery(1000.0, 1300.0)) ==
+                        std::unordered_set<std::int64_t>{2, 3});
+                REQUIRE(snapshot->rangeCount(1000.0, 1300.0) == 2);
+                const auto page{snapshot->rangeQueryOrdered(0.0, 10000.0, 10, RangeCursor{})};
+                REQUIRE(page.todos == std::vector<TimestampTree::Entry>{{1000.0, 2}, {1200.0, 3}});
+            }
+
+            THEN("The snapshot tells which todos, titles and ranges changed")
+            {
+                REQUIRE(snapshot->changed(0));
+                REQUIRE_FALSE(snapshot->changed(1));
+                REQUIRE(snapshot->changedTitle("Buy Milk"s));
+                REQUIRE_FALSE(snapshot->changedTitle("Study Chinese"s));
+                REQUIRE(snapshot->changedRange(1000.0, 1300.0));
+                REQUIRE_FALSE(snapshot->changedRange(2000000.0, 3000000.0));
+            }
+
+            THEN("The store has the changes")
+            {
+                REQUIRE(TestUtils::collectIds(store->query(milkProperty)) == std::unordered_set<std::int64_t>{1, 123});
+                REQUIRE(store->rangeCount(1000.0, 1300.0) == 1);
+                REQUIRE(store->snapshot()->rangeCount(1000.0, 1300.0) == 1);
+            }
+        }
+
+        WHEN("The snapshot is read between changes of the store")
+        {
+            const auto readsAsItWas{[&snapshot, &milkProperty]
+                                    {
+                                        return TestUtils::collectIds(snapshot->query(milkProperty)) ==
+                                               std::unordered_set<std::int64_t>{0, 1} and
+                                               snapshot->queryCount(milkProperty) == 2 and
+                                               TestUtils::collectIds(snapshot->rangeQuery(1000.0, 1300.0)) ==
+                                               std::unordered_set<std::int64_t>{2, 3} and
+                                               snapshot->rangeCount(1000.0, 1300.0) == 2;
+                                    }};
+            store->update(0, {{titleKey, "Buy Cereals"s}});
+            REQUIRE(readsAsItWas());
+            store->update(2, {{timestampKey, 1250.0}});
+            REQUIRE(readsAsItWas());
+            REQUIRE_FALSE(snapshot->changedRange(1000.0, 1300.0));
+            store->update(2, {{timestampKey, 5000.0}});
+            REQUIRE(readsAsItWas());
+            store->remove(3);
+            store->insert(3, TestUtils::createProperties("Buy Milk"s, "again"s, 1200.0));
+            REQUIRE(readsAsItWas());
+            store->insert(123, TestUtils::createProperties("Buy Milk"s, "make of almonds!"s, 1100.0));
+            REQUIRE(readsAsItWas());
+            store->update(123, {{timestampKey, 5000.0}});
+            store->remove(123);
+
+            THEN("Every read returns the todos as they were")
+            {
+                REQUIRE(readsAsItWas());
+                REQUIRE(snapshot->changedTitle("Buy Milk"s));
+                REQUIRE(snapshot->changedRange(1000.0, 1300.0));
+                REQUIRE_FALSE(snapshot->changedRange(1100.0, 1100.0));
+                REQUIRE(snapshot->changedIds().size() == 4);
+            }
+
+            THEN("Many threads can read the snapshot at once")
+            {
+                std::vector<std::future<bool>> readers;
+                for(auto thread{0}; thread < 4; ++thread)
+                {
+                    readers.push_back(std::async(std::launch::async, readsAsItWas));
+                }
+                for(auto& reader : readers)
+                {
+                    REQUIRE(reader.get());
+                }
+            }
+        }
+
+        THEN("The snapshot cannot be changed")
+        {
+            REQUIRE_THROWS_AS(snapshot->update(0, {{titleKey, "Buy Cereals"s}}), std::runtime_error);
+            REQUIRE_THROWS_AS(snapshot->remove(0), std::runtime_error);
+        }
+    }
+}
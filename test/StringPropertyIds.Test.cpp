@@ -20,7 +20,7 @@ SCENARIO("Collect ids from string properties")
 
             THEN("A set of ids can be retrieved giving the property")
             {
-                const std::unordered_set<std::int64_t> expectedIds{0, 1};
+                const IdSet expectedIds{0, 1};
                 const auto ids{stringPropertyIds.getIds("Buy milk"s)};
                 REQUIRE(ids == expectedIds);
             }
@@ -34,14 +34,14 @@ SCENARIO("Collect ids from string properties")
 
                 THEN("The set of ids retrieved with the old property does not contain the id of the property updated")
                 {
-                    const std::unordered_set<std::int64_t> expectedIds{1};
+                    const IdSet expectedIds{1};
                     const auto ids{stringPropertyIds.getIds(oldPropertyValue)};
                     REQUIRE(ids == expectedIds);
                 }
 
                 THEN("A set of ids can be retrieved giving the new property")
                 {
-                    const std::unordered_set<std::int64_t> expectedIds{0};
+                    const IdSet expectedIds{0};
                     const auto ids{stringPropertyIds.getIds(newPropertyValue)};
                     REQUIRE(ids == expectedIds);
                 }
@@ -55,11 +55,30 @@ SCENARIO("Collect ids from string properties")
 
                 THEN("The id is not included when retrieving the ids of that property value")
                 {
-                    const std::unordered_set<std::int64_t> expectedIds{1};
+                    const IdSet expectedIds{1};
                     const auto ids{stringPropertyIds.getIds(propertyValue)};
                     REQUIRE(ids == expectedIds);
                 }
             }
+
+            AND_WHEN("The properties and ids of another container are removed and inserted")
+            {
+                StringPropertyIds removedIds;
+                removedIds.insert("Buy milk"s, 0);
+                removedIds.insert("Call mom"s, 2);
+                StringPropertyIds addedIds;
+                addedIds.insert("Buy milk"s, 2);
+                addedIds.insert("Clean the car"s, 0);
+                stringPropertyIds.remove(removedIds);
+                stringPropertyIds.insert(addedIds);
+
+                THEN("Every property has the ids of both containers applied")
+                {
+                    REQUIRE(stringPropertyIds.getIds("Buy milk"s) == IdSet{1, 2});
+                    REQUIRE(stringPropertyIds.getIds("Clean the car"s) == IdSet{0});
+                    REQUIRE(stringPropertyIds.getIds("Call mom"s).empty());
+                }
+            }
         }
     }
 }
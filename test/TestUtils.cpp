@@ -43,4 +43,9 @@ namespace TestUtils
         store.insert(id, todoProperty);
         return store;
     }
+
+    std::unordered_set<std::int64_t> collectIds(IdRange ids)
+    {
+        return {ids.begin(), ids.end()};
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ParentStore.h>
+#include <unordered_set>
 #include "Todo.h"
 
 using namespace std::string_literals;
@@ -12,4 +13,6 @@ namespace TestUtils
     TodoProperties createProperties(std::string title, std::string description, double timestamp);
 
     ParentStore createDummyParentStore();
+
+    std::unordered_set<std::int64_t> collectIds(IdRange ids);
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <stdexcept>
+#include "ThreadPool.h"
+
+SCENARIO("Thread pool")
+{
+    GIVEN("A thread pool with some workers")
+    {
+        ThreadPool pool{3};
+
+        WHEN("Running more tasks than workers")
+        {
+            std::vector<int> results(100, 0);
+            pool.run(results.size(), [&results](std::size_t task) { results[task] = int(task) * 2; });
+
+            THEN("Every task is run once before returning")
+            {
+                for(std::size_t task{0}; task < results.size(); ++task)
+                {
+                    REQUIRE(results[task] == int(task) * 2);
+                }
+            }
+        }
+
+        WHEN("A task throws")
+        {
+            std::atomic<int> runTasks{0};
+            const auto run{[&]
+            {
+                pool.run(10, [&runTasks](std::size_t task)
+                {
+                    ++runTasks;
+                    if(task == 5)
+                    {
+                        throw std::runtime_error("Task failed");
+                    }
+                });
+            }};
+
+            THEN("The exception is rethrown once every task is done")
+            {
+                REQUIRE_THROWS_AS(run(), std::runtime_error);
+                REQUIRE(runTasks == 10);
+            }
+        }
+
+        WHEN("Tasks run other fan-outs")
+        {
+            std::atomic<int> runTasks{0};
+            pool.run(4, [&pool, &runTasks](std::size_t)
+            {
+                pool.run(4, [&runTasks](std::size_t) { ++runTasks; });
+            });
+
+            THEN("They do not wait for busy workers")
+            {
+                REQUIRE(runTasks == 16);
+            }
+        }
+    }
+}
@@ -0,0 +1,198 @@
+#include <catch2/catch.hpp>
+#include <random>
+#include <set>
+#include "Arena.h"
+#include "TimestampTree.h"
+
+namespace
+{
+    using Entry = TimestampTree::Entry;
+
+    std::vector<Entry> toVector(const TimestampTree& tree)
+    {
+        return {tree.begin(), tree.end()};
+    }
+}
+
+SCENARIO("Timestamp B+-tree")
+{
+    GIVEN("An empty tree")
+    {
+        TimestampTree tree;
+
+        THEN("It has no entries")
+        {
+            REQUIRE(tree.empty());
+            REQUIRE(tree.begin() == tree.end());
+            REQUIRE(tree.lowerBound(0.0) == tree.end());
+        }
+
+        WHEN("Some entries are inserted")
+        {
+            tree.insert({300.0, 3});
+            tree.insert({100.0, 1});
+            tree.insert({200.0, 2});
+            tree.insert({100.0, 0});
+
+            THEN("They are iterated sorted by timestamp and id")
+            {
+                const std::vector<Entry> expectedEntries{{100.0, 0}, {100.0, 1}, {200.0, 2}, {300.0, 3}};
+                REQUIRE(toVector(tree) == expectedEntries);
+            }
+
+            THEN("Inserting an existing pair does nothing")
+            {
+                REQUIRE_FALSE(tree.insert({200.0, 2}));
+                REQUIRE(tree.size() == 4);
+            }
+
+            THEN("Ranges can be found with lower and upper bounds")
+            {
+                REQUIRE(*tree.lowerBound(150.0) == Entry{200.0, 2});
+                REQUIRE(*tree.upperBound(100.0) == Entry{200.0, 2});
+                REQUIRE(tree.upperBound(300.0) == tree.end());
+            }
+
+            THEN("Entries can be counted without iterating them")
+            {
+                REQUIRE(tree.rank({200.0, 2}) == 2);
+                REQUIRE(tree.count(100.0, 200.0) == 3);
+                REQUIRE(tree.count(150.0, 160.0) == 0);
+                REQUIRE(tree.count(300.0, 100.0) == 0);
+            }
+
+            THEN("The entries can be iterated backwards")
+            {
+                auto it{tree.end()};
+                REQUIRE(*--it == Entry{300.0, 3});
+                REQUIRE(*--it == Entry{200.0, 2});
+            }
+
+            AND_WHEN("An entry is erased")
+            {
+                REQUIRE(tree.erase({100.0, 1}));
+                REQUIRE_FALSE(tree.erase({100.0, 1}));
+
+                THEN("It is not iterated anymore")
+                {
+                    const std::vector<Entry> expectedEntries{{100.0, 0}, {200.0, 2}, {300.0, 3}};
+                    REQUIRE(toVector(tree) == expectedEntries);
+                }
+            }
+        }
+    }
+
+    GIVEN("A tree with many random insertions and removals")
+    {
+        TimestampTree tree;
+        std::set<Entry> expectedEntries;
+        std::mt19937_64 random{42};
+        std::uniform_int_distribution<int> timestamps{0, 2000};
+        std::uniform_int_distribution<std::int64_t> ids{0, 50};
+        for(auto i{0}; i < 60000; ++i)
+        {
+            const Entry entry{double(timestamps(random)), ids(random)};
+            // insert twice as often as erase at the beginning, and the other way around at the end
+            if(random() % 3 < (i < 30000 ? 2u : 1u))
+            {
+                REQUIRE(tree.insert(entry) == expectedEntries.insert(entry).second);
+            } else
+            {
+                REQUIRE(tree.erase(entry) == (expectedEntries.erase(entry) == 1));
+            }
+        }
+
+        THEN("It keeps the same entries than an ordered set")
+        {
+            REQUIRE(tree.size() == expectedEntries.size());
+            REQUIRE(toVector(tree) == std::vector<Entry>{expectedEntries.begin(), expectedEntries.end()});
+        }
+
+        THEN("Every range is read in order")
+        {
+            for(auto timestamp{0.0}; timestamp < 2000.0; timestamp += 97.0)
+            {
+                const std::vector<Entry> range{tree.lowerBound(timestamp), tree.upperBound(timestamp + 50.0)};
+                const std::vector<Entry> expectedRange{expectedEntries.lower_bound({timestamp, 0}),
+                                                       expectedEntries.upper_bound({timestamp + 50.0, 1000})};
+                REQUIRE(range == expectedRange);
+            }
+        }
+
+        THEN("Every range is counted as in the ordered set")
+        {
+            for(auto timestamp{0.0}; timestamp < 2000.0; timestamp += 97.0)
+            {
+                const auto expectedCount{std::distance(expectedEntries.lower_bound({timestamp, 0}),
+                                                       expectedEntries.upper_bound({timestamp + 50.0, 1000}))};
+                REQUIRE(tree.count(timestamp, timestamp + 50.0) == std::size_t(expectedCount));
+            }
+            REQUIRE(tree.count(0.0, 2000.0) == expectedEntries.size());
+        }
+
+        THEN("A copy has the same entries")
+        {
+            const auto copy{tree};
+            REQUIRE(toVector(copy) == toVector(tree));
+        }
+
+        WHEN("Every entry is erased")
+        {
+            for(const auto& entry : expectedEntries)
+            {
+                REQUIRE(tree.erase(entry));
+            }
+
+            THEN("The tree is empty")
+            {
+                REQUIRE(tree.empty());
+                REQUIRE(tree.begin() == tree.end());
+            }
+        }
+    }
+
+    GIVEN("A tree built from sorted entries")
+    {
+        std::vector<Entry> sortedEntries;
+        for(std::int64_t id{0}; id < 10000; ++id)
+        {
+            sortedEntries.push_back({double(id / 3), id});
+        }
+        TimestampTree tree;
+        tree.assignSorted(sortedEntries);
+
+        THEN("It has the same entries and can keep changing")
+        {
+            REQUIRE(toVector(tree) == sortedEntries);
+            REQUIRE(tree.insert({-1.0, 0}));
+            REQUIRE(tree.erase({0.0, 0}));
+            REQUIRE(tree.begin()->timestamp == -1.0);
+            REQUIRE(tree.size() == sortedEntries.size());
+            REQUIRE(tree.count(0.0, 9.0) == 29);
+            REQUIRE(tree.rank({3000.0, 9000}) == 9000);
+        }
+    }
+
+    GIVEN("A tree allocated from an arena")
+    {
+        Arena arena;
+        TimestampTree tree{&arena};
+        for(std::int64_t id{0}; id < 1000; ++id)
+        {
+            tree.insert({double(id % 100), id});
+        }
+
+        THEN("Its nodes are taken from the arena and it keeps changing like any other tree")
+        {
+            REQUIRE(arena.used() >= 1000 * sizeof(Entry));
+            for(std::int64_t id{0}; id < 1000; id += 2)
+            {
+                REQUIRE(tree.erase({double(id % 100), id}));
+            }
+            REQUIRE(tree.size() == 500);
+            REQUIRE(tree.count(0.0, 9.0) == 50);
+            const TimestampTree copy{tree, &arena};
+            REQUIRE(toVector(copy) == toVector(tree));
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+#include "TodoColumns.h"
+
+using namespace std::string_literals;
+
+SCENARIO("Columnar todo storage")
+{
+    GIVEN("An empty todo columns container")
+    {
+        TodoColumns columns;
+
+        WHEN("Three todos are inserted")
+        {
+            const auto firstSlot{columns.insert({10, "Buy Milk"s, "make of almonds!"s, 100.0})};
+            const auto secondSlot{columns.insert({20, "Call mom"s, "is her birthday"s, 200.0})};
+            columns.insert({30, "Study Chinese"s, "worth it!"s, 300.0});
+
+            THEN("The properties of every todo can be retrieved by slot")
+            {
+                REQUIRE(columns.size() == 3);
+                REQUIRE(columns.find(20) == secondSlot);
+                REQUIRE(columns.id(secondSlot) == 20);
+                REQUIRE(columns.title(secondSlot) == "Call mom"s);
+                REQUIRE(columns.description(secondSlot) == "is her birthday"s);
+                REQUIRE(columns.timestamp(secondSlot) == 200.0);
+            }
+
+            THEN("The timestamp column can be scanned on its own")
+            {
+                const auto& timestamps{columns.timestampColumn()};
+                const std::vector<double> expectedTimestamps{100.0, 200.0, 300.0};
+                REQUIRE(timestamps == expectedTimestamps);
+            }
+
+            THEN("An id that was not inserted is not found")
+            {
+                REQUIRE(columns.find(40) == TodoColumns::npos);
+            }
+
+            AND_WHEN("A todo is removed")
+            {
+                columns.erase(firstSlot);
+
+                THEN("The todo is not found anymore")
+                {
+                    REQUIRE(columns.find(10) == TodoColumns::npos);
+                    REQUIRE_FALSE(columns.occupied(firstSlot));
+                    REQUIRE(columns.size() == 2);
+                }
+
+                AND_WHEN("A new todo is inserted")
+                {
+                    const auto newSlot{columns.insert({40, "Clean the car"s, "before the wedding"s, 400.0})};
+
+                    THEN("The slot of the removed todo is reused")
+                    {
+                        REQUIRE(newSlot == firstSlot);
+                        REQUIRE(columns.slotCount() == 3);
+                        REQUIRE(columns.title(newSlot) == "Clean the car"s);
+                    }
+                }
+            }
+
+            AND_WHEN("An existing id is inserted again")
+            {
+                const auto slot{columns.insert({20, "Call dad"s, "it is not his birthday"s, 250.0})};
+
+                THEN("The todo keeps its slot and gets the new values")
+                {
+                    REQUIRE(slot == secondSlot);
+                    REQUIRE(columns.size() == 3);
+                    REQUIRE(columns.title(slot) == "Call dad"s);
+                    REQUIRE(columns.timestamp(slot) == 250.0);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch.hpp>
+#include "TodoPatch.h"
+
+using namespace std::string_literals;
+
+SCENARIO("Typed todo patches")
+{
+    GIVEN("A patch with some properties")
+    {
+        auto patch{TodoPatch{}.setTitle("Buy Milk"s).setTimestamp(100.0)};
+
+        THEN("Only those properties are present")
+        {
+            REQUIRE(patch.has(TodoPropertyId::title));
+            REQUIRE_FALSE(patch.has(TodoPropertyId::description));
+            REQUIRE(patch.has(TodoPropertyId::timestamp));
+            REQUIRE_FALSE(patch.complete());
+        }
+
+        THEN("Only those properties are applied to a todo")
+        {
+            Todo todo{1, "Call mom"s, "is her birthday"s, 0.0};
+            patch.applyTo(todo);
+            REQUIRE(todo.title == "Buy Milk"s);
+            REQUIRE(todo.description == "is her birthday"s);
+            REQUIRE(todo.timestamp == 100.0);
+        }
+
+        WHEN("Another patch is merged")
+        {
+            patch.merge(TodoPatch{}.setDescription("make of almonds!"s).setTimestamp(200.0));
+
+            THEN("It has the properties of both, the ones of the last patch first")
+            {
+                REQUIRE(patch.complete());
+                REQUIRE(patch.title == "Buy Milk"s);
+                REQUIRE(patch.description == "make of almonds!"s);
+                REQUIRE(patch.timestamp == 200.0);
+            }
+        }
+    }
+
+    GIVEN("String keyed properties")
+    {
+        const TodoProperties properties{{titleKey, "Buy Milk"s}, {timestampKey, 100.0}};
+
+        THEN("They are converted to a patch and back")
+        {
+            const auto patch{TodoPatch::fromProperties(properties)};
+            REQUIRE(patch.present == (propertyBit(TodoPropertyId::title) | propertyBit(TodoPropertyId::timestamp)));
+            REQUIRE(patch.toProperties() == properties);
+        }
+
+        THEN("Unknown properties are not accepted")
+        {
+            const TodoProperties unknownProperties{{"priority", 1.0}};
+            REQUIRE_THROWS_AS(TodoPatch::fromProperties(unknownProperties), std::invalid_argument);
+        }
+    }
+}
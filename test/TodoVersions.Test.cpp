@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+#include "TodoVersions.h"
+
+using namespace std::string_literals;
+
+SCENARIO("Todo versions")
+{
+    GIVEN("Versions without pinned snapshots")
+    {
+        TodoVersions versions;
+        versions.next();
+
+        THEN("Old versions are not kept")
+        {
+            REQUIRE_FALSE(versions.mustKeep(1));
+        }
+
+        WHEN("A version is pinned and a todo changes twice")
+        {
+            const auto pinnedVersion{versions.pin()};
+            versions.next();
+            REQUIRE(versions.mustKeep(1));
+            versions.keep(1, Todo{1, "Buy Milk"s, "make of almonds!"s, 100.0});
+            versions.next();
+
+            THEN("Only the todo read by the snapshot is kept")
+            {
+                REQUIRE_FALSE(versions.mustKeep(1));
+                REQUIRE(versions.find(1, pinnedVersion)->todo->title == "Buy Milk");
+                REQUIRE(versions.find(1, versions.current()) == nullptr);
+                REQUIRE(versions.find(2, pinnedVersion) == nullptr);
+            }
+
+            THEN("The changed todos are visited once")
+            {
+                std::vector<std::int64_t> changedIds;
+                versions.forEachChangedSince(pinnedVersion, [&changedIds](std::int64_t id, const std::optional<Todo>&)
+                {
+                    changedIds.push_back(id);
+                });
+                REQUIRE(changedIds == std::vector<std::int64_t>{1});
+            }
+
+            AND_WHEN("The changes are logged, even the ones whose old version is not kept")
+            {
+                versions.log(1);
+                const auto firstChange{versions.current()};
+                versions.next();
+                versions.log(1);
+                versions.log(2);
+
+                THEN("Every change after a version is visited")
+                {
+                    std::vector<std::int64_t> changedIds;
+                    versions.forEachChangeAfter(firstChange, [&changedIds](std::int64_t id)
+                    {
+                        changedIds.push_back(id);
+                    });
+                    REQUIRE(changedIds == std::vector<std::int64_t>{1, 2});
+                }
+            }
+
+            AND_WHEN("Another version is pinned and the todo is removed")
+            {
+                const auto secondPinnedVersion{versions.pin()};
+                versions.next();
+                REQUIRE(versions.mustKeep(1));
+                versions.keep(1, Todo{1, "Buy Cereals"s, "make of almonds!"s, 100.0});
+
+                THEN("Every snapshot reads its own version")
+                {
+                    REQUIRE(versions.find(1, pinnedVersion)->todo->title == "Buy Milk");
+                    REQUIRE(versions.find(1, secondPinnedVersion)->todo->title == "Buy Cereals");
+                }
+
+                THEN("The old versions are discarded once no snapshot reads them")
+                {
+                    versions.unpin(pinnedVersion);
+                    REQUIRE(versions.size() == 1);
+                    REQUIRE(versions.find(1, secondPinnedVersion)->todo->title == "Buy Cereals");
+                    versions.unpin(secondPinnedVersion);
+                    REQUIRE(versions.size() == 0);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,223 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <ChildStore.h>
+#include <GroupCommit.h>
+#include <ParentStore.h>
+#include <WriteAheadLog.h>
+#include "TestUtils.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+    std::string freshLogPath()
+    {
+        const auto path{std::filesystem::temp_directory_path() / "todo_store_write_ahead_log.test"};
+        std::filesystem::remove(path);
+        return path.string();
+    }
+
+    std::shared_ptr<ChildStore> createChild(ParentStore& store)
+    {
+        return std::shared_ptr<ChildStore>{static_cast<ChildStore*>(store.createChild().release())};
+    }
+
+    std::vector<Todo> createTodos(std::int64_t firstId, std::int64_t count)
+    {
+        std::vector<Todo> todos;
+        for(auto id{firstId}; id < firstId + count; ++id)
+        {
+            todos.push_back(Todo{id, id % 2 == 0 ? "Buy Milk"s : "Call mom"s, "soon"s, double(id)});
+        }
+        return todos;
+    }
+}
+
+SCENARIO("Write-ahead log")
+{
+    const TodoProperty milkProperty{titleKey, "Buy Milk"s};
+
+    GIVEN("A store opened from a log that does not exist")
+    {
+        const auto path{freshLogPath()};
+        auto store{ParentStore::open(path)};
+
+        THEN("The store is empty")
+        {
+            REQUIRE_FALSE(store->checkId(0));
+            REQUIRE(store->version() == 0);
+        }
+
+        WHEN("The store is changed and opened again from its log")
+        {
+            store->insertBatch(createTodos(0, 10));
+            store->insert(10, TodoPatch{}.setTitle("Buy Milk"s).setDescription("later"s).setTimestamp(10.0));
+            store->update(1, TodoPatch{}.setTitle("Buy Milk"s));
+            store->update(2, TodoProperties{{timestampKey, 20.0}});
+            store->remove(3);
+            auto child{createChild(*store)};
+            child->insert(11, TodoPatch{}.setTitle("Call mom"s).setDescription("today"s).setTimestamp(11.0));
+            child->update(4, TodoPatch{}.setDescription("now"s));
+            child->remove(5);
+            child->commit();
+            GroupCommit group{store};
+            auto firstChild{createChild(*store)};
+            auto secondChild{createChild(*store)};
+            firstChild->update(6, TodoPatch{}.setTitle("Call mom"s));
+            secondChild->remove(7);
+            group.add(firstChild);
+            group.add(secondChild);
+            group.commit();
+            const auto version{store->version()};
+            store.reset();
+            const auto reopened{ParentStore::open(path)};
+
+            THEN("Every change is recovered, each commit as a single version")
+            {
+                REQUIRE(reopened->version() == version);
+                REQUIRE(std::get<std::string>(reopened->get(1).at(titleKey)) == "Buy Milk");
+                REQUIRE(std::get<double>(reopened->get(2).at(timestampKey)) == 20.0);
+                REQUIRE_FALSE(reopened->checkId(3));
+                REQUIRE(std::get<std::string>(reopened->get(4).at(descriptionKey)) == "now");
+                REQUIRE_FALSE(reopened->checkId(5));
+                REQUIRE(std::get<std::string>(reopened->get(6).at(titleKey)) == "Call mom");
+                REQUIRE_FALSE(reopened->checkId(7));
+                REQUIRE(std::get<std::string>(reopened->get(10).at(descriptionKey)) == "later");
+                REQUIRE(reopened->checkId(11));
+            }
+
+            THEN("The indexes are rebuilt")
+            {
+                const std::unordered_set<std::int64_t> expectedIds{0, 1, 2, 4, 8, 10};
+                REQUIRE(TestUtils::collectIds(reopened->query(milkProperty)) == expectedIds);
+                REQUIRE(reopened->rangeCount(0.0, 11.0) == 8);
+                REQUIRE(reopened->rangeCount(20.0, 20.0) == 1);
+            }
+
+            AND_WHEN("The reopened store is changed and opened again")
+            {
+                reopened->remove(0);
+                reopened->update(8, TodoPatch{}.setTitle("Call mom"s));
+                const auto reopenedAgain{ParentStore::open(path)};
+
+                THEN("The changes are appended after the recovered ones")
+                {
+                    REQUIRE(reopenedAgain->version() == version + 2);
+                    REQUIRE(reopenedAgain->queryCount(milkProperty) == 4);
+                }
+            }
+        }
+
+        WHEN("A change is invalid")
+        {
+            store->insertBatch(createTodos(0, 10));
+            const auto size{WriteAheadLog{path}.size()};
+            REQUIRE_THROWS_AS(store->update(100, TodoPatch{}.setTitle("Buy Milk"s)), std::invalid_argument);
+            REQUIRE_THROWS_AS(store->remove(100), std::invalid_argument);
+            REQUIRE_THROWS_AS(store->insert(100, TodoPatch{}.setTitle("Buy Milk"s)), std::invalid_argument);
+            auto child{createChild(*store)};
+            child->update(100, TodoPatch{}.setTitle("Buy Milk"s));
+            REQUIRE_THROWS_AS(child->commit(), std::invalid_argument);
+
+            THEN("It is not logged")
+            {
+                REQUIRE(WriteAheadLog{path}.size() == size);
+                store.reset();
+                REQUIRE(ParentStore::open(path)->version() == 1);
+            }
+        }
+    }
+
+    GIVEN("A log whose last record was torn by a crash")
+    {
+        const auto path{freshLogPath()};
+        std::uintmax_t completeSize;
+        {
+            auto store{ParentStore::open(path)};
+            store->insertBatch(createTodos(0, 10));
+            store->update(0, TodoPatch{}.setTitle("Call mom"s));
+            completeSize = std::filesystem::file_size(path);
+            store->update(1, TodoPatch{}.setTitle("Buy Milk"s).setDescription("never synced"s));
+        }
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+        WHEN("The store is opened from it")
+        {
+            ParentStore store;
+            const auto records{WriteAheadLog::replay(path, store)};
+
+            THEN("The complete records are replayed and the torn one is cut off")
+            {
+                REQUIRE(records == 2);
+                REQUIRE(store.version() == 2);
+                REQUIRE(std::get<std::string>(store.get(0).at(titleKey)) == "Call mom");
+                REQUIRE(std::get<std::string>(store.get(1).at(descriptionKey)) == "soon");
+                REQUIRE(std::filesystem::file_size(path) == completeSize);
+            }
+
+            AND_WHEN("The store is changed and opened again")
+            {
+                {
+                    auto reopened{ParentStore::open(path)};
+                    reopened->remove(9);
+                }
+                const auto reopened{ParentStore::open(path)};
+
+                THEN("The new change follows the complete records")
+                {
+                    REQUIRE(reopened->version() == 3);
+                    REQUIRE_FALSE(reopened->checkId(9));
+                }
+            }
+        }
+    }
+
+    GIVEN("A log whose record was corrupted")
+    {
+        const auto path{freshLogPath()};
+        {
+            auto store{ParentStore::open(path)};
+            store->insertBatch(createTodos(0, 10));
+            store->remove(0);
+        }
+        {
+            std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+            file.seekp(-1, std::ios::end);
+            file.put('\x7f');
+        }
+
+        THEN("The records from the corrupted one are not replayed")
+        {
+            const auto store{ParentStore::open(path)};
+            REQUIRE(store->version() == 1);
+            REQUIRE(store->checkId(0));
+        }
+    }
+
+    GIVEN("The sync policies")
+    {
+        const auto policy{GENERATE(WriteAheadLog::SyncPolicy::everyCommit, WriteAheadLog::SyncPolicy::interval,
+                                   WriteAheadLog::SyncPolicy::none)};
+        const auto path{freshLogPath()};
+
+        WHEN("A store logging with the policy is changed and opened again")
+        {
+            {
+                auto store{ParentStore::open(path, {policy, std::chrono::milliseconds{1}})};
+                store->insertBatch(createTodos(0, 10));
+                for(std::int64_t id{0}; id < 10; ++id)
+                {
+                    store->update(id, TodoPatch{}.setTimestamp(100.0 + id));
+                }
+            }
+            const auto store{ParentStore::open(path)};
+
+            THEN("Every change is recovered")
+            {
+                REQUIRE(store->version() == 11);
+                REQUIRE(store->rangeCount(100.0, 109.0) == 10);
+            }
+        }
+    }
+}
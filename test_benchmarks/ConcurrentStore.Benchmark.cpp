@@ -0,0 +1,243 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ParentStore.h>
+#include <ConcurrentParentStore.h>
+
+using namespace std::string_literals;
+
+namespace
+{
+    constexpr std::int64_t concurrentTodos{10000};
+    // every run does the same total work, split between the threads
+    constexpr std::int64_t operationsPerRun{64000};
+
+    template<typename StoreType>
+    void fillStore(StoreType& store)
+    {
+        for(std::int64_t id{0}; id < concurrentTodos; ++id)
+        {
+            store.insert(id, TodoPatch{}.setTitle(id % 10 == 0 ? "Buy Milk"s : "Call mom"s)
+                                        .setDescription("make of almonds!"s)
+                                        .setTimestamp(double(id)));
+        }
+    }
+
+    /**
+     * Runs operation(thread, operationIndex) operationsPerRun times split between threadCount threads.
+     */
+    template<typename Operation>
+    std::int64_t runInThreads(int threadCount, Operation operation)
+    {
+        std::vector<std::int64_t> sums(threadCount);
+        std::vector<std::thread> threads;
+        for(auto thread{0}; thread < threadCount; ++thread)
+        {
+            threads.emplace_back([&sums, &operation, thread, threadCount]
+            {
+                for(auto i{std::int64_t(thread)}; i < operationsPerRun; i += threadCount)
+                {
+                    sums[thread] += operation(thread, i);
+                }
+            });
+        }
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+        std::int64_t sum{0};
+        for(const auto threadSum : sums)
+        {
+            sum += threadSum;
+        }
+        return sum;
+    }
+
+    std::int64_t todoId(std::int64_t operationIndex)
+    {
+        // spread the ids so the threads do not read the same todos in lockstep
+        return (operationIndex * 7919) % concurrentTodos;
+    }
+
+    /**
+     * Times every get of readerCount threads while writerCount threads keep updating, and returns the
+     * given percentile of the latencies in nanoseconds.
+     */
+    template<typename Get, typename Update>
+    std::int64_t getLatencyUnderWrites(int readerCount, int writerCount, double percentile, Get get, Update update)
+    {
+        constexpr std::int64_t getsPerReader{20000};
+        std::atomic<bool> done{false};
+        std::vector<std::thread> writers;
+        for(auto writer{0}; writer < writerCount; ++writer)
+        {
+            writers.emplace_back([&done, &update, writer]
+            {
+                for(std::int64_t i{writer}; not done; ++i)
+                {
+                    update(todoId(i));
+                }
+            });
+        }
+        std::vector<std::vector<std::int64_t>> latencies(readerCount);
+        std::vector<std::thread> readers;
+        for(auto reader{0}; reader < readerCount; ++reader)
+        {
+            readers.emplace_back([&latencies, &get, reader]
+            {
+                latencies[reader].reserve(getsPerReader);
+                for(std::int64_t i{0}; i < getsPerReader; ++i)
+                {
+                    const auto start{std::chrono::steady_clock::now()};
+                    get(todoId(i + reader));
+                    const auto end{std::chrono::steady_clock::now()};
+                    const auto latency{std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)};
+                    latencies[reader].push_back(latency.count());
+                }
+            });
+        }
+        for(auto& reader : readers)
+        {
+            reader.join();
+        }
+        done = true;
+        for(auto& writer : writers)
+        {
+            writer.join();
+        }
+        std::vector<std::int64_t> allLatencies;
+        for(const auto& readerLatencies : latencies)
+        {
+            allLatencies.insert(allLatencies.end(), readerLatencies.begin(), readerLatencies.end());
+        }
+        const auto position{std::size_t(percentile * double(allLatencies.size() - 1))};
+        std::nth_element(allLatencies.begin(), allLatencies.begin() + position, allLatencies.end());
+        return allLatencies[position];
+    }
+}
+
+TEST_CASE("Concurrent store scaling")
+{
+    ParentStore lockedStore;
+    std::mutex lockedStoreMutex;
+    fillStore(lockedStore);
+    ConcurrentParentStore concurrentStore;
+    fillStore(concurrentStore);
+    WARN("Hardware threads: " << std::thread::hardware_concurrency());
+
+    for(const auto threadCount : {1, 2, 4, 8, 16, 32})
+    {
+        const auto threads{" with "s + std::to_string(threadCount) + " threads"};
+
+        BENCHMARK("getting todos from a store behind a mutex" + threads)
+                    {
+                        return runInThreads(threadCount, [&](int, std::int64_t i)
+                        {
+                            Todo todo;
+                            const std::lock_guard<std::mutex> lock{lockedStoreMutex};
+                            lockedStore.get(todoId(i), todo);
+                            return std::int64_t(todo.timestamp);
+                        });
+                    };
+
+        BENCHMARK("getting todos from a concurrent store" + threads)
+                    {
+                        return runInThreads(threadCount, [&](int, std::int64_t i)
+                        {
+                            Todo todo;
+                            concurrentStore.get(todoId(i), todo);
+                            return std::int64_t(todo.timestamp);
+                        });
+                    };
+
+        BENCHMARK("checking ids and counting titles in a concurrent store" + threads)
+                    {
+                        return runInThreads(threadCount, [&](int, std::int64_t i)
+                        {
+                            return std::int64_t(concurrentStore.checkId(todoId(i))) +
+                                   std::int64_t(concurrentStore.queryCount({titleKey, "Buy Milk"s}));
+                        });
+                    };
+
+        BENCHMARK("95% gets and 5% updates in a store behind a mutex" + threads)
+                    {
+                        return runInThreads(threadCount, [&](int, std::int64_t i)
+                        {
+                            Todo todo;
+                            const std::lock_guard<std::mutex> lock{lockedStoreMutex};
+                            if(i % 20 == 0)
+                            {
+                                lockedStore.update(todoId(i), TodoPatch{}.setDescription("make of oats!"s));
+                                return std::int64_t{0};
+                            }
+                            lockedStore.get(todoId(i), todo);
+                            return std::int64_t(todo.timestamp);
+                        });
+                    };
+
+        BENCHMARK("95% gets and 5% updates in a concurrent store" + threads)
+                    {
+                        return runInThreads(threadCount, [&](int, std::int64_t i)
+                        {
+                            Todo todo;
+                            if(i % 20 == 0)
+                            {
+                                concurrentStore.update(todoId(i), TodoPatch{}.setDescription("make of oats!"s));
+                                return std::int64_t{0};
+                            }
+                            concurrentStore.get(todoId(i), todo);
+                            return std::int64_t(todo.timestamp);
+                        });
+                    };
+    }
+}
+
+TEST_CASE("Concurrent store get latency under writes")
+{
+    ParentStore lockedStore;
+    std::mutex lockedStoreMutex;
+    fillStore(lockedStore);
+    ConcurrentParentStore concurrentStore;
+    fillStore(concurrentStore);
+
+    const auto lockedGet{[&](std::int64_t id)
+    {
+        Todo todo;
+        const std::lock_guard<std::mutex> lock{lockedStoreMutex};
+        lockedStore.get(id, todo);
+    }};
+    const auto lockedUpdate{[&](std::int64_t id)
+    {
+        const std::lock_guard<std::mutex> lock{lockedStoreMutex};
+        lockedStore.update(id, TodoPatch{}.setDescription("make of oats!"s));
+    }};
+    const auto concurrentGet{[&](std::int64_t id)
+    {
+        Todo todo;
+        concurrentStore.get(id, todo);
+    }};
+    const auto concurrentUpdate{[&](std::int64_t id)
+    {
+        concurrentStore.update(id, TodoPatch{}.setDescription("make of oats!"s));
+    }};
+
+    // Catch only reports means, the tail latency is what readers racing with writers suffer
+    for(const auto readerCount : {1, 4, 16})
+    {
+        WARN("p50/p99 get ns, " << readerCount << " readers and 2 writers, store behind a mutex: "
+             << getLatencyUnderWrites(readerCount, 2, 0.5, lockedGet, lockedUpdate) << "/"
+             << getLatencyUnderWrites(readerCount, 2, 0.99, lockedGet, lockedUpdate));
+        WARN("p50/p99 get ns, " << readerCount << " readers and 2 writers, concurrent store: "
+             << getLatencyUnderWrites(readerCount, 2, 0.5, concurrentGet, concurrentUpdate) << "/"
+             << getLatencyUnderWrites(readerCount, 2, 0.99, concurrentGet, concurrentUpdate));
+    }
+    WARN("p50/p99 get ns, 1 reader and no writers, concurrent store: "
+         << getLatencyUnderWrites(1, 0, 0.5, concurrentGet, concurrentUpdate) << "/"
+         << getLatencyUnderWrites(1, 0, 0.99, concurrentGet, concurrentUpdate));
+}
@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "FlatIdMap.h"
+
+constexpr auto totalIds{1000000};
+
+namespace
+{
+    std::size_t allocatedBytes{0};
+
+    /**
+     * Counts the bytes requested by the std::unordered_map so its memory per entry can be reported.
+     */
+    template<typename T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+        CountingAllocator() = default;
+        template<typename U>
+        CountingAllocator(const CountingAllocator<U>&) {}
+
+        T* allocate(std::size_t n)
+        {
+            allocatedBytes += n * sizeof(T);
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* pointer, std::size_t n)
+        {
+            allocatedBytes -= n * sizeof(T);
+            std::allocator<T>{}.deallocate(pointer, n);
+        }
+
+        template<typename U>
+        bool operator==(const CountingAllocator<U>&) const { return true; }
+        template<typename U>
+        bool operator!=(const CountingAllocator<U>&) const { return false; }
+    };
+
+    std::vector<std::int64_t> shuffledIds(std::uint64_t seed)
+    {
+        std::vector<std::int64_t> ids(totalIds);
+        for(std::int64_t id{0}; id < totalIds; ++id)
+        {
+            ids[id] = id * 7;
+        }
+        std::shuffle(ids.begin(), ids.end(), std::mt19937_64{seed});
+        return ids;
+    }
+}
+
+TEST_CASE("Primary index with 1M ids")
+{
+    using UnorderedMap = std::unordered_map<std::int64_t, std::size_t, std::hash<std::int64_t>,
+            std::equal_to<>, CountingAllocator<std::pair<const std::int64_t, std::size_t>>>;
+    const auto ids{shuffledIds(42)};
+    // looking up in a different order than the insertion one, so node allocation order does not help the lookups
+    const auto lookupIds{shuffledIds(7)};
+
+    UnorderedMap unorderedMap;
+    FlatIdMap<std::size_t> flatMap;
+    for(std::size_t slot{0}; slot < ids.size(); ++slot)
+    {
+        unorderedMap[ids[slot]] = slot;
+        flatMap[ids[slot]] = slot;
+    }
+
+    WARN("std::unordered_map bytes per entry: " << double(allocatedBytes) / totalIds);
+    // 1M ids is just above the 7/8 load limit of 2^20 slots, so this is the worst case for the flat table
+    WARN("FlatIdMap bytes per entry: " << double(flatMap.memoryUsage()) / totalIds);
+
+    // the position keeps moving between samples, so every lookup hits a cold id
+    std::size_t next{0};
+    BENCHMARK_ADVANCED("std::unordered_map point lookup")(Catch::Benchmark::Chronometer meter)
+                {
+                    meter.measure([&] { return unorderedMap.find(lookupIds[next++ % totalIds])->second; });
+                };
+
+    BENCHMARK_ADVANCED("FlatIdMap point lookup")(Catch::Benchmark::Chronometer meter)
+                {
+                    meter.measure([&] { return flatMap.find(lookupIds[next++ % totalIds])->second; });
+                };
+
+    BENCHMARK_ADVANCED("std::unordered_map missing id lookup")(Catch::Benchmark::Chronometer meter)
+                {
+                    meter.measure([&] { return unorderedMap.count(lookupIds[next++ % totalIds] + 1); });
+                };
+
+    BENCHMARK_ADVANCED("FlatIdMap missing id lookup")(Catch::Benchmark::Chronometer meter)
+                {
+                    meter.measure([&] { return flatMap.count(lookupIds[next++ % totalIds] + 1); });
+                };
+}
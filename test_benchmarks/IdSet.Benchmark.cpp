@@ -0,0 +1,54 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <unordered_set>
+#include "IdSet.h"
+
+constexpr auto totalTodos{1000};
+
+TEST_CASE("IdSet")
+{
+    std::unordered_set<std::int64_t> unorderedIds;
+    IdSet ids;
+    for(int i=0; i < totalTodos; i++)
+    {
+        unorderedIds.insert(i);
+        ids.insert(i);
+    }
+    const IdSet singleId{42};
+    const std::unordered_set<std::int64_t> unorderedSingleId{42};
+
+    // node (next pointer + id, cached hash not needed for integers) plus one bucket pointer per id
+    WARN("std::unordered_set bytes per id: " <<
+         double(unorderedIds.size() * 2 * sizeof(void*) + unorderedIds.bucket_count() * sizeof(void*)) / totalTodos);
+    WARN("IdSet bytes per id: " << double(ids.memoryUsage()) / totalTodos);
+
+    BENCHMARK("copying 1 id std::unordered_set")
+                {
+                    return std::unordered_set<std::int64_t>(unorderedSingleId);
+                };
+
+    BENCHMARK("copying 1 id IdSet")
+                {
+                    return IdSet(singleId);
+                };
+
+    BENCHMARK("copying 1000 ids std::unordered_set")
+                {
+                    return std::unordered_set<std::int64_t>(unorderedIds);
+                };
+
+    BENCHMARK("copying 1000 ids IdSet")
+                {
+                    return IdSet(ids);
+                };
+
+    BENCHMARK("inserting IdSet")
+                {
+                    return ids.insert(totalTodos);
+                };
+
+    BENCHMARK("removing IdSet")
+                {
+                    return ids.erase(totalTodos);
+                };
+}
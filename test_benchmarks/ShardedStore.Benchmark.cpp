@@ -0,0 +1,95 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ParentStore.h>
+#include <ShardedStore.h>
+
+using namespace std::string_literals;
+
+namespace
+{
+    constexpr std::int64_t shardedTodos{100000};
+
+    std::vector<Todo> createTodos()
+    {
+        std::vector<Todo> todos;
+        todos.reserve(shardedTodos);
+        for(std::int64_t id{0}; id < shardedTodos; ++id)
+        {
+            todos.push_back({id, id % 10 == 0 ? "Buy Milk"s : "Call mom"s, "make of almonds!"s, double(id)});
+        }
+        return todos;
+    }
+
+    std::int64_t sumIds(IdRange ids)
+    {
+        std::int64_t sum{0};
+        for(const auto id : ids)
+        {
+            sum += id;
+        }
+        return sum;
+    }
+}
+
+TEST_CASE("Sharded store")
+{
+    const auto todos{createTodos()};
+    WARN("Hardware threads: " << std::thread::hardware_concurrency());
+
+    BENCHMARK("ingesting 100000 todos in a parent store")
+                {
+                    ParentStore store;
+                    store.insertBatch(todos);
+                    return store.checkId(0);
+                };
+
+    auto parentStore{std::make_shared<ParentStore>()};
+    parentStore->insertBatch(todos);
+
+    BENCHMARK("range querying 50000 todos of a parent store")
+                {
+                    return sumIds(parentStore->rangeQuery(25000.0, 74999.0));
+                };
+
+    for(const std::size_t shardCount : {1, 2, 4, 8})
+    {
+        const auto shards{" with "s + std::to_string(shardCount) + " shards"};
+
+        BENCHMARK("ingesting 100000 todos in a sharded store" + shards)
+                    {
+                        ShardedStore store{shardCount};
+                        store.insertBatch(todos);
+                        return store.checkId(0);
+                    };
+
+        auto store{std::make_shared<ShardedStore>(shardCount)};
+        store->insertBatch(todos);
+
+        BENCHMARK("range querying 50000 todos of a sharded store" + shards)
+                    {
+                        return sumIds(store->rangeQuery(25000.0, 74999.0));
+                    };
+
+        BENCHMARK("querying 10000 todos by title of a sharded store" + shards)
+                    {
+                        return sumIds(store->query({titleKey, "Buy Milk"s}));
+                    };
+
+        BENCHMARK("getting a todo from a sharded store" + shards)
+                    {
+                        return store->checkId(4242);
+                    };
+
+        BENCHMARK("committing a transaction updating 2 todos of a sharded store" + shards)
+                    {
+                        auto transaction{store->createChild()};
+                        transaction->update(10, TodoPatch{}.setDescription("make of oats!"s));
+                        transaction->update(11, TodoPatch{}.setDescription("make of oats!"s));
+                        transaction->commit();
+                        return transaction->checkId(10);
+                    };
+    }
+}
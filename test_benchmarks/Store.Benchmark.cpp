@@ -1,7 +1,12 @@
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <filesystem>
 #include <Store.h>
 #include <ParentStore.h>
+#include <ChildStore.h>
+#include <PersistentParentStore.h>
+#include <GroupCommit.h>
 
 using namespace std::string_literals;
 constexpr auto totalTodos{1000};
@@ -15,6 +20,19 @@ TodoProperties createProperties(std::string title, std::string description, doub
     };
 }
 
+/**
+ * Query results are lazy, so the benchmarks have to iterate them to measure the whole query
+ */
+std::int64_t consumeIds(IdRange ids)
+{
+    std::int64_t sum{0};
+    for(const auto id : ids)
+    {
+        sum += id;
+    }
+    return sum;
+}
+
 ParentStore createDummyStore()
 {
     auto timestampInitialValue{0.0};
@@ -47,10 +65,32 @@ TEST_CASE("Basic store")
                     return store.update(0, propertiesToUpdate);
                 };
 
+    const auto patchToUpdate{TodoPatch::fromProperties(propertiesToUpdate)};
+    BENCHMARK("updating with a patch")
+                {
+                    return store.update(0, patchToUpdate);
+                };
+
+    // every update changes the title and the timestamp, so the indexes are updated too
+    const TodoPatch patches[]{TodoPatch{}.setTitle("Buy Tea").setTimestamp(1.0),
+                              TodoPatch{}.setTitle("Buy Coffee").setTimestamp(2.0)};
+    std::size_t updates{0};
+    BENCHMARK("updating indexed properties with a patch")
+                {
+                    return store.update(1, patches[updates++ % 2]);
+                };
+
     BENCHMARK("retrieving properties")
                 {
                     return store.get(id);
                 };
+
+    Todo todo;
+    BENCHMARK("retrieving todo")
+                {
+                    store.get(id, todo);
+                    return todo.timestamp;
+                };
 }
 
 TEST_CASE("Query small store (contains only one todo)")
@@ -65,14 +105,14 @@ TEST_CASE("Query small store (contains only one todo)")
     const TodoProperty queryProperty{titleKey, "Buy Milk"s};
     BENCHMARK("querying small store")
                 {
-                    return store.query(queryProperty);
+                    return consumeIds(store.query(queryProperty));
                 };
 
     constexpr auto minTimeStamp{1000.0};
     constexpr auto maxTimeStamp{1300.0};
     BENCHMARK("range querying small store")
                 {
-                    return store.rangeQuery(minTimeStamp, maxTimeStamp);
+                    return consumeIds(store.rangeQuery(minTimeStamp, maxTimeStamp));
                 };
 
 }
@@ -84,13 +124,37 @@ TEST_CASE("Query big store (contains 1000 todos with the same title)")
     const TodoProperty queryProperty{titleKey, "Buy Milk"s};
     BENCHMARK("querying")
                 {
-                    return store.query(queryProperty);
+                    return consumeIds(store.query(queryProperty));
                 };
 
     constexpr auto minTimeStamp{0.0};
     BENCHMARK("range querying")
                 {
-                    return store.rangeQuery(minTimeStamp, totalTodos);
+                    return consumeIds(store.rangeQuery(minTimeStamp, totalTodos));
+                };
+
+    BENCHMARK("range counting")
+                {
+                    return store.rangeCount(minTimeStamp, totalTodos);
+                };
+
+    constexpr auto pageSize{50};
+    BENCHMARK("range querying next 50 todos by timestamp")
+                {
+                    return store.rangeQueryOrdered(minTimeStamp, totalTodos, pageSize, RangeCursor{});
+                };
+
+    const auto cursor{store.rangeQueryOrdered(minTimeStamp, totalTodos, totalTodos / 2, RangeCursor{}).next};
+    BENCHMARK("range querying 50 todos by timestamp from the middle of the range")
+                {
+                    return store.rangeQueryOrdered(minTimeStamp, totalTodos, pageSize, *cursor);
+                };
+
+    BENCHMARK("querying first id")
+                {
+                    std::int64_t id;
+                    store.query(queryProperty).next(id);
+                    return id;
                 };
 }
 
@@ -105,10 +169,600 @@ TEST_CASE("Child stores")
                 };
 
     constexpr auto id{133};
-    child->update(id, {{titleKey, "Buy Chocolate"s}});
+
+    auto queryChild{parent->createChild()};
+    queryChild->update(id, {{titleKey, "Buy Chocolate"s}});
+    queryChild->remove(id + 1);
+    const TodoProperty queryProperty{titleKey, "Buy Milk"s};
+    BENCHMARK("child querying")
+                {
+                    return consumeIds(queryChild->query(queryProperty));
+                };
+
+    BENCHMARK("child range querying")
+                {
+                    return consumeIds(queryChild->rangeQuery(0.0, totalTodos));
+                };
 
     BENCHMARK("child committing")
                 {
+                    // a committed child goes on as a new transaction, validated against the parent commits
+                    child->update(id, {{titleKey, "Buy Chocolate"s}});
                     return child->commit();
                 };
-}
\ No newline at end of file
+
+    // the todos committed by other children after its creation are read from their old versions
+    auto isolatedChild{parent->createChild()};
+    auto committingChild{parent->createChild()};
+    for(auto i{0}; i < 100; ++i)
+    {
+        committingChild->update(i, {{titleKey, "Buy Bread"s}});
+    }
+    committingChild->commit();
+    BENCHMARK("child querying with 100 todos changed since its creation")
+                {
+                    return consumeIds(isolatedChild->query(queryProperty));
+                };
+
+    BENCHMARK("child retrieving a todo changed since its creation")
+                {
+                    return isolatedChild->get(50);
+                };
+}
+
+TEST_CASE("Group commit (256 transactions inserting a todo each)")
+{
+    constexpr auto transactionCount{256};
+    auto parent{std::make_shared<ParentStore>(createDummyStore())};
+    // every transaction inserts a new todo, so none of them conflicts, whatever was committed before
+    std::int64_t nextId{totalTodos};
+    const auto createTransactions{[&parent, &nextId]
+    {
+        std::vector<std::shared_ptr<ChildStore>> children;
+        for(auto i{0}; i < transactionCount; ++i)
+        {
+            children.emplace_back(static_cast<ChildStore*>(parent->createChild().release()));
+            children.back()->insert(nextId, TodoPatch{}.setTitle(i % 2 == 0 ? "Buy Bread"s : "Buy Milk"s)
+                                                       .setDescription("make of almonds!"s)
+                                                       .setTimestamp(double(nextId)));
+            ++nextId;
+        }
+        return children;
+    }};
+
+    // the transactions are created before measuring, only committing them is timed
+    BENCHMARK_ADVANCED("committing one by one")(Catch::Benchmark::Chronometer meter)
+                {
+                    std::vector<std::vector<std::shared_ptr<ChildStore>>> runs(meter.runs());
+                    std::generate(runs.begin(), runs.end(), createTransactions);
+                    meter.measure([&runs, &parent](int run)
+                                  {
+                                      for(const auto& child : runs[run])
+                                      {
+                                          child->commit();
+                                      }
+                                      return parent->version();
+                                  });
+                };
+
+    for(const auto groupSize : {16, 256})
+    {
+        BENCHMARK_ADVANCED("committing in groups of " + std::to_string(groupSize))(Catch::Benchmark::Chronometer meter)
+                    {
+                        std::vector<std::vector<std::shared_ptr<ChildStore>>> runs(meter.runs());
+                        std::generate(runs.begin(), runs.end(), createTransactions);
+                        meter.measure([&runs, &parent, groupSize](int run)
+                                      {
+                                          GroupCommit group{parent};
+                                          for(const auto& child : runs[run])
+                                          {
+                                              group.add(child);
+                                              if(group.size() == std::size_t(groupSize))
+                                              {
+                                                  group.commit();
+                                              }
+                                          }
+                                          return parent->version();
+                                      });
+                    };
+    }
+}
+
+TEST_CASE("Large commit (10000 todos updated in a store with 100000 todos)")
+{
+    constexpr auto storeSize{100000};
+    constexpr auto updatedTodos{10000};
+    std::vector<Todo> todos;
+    todos.reserve(storeSize);
+    for(std::int64_t id{0}; id < storeSize; ++id)
+    {
+        todos.push_back({id, "Buy Milk " + std::to_string(id % 1000), "make of almonds!", double(id)});
+    }
+    auto parent{std::make_shared<ParentStore>()};
+    parent->insertBatch(todos);
+
+    // every run changes the title and timestamp of the same todos to new values
+    auto run{0};
+    std::vector<TodoPatch> patches(updatedTodos);
+    const auto updateTodos{[&](Store& child)
+    {
+        ++run;
+        for(std::int64_t id{0}; id < updatedTodos; ++id)
+        {
+            auto& patch{patches[id]};
+            patch = TodoPatch{}.setTitle("Buy Bread " + std::to_string((id + run) % 1000))
+                               .setTimestamp(double(storeSize + id * 2 + run % 2));
+            child.update(id * (storeSize / updatedTodos), patch);
+        }
+    }};
+
+    // the cost of the child itself, to be subtracted from the commit benchmarks
+    BENCHMARK("updating the todos in a child without committing")
+                {
+                    auto child{parent->createChild()};
+                    updateTodos(*child);
+                    return parent->version();
+                };
+
+    BENCHMARK("committing the child delta")
+                {
+                    auto child{parent->createChild()};
+                    updateTodos(*child);
+                    child->commit();
+                    return parent->version();
+                };
+
+    BENCHMARK("committing by replaying the changes")
+                {
+                    // the child is kept alive while committing, so old versions are kept like in a child commit
+                    auto child{parent->createChild()};
+                    updateTodos(*child);
+                    std::vector<TodoChange> changes;
+                    changes.reserve(updatedTodos);
+                    for(std::int64_t id{0}; id < updatedTodos; ++id)
+                    {
+                        changes.push_back({TodoChange::Kind::update, id * (storeSize / updatedTodos), &patches[id]});
+                    }
+                    parent->commitChanges(changes);
+                    return parent->version();
+                };
+}
+
+TEST_CASE("Child store with a large delta (50000 of 100000 todos removed, 25000 updated)")
+{
+    constexpr auto storeSize{100000};
+    std::vector<Todo> todos;
+    todos.reserve(storeSize);
+    for(std::int64_t id{0}; id < storeSize; ++id)
+    {
+        // every title has a single todo
+        todos.push_back({id, "Buy Milk " + std::to_string(id), "make of almonds!", double(id)});
+    }
+    auto parent{std::make_shared<ParentStore>()};
+    parent->insertBatch(todos);
+    const auto changeTodos{[](Store& child, std::int64_t removedTodos)
+    {
+        for(std::int64_t id{0}; id < 2 * removedTodos; id += 2)
+        {
+            child.remove(id);
+        }
+        for(std::int64_t id{1}; id < removedTodos; id += 2)
+        {
+            child.update(id, TodoPatch{}.setTimestamp(double(storeSize + id)));
+        }
+    }};
+    auto child{parent->createChild()};
+    changeTodos(*child, storeSize / 2);
+    const TodoProperty titleProperty{titleKey, "Buy Milk 60001"s};
+
+    BENCHMARK("querying a title with 1 todo")
+                {
+                    return consumeIds(child->query(titleProperty));
+                };
+
+    BENCHMARK("counting a title with 1 todo")
+                {
+                    return child->queryCount(titleProperty);
+                };
+
+    BENCHMARK("querying a range with 10 todos")
+                {
+                    return consumeIds(child->rangeQuery(60000.0, 60019.0));
+                };
+
+    BENCHMARK("counting a range with 10 todos")
+                {
+                    return child->rangeCount(60000.0, 60019.0);
+                };
+
+    BENCHMARK("reading an ordered page of 10 todos")
+                {
+                    return child->rangeQueryOrdered(60000.0, 70000.0, 10, RangeCursor{}).todos.size();
+                };
+
+    // the first query of a new child is the difference between both benchmarks
+    constexpr auto freshRemovedTodos{1000};
+    BENCHMARK("removing 1000 todos in a new child")
+                {
+                    auto freshChild{parent->createChild()};
+                    changeTodos(*freshChild, freshRemovedTodos);
+                    return freshChild->checkId(0);
+                };
+
+    BENCHMARK("removing 1000 todos in a new child and querying a title")
+                {
+                    auto freshChild{parent->createChild()};
+                    changeTodos(*freshChild, freshRemovedTodos);
+                    return consumeIds(freshChild->query(titleProperty));
+                };
+}
+
+TEST_CASE("Short transactions (a child changing 100 todos)")
+{
+    auto parent{std::make_shared<ParentStore>(createDummyStore())};
+    const auto changeTodos{[](Store& child, std::int64_t firstRemovedId, std::int64_t firstInsertedId)
+    {
+        for(std::int64_t id{0}; id < 80; ++id)
+        {
+            child.update(id, TodoPatch{}.setTitle("Buy Chocolate "s + std::to_string(id)).setTimestamp(id + 0.5));
+        }
+        for(auto id{firstRemovedId}; id < firstRemovedId + 10; ++id)
+        {
+            child.remove(id);
+        }
+        for(auto id{firstInsertedId}; id < firstInsertedId + 10; ++id)
+        {
+            child.insert(id, TodoPatch{}.setTitle("Buy Bread").setDescription("").setTimestamp(double(id)));
+        }
+    }};
+
+    BENCHMARK("changing the todos in a new child and discarding it")
+                {
+                    auto child{parent->createChild()};
+                    changeTodos(*child, 80, totalTodos);
+                    return child->checkId(0);
+                };
+
+    BENCHMARK("changing the todos in a pooled child and releasing it")
+                {
+                    auto child{parent->acquireChild()};
+                    changeTodos(*child, 80, totalTodos);
+                    return child->checkId(0);
+                };
+
+    auto rolledBackChild{parent->createChild()};
+    BENCHMARK("changing the todos in a child and rolling it back")
+                {
+                    changeTodos(*rolledBackChild, 80, totalTodos);
+                    rolledBackChild->rollback();
+                    return rolledBackChild->checkId(0);
+                };
+
+    // every commit removes the todos inserted by the previous one
+    auto child{parent->createChild()};
+    std::int64_t firstRemovedId{80};
+    std::int64_t firstInsertedId{totalTodos};
+    BENCHMARK("changing the todos in a child and committing it")
+                {
+                    changeTodos(*child, firstRemovedId, firstInsertedId);
+                    child->commit();
+                    firstRemovedId = firstInsertedId;
+                    firstInsertedId += 10;
+                    return parent->version();
+                };
+}
+
+TEST_CASE("Partial rollback (undoing the last 10 changes of a child with 10000 changes)")
+{
+    constexpr auto storeSize{100000};
+    constexpr auto changedTodos{10000};
+    std::vector<Todo> todos;
+    todos.reserve(storeSize);
+    for(std::int64_t id{0}; id < storeSize; ++id)
+    {
+        todos.push_back({id, "Buy Milk " + std::to_string(id % 1000), "make of almonds!", double(id)});
+    }
+    auto parent{std::make_shared<ParentStore>()};
+    parent->insertBatch(todos);
+    const auto changeTodos{[](Store& child, std::int64_t firstId, std::int64_t lastId)
+    {
+        for(auto id{firstId}; id < lastId; ++id)
+        {
+            child.update(id, TodoPatch{}.setTitle("Buy Bread "s + std::to_string(id % 1000))
+                                        .setTimestamp(double(storeSize + id)));
+        }
+    }};
+
+    auto child{std::make_shared<ChildStore>(parent, parent->snapshot())};
+    changeTodos(*child, 0, changedTodos - 10);
+    const auto savepoint{child->savepoint()};
+    BENCHMARK("changing 10 todos and rolling back to a savepoint")
+                {
+                    changeTodos(*child, changedTodos - 10, changedTodos);
+                    child->rollbackTo(savepoint);
+                    return child->checkId(0);
+                };
+
+    // without savepoints, the changes to keep are replayed after rolling back the whole child
+    auto rolledBackChild{parent->createChild()};
+    changeTodos(*rolledBackChild, 0, changedTodos - 10);
+    BENCHMARK("changing 10 todos, rolling back and replaying the other changes")
+                {
+                    changeTodos(*rolledBackChild, changedTodos - 10, changedTodos);
+                    rolledBackChild->rollback();
+                    changeTodos(*rolledBackChild, 0, changedTodos - 10);
+                    return rolledBackChild->checkId(0);
+                };
+}
+
+TEST_CASE("Persistent store against parent store (100000 todos, children changing 10000 of them)")
+{
+    constexpr auto storeSize{100000};
+    constexpr auto changedTodos{10000};
+    std::vector<Todo> todos;
+    todos.reserve(storeSize);
+    for(std::int64_t id{0}; id < storeSize; ++id)
+    {
+        todos.push_back({id, "Buy Milk " + std::to_string(id % 1000), "make of almonds!", double(id)});
+    }
+    auto parent{std::make_shared<ParentStore>()};
+    parent->insertBatch(todos);
+    auto persistentParent{std::make_shared<PersistentParentStore>()};
+    persistentParent->insertBatch(todos);
+    const auto changeTodos{[](Store& child, std::int64_t firstId, std::int64_t lastId)
+    {
+        for(auto id{firstId}; id < lastId; ++id)
+        {
+            child.update(id * (storeSize / changedTodos),
+                         TodoPatch{}.setTitle("Buy Bread "s + std::to_string(id % 1000))
+                                    .setTimestamp(double(storeSize + id)));
+        }
+    }};
+
+    BENCHMARK("creating a child of the parent store")
+                {
+                    return parent->createChild();
+                };
+
+    BENCHMARK("creating a child of the persistent store")
+                {
+                    return persistentParent->createChild();
+                };
+
+    const auto child{parent->createChild()};
+    changeTodos(*child, 0, changedTodos);
+    const auto persistentChild{persistentParent->createChild()};
+    changeTodos(*persistentChild, 0, changedTodos);
+    const TodoProperty queryProperty{titleKey, "Buy Milk 5"s};
+    BENCHMARK("querying a title with 100 todos in a child of the parent store")
+                {
+                    return consumeIds(child->query(queryProperty));
+                };
+
+    BENCHMARK("querying a title with 100 todos in a child of the persistent store")
+                {
+                    return consumeIds(persistentChild->query(queryProperty));
+                };
+
+    BENCHMARK("counting a range with 1000 todos in a child of the parent store")
+                {
+                    return child->rangeCount(50000.0, 50999.0);
+                };
+
+    BENCHMARK("counting a range with 1000 todos in a child of the persistent store")
+                {
+                    return persistentChild->rangeCount(50000.0, 50999.0);
+                };
+
+    BENCHMARK("changing 100 todos in a child of the parent store and committing it")
+                {
+                    auto committedChild{parent->createChild()};
+                    changeTodos(*committedChild, 0, 100);
+                    committedChild->commit();
+                    return parent->version();
+                };
+
+    BENCHMARK("changing 100 todos in a child of the persistent store and committing it")
+                {
+                    auto committedChild{persistentParent->createChild()};
+                    changeTodos(*committedChild, 0, 100);
+                    committedChild->commit();
+                    return persistentParent->version();
+                };
+
+    // every write of the persistent store copies the path of the todo and its index entries
+    BENCHMARK("updating a todo of the parent store")
+                {
+                    parent->update(storeSize / 2, TodoPatch{}.setTimestamp(double(parent->version())));
+                    return parent->version();
+                };
+
+    BENCHMARK("updating a todo of the persistent store")
+                {
+                    persistentParent->update(storeSize / 2,
+                                             TodoPatch{}.setTimestamp(double(persistentParent->version())));
+                    return persistentParent->version();
+                };
+}
+
+TEST_CASE("Nested child stores (depth 1 against depth 5)")
+{
+    // both children hide the same todos, the deepest one through 4 levels of children
+    auto parent{std::make_shared<ParentStore>(createDummyStore())};
+    const std::shared_ptr<Store> firstChild{parent->createChild()};
+    std::shared_ptr<Store> deepestChild{parent->createChild()};
+    for(auto level{1}; level < 5; ++level)
+    {
+        firstChild->update(level, {{titleKey, "Buy Chocolate"s}});
+        deepestChild->update(level, {{titleKey, "Buy Chocolate"s}});
+        deepestChild = deepestChild->createChild();
+    }
+
+    BENCHMARK("creating nested child")
+                {
+                    return deepestChild->createChild();
+                };
+
+    Todo todo;
+    BENCHMARK("retrieving todo at depth 1")
+                {
+                    firstChild->get(133, todo);
+                    return todo.timestamp;
+                };
+
+    BENCHMARK("retrieving todo at depth 5")
+                {
+                    deepestChild->get(133, todo);
+                    return todo.timestamp;
+                };
+
+    const TodoProperty queryProperty{titleKey, "Buy Milk"s};
+    BENCHMARK("querying at depth 1")
+                {
+                    return consumeIds(firstChild->query(queryProperty));
+                };
+
+    BENCHMARK("querying at depth 5")
+                {
+                    return consumeIds(deepestChild->query(queryProperty));
+                };
+
+    BENCHMARK("committing nested child")
+                {
+                    const std::shared_ptr<Store> nestedChild{deepestChild->createChild()};
+                    nestedChild->update(133, {{titleKey, "Buy Chocolate"s}});
+                    return nestedChild->commit();
+                };
+}
+
+TEST_CASE("Batch insertion (100000 todos with 1000 different titles)")
+{
+    constexpr auto batchSize{100000};
+    std::vector<Todo> todos;
+    todos.reserve(batchSize);
+    for(std::int64_t id{0}; id < batchSize; ++id)
+    {
+        // timestamps are not inserted in order, as when loading todos from other sources
+        todos.push_back({id, "Buy Milk " + std::to_string(id % 1000), "make of almonds!",
+                         double((id * 7919) % batchSize)});
+    }
+
+    BENCHMARK("inserting one by one")
+                {
+                    ParentStore store;
+                    for(const auto& todo : todos)
+                    {
+                        store.insert(todo.id, createProperties(todo.title, todo.description, todo.timestamp));
+                    }
+                    return store.rangeCount(0.0, batchSize);
+                };
+
+    BENCHMARK("inserting a batch")
+                {
+                    ParentStore store;
+                    store.insertBatch(todos);
+                    return store.rangeCount(0.0, batchSize);
+                };
+}
+
+TEST_CASE("Getting many todos (64 random ids of a store with 1000000 todos)")
+{
+    constexpr auto storeSize{1000000};
+    std::vector<Todo> todos;
+    todos.reserve(storeSize);
+    for(std::int64_t id{0}; id < storeSize; ++id)
+    {
+        todos.push_back({id, "Buy Milk", "make of almonds!", double(id)});
+    }
+    ParentStore store;
+    store.insertBatch(todos);
+
+    std::vector<std::int64_t> ids(64);
+    std::int64_t next{0};
+    const auto randomIds{[&ids, &next]()
+                         {
+                             for(auto& id : ids)
+                             {
+                                 id = (next++ * 7919) % storeSize;
+                             }
+                         }};
+
+    BENCHMARK("getting one by one")
+                {
+                    randomIds();
+                    double sum{0.0};
+                    for(const auto id : ids)
+                    {
+                        sum += std::get<double>(store.get(id).at(timestampKey));
+                    }
+                    return sum;
+                };
+
+    std::vector<std::optional<Todo>> result;
+    BENCHMARK("getting many")
+                {
+                    randomIds();
+                    store.getMany(ids, result);
+                    double sum{0.0};
+                    for(const auto& todo : result)
+                    {
+                        sum += todo->timestamp;
+                    }
+                    return sum;
+                };
+}
+
+TEST_CASE("Write-ahead log (children changing 100 todos of a store with 100000 todos and committing them)")
+{
+    constexpr auto storeSize{100000};
+    std::vector<Todo> todos;
+    todos.reserve(storeSize);
+    for(std::int64_t id{0}; id < storeSize; ++id)
+    {
+        todos.push_back({id, "Buy Milk " + std::to_string(id % 1000), "make of almonds!", double(id)});
+    }
+    const auto openStore{[&todos](const std::string& name, WriteAheadLog::Options options)
+    {
+        const auto path{std::filesystem::temp_directory_path() / ("todo_store_" + name + ".benchmark")};
+        std::filesystem::remove(path);
+        auto store{ParentStore::open(path.string(), options)};
+        store->insertBatch(todos);
+        return store;
+    }};
+    const auto commitChild{[](ParentStore& store)
+    {
+        auto child{store.createChild()};
+        for(std::int64_t id{0}; id < 100; ++id)
+        {
+            child->update(id * (storeSize / 100), TodoPatch{}.setTitle("Buy Bread "s + std::to_string(id))
+                                                             .setTimestamp(double(storeSize + id)));
+        }
+        child->commit();
+        return store.version();
+    }};
+
+    auto store{std::make_shared<ParentStore>()};
+    store->insertBatch(todos);
+    BENCHMARK("committing without a log")
+                {
+                    return commitChild(*store);
+                };
+
+    const auto unsyncedStore{openStore("unsynced", {WriteAheadLog::SyncPolicy::none})};
+    BENCHMARK("committing with a log not synced")
+                {
+                    return commitChild(*unsyncedStore);
+                };
+
+    const auto intervalStore{openStore("interval", {WriteAheadLog::SyncPolicy::interval})};
+    BENCHMARK("committing with a log synced every 10 ms")
+                {
+                    return commitChild(*intervalStore);
+                };
+
+    const auto syncedStore{openStore("synced", {WriteAheadLog::SyncPolicy::everyCommit})};
+    BENCHMARK("committing with a log synced on every commit")
+                {
+                    return commitChild(*syncedStore);
+                };
+}